@@ -28,7 +28,7 @@
 /**
  * GLOBAL VARIABLES
  */
-uint8_t state = 0x02;   // LED state
+volatile uint8_t state = 0x02;   // LED state, changed by the ISR
 
 /**
  * ISR
@@ -68,8 +68,8 @@ void main(void)
     // 5. Configure pull-up resistor for SW1
     MAP_GPIOPadConfigSet( GPIO_PORTF_BASE , GPIO_PIN_4, GPIO_STRENGTH_2MA , GPIO_PIN_TYPE_STD_WPU );
 
-    // 6. Register the port-level interrupt service routine (interrupt handler).
-    MAP_GPIOIntRegister( GPIO_PORTF_BASE , toggle_color );
+    // 6. The port-level interrupt service routine (interrupt handler) is placed in the
+    //    vector table at link time (see tm4c123gh6pm_startup_ccs.c); no run-time registration needed.
 
     // 7. Configure SW1 interrupt (triggered when button is pressed down = shorted to ground)
     MAP_GPIOIntTypeSet( GPIO_PORTF_BASE , GPIO_PIN_4 , GPIO_FALLING_EDGE );
@@ -22,7 +22,7 @@
 #include "driverlib/interrupt.h"    // interrupt API
 #include "driverlib/rom_map.h"      // macros for memory-saving API calls
 
-bool isReadyToTurnOff = false;
+volatile bool isReadyToTurnOff = false;    // set by the ISR, read and cleared by main
 
 /**
  * ISR
@@ -75,8 +75,8 @@ void main(void)
     period = MAP_SysCtlClockGet() / 2;
     MAP_TimerLoadSet( TIMER0_BASE, TIMER_BOTH , period - 1); // since 1 clock cycle is 1/40MHz long, this should take 1/2 sec to finish
 
-    // 6. Register the peripheral-level interrupt handler
-    TimerIntRegister( TIMER0_BASE , TIMER_BOTH , timerExpired );
+    // 6. The peripheral-level interrupt handler is placed in the vector table
+    //    at link time (see tm4c123gh6pm_startup_ccs.c); no run-time registration needed.
 
     // 7. Enable timer interrupt
     MAP_TimerIntEnable( TIMER0_BASE , TIMER_TIMA_TIMEOUT ); // use timerA for 32-bit timer timeout
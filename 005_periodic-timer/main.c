@@ -25,7 +25,7 @@
 /**
  * GLOBAL VARIABLE
  */
-uint8_t control = 0x0;
+volatile uint8_t control = 0x0;    // changed by the ISR, read by main
 
 /**
  * ISR
@@ -78,8 +78,8 @@ void main(void)
     period = MAP_SysCtlClockGet() / 2;
     MAP_TimerLoadSet( TIMER0_BASE, TIMER_BOTH , period - 1); // Set to 1/2 seconds
 
-    // 6. Register the peripheral-level interrupt handler
-    TimerIntRegister( TIMER0_BASE , TIMER_BOTH , toggle_color );
+    // 6. The peripheral-level interrupt handler is placed in the vector table
+    //    at link time (see tm4c123gh6pm_startup_ccs.c); no run-time registration needed.
 
     // 7. Enable timer interrupt
     MAP_TimerIntEnable( TIMER0_BASE , TIMER_TIMA_TIMEOUT ); // use timerA for 32-bit timer timeout
@@ -26,7 +26,7 @@
 /**
  * GLOBAL VARIABLE
  */
-uint8_t control = 0x0;
+volatile uint8_t control = 0x0;    // changed by the ISR, read by main
 
 /**
  * ISR
@@ -71,8 +71,8 @@ void main(void)
     // Timer counts up in real time (32 bits only)
     MAP_TimerConfigure( TIMER0_BASE , TIMER_CFG_RTC );
 
-    // 5. Register the port-level interrupt handler
-    TimerIntRegister( TIMER0_BASE , TIMER_A , toggle_color );
+    // 5. The peripheral-level interrupt handler is placed in the vector table
+    //    at link time (see tm4c123gh6pm_startup_ccs.c); no run-time registration needed.
 
     // 6. Enable timer interrupt
     MAP_TimerIntEnable( TIMER0_BASE , TIMER_TIMA_TIMEOUT ); // use timerA for 32-bit timer timeout
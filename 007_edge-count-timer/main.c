@@ -30,7 +30,7 @@
 /**
  * GLOBAL VARIABLES
  */
-uint32_t ui32InterruptCount = 0;
+volatile uint32_t ui32InterruptCount = 0;    // written by the ISR; volatile so main re-reads it
 
 /**
  * ISR
@@ -104,8 +104,8 @@ void main(void)
     // 7. Set timer matching condition
     MAP_TimerMatchSet( TIMER0_BASE , TIMER_A , 10 );
 
-    // 6. Register the port-level interrupt handler
-    TimerIntRegister( TIMER0_BASE , TIMER_A , counted_ten );
+    // 6. The interrupt handler is placed in the vector table at link time
+    //    (see tm4c123gh6pm_startup_ccs.c); no run-time registration needed.
 
     // 7. Enable capture match interrupt (not the timeout interrupt!)
     MAP_TimerIntEnable( TIMER0_BASE , TIMER_CAPA_MATCH );
@@ -122,17 +122,24 @@ void main(void)
 
     uint32_t ui32EdgeCount = 0;
     uint32_t ui32LastCount = ui32EdgeCount;
+    uint32_t ui32Tens = 0;
     MAP_TimerEnable( TIMER0_BASE , TIMER_A );
 
     UARTprintf("\n\n\n\n\n\n\n\n\n\n\n\n\rEdge Counter Sample\r\n");
 
     while(1) {
-        ui32EdgeCount = MAP_TimerValueGet(TIMER0_BASE, TIMER_A);
+        // Read the timer and the ISR's count as one snapshot: if the ISR ran in
+        // between (the count moved), the timer value belongs to the other side
+        // of the match, so read both again. The ISR is never held off.
+        do {
+            ui32Tens = ui32InterruptCount;
+            ui32EdgeCount = MAP_TimerValueGet(TIMER0_BASE, TIMER_A);
+        } while ( ui32Tens != ui32InterruptCount );
 
         if ( ui32LastCount != ui32EdgeCount ){
             ui32LastCount = ui32EdgeCount;
             UARTprintf("\rHg contacts detected: %2d\r\n", ui32LastCount);
-            UARTprintf("\rIt's more than %d\r\b", ui32InterruptCount);
+            UARTprintf("\rIt's more than %d\r\b", ui32Tens);
         }
 
     }
@@ -16,6 +16,7 @@
 #include "inc/hw_memmap.h"          // macros defining the memory map of the device
 #include "inc/hw_ints.h"            // macros that define the interrupt assignment on Tiva C MCUs
 #include "inc/hw_adc.h"             // macros used when accessing ADC hardware
+#include "inc/hw_types.h"           // macros for direct register access
 #include "driverlib/sysctl.h"       // system control API
 #include "driverlib/gpio.h"         // general purpose input output API
 #include "driverlib/pin_map.h"      // pin mapping of alternative functions
@@ -25,30 +26,436 @@
 #include "driverlib/timer.h"        // general purpose timers API
 #include "driverlib/rom_map.h"      // macros for memory-saving API calls
 #include "driverlib/uart.h"         // universal asynchronous receiver transmitter API
+#include "driverlib/systick.h"      // system tick timer API
 #include "utils/uartstdio.h"        // utility library for easier serial writing
+#include "utils/cyclecount.h"       // DWT cycle counter for boot/latency measurement
+#include "utils/vtable.h"           // vector table placement (flash or SRAM)
+#include "utils/faultrecord.h"      // fault capture and post-reset crash report
+#include "utils/boottime.h"         // boot phase time stamps and overlapped peripheral bring-up
+#include "utils/stackmon.h"         // stack painting, high-water mark and MPU stack guard
+#include "utils/mempool.h"          // fixed-block pools with reference-counted blocks
+#include "utils/pipeline.h"         // zero-copy block pipeline with per-stage cycle accounting
+#include "utils/pipestages.h"       // filter, decimate and threshold stages
+#include "utils/telemetry.h"        // COBS framed binary telemetry on the console UART
+#include "utils/sampack.h"          // 12-bit packing and delta coding of sample blocks
+#include "utils/shell.h"            // non-blocking command shell on the console
+#include "utils/params.h"           // tunable parameters saved in EEPROM
+#include "utils/flashlog.h"         // circular log of packed blocks in internal flash
+#include "utils/dmamgr.h"           // uDMA control table, channel plan and per-channel statistics
+#include "utils/ssidma.h"           // SPI transfers on an SSI module by uDMA
+#include "utils/dmaseq.h"           // uDMA scatter-gather task lists (DMA_SCATTER_GATHER builds)
+#include "utils/samplering.h"       // sample blocks filled by a looping task list (DMA_SCATTER_GATHER builds)
+#include "utils/blockdev.h"         // 512-byte block device interface
+#include "utils/sdspi.h"            // SD card in SPI mode
+#include "utils/blklog.h"           // append-only log of blocks on the SD card
+#include "utils/i2cbus.h"           // queued, interrupt-driven I2C master and sensor polling
+#include "utils/adcwatch.h"         // threshold alarms from the ADC digital comparators
+#include "utils/capture.h"          // triggered capture with pre-trigger history
+#include "utils/power.h"            // real and reactive power and phase of sample pairs (DUAL_ADC builds)
+#include "utils/rategen.h"          // drift-free fractional rates from a periodic timer
+#include "utils/intprio.h"          // interrupt priority plan and BASEPRI critical sections
+#include "utils/lfqueue.h"          // lock-free queues built on LDREX/STREX
+#include "utils/seqlock.h"          // consistent multi-word snapshots from interrupt handlers
+#include "utils/sched.h"            // run-to-completion tasks with event queues
+#include "utils/kernel.h"           // preemptive threads, semaphores and mutexes (KERNEL_THREADS builds)
+#include "stdlib.h"                 // strtoul() for command arguments
+#include "string.h"                 // strcmp() for command arguments
 
 /**
  * MACROS
  */
 #define BUFFER_SIZE 256
+#define SAMPLE_BLOCKS 6             // two being filled by DMA, up to PIPE_QUEUE_DEPTH waiting in the pipeline
+#define REPORT_BLOCKS 1024          // default blocks between pipeline statistics (~16 s); the "report" parameter
+#define TELEMETRY_CHANNEL_ADC 0
+#define TELEMETRY_CHANNEL_LOG 1     // blocks read back from the flash log
+#define TELEMETRY_CHANNEL_CAPTURE 2 // triggered capture windows
+#define TELEMETRY_CHANNEL_TIME 3    // time stamps of the ADC blocks (tools/sample_clock.py)
+#define CAPTURE_HISTORY 1024        // samples of history kept for a capture: 64 ms at the default rate
+#define CAPTURE_PRE 256             // of which before the trigger
+#define LOG_FLASH_BASE 0x00020000   // upper 128 KB of flash; the program image must stay below it (see the .map file)
+#define LOG_FLASH_SIZE 0x00020000
+#define SAMPLE_RATE 16000           // default ADC samples per second; the "rate" command changes it and "save" keeps it
+#define SAMPLE_RATE_MIN 1000        // Timer A is 16 bits wide in split mode: 40 MHz / 65536 is about 610 Hz
+#define SAMPLE_RATE_MAX 100000      // the ADC clock allows 500 kS/s, but one block per 2.5 ms keeps the pipeline ahead
+
+// TELEMETRY_STREAM sends every block as a binary frame (see tools/telemetry_rx.py) instead of the text
+// status line; 16 kS/s of 16-bit samples needs about 33 kB/s, beyond 115200 baud (12-bit packing
+// needs 24 kB/s, Rice coding less on slowly varying inputs)
+#ifdef TELEMETRY_STREAM
+#define CONSOLE_BAUD 921600
+#else
+#define CONSOLE_BAUD 115200
+#endif
+#define LATENCY_SAMPLES 16
+#define STACK_CONTEXT_MAIN 0
+#define STACK_CONTEXT_ADC  1
+#define TICK_HZ 1000                // SysTick rate; the deferred tasks are paced in its ticks (ms)
+#define I2C_POLL_MS 10              // one sensor poll tick every 10 ms
+#define HEARTBEAT_MS 500            // LED toggles, as in 005_periodic-timer
+
+// KERNEL_THREADS runs the main loop as the lowest thread of a preemptive kernel (utils/kernel.c), so work that
+// has to block can be given a thread of its own; "kernel" lists the threads and "kernel bench" times a switch
+#ifdef KERNEL_THREADS
+#define MAIN_THREAD_STACK 1024      // twice the system stack the loop had, which also took the interrupt frames
+#define MAIN_THREAD_PRIORITY 8
+#define KERNEL_BENCH_ROUNDS 1000
+#endif
+#define I2C_POLL_PER_TICK 2         // sensors read per tick
+
+// DUAL_ADC samples AIN1 (PE2) on ADC1 from the same timer trigger as AIN0 (PE3) on ADC0, so the two inputs of a pair,
+// a voltage and a current say, are converted at the same ADC clock edge. ADC1 DMAs into a ring of its own; both ADCs
+// count the same triggers, so ADC1's block n pairs with ADC0's block n. "power" shows what the "power" stage makes of it
+#ifdef DUAL_ADC
+#define PAIR_RING_BLOCKS 8          // more than SAMPLE_BLOCKS, so a slot outlasts the ADC0 block it pairs with
+#define PAIR_SLOT_EMPTY 0xFFFFFFFF
+#define ADC_MIDSCALE 2048
+#endif
+
+// DMA_SCATTER_GATHER fills a ring of sample pool blocks in turn from one looping uDMA task list instead of re-arming
+// the ping-pong halves from the ADC interrupt: after each block the uDMA itself stamps it from a free-running timer and
+// posts its slot number, and SysTick lends finished blocks to the pipeline, swapping free blocks into their slots.
+// Nothing has to happen by the end of a block
+#ifdef DMA_SCATTER_GATHER
+#define RING_BLOCKS 3               // slots in the task list: SysTick has two blocks' time to lend each; the pool's
+                                    // other blocks are what the pipeline can hold at once
+#endif
+#define PARAM_SCHEMA 2              // raise when parameters are added or change meaning; saved values are matched by id
 
 /**
  * GLOBAL VARIABLES
  */
-#pragma DATA_ALIGN(pui8DMAControlTable, 1024)
-uint8_t pui8DMAControlTable[1024];      // application must allocate the channel control table that must be 1024-byte aligned
+// ADC sample blocks come from a pool so a filled block can be handed on by pointer while DMA refills a fresh one
+#pragma NOINIT(g_pui32SampleStorage)    // DMA fills the blocks before they are read
+static uint32_t g_pui32SampleStorage[MEMPOOL_WORDS(PIPE_BLOCK_SIZE(BUFFER_SIZE * sizeof(uint16_t)), SAMPLE_BLOCKS)];
+static uint8_t g_pui8SampleRefs[SAMPLE_BLOCKS];
+static tMemPool g_sSamplePool;
+static tPipeBlock *g_ppsDMABlock[2];    // blocks the primary and alternate DMA structures are filling
+static uint32_t g_ui32FillHalf;         // ping-pong half (0 = primary) that completes next
+static uint32_t g_ui32BlockSeq;
+static uint32_t g_ui32Overruns;         // blocks overwritten because the pipeline fell behind
+static uint32_t g_ui32Missed;           // ADC FIFO overflows, each losing one or more triggers' samples
+
+// Block, overrun and missed trigger counts published together by the ADC ISR, so "stats" never pairs counts from
+// different blocks
+#define SAMPLE_STATUS_BLOCKS    0
+#define SAMPLE_STATUS_OVERRUNS  1
+#define SAMPLE_STATUS_MISSED    2
+#define SAMPLE_STATUS_WORDS     3
+static tSeqLock g_sSampleStatusLock;
+static volatile uint32_t g_pui32SampleStatus[SAMPLE_STATUS_WORDS];
+
+#ifdef DMA_SCATTER_GATHER
+// The ring: a lent block leaves the task list, a free one taking its slot, so the uDMA never writes a block the
+// pipeline holds. Time stamps are WTIMER0 A counts, which run at the CPU clock like the cycle counter, less the
+// difference read between the two
+static tDMAControlTable g_psRingTasks[SAMPLERING_TASKS(RING_BLOCKS)];
+static tDMASeq g_sRingSeq = { g_psRingTasks, SAMPLERING_TASKS(RING_BLOCKS), UDMA_CHANNEL_ADC0, true };
+static tPipeBlock *g_ppsRingBlock[RING_BLOCKS];
+static volatile uint32_t g_pui32RingTime[RING_BLOCKS];
+static uint32_t g_pui32RingSlot[RING_BLOCKS];                   // slot numbers, copied out by the uDMA
+static tSampleRing g_sSampleRing = { &g_sRingSeq, &g_sSamplePool, g_ppsRingBlock, g_pui32RingTime, g_pui32RingSlot,
+                                     RING_BLOCKS };
+static uint32_t g_ui32RingTimeOffset;   // cycle count less timer count
+static uint32_t g_ui32RingLastTime;     // timer count of the block handed over last
+static void SampleRingPoll(void);
+#endif
+
+#ifdef DUAL_ADC
+// ADC1's ring: slot n % PAIR_RING_BLOCKS holds its block n once the slot's number is set; the time is that of the
+// block's last sample, as for the ADC0 blocks, so a pair whose ADCs have slipped apart is not mistaken for one
+static uint16_t g_ppui16PairRing[PAIR_RING_BLOCKS][BUFFER_SIZE];
+static volatile uint32_t g_pui32PairSeq[PAIR_RING_BLOCKS];
+static volatile uint32_t g_pui32PairTime[PAIR_RING_BLOCKS];
+static uint32_t g_ui32PairBlocks;       // ADC1 blocks completed
+static uint32_t g_ui32PairFillHalf;     // ping-pong half (0 = primary) that completes next
+static uint32_t g_ui32PairMissed;       // ADC0 blocks whose ADC1 block was overwritten before the stage got to it
+static uint32_t g_ui32PairSkewed;       // ADC0 blocks whose ADC1 block was not taken at the same time
+static uint32_t g_ui32PowerBlocks;
+static tPowerResult g_sPower;           // of the latest pair
+#endif
+
+// Every peripheral used by this demo; clocked together so their reset release overlaps the PLL lock
+static const uint32_t g_pui32Peripherals[] =
+{
+    SYSCTL_PERIPH_GPIOE,        // ADC channel 0 is located at PE3
+    SYSCTL_PERIPH_ADC0,
+#ifdef DUAL_ADC
+    SYSCTL_PERIPH_ADC1,         // AIN1 (PE2), paired with AIN0
+#endif
+    SYSCTL_PERIPH_UDMA,
+    SYSCTL_PERIPH_TIMER0,       // ADC trigger
+#ifdef DMA_SCATTER_GATHER
+    SYSCTL_PERIPH_WTIMER0,      // block time stamps, read by the uDMA
+#endif
+    SYSCTL_PERIPH_GPIOA,        // UART0 and SSI0 pins
+    SYSCTL_PERIPH_UART0,
+    SYSCTL_PERIPH_EEPROM0,      // saved parameters
+    SYSCTL_PERIPH_SSI0,         // SD card
+    SYSCTL_PERIPH_GPIOB,        // I2C0 pins
+    SYSCTL_PERIPH_I2C0,         // sensor bus
+    SYSCTL_PERIPH_GPIOF         // heartbeat LED (PF3)
+};
+#define NUM_PERIPHERALS (sizeof(g_pui32Peripherals) / sizeof(g_pui32Peripherals[0]))
 
-static uint16_t pui16ADCBuffer1[BUFFER_SIZE];
-static uint16_t pui16ADCBuffer2[BUFFER_SIZE];
+// Interrupt priority plan: lower numbers preempt higher ones. 0x00 is kept for handlers that share no data,
+// since no critical section short of masking everything can hold it off.
+#define PRIORITY_ALARM      0x00    // ADC comparator alarms: time-stamped and posted, nothing shared
+#define PRIORITY_RATE       0x00    // sample clock: loads the next period within the current one; set with all masked
+#define PRIORITY_SAMPLING   0x20    // must re-arm a ping-pong half before the other one fills
+#define PRIORITY_TICK       0x40    // time base of the tasks (and of the kernel)
+#define PRIORITY_IO         0x60    // sensor bus
+#define PRIORITY_CONSOLE    0x80    // console and error counting
+#define PRIORITY_TASKS      0xE0    // PendSV: deferred tasks; SchedInit() and KernelInit() set it as well
+static const tIntPriority g_psIntPlan[] =
+{
+    { INT_TIMER0A,   PRIORITY_RATE,     "Timer 0A rate" },
+    { INT_ADC0SS1,   PRIORITY_ALARM,    "ADC0 SS1 watch" },
+    { INT_GPIOF,     PRIORITY_ALARM,    "GPIO F button" },
+    { INT_ADC0SS0,   PRIORITY_SAMPLING, "ADC0 SS0" },
+#ifdef DUAL_ADC
+    { INT_ADC1SS0,   PRIORITY_SAMPLING, "ADC1 SS0" },
+#endif
+    { FAULT_SYSTICK, PRIORITY_TICK,     "SysTick" },
+    { INT_I2C0,      PRIORITY_IO,       "I2C0" },
+    { INT_UART0,     PRIORITY_CONSOLE,  "UART0" },
+    { INT_UDMAERR,   PRIORITY_CONSOLE,  "uDMA error" },
+    { FAULT_PENDSV,  PRIORITY_TASKS,    "PendSV" }
+};
+#define NUM_INT_PLAN (sizeof(g_psIntPlan) / sizeof(g_psIntPlan[0]))
 
-enum BUFFER_STATUS
+// uDMA channel plan: each channel number serves one peripheral at a time, so two entries on the same number are a
+// conflict. DMAMgrInit() assigns the channels in this order, leaves out any it finds taken and says so at boot;
+// "dma" shows the plan with each channel's transfers, items and errors
+static const tDMAChannelUse g_psDMAPlan[] =
 {
-    EMPTY,
-    FILLING,
-    FULL
+    { UDMA_CH14_ADC0_0,  "ADC0 SS0" },
+    { UDMA_CH10_SSI0RX,  "SD card rx" },
+    { UDMA_CH11_SSI0TX,  "SD card tx" },
+#ifdef DUAL_ADC
+    { UDMA_CH24_ADC1_0,  "ADC1 SS0" },
+#endif
 };
-static enum BUFFER_STATUS pui32BufferStatus[2];
+#define NUM_DMA_PLAN (sizeof(g_psDMAPlan) / sizeof(g_psDMAPlan[0]))
+
+static const char * const g_ppcStackContexts[] = { "main loop", "ADC0 SS0 ISR" };
+
 static uint32_t g_ui32DMAErrCount = 0u;
+static uint32_t g_ui32SampleRate;
+
+// The ADC trigger: Timer 0A's period alternates between the two cycle counts either side of clock / rate, so rates
+// that do not divide the clock (44100 Hz, say) come out exact instead of drifting; "rate" shows the periods and jitter
+static tRateGen g_sSampleClock = { TIMER0_BASE, TIMER_A, INT_TIMER0A, 65536 };
+#ifndef TELEMETRY_STREAM
+static uint32_t g_ui32ReportBlocks;
+#endif
+
+// Flash log of packed blocks; "log on" starts recording, "log dump" plays it back as telemetry frames
+static uint32_t UptimeMs(void);
+static tFlashLog g_sFlashLog;
+static tFlashLogStage g_sLogStage = { &g_sFlashLog, UptimeMs, false };
+static tFlashLogCursor g_sDumpCursor;
+static uint32_t g_ui32DumpStart, g_ui32DumpEnd;  // log times to dump
+static bool g_bDumping, g_bDumpResume;  // dump in progress; recording to resume afterwards
+
+// SD card on SSI0 (PA2 clock, PA3 chip select, PA4 MISO, PA5 MOSI); "sd on" records every block to it
+static const tSSIDMA g_sSDBus = { SSI0_BASE, UDMA_CHANNEL_SSI0RX, UDMA_CHANNEL_SSI0TX, GPIO_PORTA_BASE, GPIO_PIN_3 };
+static tSDCard g_sSDCard;
+static tBlockDevice g_sSDDevice;
+static bool g_bSDCard;                  // a card answered at start-up
+static tBlkLog g_sBlkLog;
+static tBlkLogStage g_sSDStage = { &g_sBlkLog, UptimeMs, false };
+
+// Sensor bus on I2C0 (PB2 SCL, PB3 SDA, 100 kHz); the sensors are read in turn by the sensors task, "i2c" shows them
+static int32_t TMP102Convert(const uint8_t *pui8Data);
+static int32_t INA219Convert(const uint8_t *pui8Data);
+static tI2CBus g_sI2CBus = { I2C0_BASE, INT_I2C0, GPIO_PORTB_BASE, GPIO_PIN_2, GPIO_PORTB_BASE, GPIO_PIN_3, false };
+static tI2CSensor g_psSensors[] =
+{
+    { "temperature (m degC)", 0x48, 0x00, 2, TMP102Convert },   // TMP102 temperature register
+    { "bus voltage (mV)", 0x40, 0x02, 2, INA219Convert },       // INA219 bus voltage register
+};
+#define NUM_SENSORS (sizeof(g_psSensors) / sizeof(g_psSensors[0]))
+static tI2CPoller g_sSensorPoller;
+
+// Alarms on the sampled input raised by the ADC0 digital comparators, fed by sample sequence 1 from the same timer
+// trigger; no CPU time is spent per sample, only per alarm. Each trigger costs two more conversions (300 kS/s at
+// SAMPLE_RATE_MAX, within the ADC's 500 kS/s). "watch" shows them; "stream off" leaves the alarms running alone.
+static void WatchNotify(uint32_t ui32Watch, uint32_t ui32Time);
+static const tADCWatch g_psWatches[] =
+{
+    { "high", ADC_CTL_CH0, ADC_COMP_INT_HIGH_HONCE, 3300, 3500 },   // reaches 3500 counts; re-armed below 3300
+    { "low", ADC_CTL_CH0, ADC_COMP_INT_LOW_HONCE, 600, 800 }        // drops below 600 counts; re-armed at 800
+};
+#define NUM_WATCHES (sizeof(g_psWatches) / sizeof(g_psWatches[0]))
+static tADCWatcher g_sWatcher = { ADC0_BASE, 1, INT_ADC0SS1, ADC_TRIGGER_TIMER, g_psWatches, NUM_WATCHES, WatchNotify };
+static bool g_bStreaming = true;        // sample sequence 0 feeds the DMA blocks
+static uint32_t g_ui32SamplePeriod;     // cycles between samples, for the block time stamps
+
+// Oscilloscope-style capture: a window of samples around a trigger, taken from the blocks before they are packed and
+// sent on TELEMETRY_CHANNEL_CAPTURE (tools/telemetry_rx.py --capture). The trigger is a level or edge in the samples,
+// an ADC comparator alarm or SW1 (PF4); "capture" arms it, and it re-arms itself once each window is sent.
+#define CAPTURE_SOURCE_ALARM 0
+#define CAPTURE_SOURCE_BUTTON 1
+static uint16_t g_pui16CaptureHistory[CAPTURE_HISTORY];
+static tCapture g_sCapture = { g_pui16CaptureHistory, CAPTURE_HISTORY, CAPTURE_PRE, CAPTURE_HISTORY - CAPTURE_PRE, TELEMETRY_CHANNEL_CAPTURE };
+static volatile uint32_t g_ui32CaptureSource;   // which event feeds an external trigger
+
+// Processing chain for every ADC block; stages run in this order from the main loop
+#ifdef DUAL_ADC
+static uint32_t StagePower(void *pvState, tPipeBlock *psBlock);
+#endif
+static uint8_t g_pui8PackScratch[PACK_12BIT_SIZE(BUFFER_SIZE)];
+// Conditioning after capture (which wants the raw input), all off by default: a low-pass filter, decimation by a
+// boxcar mean, and a gate that drops blocks whose samples all lie within "gate" counts of mid-scale
+static tPipeFilter g_sFilter;
+static tPipeDecimate g_sDecimate;
+static tPipeThreshold g_sGate;
+static uint32_t g_ui32Gate;
+static tPackStage g_sPackStage = { PACK_MODE_RICE, g_pui8PackScratch, sizeof(g_pui8PackScratch) };
+#ifdef TELEMETRY_STREAM
+static tTelemetryStage g_sTelemetryStage = { TELEMETRY_CHANNEL_ADC };
+static tTelemetryTimeStage g_sTimeStage = { TELEMETRY_CHANNEL_TIME };  // clock filled in at start-up
+static tPipeStage g_psStages[] =
+{
+    { "capture     ", CaptureStage, &g_sCapture },
+    { "time        ", TelemetryStageTime, &g_sTimeStage },      // every block, at the length it was taken
+#ifdef DUAL_ADC
+    { "power       ", StagePower, 0 },
+#endif
+    { "filter      ", PipeStageFilter, &g_sFilter },
+    { "decimate    ", PipeStageDecimate, &g_sDecimate },
+    { "gate        ", PipeStageThreshold, &g_sGate },
+    { "pack        ", PipeStagePack, &g_sPackStage },
+    { "log         ", FlashLogStageWrite, &g_sLogStage },
+    { "sd          ", BlkLogStageWrite, &g_sSDStage },
+    { "transmit    ", TelemetryStageSend, &g_sTelemetryStage }
+};
+#else
+static uint32_t StageCount(void *pvState, tPipeBlock *psBlock);
+static uint32_t StageAverage(void *pvState, tPipeBlock *psBlock);
+static uint32_t StageDisplay(void *pvState, tPipeBlock *psBlock);
+static uint32_t ui32AveData[2];         // means of the latest even and odd blocks
+static uint32_t ui32SamplesTaken = 0;
+static tPipeStage g_psStages[] =
+{
+    { "capture     ", CaptureStage, &g_sCapture },
+    { "count       ", StageCount, &ui32SamplesTaken },         // every block, at the length it was taken
+#ifdef DUAL_ADC
+    { "power       ", StagePower, 0 },
+#endif
+    { "filter      ", PipeStageFilter, &g_sFilter },
+    { "decimate    ", PipeStageDecimate, &g_sDecimate },
+    { "gate        ", PipeStageThreshold, &g_sGate },
+    { "average     ", StageAverage, ui32AveData },
+    { "display     ", StageDisplay, ui32AveData },
+    { "pack        ", PipeStagePack, &g_sPackStage },   // in place, so after the stages that read samples
+    { "log         ", FlashLogStageWrite, &g_sLogStage },
+    { "sd          ", BlkLogStageWrite, &g_sSDStage }
+};
+#endif
+#define NUM_STAGES (sizeof(g_psStages) / sizeof(g_psStages[0]))
+static tPipeline g_sPipeline;
+
+// Tasks sharing the MCU, highest priority first.  The sensor poll and the heartbeat are posted by SysTick and run
+// from PendSV, so they keep time however long a block takes; the pipeline runs from the main loop, once per DMA block.
+// Only the main loop tasks may print.  "stats" shows what each task costs.
+#define TASK_EVENT_TICK 0
+#define TASK_EVENT_BLOCK 1          // a block was filled (or overwritten, if the pipeline is behind)
+#define TASK_EVENT_RETRY 2          // a stalled stage's service has run
+static void TaskSensors(void *pvState, uint32_t ui32Event);
+static void TaskHeartbeat(void *pvState, uint32_t ui32Event);
+static void TaskAlarms(void *pvState, uint32_t ui32Event);
+static void TaskPipeline(void *pvState, uint32_t ui32Event);
+static tLFSlot g_psSensorEvents[2];     // queue depths are powers of two
+static tLFSlot g_psHeartbeatEvents[2];
+static tLFSlot g_psAlarmEvents[ADC_WATCH_QUEUE_DEPTH];
+static tLFSlot g_psPipelineEvents[8];   // at least SAMPLE_BLOCKS
+static tSchedTask g_psTasks[] =
+{
+    { "sensors", TaskSensors, &g_sSensorPoller, g_psSensorEvents, 2 },
+    { "heartbeat", TaskHeartbeat, 0, g_psHeartbeatEvents, 2 },
+    { "alarms", TaskAlarms, &g_sWatcher, g_psAlarmEvents, ADC_WATCH_QUEUE_DEPTH },
+    { "pipeline", TaskPipeline, &g_sPipeline, g_psPipelineEvents, 8 }
+};
+#define NUM_TASKS (sizeof(g_psTasks) / sizeof(g_psTasks[0]))
+#define NUM_DEFERRED_TASKS 2
+#define TASK_SENSORS (&g_psTasks[0])
+#define TASK_HEARTBEAT (&g_psTasks[1])
+#define TASK_ALARMS (&g_psTasks[2])
+#define TASK_PIPELINE (&g_psTasks[3])
+static volatile uint32_t g_ui32Ticks;   // SysTick interrupts since the tasks started
+#ifdef KERNEL_THREADS
+#pragma DATA_ALIGN(g_pui32MainStack, 8)
+static uint32_t g_pui32MainStack[MAIN_THREAD_STACK / 4];
+static tThread g_sMainThread;
+#endif
+
+// Parameters that can be tuned from the console and saved; ids are the keys in EEPROM and are never reused
+static void SampleRateApply(void);
+static void FilterApply(void);
+static void GateApply(void);
+static const tParam g_psParams[] =
+{
+    { 1, PARAM_TYPE_U32, "rate", &g_ui32SampleRate, SAMPLE_RATE_MIN, SAMPLE_RATE_MAX, SAMPLE_RATE, SampleRateApply },
+    { 2, PARAM_TYPE_U32, "pack", &g_sPackStage.ui32Mode, PACK_MODE_NONE, PACK_MODE_VARINT, PACK_MODE_RICE, 0 },
+#ifndef TELEMETRY_STREAM
+    { 3, PARAM_TYPE_U32, "report", &g_ui32ReportBlocks, 0, 65535, REPORT_BLOCKS, 0 },     // 0 turns the report off
+#endif
+    { 4, PARAM_TYPE_U32, "filter", &g_sFilter.ui32Shift, 0, 8, 0, FilterApply },      // y += (x - y) / 2^filter; 0 is off
+    { 5, PARAM_TYPE_U32, "decimate", &g_sDecimate.ui32Factor, 1, 16, 1, 0 },           // 1 is off
+    { 6, PARAM_TYPE_U32, "gate", &g_ui32Gate, 0, 2047, 0, GateApply },                 // 0 is off
+};
+#define NUM_PARAMS (sizeof(g_psParams) / sizeof(g_psParams[0]))
+#define PARAM_RATE (&g_psParams[0])
+#define PARAM_PACK (&g_psParams[1])
+
+// Console commands, run from the main loop by ShellPoll()
+static int CmdRate(int argc, char *argv[]);
+static int CmdStats(int argc, char *argv[]);
+static int CmdParam(int argc, char *argv[]);
+static int CmdSave(int argc, char *argv[]);
+static int CmdDefaults(int argc, char *argv[]);
+static int CmdPack(int argc, char *argv[]);
+static int CmdLog(int argc, char *argv[]);
+static int CmdSD(int argc, char *argv[]);
+static int CmdI2C(int argc, char *argv[]);
+static int CmdIrq(int argc, char *argv[]);
+static int CmdWatch(int argc, char *argv[]);
+static int CmdStream(int argc, char *argv[]);
+static int CmdCapture(int argc, char *argv[]);
+static int CmdDMA(int argc, char *argv[]);
+#ifdef DUAL_ADC
+static int CmdPower(int argc, char *argv[]);
+#endif
+#ifdef KERNEL_THREADS
+static int CmdKernel(int argc, char *argv[]);
+#endif
+static const tShellCommand g_psCommands[] =
+{
+    { "help",  ShellCmdHelp, ": list the commands" },
+    { "rate",  CmdRate,      " [Hz]: show or set the ADC sample rate" },
+    { "stats", CmdStats,     ": pipeline, pool and stack statistics" },
+    { "param", CmdParam,     " [name [value]]: show or set parameters" },
+    { "save",  CmdSave,      ": save the parameters to EEPROM" },
+    { "defaults", CmdDefaults, ": restore the default parameters (save to keep them)" },
+    { "pack",  CmdPack,      " [none|12bit|rice|varint]: show or set the block coding" },
+    { "log",   CmdLog,       " [on|off|dump [from_ms [to_ms]]]: flash log status, recording, playback" },
+    { "sd",    CmdSD,        " [on|off|format]: SD card log status, recording, erase" },
+    { "i2c",   CmdI2C,       ": sensor bus statistics and the latest readings" },
+    { "irq",   CmdIrq,       " [on|off]: interrupt priorities, critical-section timing" },
+    { "watch", CmdWatch,     " [on|off]: ADC comparator alarms" },
+    { "stream", CmdStream,   " [on|off]: ADC sample blocks (the alarms carry on without them)" },
+    { "capture", CmdCapture, " [off|above|rising|falling level|alarm|button]: triggered capture" },
+    { "dma",   CmdDMA,       ": uDMA channel plan, transfers and errors" },
+#ifdef DUAL_ADC
+    { "power", CmdPower,     ": power and phase of AIN0 and AIN1, and what the stage costs" },
+#endif
+#ifdef KERNEL_THREADS
+    { "kernel", CmdKernel,   " [bench]: threads and switch cost" },
+#endif
+    { 0, 0, 0 }
+};
 
 
 void
@@ -79,7 +486,196 @@ ConfigureUART(void)
     //
     // Initialize the UART for console I/O.
     //
-    UARTStdioConfig(0, 115200, 16000000);
+    UARTStdioConfig(0, CONSOLE_BAUD, 16000000);
+}
+
+
+/**
+ * Brings up SSI0 and looks for an SD card, then for a log on it.  Needs the uDMA controller running.
+ */
+static void
+ConfigureSD(void)
+{
+    MAP_GPIOPinConfigure(GPIO_PA2_SSI0CLK);
+    MAP_GPIOPinConfigure(GPIO_PA4_SSI0RX);
+    MAP_GPIOPinConfigure(GPIO_PA5_SSI0TX);
+    MAP_GPIOPinTypeSSI(GPIO_PORTA_BASE, GPIO_PIN_2 | GPIO_PIN_4 | GPIO_PIN_5);
+    MAP_GPIOPadConfigSet(GPIO_PORTA_BASE, GPIO_PIN_4, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);   // reads 0xFF with no card
+
+    g_bSDCard = SDCardInit(&g_sSDCard, &g_sSDBus, &g_sSDDevice);
+    BlkLogMount(&g_sBlkLog, g_bSDCard ? &g_sSDDevice : 0);
+}
+
+
+/**
+ * Brings up I2C0 for the sensor bus and starts polling the sensors.
+ */
+static void
+ConfigureI2C(void)
+{
+    MAP_GPIOPinConfigure(GPIO_PB2_I2C0SCL);
+    MAP_GPIOPinConfigure(GPIO_PB3_I2C0SDA);
+    MAP_GPIOPinTypeI2CSCL(GPIO_PORTB_BASE, GPIO_PIN_2);
+    MAP_GPIOPinTypeI2C(GPIO_PORTB_BASE, GPIO_PIN_3);
+
+    I2CBusInit(&g_sI2CBus);
+    I2CPollInit(&g_sSensorPoller, &g_sI2CBus, g_psSensors, NUM_SENSORS, I2C_POLL_PER_TICK);
+}
+
+/**
+ * I2C0 Interrupt Handler: one per byte on the bus
+ */
+void
+I2C0IntHandler(void)
+{
+    I2CBusIntHandler(&g_sI2CBus);
+}
+
+/**
+ * Starts the SysTick that paces the deferred tasks, and the LED (PF3, green) the heartbeat blinks
+ */
+static void
+ConfigureTasks(void)
+{
+    MAP_GPIOPinTypeGPIOOutput(GPIO_PORTF_BASE, GPIO_PIN_3);
+    MAP_SysTickPeriodSet(SysCtlClockGet() / TICK_HZ);
+    MAP_SysTickIntEnable();
+    MAP_SysTickEnable();
+}
+
+/**
+ * Makes SW1 (PF4, to ground when pressed) interrupt on the press, as a capture trigger
+ */
+static void
+ConfigureButton(void)
+{
+    MAP_GPIOPinTypeGPIOInput(GPIO_PORTF_BASE, GPIO_PIN_4);
+    MAP_GPIOPadConfigSet(GPIO_PORTF_BASE, GPIO_PIN_4, GPIO_STRENGTH_2MA, GPIO_PIN_TYPE_STD_WPU);
+    MAP_GPIOIntTypeSet(GPIO_PORTF_BASE, GPIO_PIN_4, GPIO_FALLING_EDGE);
+    MAP_GPIOIntClear(GPIO_PORTF_BASE, GPIO_INT_PIN_4);
+    MAP_GPIOIntEnable(GPIO_PORTF_BASE, GPIO_INT_PIN_4);
+    MAP_IntEnable(INT_GPIOF);
+}
+
+/**
+ * SysTick Handler: posts the periodic task events and leaves the work to them
+ */
+void
+SysTickHandler(void)
+{
+    g_ui32Ticks++;
+#ifdef KERNEL_THREADS
+    KernelTick();
+#endif
+#ifdef DMA_SCATTER_GATHER
+    SampleRingPoll();
+#endif
+    if((g_ui32Ticks % I2C_POLL_MS) == 0)
+    {
+        SchedPost(TASK_SENSORS, TASK_EVENT_TICK);
+    }
+    if((g_ui32Ticks % HEARTBEAT_MS) == 0)
+    {
+        SchedPost(TASK_HEARTBEAT, TASK_EVENT_TICK);
+    }
+}
+
+/**
+ * Task (PendSV): recover a stuck sensor bus, then queue the next reads; the transfers run from the I2C0 interrupt
+ */
+static void
+TaskSensors(void *pvState, uint32_t ui32Event)
+{
+    I2CBusService(&g_sI2CBus, g_ui32Ticks);     // ticks are milliseconds
+    I2CPollTick(pvState);
+}
+
+/**
+ * Task (PendSV): toggle the green LED
+ */
+static void
+TaskHeartbeat(void *pvState, uint32_t ui32Event)
+{
+    MAP_GPIOPinWrite(GPIO_PORTF_BASE, GPIO_PIN_3, MAP_GPIOPinRead(GPIO_PORTF_BASE, GPIO_PIN_3) ^ GPIO_PIN_3);
+}
+
+/**
+ * ADC0 SS1 Interrupt Handler: a digital comparator fired
+ */
+void
+ADCSeq1Handler(void)
+{
+    ADCWatchIntHandler(&g_sWatcher);
+}
+
+/**
+ * GPIO Port F Interrupt Handler: SW1 was pressed; the time is taken first, for the capture trigger
+ */
+void
+GPIOFIntHandler(void)
+{
+    uint32_t ui32Time = CycleCountGet();
+
+    MAP_GPIOIntClear(GPIO_PORTF_BASE, GPIO_INT_PIN_4);
+    if(g_ui32CaptureSource == CAPTURE_SOURCE_BUTTON)
+    {
+        CaptureTrigger(&g_sCapture, ui32Time);
+    }
+}
+
+/**
+ * Called by ADCWatchIntHandler() for each alarm: the alarms task prints it, and it may trigger a capture
+ */
+static void
+WatchNotify(uint32_t ui32Watch, uint32_t ui32Time)
+{
+    if(g_ui32CaptureSource == CAPTURE_SOURCE_ALARM)
+    {
+        CaptureTrigger(&g_sCapture, ui32Time);
+    }
+    SchedPost(TASK_ALARMS, ui32Watch);
+}
+
+/**
+ * Task (main loop): report the alarms, with how long after the comparator fired they got here
+ */
+static void
+TaskAlarms(void *pvState, uint32_t ui32Event)
+{
+    tADCWatchEvent sEvent;
+
+    while(ADCWatchEventGet(pvState, &sEvent))
+    {
+        UARTprintf("\nADC alarm \"%s\", %d us ago\n", g_psWatches[sEvent.ui32Watch].pcName,
+                   (CycleCountGet() - sEvent.ui32Time) / (SysCtlClockGet() / 1000000));
+    }
+}
+
+/**
+ * Task (main loop): pass the queued blocks through the stages
+ */
+static void
+TaskPipeline(void *pvState, uint32_t ui32Event)
+{
+    PipelineRun(pvState);
+}
+
+/**
+ * TMP102 temperature: 12 bits left aligned, 0.0625 degC per count; returned in m degC
+ */
+static int32_t
+TMP102Convert(const uint8_t *pui8Data)
+{
+    return((((int16_t)((pui8Data[0] << 8) | pui8Data[1]) >> 4) * 625) / 10);
+}
+
+/**
+ * INA219 bus voltage: bits 15-3, 4 mV per count
+ */
+static int32_t
+INA219Convert(const uint8_t *pui8Data)
+{
+    return((((pui8Data[0] << 8) | pui8Data[1]) >> 3) * 4);
 }
 
 
@@ -104,7 +700,69 @@ uDMAErrorHandler(void)
     {
         uDMAErrorStatusClear();
         g_ui32DMAErrCount++;
+        DMAMgrErrorAccount();   // charge it to the channel it stopped
+    }
+}
+
+/**
+ * Publishes the block counts for "stats" and wakes the pipeline task
+ */
+static void
+SampleStatusPublish(void)
+{
+    SeqLockWriteBegin(&g_sSampleStatusLock);
+    g_pui32SampleStatus[SAMPLE_STATUS_BLOCKS] = g_ui32BlockSeq;
+    g_pui32SampleStatus[SAMPLE_STATUS_OVERRUNS] = g_ui32Overruns;
+    g_pui32SampleStatus[SAMPLE_STATUS_MISSED] = g_ui32Missed;
+    SeqLockWriteEnd(&g_sSampleStatusLock);
+    SchedPost(TASK_PIPELINE, TASK_EVENT_BLOCK);
+}
+
+/**
+ * Hands a filled DMA block to the pipeline and re-arms that half of the ping-pong with a fresh block
+ */
+static void
+SampleBlockDone(uint32_t ui32Half)
+{
+    tPipeBlock *psBlock = g_ppsDMABlock[ui32Half];
+    tPipeBlock *psNext;
+
+    psBlock->ui32Length = BUFFER_SIZE;
+    psBlock->ui32Seq = g_ui32BlockSeq++;
+    psBlock->ui32Missed = g_ui32Missed;
+
+    //
+    // Time stamp the block's last sample: now, less the samples DMA has
+    // already put in the other half, so a late interrupt does not skew it.
+    //
+    psBlock->ui32Time = CycleCountGet() -
+                        ((BUFFER_SIZE - uDMAChannelSizeGet(UDMA_CHANNEL_ADC0 |
+                                                           (ui32Half ? UDMA_PRI_SELECT : UDMA_ALT_SELECT))) *
+                         g_ui32SamplePeriod);
+
+    //
+    // If there is no free block or the pipeline queue is full, the pipeline
+    // is behind: keep the block and let DMA overwrite it.
+    //
+    psNext = PipeBlockAlloc(&g_sSamplePool, PIPE_FORMAT_SAMPLES16);
+    if(psNext && PipelineSubmit(&g_sPipeline, psBlock))
+    {
+        g_ppsDMABlock[ui32Half] = psNext;
     }
+    else
+    {
+        if(psNext)
+        {
+            PipeBlockRelease(psNext);
+        }
+        g_ui32Overruns++;
+    }
+    SampleStatusPublish();
+
+    DMAMgrTransferSet(UDMA_CHANNEL_ADC0 | (ui32Half ? UDMA_ALT_SELECT : UDMA_PRI_SELECT),
+                      UDMA_MODE_PINGPONG,
+                      (void *)(ADC0_BASE + ADC_O_SSFIFO0),
+                      g_ppsDMABlock[ui32Half]->pvData, BUFFER_SIZE);
 }
 
 /**
@@ -117,163 +775,1180 @@ ADCSeq0Handler(void)
     // Clear the Interrupt Flag.
     //
     ADCIntClear(ADC0_BASE, 0);
+    StackMonitorSample(STACK_CONTEXT_ADC);
 
     //
-    // Determine which buffer as been filled based on the UDMA_MODE_STOP flag
-    // and update the buffer status.
+    // The FIFO overflows when DMA has fallen behind the triggers, losing at
+    // least one conversion; counting here charges it to the block that
+    // completes now, close to where the samples went missing.
     //
-    if ((uDMAChannelModeGet(UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT) ==
-                               UDMA_MODE_STOP) &&
-                              (pui32BufferStatus[0] == FILLING))
-   {
-       pui32BufferStatus[0] = FULL;
-       pui32BufferStatus[1] = FILLING;
-   }
-   else if ((uDMAChannelModeGet(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT) ==
-                                UDMA_MODE_STOP) &&
-                               (pui32BufferStatus[1] == FILLING))
-   {
-       pui32BufferStatus[0] = FILLING;
-       pui32BufferStatus[1] = FULL;
-   }
-}
-
+    if(ADCSequenceOverflow(ADC0_BASE, 0))
+    {
+        ADCSequenceOverflowClear(ADC0_BASE, 0);
+        g_ui32Missed++;
+    }
 
+    //
+    // A half whose mode has gone to UDMA_MODE_STOP is full.  Halves complete
+    // alternately, so check the one expected next first; if this interrupt
+    // was late, both may be done.
+    //
+    while(uDMAChannelModeGet(UDMA_CHANNEL_ADC0 |
+                             (g_ui32FillHalf ? UDMA_ALT_SELECT : UDMA_PRI_SELECT)) ==
+          UDMA_MODE_STOP)
+    {
+        SampleBlockDone(g_ui32FillHalf);
+        g_ui32FillHalf ^= 1;
+        BootTimeMark(BOOT_PHASE_FIRST_BLOCK);
+    }
+}
 
+#ifdef DMA_SCATTER_GATHER
 /**
- * main.c
+ * Builds the looping task list that fills the ring's blocks in turn and starts WTIMER0 A free-running for its time
+ * stamps; the ADC sequence must not be triggered yet
  */
-void main(void)
+static void
+ConfigureSampleRing(void)
 {
-    /**
-     * Application:
-     * We will enable DMA controller to manage ADC data
-     * and store them into memory
-     *
-     * Note: cannot use debugger to view data because DMA runs separately from processor (debugger is based on processor)
-     *
-     */
-
-    // LOCAL VARIABLES
-    uint32_t ui32AveData1, ui32AveData2, ui32Count;
-    uint32_t ui32SamplesTaken = 0;
-    pui32BufferStatus[0] = FILLING;
-    pui32BufferStatus[1] = EMPTY;
+    MAP_TimerConfigure(WTIMER0_BASE, TIMER_CFG_SPLIT_PAIR | TIMER_CFG_A_PERIODIC_UP);
+    MAP_TimerLoadSet(WTIMER0_BASE, TIMER_A, 0xFFFFFFFF);
+    MAP_TimerEnable(WTIMER0_BASE, TIMER_A);
+    g_ui32RingTimeOffset = CycleCountGet() - MAP_TimerValueGet(WTIMER0_BASE, TIMER_A);
 
-    // A. System level configuration
-    // 1. Setup system clock
-    MAP_SysCtlClockSet( SYSCTL_OSC_MAIN | SYSCTL_XTAL_16MHZ | SYSCTL_USE_PLL | SYSCTL_SYSDIV_5 ); // Use MOSC to drive 400MHz PLL. The use sysdiv5 to apply a /10 divisor and finally generating a 40MHz clock signal.
+    //
+    // Per block: the samples, paced by the ADC; then, straight after the last
+    // one, the timer count into the block's time slot and the slot number
+    // into the ring's status word.  The last task restarts the list.
+    //
+    SampleRingInit(&g_sSampleRing, (void *)(ADC0_BASE + ADC_O_SSFIFO0), BUFFER_SIZE,
+                   (void *)(WTIMER0_BASE + TIMER_O_TAV));
 
-    // 2. Enable GPIO first (ADC channel 0 is located at PE3)
-    MAP_SysCtlPeripheralEnable( SYSCTL_PERIPH_GPIOE );
-    while( !MAP_SysCtlPeripheralReady( SYSCTL_PERIPH_GPIOE )) {}
+    uDMAChannelAttributeDisable(UDMA_CHANNEL_ADC0, UDMA_ATTR_ALTSELECT | UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);
+    uDMAChannelAttributeEnable(UDMA_CHANNEL_ADC0, UDMA_ATTR_USEBURST);
+    DMASeqStart(&g_sRingSeq);
+}
 
-    // 3. Enable the ADC0 module
-    MAP_SysCtlPeripheralEnable(SYSCTL_PERIPH_ADC0);
-    while( !MAP_SysCtlPeripheralReady( SYSCTL_PERIPH_ADC0 )) {}
+/**
+ * Called from SysTick: lends the blocks the uDMA has filled since the last call to the pipeline.  A block that cannot
+ * be lent (no free block to take its slot, or the uDMA has come round to it again) is counted as an overrun
+ */
+static void
+SampleRingPoll(void)
+{
+    uint32_t ui32Time, ui32Slots, ui32Blocks, ui32BlockCycles;
+    tPipeBlock *psBlock;
 
-    // 4. Enable the DMA peripheral
-    MAP_SysCtlPeripheralEnable( SYSCTL_PERIPH_UDMA );
-    while( !MAP_SysCtlPeripheralReady( SYSCTL_PERIPH_UDMA )) {}
+    ui32Slots = SampleRingFilled(&g_sSampleRing, &ui32Time);
+    if(g_ui32BlockSeq == 0)
+    {
+        if(ui32Slots == 0)
+        {
+            return;
+        }
+        ui32Blocks = ui32Slots;
+    }
+    else
+    {
+        if(ui32Time == g_ui32RingLastTime)
+        {
+            return;
+        }
 
-    // 5. Enable the timer peripheral
-    MAP_SysCtlPeripheralEnable( SYSCTL_PERIPH_TIMER0 );
-    while( !MAP_SysCtlPeripheralReady( SYSCTL_PERIPH_TIMER0 )) {}
+        //
+        // Count the blocks from the time stamps too, so that laps of the ring
+        // that went by unseen (SysTick held off, say) still advance the block
+        // numbers, as blocks overwritten.
+        //
+        ui32BlockCycles = BUFFER_SIZE * g_ui32SamplePeriod;
+        ui32Blocks = (ui32Time - g_ui32RingLastTime + (ui32BlockCycles / 2)) / ui32BlockCycles;
+        if(ui32Slots == 0)
+        {
+            ui32Slots = RING_BLOCKS;
+        }
+        if(ui32Blocks < ui32Slots)
+        {
+            ui32Blocks = ui32Slots;
+        }
+    }
+    g_ui32RingLastTime = ui32Time;
+    g_ui32Overruns += ui32Blocks - ui32Slots;
+    g_ui32BlockSeq += ui32Blocks - ui32Slots;
 
-    // Optional: Configure UART for demo
-    ConfigureUART();
-    UARTprintf("\nTimer->ADC->uDMA demo!\n\n");
-    UARTprintf("ui32AveData1\tui32AveData2\tTotal Samples\n");
+    if(ADCSequenceOverflow(ADC0_BASE, 0))
+    {
+        ADCSequenceOverflowClear(ADC0_BASE, 0);
+        g_ui32Missed++;
+    }
 
-    // B. Peripheral level configuration
-    // 5. Configure PE3 to use its ADC function
-    MAP_GPIOPinTypeADC( GPIO_PORTE_BASE, GPIO_PIN_3 );
+    while(ui32Slots--)
+    {
+        psBlock = SampleRingLend(&g_sSampleRing, &ui32Time);
+        if(psBlock)
+        {
+            psBlock->ui32Length = BUFFER_SIZE;
+            psBlock->ui32Seq = g_ui32BlockSeq;
+            psBlock->ui32Time = ui32Time + g_ui32RingTimeOffset;
+            psBlock->ui32Missed = g_ui32Missed;
+            if(!PipelineSubmit(&g_sPipeline, psBlock))
+            {
+                PipeBlockRelease(psBlock);
+                g_ui32Overruns++;
+            }
+        }
+        else
+        {
+            g_ui32Overruns++;
+        }
+        DMAMgrAccount(UDMA_CHANNEL_ADC0, BUFFER_SIZE);     // the task list reloads itself, unseen by dmamgr
+        g_ui32BlockSeq++;
+    }
 
-    // 6. Configure ADC0 SS0
-    ADCClockConfigSet( ADC0_BASE, ADC_CLOCK_SRC_PIOSC | ADC_CLOCK_RATE_HALF , 1 );
-    SysCtlDelay(10);
+    SampleStatusPublish();
+    BootTimeMark(BOOT_PHASE_FIRST_BLOCK);
+}
+#endif
 
-    IntDisable(INT_ADC0SS0);
-    IntRegister(INT_ADC0SS0, ADCSeq0Handler);
-    ADCIntDisable(ADC0_BASE, 0);
-    ADCSequenceDisable(ADC0_BASE, 0);
-    MAP_ADCSequenceConfigure( ADC0_BASE, 0, ADC_TRIGGER_TIMER, 0 );
-    MAP_ADCSequenceStepConfigure( ADC0_BASE, 0, 0, ADC_CTL_IE | ADC_CTL_END | ADC_CTL_CH0 );
-    MAP_ADCSequenceEnable( ADC0_BASE, 0 );
-    ADCIntClear(ADC0_BASE, 0);
+#ifdef DUAL_ADC
+/**
+ * Sets up ADC1 SS0 to convert AIN1 on every timer trigger and DMA the results into the first two slots of the ring;
+ * must be done before the timer starts, so the block numbers of the two ADCs stay in step
+ */
+static void
+ConfigurePairADC(void)
+{
+    uint32_t ui32Slot;
 
-    // 7. Configure uDMA controller
-    MAP_uDMAEnable();
-    uDMAControlBaseSet( pui8DMAControlTable );
-    uDMAChannelAttributeDisable( UDMA_CHANNEL_ADC0 , UDMA_ATTR_ALTSELECT | UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK );
-    uDMAChannelControlSet( UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT , UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 | UDMA_ARB_1 );
-    uDMAChannelControlSet(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT, UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 | UDMA_ARB_1);
-    uDMAChannelTransferSet(UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT,
-                               UDMA_MODE_PINGPONG,
-                               (void *)(ADC0_BASE + ADC_O_SSFIFO0),
-                               &pui16ADCBuffer1, BUFFER_SIZE);
-    uDMAChannelTransferSet(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT,
-                               UDMA_MODE_PINGPONG,
-                               (void *)(ADC0_BASE + ADC_O_SSFIFO0),
-                               &pui16ADCBuffer2, BUFFER_SIZE);
-    uDMAChannelAttributeEnable( UDMA_CHANNEL_ADC0 , UDMA_ATTR_USEBURST );
-    uDMAChannelEnable(UDMA_CHANNEL_ADC0);
+    for(ui32Slot = 0; ui32Slot < PAIR_RING_BLOCKS; ui32Slot++)
+    {
+        g_pui32PairSeq[ui32Slot] = PAIR_SLOT_EMPTY;
+    }
 
-    // 8. Wrap up ADC-DMA configuration (enabling adc interrupt after dma is configured)
-    ADCSequenceDMAEnable(ADC0_BASE, 0);
-    ADCIntEnable(ADC0_BASE, 0);
-    IntEnable(INT_ADC0SS0);
+    MAP_GPIOPinTypeADC(GPIO_PORTE_BASE, GPIO_PIN_2);
+    ADCClockConfigSet(ADC1_BASE, ADC_CLOCK_SRC_PIOSC | ADC_CLOCK_RATE_HALF, 1);     // as ADC0, so both convert in step
+    ADCSequenceDisable(ADC1_BASE, 0);
+    MAP_ADCSequenceConfigure(ADC1_BASE, 0, ADC_TRIGGER_TIMER, 0);
+    MAP_ADCSequenceStepConfigure(ADC1_BASE, 0, 0, ADC_CTL_IE | ADC_CTL_END | ADC_CTL_CH1);
+    MAP_ADCSequenceEnable(ADC1_BASE, 0);
+    ADCIntClear(ADC1_BASE, 0);
 
-    // 9. Configure Timer for ADC sampling
-    TimerConfigure(TIMER0_BASE,TIMER_CFG_SPLIT_PAIR | TIMER_CFG_A_PERIODIC);
-    TimerLoadSet(TIMER0_BASE, TIMER_A, (SysCtlClockGet()/16000) - 1);
-    TimerControlTrigger(TIMER0_BASE, TIMER_A, true);
-    IntMasterEnable();
-    TimerEnable(TIMER0_BASE, TIMER_A);
+    uDMAChannelAttributeDisable(UDMA_SEC_CHANNEL_ADC10, UDMA_ATTR_ALTSELECT | UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);
+    uDMAChannelControlSet(UDMA_SEC_CHANNEL_ADC10 | UDMA_PRI_SELECT, UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 | UDMA_ARB_1);
+    uDMAChannelControlSet(UDMA_SEC_CHANNEL_ADC10 | UDMA_ALT_SELECT, UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 | UDMA_ARB_1);
+    DMAMgrTransferSet(UDMA_SEC_CHANNEL_ADC10 | UDMA_PRI_SELECT, UDMA_MODE_PINGPONG,
+                      (void *)(ADC1_BASE + ADC_O_SSFIFO0), g_ppui16PairRing[0], BUFFER_SIZE);
+    DMAMgrTransferSet(UDMA_SEC_CHANNEL_ADC10 | UDMA_ALT_SELECT, UDMA_MODE_PINGPONG,
+                      (void *)(ADC1_BASE + ADC_O_SSFIFO0), g_ppui16PairRing[1], BUFFER_SIZE);
+    uDMAChannelAttributeEnable(UDMA_SEC_CHANNEL_ADC10, UDMA_ATTR_USEBURST);
+    uDMAChannelEnable(UDMA_SEC_CHANNEL_ADC10);
 
+    ADCSequenceDMAEnable(ADC1_BASE, 0);
+    ADCIntEnable(ADC1_BASE, 0);
+    IntEnable(INT_ADC1SS0);
+}
 
+/**
+ * ISR for ADC1 SS0: numbers and time stamps the filled slot, and re-arms that half two slots on
+ */
+void
+ADC1Seq0Handler(void)
+{
+    uint32_t ui32Select, ui32Slot;
 
-    while(1) {
-        if(pui32BufferStatus[0] == FULL){
-            //process data
-            for(ui32Count = 0; ui32Count < BUFFER_SIZE; ui32Count++){
-                ui32AveData1 += pui16ADCBuffer1[ui32Count];
-                pui16ADCBuffer1[ui32Count] = 0;
-            }
+    ADCIntClear(ADC1_BASE, 0);
 
-            pui32BufferStatus[0] = EMPTY;
-            uDMAChannelTransferSet(UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT,
-                                              UDMA_MODE_PINGPONG,
-                                              (void *)(ADC0_BASE + ADC_O_SSFIFO0),
-                                              &pui16ADCBuffer1, BUFFER_SIZE);
-            uDMAChannelEnable(UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT);
+    ui32Select = g_ui32PairFillHalf ? UDMA_ALT_SELECT : UDMA_PRI_SELECT;
+    while(uDMAChannelModeGet(UDMA_SEC_CHANNEL_ADC10 | ui32Select) == UDMA_MODE_STOP)
+    {
+        ui32Slot = g_ui32PairBlocks % PAIR_RING_BLOCKS;
+        g_pui32PairTime[ui32Slot] = CycleCountGet() -
+                                    ((BUFFER_SIZE - uDMAChannelSizeGet(UDMA_SEC_CHANNEL_ADC10 |
+                                                                       (ui32Select ^ UDMA_ALT_SELECT))) *
+                                     g_ui32SamplePeriod);
+        g_pui32PairSeq[ui32Slot] = g_ui32PairBlocks;
 
-            ui32AveData1 = ui32AveData1 / BUFFER_SIZE;
-            ui32SamplesTaken += BUFFER_SIZE;
-        }
+        ui32Slot = (g_ui32PairBlocks + 2) % PAIR_RING_BLOCKS;
+        g_pui32PairSeq[ui32Slot] = PAIR_SLOT_EMPTY;     // before DMA starts overwriting it
+        DMAMgrTransferSet(UDMA_SEC_CHANNEL_ADC10 | ui32Select, UDMA_MODE_PINGPONG,
+                          (void *)(ADC1_BASE + ADC_O_SSFIFO0), g_ppui16PairRing[ui32Slot], BUFFER_SIZE);
 
+        g_ui32PairBlocks++;
+        g_ui32PairFillHalf ^= 1;
+        ui32Select ^= UDMA_ALT_SELECT;
+    }
+}
 
+/**
+ * Pipeline stage: power and phase of the ADC0 block and its ADC1 pair, kept for "power"
+ */
+static uint32_t
+StagePower(void *pvState, tPipeBlock *psBlock)
+{
+    uint32_t ui32Slot = psBlock->ui32Seq % PAIR_RING_BLOCKS;
+    tPowerResult sResult;
+    int32_t i32Skew;
 
-        if(pui32BufferStatus[1] == FULL){
-           //process data
-           for(ui32Count = 0; ui32Count < BUFFER_SIZE; ui32Count++){
-               ui32AveData2 += pui16ADCBuffer2[ui32Count];
-               pui16ADCBuffer2[ui32Count] = 0;
-           }
+    //
+    // The two ADCs count the same triggers, so they only slip apart if one
+    // of them loses samples; the time stamps show it.
+    //
+    if(g_pui32PairSeq[ui32Slot] != psBlock->ui32Seq)
+    {
+        g_ui32PairMissed++;
+        return(PIPE_CONTINUE);
+    }
+    i32Skew = (int32_t)(g_pui32PairTime[ui32Slot] - psBlock->ui32Time);
+    if((uint32_t)((i32Skew < 0) ? -i32Skew : i32Skew) > ((BUFFER_SIZE / 2) * g_ui32SamplePeriod))
+    {
+        g_ui32PairSkewed++;
+        return(PIPE_CONTINUE);
+    }
 
-           pui32BufferStatus[1] = EMPTY;
-           uDMAChannelTransferSet(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT,
-                                             UDMA_MODE_PINGPONG,
-                                             (void *)(ADC0_BASE + ADC_O_SSFIFO0),
-                                             &pui16ADCBuffer2, BUFFER_SIZE);
-           uDMAChannelEnable(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT);
+    PowerCompute(psBlock->pvData, g_ppui16PairRing[ui32Slot], psBlock->ui32Length, ADC_MIDSCALE, &sResult);
+    if(g_pui32PairSeq[ui32Slot] != psBlock->ui32Seq)
+    {
+        g_ui32PairMissed++;     // re-armed while it was being read
+        return(PIPE_CONTINUE);
+    }
+    g_sPower = sResult;
+    g_ui32PowerBlocks++;
 
-           ui32AveData2 = ui32AveData2 / BUFFER_SIZE;
-           ui32SamplesTaken += BUFFER_SIZE;
+    return(PIPE_CONTINUE);
+}
+#endif
 
-           UARTprintf("\t%4d\t\t%4d\t\t%d\r", ui32AveData1, ui32AveData2, ui32SamplesTaken);
+#ifndef TELEMETRY_STREAM
+/**
+ * Pipeline stage: count of the samples taken, before decimation or the gate shrink or drop any
+ */
+static uint32_t
+StageCount(void *pvState, tPipeBlock *psBlock)
+{
+    uint32_t *pui32Samples = pvState;
+
+    *pui32Samples += psBlock->ui32Length;
+
+    return(PIPE_CONTINUE);
+}
+
+/**
+ * Pipeline stage: mean of the block
+ */
+static uint32_t
+StageAverage(void *pvState, tPipeBlock *psBlock)
+{
+    uint32_t *pui32Ave = pvState;
+    uint16_t *pui16Data = psBlock->pvData;
+    uint32_t ui32Count, ui32Sum = 0;
+
+    if(psBlock->ui32Length == 0)
+    {
+        return(PIPE_DROP);
+    }
+
+    for(ui32Count = 0; ui32Count < psBlock->ui32Length; ui32Count++)
+    {
+        ui32Sum += pui16Data[ui32Count];
+    }
+    pui32Ave[psBlock->ui32Seq & 1] = ui32Sum / psBlock->ui32Length;
+
+    return(PIPE_CONTINUE);
+}
+
+/**
+ * Pipeline stage: console status line after every odd block, statistics every g_ui32ReportBlocks
+ */
+static uint32_t
+StageDisplay(void *pvState, tPipeBlock *psBlock)
+{
+    uint32_t *pui32Ave = pvState;
+    tMemPoolStats sPoolStats;
+
+    if((psBlock->ui32Seq & 1) && !ShellLineActive())    // hold the status line while a command is typed
+    {
+        StackMonitorSample(STACK_CONTEXT_MAIN);
+        MemPoolStatsGet(&g_sSamplePool, &sPoolStats);
+        UARTprintf("\t%4d\t\t%4d\t\t%d\t\t%d/%d\t\t%d\r", pui32Ave[0], pui32Ave[1], ui32SamplesTaken,
+                   sPoolStats.ui32Peak, sPoolStats.ui32Count, g_ui32Overruns);
+    }
+
+    if(g_ui32ReportBlocks && ((psBlock->ui32Seq % g_ui32ReportBlocks) == (g_ui32ReportBlocks - 1)))
+    {
+        UARTprintf("\n\n");
+        PipelineReport(&g_sPipeline);
+        UARTprintf("\nui32AveData1\tui32AveData2\tTotal Samples\tPool peak\tOverruns\n");
+    }
+
+    return(PIPE_CONTINUE);
+}
+#endif
+
+/**
+ * Timer 0A Interrupt Handler: loads the sample clock's next period (only enabled for rates that do not divide the clock)
+ */
+void
+Timer0AIntHandler(void)
+{
+    RateGenIntHandler(&g_sSampleClock);
+}
+
+/**
+ * Applies the "rate" parameter; the new timer period is loaded at the next time-out, so sampling carries on without a glitch
+ */
+static void
+SampleRateApply(void)
+{
+    g_ui32SamplePeriod = SysCtlClockGet() / g_ui32SampleRate;  // rounded down; close enough for time stamps
+    RateGenSet(&g_sSampleClock, g_ui32SampleRate, 1);
+    CaptureRateSet(&g_sCapture, g_ui32SamplePeriod);
+}
+
+/**
+ * Parameter "filter" changed: the accumulator is scaled by the old shift, so start again from the next sample
+ */
+static void
+FilterApply(void)
+{
+    g_sFilter.bPrimed = false;
+}
+
+/**
+ * Parameter "gate" changed (and at start-up): sets the quiet band around mid-scale. With a gate of 0 the band is
+ * empty (low above high), so every sample is outside it and every block passes
+ */
+static void
+GateApply(void)
+{
+    if(g_ui32Gate == 0)
+    {
+        g_sGate.ui16Low = 1;
+        g_sGate.ui16High = 0;
+    }
+    else
+    {
+        g_sGate.ui16Low = 2048 - g_ui32Gate;
+        g_sGate.ui16High = 2048 + g_ui32Gate;
+    }
+}
+
+/**
+ * Command: rate [Hz]
+ */
+static int
+CmdRate(int argc, char *argv[])
+{
+    uint32_t ui32Rate;
+    char *pcEnd;
+
+    if(argc > 2)
+    {
+        return(SHELL_TOO_MANY_ARGS);
+    }
+
+    if(argc == 2)
+    {
+        ui32Rate = strtoul(argv[1], &pcEnd, 10);
+        if(*pcEnd || !ParamSet(PARAM_RATE, ui32Rate))
+        {
+            UARTprintf("Rate must be %d to %d Hz\n", SAMPLE_RATE_MIN, SAMPLE_RATE_MAX);
+            return(SHELL_INVALID_ARG);
+        }
+    }
+
+    RateGenReport(&g_sSampleClock);     // the rate the timer achieves
+    return(0);
+}
+
+/**
+ * Command: stats
+ */
+static int
+CmdStats(int argc, char *argv[])
+{
+    tMemPoolStats sPoolStats;
+    uint32_t pui32Status[SAMPLE_STATUS_WORDS];
+#ifdef TELEMETRY_STREAM
+    tTelemetryStats sTelemStats;
+#endif
+
+    PipelineReport(&g_sPipeline);
+    MemPoolStatsGet(&g_sSamplePool, &sPoolStats);
+    while(!SeqLockRead(&g_sSampleStatusLock, g_pui32SampleStatus, pui32Status, SAMPLE_STATUS_WORDS)) {}
+    UARTprintf("Pool %d/%d blocks (peak %d), %d of %d blocks overrun, %d missed triggers, %d DMA errors\n",
+               sPoolStats.ui32InUse, sPoolStats.ui32Count, sPoolStats.ui32Peak,
+               pui32Status[SAMPLE_STATUS_OVERRUNS], pui32Status[SAMPLE_STATUS_BLOCKS],
+               pui32Status[SAMPLE_STATUS_MISSED], g_ui32DMAErrCount);
+#ifdef TELEMETRY_STREAM
+    TelemetryStatsGet(&sTelemStats);
+    UARTprintf("Telemetry %d frames, %d bytes, %d deferred\n",
+               sTelemStats.ui32Frames, sTelemStats.ui32Bytes, sTelemStats.ui32Busy);
+#endif
+    FlashLogReport(&g_sFlashLog);
+    if(g_bSDCard)
+    {
+        BlkLogReport(&g_sBlkLog);
+    }
+    SchedReport();
+    StackMonitorSample(STACK_CONTEXT_MAIN);
+    StackMonitorReport(g_ppcStackContexts, 2);
+    return(0);
+}
+
+/**
+ * Command: param [name [value]]
+ */
+static int
+CmdParam(int argc, char *argv[])
+{
+    const tParam *psParam;
+    int32_t i32Value;
+    char *pcEnd;
+
+    if(argc > 3)
+    {
+        return(SHELL_TOO_MANY_ARGS);
+    }
+
+    if(argc == 1)
+    {
+        ParamsReport();
+        return(0);
+    }
+
+    psParam = ParamFind(argv[1]);
+    if(!psParam)
+    {
+        UARTprintf("No parameter \"%s\"\n", argv[1]);
+        return(SHELL_INVALID_ARG);
+    }
+
+    if(argc == 3)
+    {
+        i32Value = strtol(argv[2], &pcEnd, 0);
+        if(*pcEnd || !ParamSet(psParam, i32Value))
+        {
+            UARTprintf("%s must be %d to %d\n", psParam->pcName, psParam->i32Min, psParam->i32Max);
+            return(SHELL_INVALID_ARG);
+        }
+    }
+
+    UARTprintf("%s = %d\n", psParam->pcName, ParamGet(psParam));
+    return(0);
+}
+
+/**
+ * Command: save
+ */
+static int
+CmdSave(int argc, char *argv[])
+{
+    UARTprintf(ParamsCommit() ? "Parameters saved\n" : "EEPROM write failed\n");
+    return(0);
+}
+
+/**
+ * Command: defaults
+ */
+static int
+CmdDefaults(int argc, char *argv[])
+{
+    ParamsDefaults();
+    ParamsReport();
+    return(0);
+}
+
+/**
+ * Command: pack [none|12bit|rice|varint]
+ * The pack stage reads its mode for every block, so the change applies from the next block on
+ */
+static int
+CmdPack(int argc, char *argv[])
+{
+    static const char * const ppcModes[] = { "none", "12bit", "rice", "varint" };  // PACK_MODE_ order
+    uint32_t ui32Mode;
+
+    if(argc > 2)
+    {
+        return(SHELL_TOO_MANY_ARGS);
+    }
+
+    if(argc == 2)
+    {
+        for(ui32Mode = 0; ui32Mode < (sizeof(ppcModes) / sizeof(ppcModes[0])); ui32Mode++)
+        {
+            if(!strcmp(argv[1], ppcModes[ui32Mode]))
+            {
+                break;
+            }
+        }
+        if(ui32Mode == (sizeof(ppcModes) / sizeof(ppcModes[0])))
+        {
+            return(SHELL_INVALID_ARG);
+        }
+        ParamSet(PARAM_PACK, ui32Mode);
+    }
+
+    UARTprintf("Block coding %s\n", ppcModes[g_sPackStage.ui32Mode]);
+    return(0);
+}
+
+/**
+ * Milliseconds since the tasks started: the 1 kHz SysTick count, which keeps counting while no blocks flow
+ */
+static uint32_t
+UptimeMs(void)
+{
+    return(g_ui32Ticks);
+}
+
+/**
+ * Command: log [on|off|dump [from_ms [to_ms]]]
+ * A dump pauses recording, so the ring is not overwritten under the cursor, and resumes it when done
+ */
+static int
+CmdLog(int argc, char *argv[])
+{
+    char *pcEnd;
+
+    if(argc > 4)
+    {
+        return(SHELL_TOO_MANY_ARGS);
+    }
+
+    if(argc == 1)
+    {
+        FlashLogReport(&g_sFlashLog);
+        UARTprintf("     recording %s%s\n", g_sLogStage.bRecording ? "on" : "off",
+                   g_bDumping ? ", dump in progress" : "");
+    }
+    else if(!strcmp(argv[1], "on") && (argc == 2))
+    {
+        if(g_bDumping)
+        {
+            g_bDumpResume = true;       // appends would go under the dump cursor; start once the dump ends
+        }
+        else
+        {
+            g_sLogStage.bRecording = true;
+        }
+    }
+    else if(!strcmp(argv[1], "off") && (argc == 2))
+    {
+        g_sLogStage.bRecording = false;
+        g_bDumpResume = false;
+    }
+    else if(!strcmp(argv[1], "dump") && !g_bDumping)
+    {
+        g_ui32DumpStart = 0;
+        g_ui32DumpEnd = 0xFFFFFFFF;
+        if(argc > 2)
+        {
+            g_ui32DumpStart = strtoul(argv[2], &pcEnd, 10);
+            if(*pcEnd)
+            {
+                return(SHELL_INVALID_ARG);
+            }
+        }
+        if(argc > 3)
+        {
+            g_ui32DumpEnd = strtoul(argv[3], &pcEnd, 10);
+            if(*pcEnd)
+            {
+                return(SHELL_INVALID_ARG);
+            }
+        }
+        g_bDumpResume = g_sLogStage.bRecording;
+        g_sLogStage.bRecording = false;
+        FlashLogFind(&g_sFlashLog, g_ui32DumpStart, &g_sDumpCursor);
+        g_bDumping = true;
+    }
+    else
+    {
+        return(SHELL_INVALID_ARG);
+    }
+
+    return(0);
+}
+
+/**
+ * Sends logged records as telemetry frames on TELEMETRY_CHANNEL_LOG for as long as the transmit buffer takes them
+ */
+static void
+LogDumpRun(void)
+{
+    static uint32_t ui32Dumped;
+    tFlashLogCursor sCursor;
+    tFlashLogRecord sRecord;
+    uint8_t ui8Type;
+
+    while(g_bDumping)
+    {
+        sCursor = g_sDumpCursor;
+        if(!FlashLogNext(&g_sFlashLog, &sCursor, &sRecord) || (sRecord.ui32Time > g_ui32DumpEnd))
+        {
+            g_bDumping = false;
+            g_sLogStage.bRecording = g_bDumpResume;
+            UARTprintf("Log dump: %d records\n", ui32Dumped);
+            ui32Dumped = 0;
+            break;
+        }
+
+        //
+        // Skip the records before the start time in the first sector found, and any the host could not decode.
+        //
+        ui8Type = TelemetryFormatType(sRecord.ui32Format);
+        if((sRecord.ui32Time >= g_ui32DumpStart) && ui8Type && (sRecord.ui32Bytes <= TELEM_MAX_PAYLOAD))
+        {
+            if(!TelemetrySend(ui8Type, TELEMETRY_CHANNEL_LOG, (uint16_t)sRecord.ui32Seq,
+                              sRecord.pvData, sRecord.ui32Bytes))
+            {
+                break;      // transmit buffer full; carry on next time round the main loop
+            }
+            ui32Dumped++;
+        }
+        g_sDumpCursor = sCursor;
+    }
+}
+
+/**
+ * Command: sd [on|off|format]
+ * Format starts a new, empty log on the card; the blocks of the old one are left but no longer read
+ */
+static int
+CmdSD(int argc, char *argv[])
+{
+    if(argc > 2)
+    {
+        return(SHELL_TOO_MANY_ARGS);
+    }
+
+    if(!g_bSDCard)
+    {
+        UARTprintf("SD: no card (checked at start-up)\n");
+    }
+    else if(argc == 1)
+    {
+        BlkLogReport(&g_sBlkLog);
+        UARTprintf("    recording %s\n", g_sSDStage.bRecording ? "on" : "off");
+    }
+    else if(!strcmp(argv[1], "on"))
+    {
+        g_sSDStage.bRecording = true;
+    }
+    else if(!strcmp(argv[1], "off"))
+    {
+        g_sSDStage.bRecording = false;
+        BlkLogFlush(&g_sBlkLog);        // written out by the main loop
+    }
+    else if(!strcmp(argv[1], "format"))
+    {
+        g_sSDStage.bRecording = false;
+        UARTprintf("SD: %s\n", BlkLogFormat(&g_sBlkLog) ? "formatted" : "format failed");
+    }
+    else
+    {
+        return(SHELL_INVALID_ARG);
+    }
+
+    return(0);
+}
+
+/**
+ * Command: i2c
+ */
+static int
+CmdI2C(int argc, char *argv[])
+{
+    if(argc > 1)
+    {
+        return(SHELL_TOO_MANY_ARGS);
+    }
+
+    I2CBusReport(&g_sI2CBus);
+    I2CPollReport(&g_sSensorPoller);
+    return(0);
+}
+
+/**
+ * Command: watch [on|off]
+ */
+static int
+CmdWatch(int argc, char *argv[])
+{
+    if(argc > 2)
+    {
+        return(SHELL_TOO_MANY_ARGS);
+    }
+
+    if(argc == 2)
+    {
+        if(!strcmp(argv[1], "on"))
+        {
+            ADCWatchEnable(&g_sWatcher, true);
         }
+        else if(!strcmp(argv[1], "off"))
+        {
+            ADCWatchEnable(&g_sWatcher, false);
+        }
+        else
+        {
+            return(SHELL_INVALID_ARG);
+        }
+    }
+    ADCWatchReport(&g_sWatcher);
+    return(0);
+}
 
+/**
+ * Command: stream [on|off]
+ */
+static int
+CmdStream(int argc, char *argv[])
+{
+    if(argc > 2)
+    {
+        return(SHELL_TOO_MANY_ARGS);
     }
+
+    if(argc == 2)
+    {
+        if(strcmp(argv[1], "on") && strcmp(argv[1], "off"))
+        {
+            return(SHELL_INVALID_ARG);
+        }
+        g_bStreaming = !strcmp(argv[1], "on");
+
+        //
+        // DMA is still armed, so the block in progress carries on.  With two
+        // ADCs, the timer is held while both change so they miss the same
+        // triggers and their block numbers stay in step.
+        //
+#ifdef DUAL_ADC
+        TimerDisable(TIMER0_BASE, TIMER_A);
+#endif
+        if(g_bStreaming)
+        {
+            MAP_ADCSequenceEnable(ADC0_BASE, 0);
+#ifdef DUAL_ADC
+            MAP_ADCSequenceEnable(ADC1_BASE, 0);
+#endif
+        }
+        else
+        {
+            MAP_ADCSequenceDisable(ADC0_BASE, 0);
+#ifdef DUAL_ADC
+            MAP_ADCSequenceDisable(ADC1_BASE, 0);
+#endif
+        }
+#ifdef DUAL_ADC
+        TimerEnable(TIMER0_BASE, TIMER_A);
+#endif
+    }
+    UARTprintf("Sample stream %s\n", g_bStreaming ? "on" : "off");
+    return(0);
 }
 
+#ifdef DUAL_ADC
+/**
+ * Command: power
+ */
+static int
+CmdPower(int argc, char *argv[])
+{
+    uint32_t ui32Idx;
+
+    if(argc > 1)
+    {
+        return(SHELL_TOO_MANY_ARGS);
+    }
+
+    UARTprintf("Power of AIN0 (voltage) and AIN1 (current), latest of %d block pairs; %d missed, %d misaligned\n",
+               g_ui32PowerBlocks, g_ui32PairMissed, g_ui32PairSkewed);
+    PowerReport(&g_sPower);
+    for(ui32Idx = 0; ui32Idx < NUM_STAGES; ui32Idx++)
+    {
+        if((g_psStages[ui32Idx].pfnProcess == StagePower) && g_psStages[ui32Idx].ui32Calls)
+        {
+            UARTprintf("  %d cycles per block of %d pairs (max %d)\n",
+                       g_psStages[ui32Idx].ui32Cycles / g_psStages[ui32Idx].ui32Calls, BUFFER_SIZE,
+                       g_psStages[ui32Idx].ui32MaxCycles);
+        }
+    }
+    return(0);
+}
+#endif
+
+/**
+ * Command: capture [off|above|rising|falling level|alarm|button]
+ */
+static int
+CmdCapture(int argc, char *argv[])
+{
+    uint32_t ui32Trigger, ui32Level = 0, ui32Source = g_ui32CaptureSource;
+    char *pcEnd;
+
+    if(argc > 3)
+    {
+        return(SHELL_TOO_MANY_ARGS);
+    }
+
+    if(argc >= 2)
+    {
+        if(!strcmp(argv[1], "off"))
+        {
+            ui32Trigger = CAPTURE_TRIG_OFF;
+        }
+        else if(!strcmp(argv[1], "above"))
+        {
+            ui32Trigger = CAPTURE_TRIG_ABOVE;
+        }
+        else if(!strcmp(argv[1], "rising"))
+        {
+            ui32Trigger = CAPTURE_TRIG_RISING;
+        }
+        else if(!strcmp(argv[1], "falling"))
+        {
+            ui32Trigger = CAPTURE_TRIG_FALLING;
+        }
+        else if(!strcmp(argv[1], "alarm") || !strcmp(argv[1], "button"))
+        {
+            ui32Trigger = CAPTURE_TRIG_EXTERNAL;
+            ui32Source = strcmp(argv[1], "alarm") ? CAPTURE_SOURCE_BUTTON : CAPTURE_SOURCE_ALARM;
+        }
+        else
+        {
+            return(SHELL_INVALID_ARG);
+        }
+
+        //
+        // The level triggers need a level, in ADC counts; the others take none.
+        //
+        if((ui32Trigger == CAPTURE_TRIG_OFF) || (ui32Trigger == CAPTURE_TRIG_EXTERNAL))
+        {
+            if(argc == 3)
+            {
+                return(SHELL_TOO_MANY_ARGS);
+            }
+        }
+        else
+        {
+            if(argc != 3)
+            {
+                return(SHELL_INVALID_ARG);
+            }
+            ui32Level = strtoul(argv[2], &pcEnd, 10);
+            if(*pcEnd || (ui32Level > 4095))
+            {
+                UARTprintf("Level must be 0 to 4095\n");
+                return(SHELL_INVALID_ARG);
+            }
+        }
+
+        //
+        // Every argument has been checked; change the source and the trigger it feeds together.
+        //
+        g_ui32CaptureSource = ui32Source;
+        CaptureArm(&g_sCapture, ui32Trigger, ui32Level);
+    }
+
+    CaptureReport(&g_sCapture);
+    return(0);
+}
+
+/**
+ * Command: dma
+ */
+static int
+CmdDMA(int argc, char *argv[])
+{
+    if(argc > 1)
+    {
+        return(SHELL_TOO_MANY_ARGS);
+    }
+
+    DMAMgrReport();
+    return(0);
+}
+
+/**
+ * Command: irq [on|off]
+ */
+static int
+CmdIrq(int argc, char *argv[])
+{
+    if(argc > 2)
+    {
+        return(SHELL_TOO_MANY_ARGS);
+    }
+
+    if(argc == 2)
+    {
+        if(!strcmp(argv[1], "on"))
+        {
+            IntCriticalStatsEnable(true);   // clears the previous timings
+        }
+        else if(!strcmp(argv[1], "off"))
+        {
+            IntCriticalStatsEnable(false);
+        }
+        else
+        {
+            return(SHELL_INVALID_ARG);
+        }
+    }
+    IntPlanReport();
+    return(0);
+}
+
+/**
+ * Main loop work polled whenever no task has an event
+ */
+static void
+MainIdle(void)
+{
+    ShellPoll();
+    if(!g_bDumping)
+    {
+        FlashLogService(&g_sFlashLog);  // keep sectors erased ahead of the log, but not the oldest one mid-dump
+    }
+    BlkLogService(&g_sBlkLog);          // one SD write in flight at a time, polled so the loop never waits on the card
+    if(PipelineStalled(&g_sPipeline))
+    {
+        SchedPost(TASK_PIPELINE, TASK_EVENT_RETRY);     // a busy stage may be free now; no new block need arrive
+    }
+    LogDumpRun();
+    CaptureService(&g_sCapture);        // a frozen capture window goes out as frames, then the capture re-arms
+}
+
+#ifdef KERNEL_THREADS
+/**
+ * Command: kernel [bench]
+ */
+static int
+CmdKernel(int argc, char *argv[])
+{
+    if(argc > 2)
+    {
+        return(SHELL_TOO_MANY_ARGS);
+    }
+    if((argc == 2) && strcmp(argv[1], "bench"))
+    {
+        return(SHELL_INVALID_ARG);
+    }
+
+    if(argc == 2)
+    {
+        UARTprintf("%d cycles per switch over %d round trips\n",
+                   KernelBenchmark(KERNEL_BENCH_ROUNDS), KERNEL_BENCH_ROUNDS);
+    }
+    KernelReport();
+    return(0);
+}
+
+/**
+ * Main thread: the tasks and the polled work, exactly as the main loop runs them without the kernel
+ */
+static void
+ThreadMain(void *pvArg)
+{
+    SchedRun(MainIdle);
+}
+#endif
+
+/**
+ * main.c
+ */
+void main(void)
+{
+    /**
+     * Application:
+     * We will enable DMA controller to manage ADC data
+     * and store them into memory
+     *
+     * Note: cannot use debugger to view data because DMA runs separately from processor (debugger is based on processor)
+     *
+     */
+
+    // LOCAL VARIABLES
+    uint32_t ui32BootCycles = CycleCountGet();  // cycles from reset to here (C run-time init)
+    uint32_t ui32VTableCycles;
+    tVectorLatency sLatency;
+    tStackRegion *psStack;
+    uint32_t ui32TriggerPeriod;
+    uint32_t ui32FirstBlock;
+    bool bDMAPlan;
+    uint32_t ui32ParamLoad, ui32ParamCycles;
+    BootTimeMark(BOOT_PHASE_MAIN);
+    psStack = StackMonitorInit();     // paint the unused stack so its high-water mark can be read later
+
+    // A. System level configuration
+    // 0. Place the vector table (flash as linked, or copied once to SRAM if VECTOR_TABLE_IN_RAM is defined).
+    //    Handlers are assigned in tm4c123gh6pm_startup_ccs.c, so IntRegister() is never needed.
+    VectorTableInit();
+    ui32VTableCycles = CycleCountGet() - ui32BootCycles;
+    IntPlanApply(g_psIntPlan, NUM_INT_PLAN);   // before any interrupt is enabled; NVIC needs no clock (not in the table's time)
+    FaultRecordInit();      // route MemManage/Bus/Usage faults to their own handlers (recorded, then reset)
+    StackGuardEnable(psStack, STACK_GUARD_MPU_REGION);   // a stack overflow now faults instead of corrupting .bss
+
+    // 1. Start clocking all peripherals at once (no per-peripheral ready spin)
+    BootPeripheralsEnable(g_pui32Peripherals, NUM_PERIPHERALS);
+
+    // 2. Setup system clock; the peripherals come out of reset while the PLL locks
+    MAP_SysCtlClockSet( SYSCTL_OSC_MAIN | SYSCTL_XTAL_16MHZ | SYSCTL_USE_PLL | SYSCTL_SYSDIV_5 ); // Use MOSC to drive 400MHz PLL. The use sysdiv5 to apply a /10 divisor and finally generating a 40MHz clock signal.
+    BootTimeMark(BOOT_PHASE_CLOCK);
+
+    // 3. Make sure every peripheral is ready before touching its registers (normally already true by now)
+    BootPeripheralsWait(g_pui32Peripherals, NUM_PERIPHERALS);
+    BootTimeMark(BOOT_PHASE_PERIPH);
+
+    // 4. Load the saved parameters (sample rate, ...) before anything uses them, and find the end of the flash log
+    ui32ParamCycles = CycleCountGet();
+    ui32ParamLoad = ParamsInit(g_psParams, NUM_PARAMS, PARAM_SCHEMA);
+    ui32ParamCycles = CycleCountGet() - ui32ParamCycles;
+    GateApply();
+    FlashLogInit(&g_sFlashLog, LOG_FLASH_BASE, LOG_FLASH_SIZE);     // sectors are erased later, from the main loop
+
+    // B. Peripheral level configuration
+    // Sampling is started before the console is brought up, so time to the first ADC sample
+    // does not include printing at 115200 baud.
+    // 5. Configure PE3 to use its ADC function
+    MAP_GPIOPinTypeADC( GPIO_PORTE_BASE, GPIO_PIN_3 );
+
+    // 6. Configure ADC0 SS0
+    ADCClockConfigSet( ADC0_BASE, ADC_CLOCK_SRC_PIOSC | ADC_CLOCK_RATE_HALF , 1 );
+    SysCtlDelay(10);
+
+    IntDisable(INT_ADC0SS0);
+    ADCIntDisable(ADC0_BASE, 0);
+    ADCSequenceDisable(ADC0_BASE, 0);
+    MAP_ADCSequenceConfigure( ADC0_BASE, 0, ADC_TRIGGER_TIMER, 0 );
+    MAP_ADCSequenceStepConfigure( ADC0_BASE, 0, 0, ADC_CTL_IE | ADC_CTL_END | ADC_CTL_CH0 );
+    MAP_ADCSequenceEnable( ADC0_BASE, 0 );
+    ADCIntClear(ADC0_BASE, 0);
+
+    // 7. Configure uDMA controller, starting with two blocks from the sample pool
+    MemPoolInit(&g_sSamplePool, g_pui32SampleStorage, PIPE_BLOCK_SIZE(BUFFER_SIZE * sizeof(uint16_t)), SAMPLE_BLOCKS, g_pui8SampleRefs);
+    MemPoolLevelSet(&g_sSamplePool, PRIORITY_SAMPLING);    // the ADC ISR is its most urgent user
+    PipelineInit(&g_sPipeline, g_psStages, NUM_STAGES);
+    SchedInit(g_psTasks, NUM_TASKS, NUM_DEFERRED_TASKS);    // before the first block is posted to the pipeline task
+    bDMAPlan = DMAMgrInit(g_psDMAPlan, NUM_DMA_PLAN);
+    IntEnable(INT_UDMAERR);
+#ifdef DMA_SCATTER_GATHER
+    ConfigureSampleRing();
+#else
+    g_ppsDMABlock[0] = PipeBlockAlloc(&g_sSamplePool, PIPE_FORMAT_SAMPLES16);
+    g_ppsDMABlock[1] = PipeBlockAlloc(&g_sSamplePool, PIPE_FORMAT_SAMPLES16);
+    uDMAChannelAttributeDisable( UDMA_CHANNEL_ADC0 , UDMA_ATTR_ALTSELECT | UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK );
+    uDMAChannelControlSet( UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT , UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 | UDMA_ARB_1 );
+    uDMAChannelControlSet(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT, UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 | UDMA_ARB_1);
+    DMAMgrTransferSet(UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT,
+                          UDMA_MODE_PINGPONG,
+                          (void *)(ADC0_BASE + ADC_O_SSFIFO0),
+                          g_ppsDMABlock[0]->pvData, BUFFER_SIZE);
+    DMAMgrTransferSet(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT,
+                          UDMA_MODE_PINGPONG,
+                          (void *)(ADC0_BASE + ADC_O_SSFIFO0),
+                          g_ppsDMABlock[1]->pvData, BUFFER_SIZE);
+    uDMAChannelAttributeEnable( UDMA_CHANNEL_ADC0 , UDMA_ATTR_USEBURST );
+    uDMAChannelEnable(UDMA_CHANNEL_ADC0);
+#endif
+
+    // 8. Wrap up ADC-DMA configuration (enabling adc interrupt after dma is configured)
+    ADCSequenceDMAEnable(ADC0_BASE, 0);
+#ifndef DMA_SCATTER_GATHER
+    ADCIntEnable(ADC0_BASE, 0);     // a looping task list never completes, so it needs no interrupt
+    IntEnable(INT_ADC0SS0);
+#endif
+    ADCWatchInit(&g_sWatcher);      // comparator alarms on SS1, started by the same timer trigger
+    ConfigureButton();              // SW1, a capture trigger
+#ifdef DUAL_ADC
+    ConfigurePairADC();             // AIN1 on ADC1, from the same trigger
+#endif
+
+    // 9. Configure Timer for ADC sampling
+    ui32TriggerPeriod = SysCtlClockGet()/g_ui32SampleRate;
+    g_ui32SamplePeriod = ui32TriggerPeriod;
+    CaptureInit(&g_sCapture, ui32TriggerPeriod);
+#ifdef TELEMETRY_STREAM
+    g_sTimeStage.ui32Clock = SysCtlClockGet();  // the block time stamps count CPU cycles
+#endif
+    TimerConfigure(TIMER0_BASE,TIMER_CFG_SPLIT_PAIR | TIMER_CFG_A_PERIODIC);
+    RateGenInit(&g_sSampleClock, SysCtlClockGet());
+    RateGenSet(&g_sSampleClock, g_ui32SampleRate, 1);
+    TimerControlTrigger(TIMER0_BASE, TIMER_A, true);
+    IntMasterEnable();
+    TimerEnable(TIMER0_BASE, TIMER_A);
+    BootTimeMark(BOOT_PHASE_ARMED);     // first conversion follows one trigger period later
+
+    // C. Deferred bring-up
+    // 10. Configure UART for demo
+    ConfigureUART();
+    UARTprintf("\nTimer->ADC->uDMA demo!\n\n");
+    FaultRecordReport();    // print the crash record left by a fault before the last reset, if any
+    if(!bDMAPlan)
+    {
+        DMAMgrReport();     // say which channels were left out
+    }
+    UARTFlushTx(false);
+
+    // 11. Look for an SD card on SSI0; without one the "sd" stage just passes blocks on
+    ConfigureSD();
+
+    // 12. Start the I2C sensor bus; a missing sensor only shows up as NAKs in the "i2c" report
+    ConfigureI2C();
+
+    // Report the cost of the chosen vector table placement and of each boot phase
+#ifdef DMA_SCATTER_GATHER
+    while(!BootTimeGet(BOOT_PHASE_FIRST_BLOCK, &ui32FirstBlock))
+    {
+        SampleRingPoll();           // SysTick, which hands the blocks over, starts later
+    }
+#else
+    while(!BootTimeGet(BOOT_PHASE_FIRST_BLOCK, &ui32FirstBlock)) {}
+#endif
+    BootTimeReport(SysCtlClockGet(), ui32TriggerPeriod);
+    VectorTableLatencyMeasure(&sLatency, LATENCY_SAMPLES);
+    UARTprintf("Vector table in %s: %d cycles to place table, IRQ entry %d-%d cycles\n\n",
+               VectorTableIsRAM() ? "SRAM" : "flash", ui32VTableCycles,
+               sLatency.ui32Min, sLatency.ui32Max);
+    StackMonitorReport(g_ppcStackContexts, 2);
+    LFQueueBenchmark();
+    SeqLockBenchmark();
+    UARTprintf("Sample pool: %d blocks of %d samples\n\n", SAMPLE_BLOCKS, BUFFER_SIZE);
+    UARTprintf("Parameters: %s in %d cycles\n",
+               (ui32ParamLoad == PARAM_LOAD_OK) ? "loaded from EEPROM" :
+               (ui32ParamLoad == PARAM_LOAD_MIGRATED) ? "migrated from an older schema" :
+               (ui32ParamLoad == PARAM_LOAD_DEFAULTS) ? "defaults, none saved" : "defaults, EEPROM error",
+               ui32ParamCycles);
+    ParamsReport();
+    UARTprintf("\n");
+    FlashLogReport(&g_sFlashLog);
+    if(g_bSDCard)
+    {
+        BlkLogReport(&g_sBlkLog);
+    }
+    else
+    {
+        UARTprintf("SD: no card\n");
+    }
+    UARTprintf("\n");
+#ifndef TELEMETRY_STREAM
+    UARTprintf("ui32AveData1\tui32AveData2\tTotal Samples\tPool peak\tOverruns\n");
+#endif
+    UARTFlushTx(false);     // the console is buffered; let the start-up reports drain before blocks are sent
+
+    // 13. Accept commands on the console (type help); input is handled when no task has work
+    ShellInit(g_psCommands, "> ");
+
+    // 14. Start the periodic tasks, then run the tasks for good; DMA is re-armed by ADCSeq0Handler, which posts each block
+    // (DMA_SCATTER_GATHER: the task list re-arms itself, and SysTick posts the blocks)
+#ifdef KERNEL_THREADS
+    KernelInit(SchedPendSVHandler);     // the kernel takes over PendSV and runs the deferred tasks from it first
+    ThreadCreate(&g_sMainThread, "main", ThreadMain, 0, g_pui32MainStack, sizeof(g_pui32MainStack), MAIN_THREAD_PRIORITY);
+    ConfigureTasks();
+    KernelStart();
+#else
+    ConfigureTasks();
+    SchedRun(MainIdle);
+#endif
+}
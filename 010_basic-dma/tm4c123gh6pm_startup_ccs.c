@@ -23,6 +23,7 @@
 //*****************************************************************************
 
 #include <stdint.h>
+#include "utils/cyclecount.h"
 
 //*****************************************************************************
 //
@@ -31,8 +32,6 @@
 //*****************************************************************************
 void ResetISR(void);
 static void NmiSR(void);
-static void FaultISR(void);
-static void IntDefaultHandler(void);
 
 //*****************************************************************************
 //
@@ -42,6 +41,18 @@ static void IntDefaultHandler(void);
 //*****************************************************************************
 extern void _c_int00(void);
 
+//*****************************************************************************
+//
+// External declaration for the handler of faults and unexpected interrupts.
+// It is assembly (utils/faultrecord.c) and is entered straight from the
+// vector table, so the exception frame is on top of the stack.  The stacked
+// frame and fault status registers are saved to no-init RAM and the device
+// is reset; the record is reported over UART on the next boot.  If a
+// debugger is attached the processor halts on a breakpoint instead.
+//
+//*****************************************************************************
+extern void FaultHandler(void);
+
 //*****************************************************************************
 //
 // Linker variable that marks the top of the stack.
@@ -54,7 +65,23 @@ extern uint32_t __STACK_TOP;
 // External declarations for the interrupt handlers used by the application.
 //
 //*****************************************************************************
-// To be added by user
+extern void ADCSeq0Handler(void);
+extern void ADCSeq1Handler(void);
+extern void GPIOFIntHandler(void);
+extern void Timer0AIntHandler(void);
+#ifdef DUAL_ADC
+extern void ADC1Seq0Handler(void);
+#endif
+extern void uDMAErrorHandler(void);
+extern void VectorTableProbeHandler(void);
+extern void UARTStdioIntHandler(void);
+extern void I2C0IntHandler(void);
+#ifdef KERNEL_THREADS
+extern void KernelPendSVHandler(void);
+#else
+extern void SchedPendSVHandler(void);
+#endif
+extern void SysTickHandler(void);
 
 //*****************************************************************************
 //
@@ -70,158 +97,166 @@ void (* const g_pfnVectors[])(void) =
                                             // The initial stack pointer
     ResetISR,                               // The reset handler
     NmiSR,                                  // The NMI handler
-    FaultISR,                               // The hard fault handler
-    IntDefaultHandler,                      // The MPU fault handler
-    IntDefaultHandler,                      // The bus fault handler
-    IntDefaultHandler,                      // The usage fault handler
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    IntDefaultHandler,                      // SVCall handler
-    IntDefaultHandler,                      // Debug monitor handler
-    0,                                      // Reserved
-    IntDefaultHandler,                      // The PendSV handler
-    IntDefaultHandler,                      // The SysTick handler
-    IntDefaultHandler,                      // GPIO Port A
-    IntDefaultHandler,                      // GPIO Port B
-    IntDefaultHandler,                      // GPIO Port C
-    IntDefaultHandler,                      // GPIO Port D
-    IntDefaultHandler,                      // GPIO Port E
-    IntDefaultHandler,                      // UART0 Rx and Tx
-    IntDefaultHandler,                      // UART1 Rx and Tx
-    IntDefaultHandler,                      // SSI0 Rx and Tx
-    IntDefaultHandler,                      // I2C0 Master and Slave
-    IntDefaultHandler,                      // PWM Fault
-    IntDefaultHandler,                      // PWM Generator 0
-    IntDefaultHandler,                      // PWM Generator 1
-    IntDefaultHandler,                      // PWM Generator 2
-    IntDefaultHandler,                      // Quadrature Encoder 0
-    IntDefaultHandler,                      // ADC Sequence 0
-    IntDefaultHandler,                      // ADC Sequence 1
-    IntDefaultHandler,                      // ADC Sequence 2
-    IntDefaultHandler,                      // ADC Sequence 3
-    IntDefaultHandler,                      // Watchdog timer
-    IntDefaultHandler,                      // Timer 0 subtimer A
-    IntDefaultHandler,                      // Timer 0 subtimer B
-    IntDefaultHandler,                      // Timer 1 subtimer A
-    IntDefaultHandler,                      // Timer 1 subtimer B
-    IntDefaultHandler,                      // Timer 2 subtimer A
-    IntDefaultHandler,                      // Timer 2 subtimer B
-    IntDefaultHandler,                      // Analog Comparator 0
-    IntDefaultHandler,                      // Analog Comparator 1
-    IntDefaultHandler,                      // Analog Comparator 2
-    IntDefaultHandler,                      // System Control (PLL, OSC, BO)
-    IntDefaultHandler,                      // FLASH Control
-    IntDefaultHandler,                      // GPIO Port F
-    IntDefaultHandler,                      // GPIO Port G
-    IntDefaultHandler,                      // GPIO Port H
-    IntDefaultHandler,                      // UART2 Rx and Tx
-    IntDefaultHandler,                      // SSI1 Rx and Tx
-    IntDefaultHandler,                      // Timer 3 subtimer A
-    IntDefaultHandler,                      // Timer 3 subtimer B
-    IntDefaultHandler,                      // I2C1 Master and Slave
-    IntDefaultHandler,                      // Quadrature Encoder 1
-    IntDefaultHandler,                      // CAN0
-    IntDefaultHandler,                      // CAN1
-    0,                                      // Reserved
-    0,                                      // Reserved
-    IntDefaultHandler,                      // Hibernate
-    IntDefaultHandler,                      // USB0
-    IntDefaultHandler,                      // PWM Generator 3
-    IntDefaultHandler,                      // uDMA Software Transfer
-    IntDefaultHandler,                      // uDMA Error
-    IntDefaultHandler,                      // ADC1 Sequence 0
-    IntDefaultHandler,                      // ADC1 Sequence 1
-    IntDefaultHandler,                      // ADC1 Sequence 2
-    IntDefaultHandler,                      // ADC1 Sequence 3
-    0,                                      // Reserved
-    0,                                      // Reserved
-    IntDefaultHandler,                      // GPIO Port J
-    IntDefaultHandler,                      // GPIO Port K
-    IntDefaultHandler,                      // GPIO Port L
-    IntDefaultHandler,                      // SSI2 Rx and Tx
-    IntDefaultHandler,                      // SSI3 Rx and Tx
-    IntDefaultHandler,                      // UART3 Rx and Tx
-    IntDefaultHandler,                      // UART4 Rx and Tx
-    IntDefaultHandler,                      // UART5 Rx and Tx
-    IntDefaultHandler,                      // UART6 Rx and Tx
-    IntDefaultHandler,                      // UART7 Rx and Tx
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    IntDefaultHandler,                      // I2C2 Master and Slave
-    IntDefaultHandler,                      // I2C3 Master and Slave
-    IntDefaultHandler,                      // Timer 4 subtimer A
-    IntDefaultHandler,                      // Timer 4 subtimer B
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
-    0,                                      // Reserved
+    FaultHandler,                           // The hard fault handler
+    FaultHandler,                           // The MPU fault handler
+    FaultHandler,                           // The bus fault handler
+    FaultHandler,                           // The usage fault handler
+    0,                                      // Reserved
     0,                                      // Reserved
     0,                                      // Reserved
     0,                                      // Reserved
+    FaultHandler,                           // SVCall handler
+    FaultHandler,                           // Debug monitor handler
+    0,                                      // Reserved
+#ifdef KERNEL_THREADS
+    KernelPendSVHandler,                    // The PendSV handler
+#else
+    SchedPendSVHandler,                     // The PendSV handler
+#endif
+    SysTickHandler,                         // The SysTick handler
+    FaultHandler,                           // GPIO Port A
+    FaultHandler,                           // GPIO Port B
+    FaultHandler,                           // GPIO Port C
+    FaultHandler,                           // GPIO Port D
+    FaultHandler,                           // GPIO Port E
+    UARTStdioIntHandler,                    // UART0 Rx and Tx
+    FaultHandler,                           // UART1 Rx and Tx
+    FaultHandler,                           // SSI0 Rx and Tx
+    I2C0IntHandler,                         // I2C0 Master and Slave
+    FaultHandler,                           // PWM Fault
+    FaultHandler,                           // PWM Generator 0
+    FaultHandler,                           // PWM Generator 1
+    FaultHandler,                           // PWM Generator 2
+    FaultHandler,                           // Quadrature Encoder 0
+    ADCSeq0Handler,                         // ADC Sequence 0
+    ADCSeq1Handler,                         // ADC Sequence 1
+    FaultHandler,                           // ADC Sequence 2
+    FaultHandler,                           // ADC Sequence 3
+    FaultHandler,                           // Watchdog timer
+    Timer0AIntHandler,                      // Timer 0 subtimer A
+    FaultHandler,                           // Timer 0 subtimer B
+    FaultHandler,                           // Timer 1 subtimer A
+    FaultHandler,                           // Timer 1 subtimer B
+    FaultHandler,                           // Timer 2 subtimer A
+    FaultHandler,                           // Timer 2 subtimer B
+    FaultHandler,                           // Analog Comparator 0
+    FaultHandler,                           // Analog Comparator 1
+    FaultHandler,                           // Analog Comparator 2
+    FaultHandler,                           // System Control (PLL, OSC, BO)
+    FaultHandler,                           // FLASH Control
+    GPIOFIntHandler,                        // GPIO Port F
+    FaultHandler,                           // GPIO Port G
+    FaultHandler,                           // GPIO Port H
+    FaultHandler,                           // UART2 Rx and Tx
+    FaultHandler,                           // SSI1 Rx and Tx
+    FaultHandler,                           // Timer 3 subtimer A
+    FaultHandler,                           // Timer 3 subtimer B
+    FaultHandler,                           // I2C1 Master and Slave
+    FaultHandler,                           // Quadrature Encoder 1
+    FaultHandler,                           // CAN0
+    FaultHandler,                           // CAN1
+    0,                                      // Reserved
+    0,                                      // Reserved
+    FaultHandler,                           // Hibernate
+    FaultHandler,                           // USB0
+    FaultHandler,                           // PWM Generator 3
+    FaultHandler,                           // uDMA Software Transfer
+    uDMAErrorHandler,                       // uDMA Error
+#ifdef DUAL_ADC
+    ADC1Seq0Handler,                        // ADC1 Sequence 0
+#else
+    FaultHandler,                           // ADC1 Sequence 0
+#endif
+    FaultHandler,                           // ADC1 Sequence 1
+    FaultHandler,                           // ADC1 Sequence 2
+    FaultHandler,                           // ADC1 Sequence 3
+    0,                                      // Reserved
+    0,                                      // Reserved
+    FaultHandler,                           // GPIO Port J
+    FaultHandler,                           // GPIO Port K
+    FaultHandler,                           // GPIO Port L
+    FaultHandler,                           // SSI2 Rx and Tx
+    FaultHandler,                           // SSI3 Rx and Tx
+    FaultHandler,                           // UART3 Rx and Tx
+    FaultHandler,                           // UART4 Rx and Tx
+    FaultHandler,                           // UART5 Rx and Tx
+    FaultHandler,                           // UART6 Rx and Tx
+    FaultHandler,                           // UART7 Rx and Tx
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    FaultHandler,                           // I2C2 Master and Slave
+    FaultHandler,                           // I2C3 Master and Slave
+    FaultHandler,                           // Timer 4 subtimer A
+    FaultHandler,                           // Timer 4 subtimer B
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    0,                                      // Reserved
+    FaultHandler,                           // Timer 5 subtimer A
+    VectorTableProbeHandler,                // Timer 5 subtimer B
+    FaultHandler,                           // Wide Timer 0 subtimer A
+    FaultHandler,                           // Wide Timer 0 subtimer B
+    FaultHandler,                           // Wide Timer 1 subtimer A
+    FaultHandler,                           // Wide Timer 1 subtimer B
+    FaultHandler,                           // Wide Timer 2 subtimer A
+    FaultHandler,                           // Wide Timer 2 subtimer B
+    FaultHandler,                           // Wide Timer 3 subtimer A
+    FaultHandler,                           // Wide Timer 3 subtimer B
+    FaultHandler,                           // Wide Timer 4 subtimer A
+    FaultHandler,                           // Wide Timer 4 subtimer B
+    FaultHandler,                           // Wide Timer 5 subtimer A
+    FaultHandler,                           // Wide Timer 5 subtimer B
+    FaultHandler,                           // FPU
     0,                                      // Reserved
-    IntDefaultHandler,                      // Timer 5 subtimer A
-    IntDefaultHandler,                      // Timer 5 subtimer B
-    IntDefaultHandler,                      // Wide Timer 0 subtimer A
-    IntDefaultHandler,                      // Wide Timer 0 subtimer B
-    IntDefaultHandler,                      // Wide Timer 1 subtimer A
-    IntDefaultHandler,                      // Wide Timer 1 subtimer B
-    IntDefaultHandler,                      // Wide Timer 2 subtimer A
-    IntDefaultHandler,                      // Wide Timer 2 subtimer B
-    IntDefaultHandler,                      // Wide Timer 3 subtimer A
-    IntDefaultHandler,                      // Wide Timer 3 subtimer B
-    IntDefaultHandler,                      // Wide Timer 4 subtimer A
-    IntDefaultHandler,                      // Wide Timer 4 subtimer B
-    IntDefaultHandler,                      // Wide Timer 5 subtimer A
-    IntDefaultHandler,                      // Wide Timer 5 subtimer B
-    IntDefaultHandler,                      // FPU
-    0,                                      // Reserved
     0,                                      // Reserved
-    IntDefaultHandler,                      // I2C4 Master and Slave
-    IntDefaultHandler,                      // I2C5 Master and Slave
-    IntDefaultHandler,                      // GPIO Port M
-    IntDefaultHandler,                      // GPIO Port N
-    IntDefaultHandler,                      // Quadrature Encoder 2
+    FaultHandler,                           // I2C4 Master and Slave
+    FaultHandler,                           // I2C5 Master and Slave
+    FaultHandler,                           // GPIO Port M
+    FaultHandler,                           // GPIO Port N
+    FaultHandler,                           // Quadrature Encoder 2
     0,                                      // Reserved
     0,                                      // Reserved
-    IntDefaultHandler,                      // GPIO Port P (Summary or P0)
-    IntDefaultHandler,                      // GPIO Port P1
-    IntDefaultHandler,                      // GPIO Port P2
-    IntDefaultHandler,                      // GPIO Port P3
-    IntDefaultHandler,                      // GPIO Port P4
-    IntDefaultHandler,                      // GPIO Port P5
-    IntDefaultHandler,                      // GPIO Port P6
-    IntDefaultHandler,                      // GPIO Port P7
-    IntDefaultHandler,                      // GPIO Port Q (Summary or Q0)
-    IntDefaultHandler,                      // GPIO Port Q1
-    IntDefaultHandler,                      // GPIO Port Q2
-    IntDefaultHandler,                      // GPIO Port Q3
-    IntDefaultHandler,                      // GPIO Port Q4
-    IntDefaultHandler,                      // GPIO Port Q5
-    IntDefaultHandler,                      // GPIO Port Q6
-    IntDefaultHandler,                      // GPIO Port Q7
-    IntDefaultHandler,                      // GPIO Port R
-    IntDefaultHandler,                      // GPIO Port S
-    IntDefaultHandler,                      // PWM 1 Generator 0
-    IntDefaultHandler,                      // PWM 1 Generator 1
-    IntDefaultHandler,                      // PWM 1 Generator 2
-    IntDefaultHandler,                      // PWM 1 Generator 3
-    IntDefaultHandler                       // PWM 1 Fault
+    FaultHandler,                           // GPIO Port P (Summary or P0)
+    FaultHandler,                           // GPIO Port P1
+    FaultHandler,                           // GPIO Port P2
+    FaultHandler,                           // GPIO Port P3
+    FaultHandler,                           // GPIO Port P4
+    FaultHandler,                           // GPIO Port P5
+    FaultHandler,                           // GPIO Port P6
+    FaultHandler,                           // GPIO Port P7
+    FaultHandler,                           // GPIO Port Q (Summary or Q0)
+    FaultHandler,                           // GPIO Port Q1
+    FaultHandler,                           // GPIO Port Q2
+    FaultHandler,                           // GPIO Port Q3
+    FaultHandler,                           // GPIO Port Q4
+    FaultHandler,                           // GPIO Port Q5
+    FaultHandler,                           // GPIO Port Q6
+    FaultHandler,                           // GPIO Port Q7
+    FaultHandler,                           // GPIO Port R
+    FaultHandler,                           // GPIO Port S
+    FaultHandler,                           // PWM 1 Generator 0
+    FaultHandler,                           // PWM 1 Generator 1
+    FaultHandler,                           // PWM 1 Generator 2
+    FaultHandler,                           // PWM 1 Generator 3
+    FaultHandler                            // PWM 1 Fault
 };
 
 //*****************************************************************************
@@ -237,6 +272,12 @@ void (* const g_pfnVectors[])(void) =
 void
 ResetISR(void)
 {
+    //
+    // Start the cycle counter so that main() can report how long the C
+    // run-time initialization took.
+    //
+    CycleCountStart();
+
     //
     // Jump to the CCS C initialization routine.  This will enable the
     // floating-point unit as well, so that does not need to be done here.
@@ -262,39 +303,3 @@ NmiSR(void)
     {
     }
 }
-
-//*****************************************************************************
-//
-// This is the code that gets called when the processor receives a fault
-// interrupt.  This simply enters an infinite loop, preserving the system state
-// for examination by a debugger.
-//
-//*****************************************************************************
-static void
-FaultISR(void)
-{
-    //
-    // Enter an infinite loop.
-    //
-    while(1)
-    {
-    }
-}
-
-//*****************************************************************************
-//
-// This is the code that gets called when the processor receives an unexpected
-// interrupt.  This simply enters an infinite loop, preserving the system state
-// for examination by a debugger.
-//
-//*****************************************************************************
-static void
-IntDefaultHandler(void)
-{
-    //
-    // Go into an infinite loop.
-    //
-    while(1)
-    {
-    }
-}
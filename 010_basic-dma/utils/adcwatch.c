@@ -0,0 +1,245 @@
+//*****************************************************************************
+//
+// adcwatch.c - Threshold and window alarms from the ADC digital comparators.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_types.h"
+#include "driverlib/adc.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/cyclecount.h"
+#include "utils/adcwatch.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup adcwatch_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Names the band whose entry raises a watch's alarm.
+//
+//*****************************************************************************
+static const char *
+ADCWatchBand(uint32_t ui32Config)
+{
+    switch(ui32Config)
+    {
+        case ADC_COMP_INT_HIGH_ALWAYS:
+        case ADC_COMP_INT_HIGH_ONCE:
+        case ADC_COMP_INT_HIGH_HALWAYS:
+        case ADC_COMP_INT_HIGH_HONCE:
+            return("high");
+        case ADC_COMP_INT_MID_ALWAYS:
+        case ADC_COMP_INT_MID_ONCE:
+            return("mid");
+        default:
+            return("low");
+    }
+}
+
+//*****************************************************************************
+//
+//! Sets up the comparators and their sample sequence, and starts watching.
+//!
+//! \param psWatcher is the watcher, with its application members set.
+//!
+//! Each trigger converts every watched channel once more, after the
+//! sequences of higher priority; the conversions go to the comparators
+//! only, never to a FIFO, so watching costs the CPU nothing until an alarm.
+//! The ADC must be clocked and configured, and the trigger source set up
+//! (or about to be) for the sample stream.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ADCWatchInit(tADCWatcher *psWatcher)
+{
+    const tADCWatch *psWatch;
+    uint32_t ui32Idx, ui32Step;
+
+    psWatcher->ui32Write = 0;
+    psWatcher->ui32Read = 0;
+    psWatcher->ui32Lost = 0;
+
+    MAP_ADCSequenceDisable(psWatcher->ui32Base, psWatcher->ui32Sequence);
+    MAP_ADCSequenceConfigure(psWatcher->ui32Base, psWatcher->ui32Sequence,
+                             psWatcher->ui32Trigger, psWatcher->ui32Sequence);
+
+    for(ui32Idx = 0; ui32Idx < psWatcher->ui32Count; ui32Idx++)
+    {
+        psWatch = &psWatcher->psWatches[ui32Idx];
+        psWatcher->pui32Alarms[ui32Idx] = 0;
+
+        MAP_ADCComparatorConfigure(psWatcher->ui32Base, ui32Idx,
+                                   ADC_COMP_TRIG_NONE | psWatch->ui32Config);
+        MAP_ADCComparatorRegionSet(psWatcher->ui32Base, ui32Idx,
+                                   psWatch->ui32Low, psWatch->ui32High);
+        MAP_ADCComparatorReset(psWatcher->ui32Base, ui32Idx, true, true);
+
+        ui32Step = psWatch->ui32Channel | (ADC_CTL_CMP0 + (ui32Idx << 16));
+        if(ui32Idx == (psWatcher->ui32Count - 1))
+        {
+            ui32Step |= ADC_CTL_END;
+        }
+        MAP_ADCSequenceStepConfigure(psWatcher->ui32Base,
+                                     psWatcher->ui32Sequence, ui32Idx,
+                                     ui32Step);
+    }
+
+    MAP_ADCComparatorIntClear(psWatcher->ui32Base, 0xff);
+    MAP_ADCComparatorIntEnable(psWatcher->ui32Base, psWatcher->ui32Sequence);
+    MAP_IntEnable(psWatcher->ui32Int);
+    ADCWatchEnable(psWatcher, true);
+}
+
+//*****************************************************************************
+//
+//! Starts or stops watching.
+//!
+//! \param psWatcher is the watcher.
+//! \param bEnable is \b true to watch.
+//!
+//! Watching is independent of the sample stream: either may run alone.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ADCWatchEnable(tADCWatcher *psWatcher, bool bEnable)
+{
+    if(bEnable)
+    {
+        MAP_ADCSequenceEnable(psWatcher->ui32Base, psWatcher->ui32Sequence);
+    }
+    else
+    {
+        MAP_ADCSequenceDisable(psWatcher->ui32Base, psWatcher->ui32Sequence);
+    }
+    psWatcher->bEnabled = bEnable;
+}
+
+//*****************************************************************************
+//
+//! Handles the interrupt of the watcher's sample sequence.
+//!
+//! \param psWatcher is the watcher.
+//!
+//! The alarm time is taken first thing, a few cycles after the comparator
+//! fired.  Each alarm is queued for ADCWatchEventGet() and passed to the
+//! notify function.  Nothing is masked, so the interrupt may be given a
+//! priority above every critical section.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ADCWatchIntHandler(tADCWatcher *psWatcher)
+{
+    tADCWatchEvent *psEvent;
+    uint32_t ui32Time, ui32Status, ui32Idx, ui32Write;
+
+    ui32Time = CycleCountGet();
+    ui32Status = MAP_ADCComparatorIntStatus(psWatcher->ui32Base);
+    MAP_ADCComparatorIntClear(psWatcher->ui32Base, ui32Status);
+    MAP_ADCIntClearEx(psWatcher->ui32Base,
+                      ADC_INT_DCON_SS0 << psWatcher->ui32Sequence);
+
+    for(ui32Idx = 0; ui32Idx < psWatcher->ui32Count; ui32Idx++)
+    {
+        if(!(ui32Status & (1 << ui32Idx)))
+        {
+            continue;
+        }
+
+        psWatcher->pui32Alarms[ui32Idx]++;
+        ui32Write = psWatcher->ui32Write;
+        if((ui32Write - psWatcher->ui32Read) >= ADC_WATCH_QUEUE_DEPTH)
+        {
+            psWatcher->ui32Lost++;
+        }
+        else
+        {
+            psEvent = &psWatcher->psQueue[ui32Write % ADC_WATCH_QUEUE_DEPTH];
+            psEvent->ui32Time = ui32Time;
+            psEvent->ui32Watch = ui32Idx;
+            psWatcher->ui32Write = ui32Write + 1;
+        }
+
+        if(psWatcher->pfnNotify)
+        {
+            psWatcher->pfnNotify(ui32Idx, ui32Time);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Takes the oldest queued alarm.
+//!
+//! \param psWatcher is the watcher.
+//! \param psEvent receives the alarm.
+//!
+//! There must be a single caller, which the interrupt handler may preempt.
+//!
+//! \return Returns \b false if no alarm is queued.
+//
+//*****************************************************************************
+bool
+ADCWatchEventGet(tADCWatcher *psWatcher, tADCWatchEvent *psEvent)
+{
+    uint32_t ui32Read;
+
+    ui32Read = psWatcher->ui32Read;
+    if(ui32Read == psWatcher->ui32Write)
+    {
+        return(false);
+    }
+
+    *psEvent = psWatcher->psQueue[ui32Read % ADC_WATCH_QUEUE_DEPTH];
+    psWatcher->ui32Read = ui32Read + 1;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Prints the watches and how often each has fired.
+//!
+//! \param psWatcher is the watcher.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ADCWatchReport(tADCWatcher *psWatcher)
+{
+    const tADCWatch *psWatch;
+    uint32_t ui32Idx;
+
+    UARTprintf("ADC watches (%s): %d alarms lost\n",
+               psWatcher->bEnabled ? "on" : "off", psWatcher->ui32Lost);
+    for(ui32Idx = 0; ui32Idx < psWatcher->ui32Count; ui32Idx++)
+    {
+        psWatch = &psWatcher->psWatches[ui32Idx];
+        UARTprintf("  %12s  ch %2d  %4s band, levels %4d/%4d  %6d alarms\n",
+                   psWatch->pcName, psWatch->ui32Channel,
+                   ADCWatchBand(psWatch->ui32Config), psWatch->ui32Low,
+                   psWatch->ui32High, psWatcher->pui32Alarms[ui32Idx]);
+    }
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
@@ -0,0 +1,120 @@
+//*****************************************************************************
+//
+// adcwatch.h - Threshold and window alarms from the ADC digital comparators.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_ADCWATCH_H__
+#define __UTILS_ADCWATCH_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The most watches: one comparator per step of a four-step sample sequence
+// (1 or 2).
+//
+//*****************************************************************************
+#define ADC_WATCH_MAX           4
+
+//*****************************************************************************
+//
+// Alarms held until the application takes them (a power of two).
+//
+//*****************************************************************************
+#define ADC_WATCH_QUEUE_DEPTH   16
+
+//*****************************************************************************
+//
+// A watch: one channel compared in hardware against two levels, which split
+// its range into a low band (below ui32Low), a mid band and a high band (at
+// or above ui32High).  ui32Config is an ADC_COMP_INT_* mode saying which
+// band entry raises the alarm; in the hysteresis modes (_HONCE, _HALWAYS)
+// the two levels are a threshold and its re-arm level, for example
+// ADC_COMP_INT_HIGH_HONCE alarms on reaching ui32High and not again until
+// the signal has dropped below ui32Low.
+//
+//*****************************************************************************
+typedef struct
+{
+    const char *pcName;
+    uint32_t ui32Channel;       // ADC_CTL_CH*
+    uint32_t ui32Config;        // ADC_COMP_INT_*
+    uint32_t ui32Low;
+    uint32_t ui32High;
+}
+tADCWatch;
+
+//*****************************************************************************
+//
+// An alarm: which watch, and the cycle count when its interrupt was taken.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Time;
+    uint32_t ui32Watch;         // index in the table given to the watcher
+}
+tADCWatchEvent;
+
+//*****************************************************************************
+//
+// The watcher: the ADC, the sample sequence given over to the comparators,
+// its interrupt, the watches and a function called from the interrupt
+// handler with the index of each watch that fires and the alarm time (or
+// 0), set by the application; the rest is private to adcwatch.c.  The
+// sequence is started by the same trigger as the sample stream and uses
+// comparators 0 to ui32Count - 1.  The application routes the sequence's
+// interrupt to ADCWatchIntHandler().
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Base;
+    uint32_t ui32Sequence;
+    uint32_t ui32Int;
+    uint32_t ui32Trigger;       // ADC_TRIGGER_*
+    const tADCWatch *psWatches;
+    uint32_t ui32Count;
+    void (*pfnNotify)(uint32_t ui32Watch, uint32_t ui32Time);
+
+    tADCWatchEvent psQueue[ADC_WATCH_QUEUE_DEPTH];
+    volatile uint32_t ui32Write;
+    volatile uint32_t ui32Read;
+    uint32_t pui32Alarms[ADC_WATCH_MAX];
+    uint32_t ui32Lost;          // alarms dropped because the queue was full
+    bool bEnabled;
+}
+tADCWatcher;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void ADCWatchInit(tADCWatcher *psWatcher);
+extern void ADCWatchEnable(tADCWatcher *psWatcher, bool bEnable);
+extern void ADCWatchIntHandler(tADCWatcher *psWatcher);
+extern bool ADCWatchEventGet(tADCWatcher *psWatcher,
+                             tADCWatchEvent *psEvent);
+extern void ADCWatchReport(tADCWatcher *psWatcher);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_ADCWATCH_H__
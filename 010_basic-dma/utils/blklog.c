@@ -0,0 +1,519 @@
+//*****************************************************************************
+//
+// blklog.c - Append-only log of sample blocks on a block device.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "utils/mempool.h"
+#include "utils/pipeline.h"
+#include "utils/telemetry.h"
+#include "utils/blockdev.h"
+#include "utils/blklog.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup blklog_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Markers ("BLKS", "BLKD" and the record's first byte).
+//
+//*****************************************************************************
+#define SUPER_MAGIC             0x534B4C42
+#define BLOCK_MAGIC             0x444B4C42
+#define RECORD_MAGIC            0xA5
+#define RECORD_HEADER           12
+#define FIRST_NONE              0xFFFF
+
+//*****************************************************************************
+//
+// States of a log.
+//
+//*****************************************************************************
+#define STATE_UNMOUNTED         0   // no device, or not formatted
+#define STATE_READY             1
+#define STATE_FULL              2
+#define STATE_FAILED            3   // a write failed; remount to go on
+
+static const char * const g_ppcStates[] =
+{
+    "not formatted", "ready", "full", "write failed"
+};
+
+//*****************************************************************************
+//
+// Payload of a buffer, and its first record offset (in the header).
+//
+//*****************************************************************************
+#define PAYLOAD(psLog, ui32Buf)                                               \
+        ((uint8_t *)(psLog)->pui32Buf[ui32Buf] + BLKLOG_HEADER)
+#define FIRST(psLog, ui32Buf)                                                 \
+        (((uint16_t *)(psLog)->pui32Buf[ui32Buf])[7])
+
+//*****************************************************************************
+//
+// CRC-16 of a data block's header and payload.
+//
+//*****************************************************************************
+static uint16_t
+BlkLogCRC(const uint32_t *pui32Block, uint32_t ui32Used)
+{
+    return(TelemetryCRC16(TelemetryCRC16(0xFFFF, (const uint8_t *)pui32Block,
+                                         16),
+                          (const uint8_t *)pui32Block + BLKLOG_HEADER,
+                          ui32Used));
+}
+
+//*****************************************************************************
+//
+// Tells whether data block ui32Index holds a valid block of the current
+// generation, reading it into the first buffer.
+//
+//*****************************************************************************
+static bool
+BlkLogBlockValid(tBlkLog *psLog, uint32_t ui32Index)
+{
+    uint32_t *pui32Block = psLog->pui32Buf[0];
+    uint32_t ui32Used;
+
+    if(!psLog->psDev->pfnRead(psLog->psDev->pvInst, ui32Index + 1,
+                              pui32Block))
+    {
+        return(false);
+    }
+
+    ui32Used = pui32Block[3] & 0xFFFF;
+    return((pui32Block[0] == BLOCK_MAGIC) &&
+           (pui32Block[1] == psLog->ui32Generation) &&
+           (pui32Block[2] == ui32Index) && (ui32Used <= BLKLOG_PAYLOAD) &&
+           (pui32Block[4] == BlkLogCRC(pui32Block, ui32Used)));
+}
+
+//*****************************************************************************
+//
+// Finishes the buffer being filled and queues it for writing.  There must
+// be a data block left for it.
+//
+//*****************************************************************************
+static void
+BlkLogSeal(tBlkLog *psLog)
+{
+    uint32_t *pui32Block = psLog->pui32Buf[psLog->ui32Fill];
+
+    pui32Block[0] = BLOCK_MAGIC;
+    pui32Block[1] = psLog->ui32Generation;
+    pui32Block[2] = psLog->ui32Assigned++;
+    pui32Block[3] = (pui32Block[3] & 0xFFFF0000) | psLog->ui32Used;
+    pui32Block[4] = BlkLogCRC(pui32Block, psLog->ui32Used);
+
+    psLog->ui32Sealed++;
+    psLog->ui32Fill = (psLog->ui32Fill + 1) % BLKLOG_BUFFERS;
+    psLog->ui32Used = 0;
+    if(psLog->ui32Sealed < BLKLOG_BUFFERS)
+    {
+        FIRST(psLog, psLog->ui32Fill) = FIRST_NONE;
+    }
+}
+
+//*****************************************************************************
+//
+// Copies bytes into the payload stream, sealing buffers as they fill.
+// BlkLogAppend() has checked that there is room.
+//
+//*****************************************************************************
+static void
+BlkLogCopy(tBlkLog *psLog, const void *pvData, uint32_t ui32Bytes)
+{
+    const uint8_t *pui8Data = pvData;
+    uint32_t ui32Chunk;
+
+    while(ui32Bytes)
+    {
+        ui32Chunk = BLKLOG_PAYLOAD - psLog->ui32Used;
+        if(ui32Chunk > ui32Bytes)
+        {
+            ui32Chunk = ui32Bytes;
+        }
+        memcpy(PAYLOAD(psLog, psLog->ui32Fill) + psLog->ui32Used, pui8Data,
+               ui32Chunk);
+        psLog->ui32Used += ui32Chunk;
+        pui8Data += ui32Chunk;
+        ui32Bytes -= ui32Chunk;
+
+        if(psLog->ui32Used == BLKLOG_PAYLOAD)
+        {
+            BlkLogSeal(psLog);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Writes the superblock and waits for it.
+//
+//*****************************************************************************
+static bool
+BlkLogWriteSuper(tBlkLog *psLog)
+{
+    uint32_t *pui32Block = psLog->pui32Buf[0];
+    uint32_t ui32Result;
+
+    memset(pui32Block, 0xFF, BLOCKDEV_BLOCK_SIZE);
+    pui32Block[0] = SUPER_MAGIC;
+    pui32Block[1] = psLog->ui32Generation;
+    pui32Block[2] = ~psLog->ui32Generation;
+
+    if(!psLog->psDev->pfnWriteStart(psLog->psDev->pvInst, 0, pui32Block))
+    {
+        return(false);
+    }
+    do
+    {
+        ui32Result = psLog->psDev->pfnWritePoll(psLog->psDev->pvInst);
+    }
+    while(ui32Result == BLOCKDEV_BUSY);
+
+    return(ui32Result == BLOCKDEV_DONE);
+}
+
+//*****************************************************************************
+//
+//! Opens the log on a device.
+//!
+//! \param psLog is the log.
+//! \param psDev is the device, or 0 if there is none.
+//!
+//! Reads the superblock and bisects the data blocks for the end of the log,
+//! about log2(blocks) reads.  A device that was never formatted is left
+//! unmounted; BlkLogFormat() prepares it.
+//!
+//! \return Returns \b true if a log was found.
+//
+//*****************************************************************************
+bool
+BlkLogMount(tBlkLog *psLog, tBlockDevice *psDev)
+{
+    uint32_t *pui32Block = psLog->pui32Buf[0];
+    uint32_t ui32Low, ui32High, ui32Mid;
+
+    memset(psLog, 0, sizeof(*psLog) - sizeof(psLog->pui32Buf));
+    psLog->psDev = psDev;
+    if(!psDev || (psDev->ui32Blocks < 2))
+    {
+        return(false);
+    }
+    psLog->ui32Blocks = psDev->ui32Blocks - 1;
+
+    if(!psDev->pfnRead(psDev->pvInst, 0, pui32Block) ||
+       (pui32Block[0] != SUPER_MAGIC) || (pui32Block[2] != ~pui32Block[1]))
+    {
+        return(false);
+    }
+    psLog->ui32Generation = pui32Block[1];
+
+    //
+    // Blocks are written in order, so the valid ones form a prefix.
+    //
+    ui32Low = 0;
+    ui32High = psLog->ui32Blocks;
+    while(ui32Low < ui32High)
+    {
+        ui32Mid = ui32Low + ((ui32High - ui32Low) / 2);
+        if(BlkLogBlockValid(psLog, ui32Mid))
+        {
+            ui32Low = ui32Mid + 1;
+        }
+        else
+        {
+            ui32High = ui32Mid;
+        }
+    }
+
+    psLog->ui32Assigned = ui32Low;
+    psLog->ui32Mounted = ui32Low;
+    FIRST(psLog, 0) = FIRST_NONE;
+    psLog->ui32State = (ui32Low < psLog->ui32Blocks) ? STATE_READY :
+                                                        STATE_FULL;
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Empties the log.
+//!
+//! \param psLog is the log, mounted or not, on a device.
+//!
+//! Pending blocks are discarded and a new generation is written to the
+//! superblock, which invalidates the old blocks without touching them.
+//! Waits for the device.
+//!
+//! \return Returns \b true if the superblock was written.
+//
+//*****************************************************************************
+bool
+BlkLogFormat(tBlkLog *psLog)
+{
+    tBlockDevice *psDev;
+    uint32_t ui32Generation;
+
+    if(!psLog->psDev || (psLog->psDev->ui32Blocks < 2))
+    {
+        return(false);
+    }
+    while(psLog->bWriting &&
+          (psLog->psDev->pfnWritePoll(psLog->psDev->pvInst) == BLOCKDEV_BUSY))
+    {
+    }
+
+    psDev = psLog->psDev;
+    ui32Generation = psLog->ui32Generation + 1;
+    memset(psLog, 0, sizeof(*psLog) - sizeof(psLog->pui32Buf));
+    psLog->psDev = psDev;
+    psLog->ui32Generation = ui32Generation;
+    psLog->ui32Blocks = psDev->ui32Blocks - 1;
+
+    if(!BlkLogWriteSuper(psLog))
+    {
+        psLog->ui32State = STATE_FAILED;
+        psLog->ui32Errors++;
+        return(false);
+    }
+    FIRST(psLog, 0) = FIRST_NONE;
+    psLog->ui32State = STATE_READY;
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Adds a record to the log.
+//!
+//! \param psLog is the log.
+//! \param ui32Format is the PIPE_FORMAT_ value of the data.
+//! \param ui32Seq is the block's sequence number.
+//! \param ui32Time is the time in milliseconds.
+//! \param pvData is the data.
+//! \param ui32Bytes is its length, at most \b BLKLOG_MAX_DATA.
+//!
+//! The record is copied into the block buffers, which BlkLogService() then
+//! writes.  If it does not fit in the buffers free at the moment nothing is
+//! copied; the caller retries once a write has finished.
+//!
+//! \return Returns one of the \b BLKLOG_ values.
+//
+//*****************************************************************************
+uint32_t
+BlkLogAppend(tBlkLog *psLog, uint32_t ui32Format, uint32_t ui32Seq,
+             uint32_t ui32Time, const void *pvData, uint32_t ui32Bytes)
+{
+    static const uint8_t pui8Pad[3] = { 0, 0, 0 };
+    uint32_t pui32Header[3];
+    uint32_t ui32Need, ui32Left, ui32Free;
+
+    ui32Need = RECORD_HEADER + ((ui32Bytes + 3) & ~3);
+    ui32Left = psLog->ui32Blocks - psLog->ui32Assigned;
+    if((psLog->ui32State != STATE_READY) || (ui32Bytes > BLKLOG_MAX_DATA) ||
+       ((ui32Left <= BLKLOG_BUFFERS) &&
+        ((ui32Left * BLKLOG_PAYLOAD) - psLog->ui32Used < ui32Need)))
+    {
+        if((psLog->ui32State == STATE_READY) && (ui32Bytes <= BLKLOG_MAX_DATA))
+        {
+            psLog->ui32State = STATE_FULL;
+        }
+        psLog->ui32Dropped++;
+        return(BLKLOG_DROPPED);
+    }
+
+    //
+    // Room in the buffers that are free, the one being filled included.
+    //
+    ui32Free = BLKLOG_BUFFERS - psLog->ui32Sealed;
+    if(ui32Free > ui32Left)
+    {
+        ui32Free = ui32Left;
+    }
+    if(ui32Free * BLKLOG_PAYLOAD < psLog->ui32Used + ui32Need)
+    {
+        //
+        // With nothing being written no room will come; start the record in
+        // a fresh buffer instead.
+        //
+        if(!psLog->ui32Sealed && psLog->ui32Used)
+        {
+            BlkLogSeal(psLog);
+        }
+        return(BLKLOG_BUSY);
+    }
+
+    pui32Header[0] = (RECORD_MAGIC << 24) | ((ui32Format & 0xFF) << 16) |
+                     (ui32Bytes & 0xFFFF);
+    pui32Header[1] = ui32Seq;
+    pui32Header[2] = ui32Time;
+
+    if(FIRST(psLog, psLog->ui32Fill) == FIRST_NONE)
+    {
+        FIRST(psLog, psLog->ui32Fill) = psLog->ui32Used;
+    }
+
+    BlkLogCopy(psLog, pui32Header, RECORD_HEADER);
+    BlkLogCopy(psLog, pvData, ui32Bytes);
+    BlkLogCopy(psLog, pui8Pad, (4 - (ui32Bytes & 3)) & 3);
+    psLog->ui32Records++;
+
+    return(BLKLOG_OK);
+}
+
+//*****************************************************************************
+//
+//! Queues the partly filled buffer for writing.
+//!
+//! \param psLog is the log.
+//!
+//! The rest of that block stays unused.  Call before the device may go
+//! away, and BlkLogService() until it returns \b false.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+BlkLogFlush(tBlkLog *psLog)
+{
+    if(psLog->ui32Used)
+    {
+        BlkLogSeal(psLog);
+    }
+}
+
+//*****************************************************************************
+//
+//! Moves filled buffers to the device.
+//!
+//! \param psLog is the log.
+//!
+//! Call from the main loop.  Polls the write in progress and starts the next
+//! one, so a call takes no longer than a few bytes on the bus.  A failed
+//! write stops the log.
+//!
+//! \return Returns \b true while writes are pending.
+//
+//*****************************************************************************
+bool
+BlkLogService(tBlkLog *psLog)
+{
+    uint32_t ui32Result, ui32Buf;
+
+    if(psLog->bWriting)
+    {
+        ui32Result = psLog->psDev->pfnWritePoll(psLog->psDev->pvInst);
+        if(ui32Result == BLOCKDEV_BUSY)
+        {
+            return(true);
+        }
+
+        psLog->bWriting = false;
+        if(psLog->ui32Sealed-- == BLKLOG_BUFFERS)
+        {
+            FIRST(psLog, psLog->ui32Fill) = FIRST_NONE;     // free again
+        }
+        if(ui32Result == BLOCKDEV_DONE)
+        {
+            psLog->ui32Written++;
+        }
+        else
+        {
+            psLog->ui32Errors++;
+            psLog->ui32State = STATE_FAILED;
+        }
+    }
+
+    if(!psLog->ui32Sealed)
+    {
+        return(false);
+    }
+    if(psLog->ui32State == STATE_FAILED)
+    {
+        psLog->ui32Sealed = 0;
+        psLog->ui32Used = 0;
+        return(false);
+    }
+
+    ui32Buf = (psLog->ui32Fill + BLKLOG_BUFFERS - psLog->ui32Sealed) %
+              BLKLOG_BUFFERS;
+    if(!psLog->psDev->pfnWriteStart(psLog->psDev->pvInst,
+                                    psLog->pui32Buf[ui32Buf][2] + 1,
+                                    psLog->pui32Buf[ui32Buf]))
+    {
+        psLog->ui32Errors++;
+        psLog->ui32State = STATE_FAILED;
+        return(true);
+    }
+    psLog->bWriting = true;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Pipeline stage that appends each block to the log while recording.
+//!
+//! \param pvState is a tBlkLogStage.
+//! \param psBlock is the block.
+//!
+//! Blocks wait in the pipeline while the device catches up; they are
+//! dropped from the log, not from the pipeline, once it is full.
+//!
+//! \return Returns \b PIPE_CONTINUE, or \b PIPE_BUSY while no buffer is
+//! free.
+//
+//*****************************************************************************
+uint32_t
+BlkLogStageWrite(void *pvState, tPipeBlock *psBlock)
+{
+    tBlkLogStage *psStage = pvState;
+    uint32_t ui32Time;
+
+    ui32Time = psStage->pfnTime();
+    if(psStage->bRecording &&
+       (BlkLogAppend(psStage->psLog, psBlock->ui32Format, psBlock->ui32Seq,
+                     ui32Time, psBlock->pvData,
+                     PIPE_BLOCK_BYTES(psBlock)) == BLKLOG_BUSY))
+    {
+        return(PIPE_BUSY);
+    }
+
+    return(PIPE_CONTINUE);
+}
+
+//*****************************************************************************
+//
+//! Prints the state of the log.
+//!
+//! \param psLog is the log.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+BlkLogReport(tBlkLog *psLog)
+{
+    UARTprintf("SD: %s, %d MB, generation %d, %d of %d blocks used "
+               "(%d at mount)\n", g_ppcStates[psLog->ui32State],
+               (psLog->ui32Blocks + 1) / 2048, psLog->ui32Generation,
+               psLog->ui32Assigned, psLog->ui32Blocks, psLog->ui32Mounted);
+    UARTprintf("    %d records, %d blocks written, %d records dropped, "
+               "%d write errors\n", psLog->ui32Records, psLog->ui32Written,
+               psLog->ui32Dropped, psLog->ui32Errors);
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
@@ -0,0 +1,126 @@
+//*****************************************************************************
+//
+// blklog.h - Append-only log of sample blocks on a block device.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_BLKLOG_H__
+#define __UTILS_BLKLOG_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Layout.  The device is used raw, without a file system.  Block 0 holds
+//
+//     "BLKS" (4) | generation (4) | ~generation (4)
+//
+// and the blocks after it are written in order, each starting with
+//
+//     "BLKD" (4) | generation (4) | index (4) | used (2), first (2) | CRC-16 (4)
+//
+// where index counts from 0 at block 1, used is the number of payload bytes
+// following the header and first is the offset of the first record that
+// starts in the payload (0xFFFF if none).  The CRC-16 (telemetry.c) covers
+// the first four words and the payload.  The payloads form one stream of
+// records,
+//
+//     0xA5, format, length (4) | block sequence (4) | time (4) | data, padded
+//     to a word
+//
+// which may continue from one block to the next: the bytes before first
+// belong to the record that began earlier.  Formatting raises the
+// generation, which invalidates every block at once; the log then ends at
+// the first block that is not valid for the current generation, which
+// BlkLogMount() finds by bisection.  A partly filled block (after
+// BlkLogFlush() or a reset) is left as it is and the log continues in the
+// next one; a record cut off that way is dropped by the reader because the
+// next block's first does not match.
+//
+//*****************************************************************************
+#define BLKLOG_BUFFERS          2
+#define BLKLOG_HEADER           20
+#define BLKLOG_PAYLOAD          (BLOCKDEV_BLOCK_SIZE - BLKLOG_HEADER)
+#define BLKLOG_MAX_DATA         (BLKLOG_BUFFERS * BLKLOG_PAYLOAD - 12)
+
+//*****************************************************************************
+//
+// Values returned by BlkLogAppend().
+//
+//*****************************************************************************
+#define BLKLOG_OK               0
+#define BLKLOG_BUSY             1   // no buffer free yet; try again later
+#define BLKLOG_DROPPED          2   // not mounted, full or failed
+
+//*****************************************************************************
+//
+// A log.  The members are private to blklog.c.
+//
+//*****************************************************************************
+typedef struct
+{
+    tBlockDevice *psDev;
+    uint32_t ui32State;
+    uint32_t ui32Generation;
+    uint32_t ui32Blocks;        // data blocks, after block 0
+    uint32_t ui32Assigned;      // index the next sealed buffer gets
+    uint32_t ui32Fill;          // buffer being filled
+    uint32_t ui32Used;          // payload bytes in it
+    uint32_t ui32Sealed;        // filled buffers not yet written
+    bool bWriting;              // the oldest of them is being written
+    uint32_t ui32Mounted;       // blocks in use when mounted
+    uint32_t ui32Records;       // records appended since mounted
+    uint32_t ui32Written;       // blocks written since mounted
+    uint32_t ui32Dropped;       // records refused
+    uint32_t ui32Errors;        // failed writes
+    uint32_t pui32Buf[BLKLOG_BUFFERS][BLOCKDEV_BLOCK_SIZE / 4];
+}
+tBlkLog;
+
+//*****************************************************************************
+//
+// State of BlkLogStageWrite(), as for FlashLogStageWrite().
+//
+//*****************************************************************************
+typedef struct
+{
+    tBlkLog *psLog;
+    uint32_t (*pfnTime)(void);
+    bool bRecording;
+}
+tBlkLogStage;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern bool BlkLogMount(tBlkLog *psLog, tBlockDevice *psDev);
+extern bool BlkLogFormat(tBlkLog *psLog);
+extern uint32_t BlkLogAppend(tBlkLog *psLog, uint32_t ui32Format,
+                             uint32_t ui32Seq, uint32_t ui32Time,
+                             const void *pvData, uint32_t ui32Bytes);
+extern void BlkLogFlush(tBlkLog *psLog);
+extern bool BlkLogService(tBlkLog *psLog);
+extern uint32_t BlkLogStageWrite(void *pvState, tPipeBlock *psBlock);
+extern void BlkLogReport(tBlkLog *psLog);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_BLKLOG_H__
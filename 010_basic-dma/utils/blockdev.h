@@ -0,0 +1,67 @@
+//*****************************************************************************
+//
+// blockdev.h - Interface to storage addressed in 512-byte blocks.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_BLOCKDEV_H__
+#define __UTILS_BLOCKDEV_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The block size of every device.
+//
+//*****************************************************************************
+#define BLOCKDEV_BLOCK_SIZE     512
+
+//*****************************************************************************
+//
+// Values returned by pfnWritePoll.
+//
+//*****************************************************************************
+#define BLOCKDEV_DONE           0   // no write in progress; the last one worked
+#define BLOCKDEV_BUSY           1   // the write is still in progress
+#define BLOCKDEV_ERROR          2   // the last write failed
+
+//*****************************************************************************
+//
+// A block device.  Reads wait for the data; writes are started by
+// pfnWriteStart and then polled, from the main loop, until pfnWritePoll
+// stops returning BLOCKDEV_BUSY, so the caller can keep working while the
+// device programs the block.  Buffers are word aligned and must stay
+// untouched until the write is done.  A driver (sdspi.c, for example) fills
+// this in when it finds its device.
+//
+//*****************************************************************************
+typedef struct
+{
+    void *pvInst;
+    uint32_t ui32Blocks;
+    bool (*pfnRead)(void *pvInst, uint32_t ui32Block, void *pvData);
+    bool (*pfnWriteStart)(void *pvInst, uint32_t ui32Block,
+                          const void *pvData);
+    uint32_t (*pfnWritePoll)(void *pvInst);
+}
+tBlockDevice;
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_BLOCKDEV_H__
@@ -0,0 +1,221 @@
+//*****************************************************************************
+//
+// boottime.c - Boot phase time stamps and overlapped peripheral bring-up.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_types.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/boottime.h"
+#include "utils/cyclecount.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup boottime_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// The marks are written before the C run-time has initialized memory, so they
+// must not be part of .bss.  g_ui32BootMarked has one bit per phase and is
+// cleared by _system_pre_init().
+//
+//*****************************************************************************
+#pragma NOINIT(g_pui32BootMarks)
+static uint32_t g_pui32BootMarks[NUM_BOOT_PHASES];
+
+#pragma NOINIT(g_ui32BootMarked)
+static uint32_t g_ui32BootMarked;
+
+static const char * const g_ppcBootPhaseNames[NUM_BOOT_PHASES] =
+{
+    "reset handler     ",
+    "C run-time init   ",
+    "PLL lock          ",
+    "peripheral ready  ",
+    "ADC/uDMA setup    ",
+    "first block       "
+};
+
+//*****************************************************************************
+//
+//! Hook called by the TI run-time (_c_int00) before it copies .data and
+//! zeroes .bss.
+//!
+//! It resets the boot marks and records the end of the reset handler.
+//!
+//! \return Returns 1 so that the run-time goes on to initialize variables.
+//
+//*****************************************************************************
+int
+_system_pre_init(void)
+{
+    g_ui32BootMarked = 0;
+    BootTimeMark(BOOT_PHASE_CINIT);
+
+    return(1);
+}
+
+//*****************************************************************************
+//
+//! Records the end of a boot phase.
+//!
+//! \param ui32Phase is one of the \b BOOT_PHASE_ values.
+//!
+//! Only the first call for each phase is recorded, so this may be called from
+//! a loop (for example on every completed block) at the cost of one test.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+BootTimeMark(uint32_t ui32Phase)
+{
+    if((ui32Phase < NUM_BOOT_PHASES) &&
+       !(g_ui32BootMarked & (1 << ui32Phase)))
+    {
+        g_pui32BootMarks[ui32Phase] = CycleCountGet();
+        g_ui32BootMarked |= 1 << ui32Phase;
+    }
+}
+
+//*****************************************************************************
+//
+//! Retrieves a boot mark.
+//!
+//! \param ui32Phase is one of the \b BOOT_PHASE_ values.
+//! \param pui32Cycles receives the cycle count at the end of the phase.
+//!
+//! \return Returns \b true if the phase has been reached.
+//
+//*****************************************************************************
+bool
+BootTimeGet(uint32_t ui32Phase, uint32_t *pui32Cycles)
+{
+    if((ui32Phase >= NUM_BOOT_PHASES) ||
+       !(g_ui32BootMarked & (1 << ui32Phase)))
+    {
+        return(false);
+    }
+
+    *pui32Cycles = g_pui32BootMarks[ui32Phase];
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Enables the clocks of a set of peripherals without waiting for them.
+//!
+//! \param pui32Peripherals is an array of \b SYSCTL_PERIPH_ values.
+//! \param ui32Count is the number of entries in the array.
+//!
+//! Enabling every clock up front lets the peripherals come out of reset in
+//! parallel (and, if called before SysCtlClockSet(), while the PLL locks)
+//! instead of spinning on SysCtlPeripheralReady() after each one.  Call
+//! BootPeripheralsWait() before touching any of their registers.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+BootPeripheralsEnable(const uint32_t *pui32Peripherals, uint32_t ui32Count)
+{
+    while(ui32Count--)
+    {
+        MAP_SysCtlPeripheralEnable(*pui32Peripherals++);
+    }
+}
+
+//*****************************************************************************
+//
+//! Waits until a set of peripherals enabled by BootPeripheralsEnable() are
+//! ready for register access.
+//!
+//! \param pui32Peripherals is an array of \b SYSCTL_PERIPH_ values.
+//! \param ui32Count is the number of entries in the array.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+BootPeripheralsWait(const uint32_t *pui32Peripherals, uint32_t ui32Count)
+{
+    while(ui32Count--)
+    {
+        while(!MAP_SysCtlPeripheralReady(*pui32Peripherals))
+        {
+        }
+        pui32Peripherals++;
+    }
+}
+
+//*****************************************************************************
+//
+// Converts a cycle count to microseconds at the given clock.
+//
+//*****************************************************************************
+static uint32_t
+CyclesToMicroseconds(uint32_t ui32Cycles, uint32_t ui32Hz)
+{
+    return((uint32_t)(((uint64_t)ui32Cycles * 1000000) / ui32Hz));
+}
+
+//*****************************************************************************
+//
+//! Prints the duration of each boot phase to the UART console.
+//!
+//! \param ui32SysClock is the system clock after BOOT_PHASE_CLOCK, in Hz.
+//! \param ui32FirstSampleCycles is the number of cycles between arming the
+//! trigger timer and the first conversion (the timer period), or 0 if not
+//! applicable.
+//!
+//! Phases up to and including the PLL lock run from the PIOSC, later ones
+//! from the system clock; the times in microseconds account for that.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+BootTimeReport(uint32_t ui32SysClock, uint32_t ui32FirstSampleCycles)
+{
+    uint32_t ui32Phase, ui32Prev = 0, ui32Cycles, ui32Hz, ui32Micros;
+    uint32_t ui32Total = 0;
+
+    UARTprintf("Boot phase            cycles      us\n");
+    for(ui32Phase = 0; ui32Phase < NUM_BOOT_PHASES; ui32Phase++)
+    {
+        if(!BootTimeGet(ui32Phase, &ui32Cycles))
+        {
+            continue;
+        }
+
+        ui32Hz = (ui32Phase <= BOOT_PHASE_CLOCK) ? BOOT_RESET_CLOCK_HZ :
+                                                   ui32SysClock;
+        ui32Micros = CyclesToMicroseconds(ui32Cycles - ui32Prev, ui32Hz);
+        ui32Total += ui32Micros;
+        UARTprintf("  %s %8d %7d\n", g_ppcBootPhaseNames[ui32Phase],
+                   ui32Cycles - ui32Prev, ui32Micros);
+        ui32Prev = ui32Cycles;
+
+        if((ui32Phase == BOOT_PHASE_ARMED) && ui32FirstSampleCycles)
+        {
+            UARTprintf("Reset to first ADC sample: %d us\n",
+                       ui32Total + CyclesToMicroseconds(ui32FirstSampleCycles,
+                                                        ui32SysClock));
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
@@ -0,0 +1,65 @@
+//*****************************************************************************
+//
+// boottime.h - Boot phase time stamps and overlapped peripheral bring-up.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_BOOTTIME_H__
+#define __UTILS_BOOTTIME_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Boot phases, in the order they are reached.  Each mark is the DWT cycle
+// count at the end of the phase; reset itself is cycle 0 (see ResetISR()).
+//
+//*****************************************************************************
+#define BOOT_PHASE_CINIT        0   // C run-time entered _system_pre_init()
+#define BOOT_PHASE_MAIN         1   // .data copied, .bss zeroed, main() entered
+#define BOOT_PHASE_CLOCK        2   // PLL locked and system clock switched
+#define BOOT_PHASE_PERIPH       3   // all peripherals clocked and ready
+#define BOOT_PHASE_ARMED        4   // ADC, uDMA and trigger timer running
+#define BOOT_PHASE_FIRST_BLOCK  5   // first DMA block of samples complete
+#define NUM_BOOT_PHASES         6
+
+//*****************************************************************************
+//
+// The core runs from the 16 MHz PIOSC until the system clock is switched.
+//
+//*****************************************************************************
+#define BOOT_RESET_CLOCK_HZ     16000000
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void BootTimeMark(uint32_t ui32Phase);
+extern bool BootTimeGet(uint32_t ui32Phase, uint32_t *pui32Cycles);
+extern void BootPeripheralsEnable(const uint32_t *pui32Peripherals,
+                                  uint32_t ui32Count);
+extern void BootPeripheralsWait(const uint32_t *pui32Peripherals,
+                                uint32_t ui32Count);
+extern void BootTimeReport(uint32_t ui32SysClock,
+                           uint32_t ui32FirstSampleCycles);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_BOOTTIME_H__
@@ -0,0 +1,519 @@
+//*****************************************************************************
+//
+// capture.c - Triggered capture of the sample stream with pre-trigger history.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_types.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/cyclecount.h"
+#include "utils/mempool.h"
+#include "utils/pipeline.h"
+#include "utils/telemetry.h"
+#include "utils/capture.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup capture_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// States of a capture.  Armed, the history is kept and the trigger looked
+// for; triggered, the history is kept until the window is complete; frozen,
+// the history is left alone while the window is sent, after which the
+// capture arms again.
+//
+//*****************************************************************************
+#define CAPTURE_IDLE            0
+#define CAPTURE_ARMED           1
+#define CAPTURE_TRIGGERED       2
+#define CAPTURE_FROZEN          3
+
+static const char * const g_ppcStates[] =
+{
+    "off", "armed", "triggered", "sending"
+};
+
+static const char * const g_ppcTriggers[] =
+{
+    "none", "above", "rising", "falling", "external"
+};
+
+//*****************************************************************************
+//
+// The frame being built by CaptureService().
+//
+//*****************************************************************************
+static uint8_t g_pui8Frame[TELEM_MAX_PAYLOAD];
+
+//*****************************************************************************
+//
+// Stores little-endian fields of a frame header.
+//
+//*****************************************************************************
+static void
+CapturePut16(uint8_t *pui8Dst, uint32_t ui32Value)
+{
+    pui8Dst[0] = ui32Value & 0xFF;
+    pui8Dst[1] = (ui32Value >> 8) & 0xFF;
+}
+
+static void
+CapturePut32(uint8_t *pui8Dst, uint32_t ui32Value)
+{
+    CapturePut16(pui8Dst, ui32Value);
+    CapturePut16(pui8Dst + 2, ui32Value >> 16);
+}
+
+//*****************************************************************************
+//
+// Looks for the trigger in a block that follows the history, setting
+// ui32TrigIndex if it is found.  An external trigger is placed by counting
+// sample periods back from the cycle count of the block's last sample; one
+// that came after that sample belongs to a later block.
+//
+//*****************************************************************************
+static bool
+CaptureFind(tCapture *psCapture, const tPipeBlock *psBlock,
+            uint32_t ui32First)
+{
+    const uint16_t *pui16Data = psBlock->pvData;
+    uint32_t ui32Idx, ui32Sample, ui32Prev, ui32Back, ui32Oldest;
+    bool bPrev, bHit;
+
+    if(psCapture->ui32Trigger == CAPTURE_TRIG_EXTERNAL)
+    {
+        if(!psCapture->bExtPending ||
+           ((int32_t)(psBlock->ui32Time - psCapture->ui32ExtTime) < 0))
+        {
+            return(false);
+        }
+
+        ui32Back = ((psBlock->ui32Time - psCapture->ui32ExtTime) /
+                    psCapture->ui32Period);
+        psCapture->ui32TrigIndex = ui32First + psBlock->ui32Length - 1 -
+                                   ui32Back;
+        ui32Oldest = ui32First - psCapture->ui32Held;
+        if((int32_t)(psCapture->ui32TrigIndex - ui32Oldest) < 0)
+        {
+            psCapture->ui32TrigIndex = ui32Oldest;
+        }
+        psCapture->bExtPending = false;
+        return(true);
+    }
+
+    bPrev = (psCapture->ui32Held != 0);
+    ui32Prev = psCapture->ui32Last;
+    for(ui32Idx = 0; ui32Idx < psBlock->ui32Length; ui32Idx++)
+    {
+        ui32Sample = pui16Data[ui32Idx];
+        switch(psCapture->ui32Trigger)
+        {
+            case CAPTURE_TRIG_ABOVE:
+                bHit = (ui32Sample >= psCapture->ui32Level);
+                break;
+            case CAPTURE_TRIG_RISING:
+                bHit = bPrev && (ui32Prev < psCapture->ui32Level) &&
+                       (ui32Sample >= psCapture->ui32Level);
+                break;
+            default:
+                bHit = bPrev && (ui32Prev >= psCapture->ui32Level) &&
+                       (ui32Sample < psCapture->ui32Level);
+                break;
+        }
+        if(bHit)
+        {
+            psCapture->ui32TrigIndex = ui32First + ui32Idx;
+            return(true);
+        }
+        ui32Prev = ui32Sample;
+        bPrev = true;
+    }
+
+    return(false);
+}
+
+//*****************************************************************************
+//
+// Fixes the window once its last sample is held, and hands it to
+// CaptureService().
+//
+//*****************************************************************************
+static void
+CaptureFreeze(tCapture *psCapture)
+{
+    uint32_t ui32Now, ui32End, ui32Oldest;
+
+    ui32Now = CycleCountGet();
+    ui32End = psCapture->ui32TrigIndex + psCapture->ui32Post;
+    ui32Oldest = psCapture->ui32Next - psCapture->ui32Held;
+
+    //
+    // Less history than asked for (just after arming, or after lost blocks)
+    // shortens the part before the trigger; the frames say by how much.
+    //
+    psCapture->ui32Start = psCapture->ui32TrigIndex - psCapture->ui32Pre;
+    if((int32_t)(psCapture->ui32Start - ui32Oldest) < 0)
+    {
+        psCapture->ui32Start = ui32Oldest;
+    }
+    psCapture->ui32Length = ui32End - psCapture->ui32Start;
+    psCapture->ui32Sent = 0;
+
+    if(psCapture->ui32Captures &&
+       ((ui32Now - psCapture->ui32FrozenAt) < psCapture->ui32MinInterval))
+    {
+        psCapture->ui32MinInterval = ui32Now - psCapture->ui32FrozenAt;
+    }
+    psCapture->ui32FrozenAt = ui32Now;
+    psCapture->ui32Captures++;
+    psCapture->ui32State = CAPTURE_FROZEN;
+}
+
+//*****************************************************************************
+//
+//! Prepares a capture, disarmed.
+//!
+//! \param psCapture is the capture, with its application members set.
+//! \param ui32Period is the sample period in cycles.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+CaptureInit(tCapture *psCapture, uint32_t ui32Period)
+{
+    psCapture->ui32State = CAPTURE_IDLE;
+    psCapture->ui32Trigger = CAPTURE_TRIG_OFF;
+    psCapture->ui32Period = ui32Period;
+    psCapture->ui32Held = 0;
+    psCapture->bExtPending = false;
+    psCapture->ui16Frame = 0;
+    psCapture->ui32Captures = 0;
+    psCapture->ui32Broken = 0;
+    psCapture->ui32MinInterval = 0xFFFFFFFF;
+    psCapture->ui32Rearm = 0;
+    psCapture->ui32MaxRearm = 0;
+    psCapture->ui32Blind = 0;
+    psCapture->bBlindPending = false;
+}
+
+//*****************************************************************************
+//
+//! Gives a capture the sample period after the rate changes.
+//!
+//! \param psCapture is the capture.
+//! \param ui32Period is the sample period in cycles.
+//!
+//! Only external triggers use the period, to turn their cycle counts into
+//! sample positions.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+CaptureRateSet(tCapture *psCapture, uint32_t ui32Period)
+{
+    psCapture->ui32Period = ui32Period;
+}
+
+//*****************************************************************************
+//
+//! Arms a capture, or disarms it.
+//!
+//! \param psCapture is the capture.
+//! \param ui32Trigger is one of the \b CAPTURE_TRIG_ values;
+//! \b CAPTURE_TRIG_OFF disarms.
+//! \param ui32Level is the level of the level triggers.
+//!
+//! The history starts again from the next block.  Once a window has been
+//! captured and sent, the capture arms again with the same trigger, so
+//! captures repeat for as long as the trigger does.  A window being sent is
+//! abandoned.  Call from the context that runs the pipeline.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+CaptureArm(tCapture *psCapture, uint32_t ui32Trigger, uint32_t ui32Level)
+{
+    psCapture->ui32State = CAPTURE_IDLE;
+    psCapture->ui32Trigger = ui32Trigger;
+    psCapture->ui32Level = ui32Level;
+    psCapture->ui32Held = 0;
+    psCapture->bExtPending = false;
+    psCapture->bBlindPending = false;
+    if(ui32Trigger != CAPTURE_TRIG_OFF)
+    {
+        psCapture->ui32State = CAPTURE_ARMED;
+    }
+}
+
+//*****************************************************************************
+//
+//! Triggers a capture armed with \b CAPTURE_TRIG_EXTERNAL.
+//!
+//! \param psCapture is the capture.
+//! \param ui32Time is the cycle count of the event.
+//!
+//! Call from the interrupt handler of the event, taking the cycle count
+//! first thing.  The first event while armed wins; later ones are ignored
+//! until the capture arms again.  Handlers that call this must not preempt
+//! each other.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+CaptureTrigger(tCapture *psCapture, uint32_t ui32Time)
+{
+    if((psCapture->ui32State == CAPTURE_ARMED) &&
+       (psCapture->ui32Trigger == CAPTURE_TRIG_EXTERNAL) &&
+       !psCapture->bExtPending)
+    {
+        psCapture->ui32ExtTime = ui32Time;
+        psCapture->bExtPending = true;
+    }
+}
+
+//*****************************************************************************
+//
+//! Pipeline stage: keeps the history and completes the window.
+//!
+//! \param pvState is the capture.
+//! \param psBlock is a block of PIPE_FORMAT_SAMPLES16 samples.
+//!
+//! Armed, the samples are copied to the history, overwriting the oldest, and
+//! looked through for the trigger.  Once triggered, the blocks are copied up
+//! to the end of the window, which is then frozen until CaptureService() has
+//! sent it; blocks pass through untouched meanwhile.  A block missing from
+//! the sequence breaks the history, and the window if one was being
+//! completed.  Runs before any stage that codes the samples in place.
+//!
+//! \return Returns \b PIPE_CONTINUE.
+//
+//*****************************************************************************
+uint32_t
+CaptureStage(void *pvState, tPipeBlock *psBlock)
+{
+    tCapture *psCapture = pvState;
+    const uint16_t *pui16Data = psBlock->pvData;
+    uint32_t ui32First, ui32Count, ui32Idx, ui32Pos;
+    int32_t i32Left;
+
+    if((psCapture->ui32State != CAPTURE_ARMED) &&
+       (psCapture->ui32State != CAPTURE_TRIGGERED))
+    {
+        return(PIPE_CONTINUE);
+    }
+
+    ui32First = psBlock->ui32Seq * psBlock->ui32Length;
+    if(psCapture->bBlindPending)
+    {
+        psCapture->ui32Blind = ui32First + psCapture->ui32Pre -
+                               (psCapture->ui32Start + psCapture->ui32Length);
+        psCapture->bBlindPending = false;
+    }
+    if(psCapture->ui32Held && (ui32First != psCapture->ui32Next))
+    {
+        if(psCapture->ui32State == CAPTURE_TRIGGERED)
+        {
+            psCapture->ui32Broken++;
+            psCapture->ui32State = CAPTURE_ARMED;
+        }
+        psCapture->ui32Held = 0;
+    }
+
+    if((psCapture->ui32State == CAPTURE_ARMED) &&
+       CaptureFind(psCapture, psBlock, ui32First))
+    {
+        psCapture->ui32State = CAPTURE_TRIGGERED;
+    }
+
+    //
+    // Copy the block, stopping at the end of the window once triggered (an
+    // external trigger may even place it before this block).
+    //
+    ui32Count = psBlock->ui32Length;
+    if(psCapture->ui32State == CAPTURE_TRIGGERED)
+    {
+        i32Left = (int32_t)(psCapture->ui32TrigIndex + psCapture->ui32Post -
+                            ui32First);
+        if(i32Left < (int32_t)ui32Count)
+        {
+            ui32Count = (i32Left > 0) ? i32Left : 0;
+        }
+    }
+
+    ui32Pos = ui32First % psCapture->ui32Size;
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        psCapture->pui16History[ui32Pos] = pui16Data[ui32Idx];
+        if(++ui32Pos == psCapture->ui32Size)
+        {
+            ui32Pos = 0;
+        }
+    }
+    if(ui32Count)
+    {
+        psCapture->ui32Last = pui16Data[ui32Count - 1];
+    }
+    psCapture->ui32Next = ui32First + ui32Count;
+    psCapture->ui32Held += ui32Count;
+    if(psCapture->ui32Held > psCapture->ui32Size)
+    {
+        psCapture->ui32Held = psCapture->ui32Size;
+    }
+
+    if((psCapture->ui32State == CAPTURE_TRIGGERED) &&
+       ((int32_t)(psCapture->ui32Next - psCapture->ui32TrigIndex) >=
+        (int32_t)psCapture->ui32Post))
+    {
+        CaptureFreeze(psCapture);
+    }
+
+    return(PIPE_CONTINUE);
+}
+
+//*****************************************************************************
+//
+//! Sends a frozen window as telemetry frames, then arms again.
+//!
+//! \param psCapture is the capture.
+//!
+//! Call from the main loop.  Frames of \b TELEM_TYPE_CAPTURE are sent for as
+//! long as the transmit buffer takes them; the rest follow on later calls.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+CaptureService(tCapture *psCapture)
+{
+    uint32_t ui32Count, ui32Idx, ui32Pos, ui32Now;
+    uint8_t *pui8Sample;
+
+    while(psCapture->ui32State == CAPTURE_FROZEN)
+    {
+        if(psCapture->ui32Sent == psCapture->ui32Length)
+        {
+            CaptureArm(psCapture, psCapture->ui32Trigger,
+                       psCapture->ui32Level);
+
+            ui32Now = CycleCountGet();
+            psCapture->ui32Rearm = ui32Now - psCapture->ui32FrozenAt;
+            if(psCapture->ui32Rearm > psCapture->ui32MaxRearm)
+            {
+                psCapture->ui32MaxRearm = psCapture->ui32Rearm;
+            }
+            psCapture->bBlindPending = true;
+            break;
+        }
+
+        ui32Count = psCapture->ui32Length - psCapture->ui32Sent;
+        if(ui32Count > CAPTURE_FRAME_SAMPLES)
+        {
+            ui32Count = CAPTURE_FRAME_SAMPLES;
+        }
+        if(UARTTxBytesFree() <=
+           TELEM_ENCODED_SIZE(CAPTURE_HEADER_SIZE + (ui32Count * 2)))
+        {
+            break;      // no room yet; build the frame when it will go
+        }
+
+        CapturePut16(g_pui8Frame, psCapture->ui32Captures);
+        CapturePut16(g_pui8Frame + 2, psCapture->ui32Sent);
+        CapturePut16(g_pui8Frame + 4, psCapture->ui32Length);
+        CapturePut16(g_pui8Frame + 6,
+                     psCapture->ui32TrigIndex - psCapture->ui32Start);
+        CapturePut32(g_pui8Frame + 8, psCapture->ui32TrigIndex);
+
+        pui8Sample = g_pui8Frame + CAPTURE_HEADER_SIZE;
+        ui32Pos = (psCapture->ui32Start + psCapture->ui32Sent) %
+                  psCapture->ui32Size;
+        for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+        {
+            CapturePut16(pui8Sample, psCapture->pui16History[ui32Pos]);
+            pui8Sample += 2;
+            if(++ui32Pos == psCapture->ui32Size)
+            {
+                ui32Pos = 0;
+            }
+        }
+
+        if(!TelemetrySend(TELEM_TYPE_CAPTURE, psCapture->ui8Channel,
+                          psCapture->ui16Frame, g_pui8Frame,
+                          CAPTURE_HEADER_SIZE + (ui32Count * 2)))
+        {
+            break;
+        }
+        psCapture->ui16Frame++;
+        psCapture->ui32Sent += ui32Count;
+    }
+}
+
+//*****************************************************************************
+//
+//! Prints the state of a capture and its timings.
+//!
+//! \param psCapture is the capture.
+//!
+//! The re-arm time runs from a window completing to the capture arming
+//! again, so it is mostly the time taken to send the window; the blind
+//! samples are those after a window that could not start a full-length one,
+//! and the shortest interval between windows gives the highest capture rate
+//! seen.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+CaptureReport(tCapture *psCapture)
+{
+    uint32_t ui32Clock, ui32PerUs;
+
+    ui32Clock = MAP_SysCtlClockGet();
+    ui32PerUs = ui32Clock / 1000000;
+
+    UARTprintf("Capture %s: trigger %s", g_ppcStates[psCapture->ui32State],
+               g_ppcTriggers[psCapture->ui32Trigger]);
+    if((psCapture->ui32Trigger != CAPTURE_TRIG_OFF) &&
+       (psCapture->ui32Trigger != CAPTURE_TRIG_EXTERNAL))
+    {
+        UARTprintf(" %d", psCapture->ui32Level);
+    }
+    UARTprintf(", %d samples before and %d from the trigger\n",
+               psCapture->ui32Pre, psCapture->ui32Post);
+    UARTprintf("  %d windows, %d broken by lost blocks\n",
+               psCapture->ui32Captures, psCapture->ui32Broken);
+    if(psCapture->ui32Captures)
+    {
+        UARTprintf("  Last trigger at sample %d, %d samples before it\n",
+                   psCapture->ui32TrigIndex,
+                   psCapture->ui32TrigIndex - psCapture->ui32Start);
+        UARTprintf("  Re-armed %d us after the window (max %d us), "
+                   "%d samples blind\n", psCapture->ui32Rearm / ui32PerUs,
+                   psCapture->ui32MaxRearm / ui32PerUs, psCapture->ui32Blind);
+    }
+    if(psCapture->ui32Captures > 1)
+    {
+        UARTprintf("  Shortest interval %d us: up to %d windows/s\n",
+                   psCapture->ui32MinInterval / ui32PerUs,
+                   ui32Clock / psCapture->ui32MinInterval);
+    }
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
@@ -0,0 +1,121 @@
+//*****************************************************************************
+//
+// capture.h - Triggered capture of the sample stream with pre-trigger history.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_CAPTURE_H__
+#define __UTILS_CAPTURE_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Triggers.  The level triggers look at every sample while armed; an
+// external trigger is an event elsewhere (a comparator alarm, a pin) whose
+// cycle count the application passes to CaptureTrigger().
+//
+//*****************************************************************************
+#define CAPTURE_TRIG_OFF        0
+#define CAPTURE_TRIG_ABOVE      1   // a sample at or above the level
+#define CAPTURE_TRIG_RISING     2   // a sample at or above the level after one below
+#define CAPTURE_TRIG_FALLING    3   // a sample below the level after one at or above
+#define CAPTURE_TRIG_EXTERNAL   4   // CaptureTrigger()
+
+//*****************************************************************************
+//
+// Layout of a TELEM_TYPE_CAPTURE frame payload, little-endian:
+//
+//     capture (2) | offset (2) | window (2) | trigger (2) | index (4) |
+//     samples (2 each)
+//
+// capture numbers the windows, offset is the position in the window of the
+// first sample in the frame, window is the number of samples in the window,
+// trigger is the position of the trigger sample in the window and index is
+// the trigger sample's number in the stream (block sequence times block
+// length, plus its place in the block).
+//
+//*****************************************************************************
+#define CAPTURE_HEADER_SIZE     12
+#define CAPTURE_FRAME_SAMPLES   ((TELEM_MAX_PAYLOAD - CAPTURE_HEADER_SIZE) / 2)
+
+//*****************************************************************************
+//
+// A capture.  The history buffer (pui16History, ui32Size samples), the
+// samples kept before and after the trigger (ui32Pre + ui32Post, at most
+// ui32Size) and the telemetry channel of the frames are set by the
+// application; the rest is private to capture.c.  The blocks must be
+// PIPE_FORMAT_SAMPLES16 of one length and carry the cycle count of their
+// last sample in ui32Time.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint16_t *pui16History;
+    uint32_t ui32Size;
+    uint32_t ui32Pre;
+    uint32_t ui32Post;
+    uint8_t ui8Channel;
+
+    uint32_t ui32Trigger;       // CAPTURE_TRIG_*
+    uint32_t ui32Level;
+    uint32_t ui32State;
+    uint32_t ui32Period;        // cycles per sample
+    uint32_t ui32Next;          // stream index after the newest sample held
+    uint32_t ui32Held;          // samples held, up to ui32Size
+    uint32_t ui32Last;          // the newest sample held, for the edge triggers
+    uint32_t ui32TrigIndex;
+    uint32_t ui32Start;         // stream index of the first sample of the window
+    uint32_t ui32Length;
+    uint32_t ui32Sent;
+    uint16_t ui16Frame;
+    volatile uint32_t ui32ExtTime;
+    volatile bool bExtPending;
+
+    //
+    // Statistics, for CaptureReport().
+    //
+    uint32_t ui32Captures;
+    uint32_t ui32Broken;        // windows given up because blocks were lost
+    uint32_t ui32FrozenAt;      // cycle count when the last window completed
+    uint32_t ui32MinInterval;   // fewest cycles between two completed windows
+    uint32_t ui32Rearm;         // cycles from the last window completing to re-arming
+    uint32_t ui32MaxRearm;
+    uint32_t ui32Blind;         // samples after the last window no trigger could use
+    bool bBlindPending;
+}
+tCapture;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void CaptureInit(tCapture *psCapture, uint32_t ui32Period);
+extern void CaptureRateSet(tCapture *psCapture, uint32_t ui32Period);
+extern void CaptureArm(tCapture *psCapture, uint32_t ui32Trigger,
+                       uint32_t ui32Level);
+extern void CaptureTrigger(tCapture *psCapture, uint32_t ui32Time);
+extern uint32_t CaptureStage(void *pvState, tPipeBlock *psBlock);
+extern void CaptureService(tCapture *psCapture);
+extern void CaptureReport(tCapture *psCapture);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_CAPTURE_H__
@@ -0,0 +1,32 @@
+//*****************************************************************************
+//
+// cyclecount.c - Access to the Cortex-M4 DWT cycle counter.
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include "inc/hw_nvic.h"
+#include "inc/hw_types.h"
+#include "utils/cyclecount.h"
+
+//*****************************************************************************
+//
+//! Resets and starts the DWT cycle counter.
+//!
+//! This function is safe to call before the C run-time has been initialized;
+//! it touches no data and is used by ResetISR() so that CycleCountGet() at
+//! the top of main() reports the number of cycles spent in boot.
+//!
+//! The cycle counter is not cleared by a system reset, so it is explicitly
+//! zeroed here.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+CycleCountStart(void)
+{
+    HWREG(NVIC_DBG_INT) |= DEMCR_TRCENA;
+    HWREG(DWT_CYCCNT) = 0;
+    HWREG(DWT_CTRL) |= DWT_CTRL_CYCCNTENA;
+}
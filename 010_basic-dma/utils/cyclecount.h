@@ -0,0 +1,57 @@
+//*****************************************************************************
+//
+// cyclecount.h - Access to the Cortex-M4 DWT cycle counter.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_CYCLECOUNT_H__
+#define __UTILS_CYCLECOUNT_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Data Watchpoint and Trace (DWT) registers.  These are part of the ARMv7-M
+// debug architecture and are not described by the TivaWare hw_*.h headers.
+//
+//*****************************************************************************
+#define DWT_CTRL                0xE0001000  // DWT Control
+#define DWT_CYCCNT              0xE0001004  // DWT Cycle Count
+#define DWT_CTRL_CYCCNTENA      0x00000001  // Cycle counter enable
+#define DEMCR_TRCENA            0x01000000  // NVIC_DBG_INT: enable DWT/ITM
+
+//*****************************************************************************
+//
+// Reads the free-running core clock cycle counter.  The counter wraps every
+// 2^32 cycles (~107 s at 40 MHz), so differences of two readings are always
+// valid as long as the interval is shorter than that.
+//
+//*****************************************************************************
+#define CycleCountGet()         HWREG(DWT_CYCCNT)
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void CycleCountStart(void);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_CYCLECOUNT_H__
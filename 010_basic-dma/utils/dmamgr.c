@@ -0,0 +1,262 @@
+//*****************************************************************************
+//
+// dmamgr.c - uDMA control table, channel assignments and statistics.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_types.h"
+#include "driverlib/debug.h"
+#include "driverlib/udma.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/dmamgr.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup dmamgr_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// The channel control table: a primary and an alternate structure for each
+// channel, on the 1024-byte boundary the controller requires.  Only the
+// structures of channels that are set up are ever read, so it is not zeroed
+// at boot.
+//
+//*****************************************************************************
+#pragma DATA_ALIGN(g_psDMAControlTable, 1024)
+#pragma NOINIT(g_psDMAControlTable)
+static tDMAControlTable g_psDMAControlTable[DMAMGR_CHANNELS * 2];
+
+//*****************************************************************************
+//
+// Per-channel statistics.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Transfers;     // transfers set up
+    uint32_t ui32Items;         // items those transfers were set up to move
+    uint32_t ui32Errors;        // bus errors that stopped the channel
+}
+tDMAChannelStats;
+
+static tDMAChannelStats g_psDMAStats[DMAMGR_CHANNELS];
+
+//*****************************************************************************
+//
+// The plan, the entry that owns each channel (plus one; 0 for none) and the
+// entries left out because their channel was already taken.
+//
+//*****************************************************************************
+static const tDMAChannelUse *g_psPlan;
+static uint32_t g_ui32PlanCount;
+static uint8_t g_pui8Owner[DMAMGR_CHANNELS];
+static uint32_t g_ui32Conflicts;
+
+//*****************************************************************************
+//
+// Names of the transfer modes, by UDMA_MODE_ value.
+//
+//*****************************************************************************
+static const char * const g_ppcModeNames[8] =
+{
+    "stop", "basic", "auto", "ping-pong",
+    "memory s-g", "memory s-g", "peripheral s-g", "peripheral s-g"
+};
+
+//*****************************************************************************
+//
+// Returns the mode of the structure a channel is using (ping-pong and
+// scatter-gather switch between them).
+//
+//*****************************************************************************
+static uint32_t
+DMAMgrActiveMode(uint32_t ui32Channel)
+{
+    uint32_t ui32Select;
+
+    ui32Select = (MAP_uDMAChannelAttributeGet(ui32Channel) &
+                  UDMA_ATTR_ALTSELECT) ? UDMA_ALT_SELECT : UDMA_PRI_SELECT;
+
+    return(MAP_uDMAChannelModeGet(ui32Channel | ui32Select));
+}
+
+//*****************************************************************************
+//
+//! Enables the uDMA controller with its control table and assigns the
+//! channels of a firmware image.
+//!
+//! \param psPlan is the plan, one entry per channel the image uses.
+//! \param ui32Count is the number of entries.
+//!
+//! Each entry's channel is mapped to its peripheral with uDMAChannelAssign()
+//! and its attributes are cleared.  An entry whose channel an earlier entry
+//! has already claimed is a conflict: it is left out, and reported by
+//! DMAMgrReport().  Call once, before any channel is set up.  The plan is
+//! kept for DMAMgrReport(), so it must stay in memory.
+//!
+//! \return Returns \b false if the plan has conflicts.
+//
+//*****************************************************************************
+bool
+DMAMgrInit(const tDMAChannelUse *psPlan, uint32_t ui32Count)
+{
+    uint32_t ui32Idx, ui32Channel;
+
+    MAP_uDMAEnable();
+    MAP_uDMAControlBaseSet(g_psDMAControlTable);
+
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        ui32Channel = DMAMGR_CHANNEL(psPlan[ui32Idx].ui32Mapping);
+        if(g_pui8Owner[ui32Channel])
+        {
+            g_ui32Conflicts++;
+            continue;
+        }
+        g_pui8Owner[ui32Channel] = ui32Idx + 1;
+        MAP_uDMAChannelAssign(psPlan[ui32Idx].ui32Mapping);
+        MAP_uDMAChannelAttributeDisable(ui32Channel, UDMA_ATTR_ALL);
+    }
+
+    g_psPlan = psPlan;
+    g_ui32PlanCount = ui32Count;
+
+    ASSERT(g_ui32Conflicts == 0);
+    return(g_ui32Conflicts == 0);
+}
+
+//*****************************************************************************
+//
+//! Sets up a transfer, as uDMAChannelTransferSet() does, and counts it.
+//!
+//! \param ui32ChannelStructIndex is the channel number with
+//! \b UDMA_PRI_SELECT or \b UDMA_ALT_SELECT.
+//! \param ui32Mode is the transfer mode.
+//! \param pvSrcAddr is the source address.
+//! \param pvDstAddr is the destination address.
+//! \param ui32TransferSize is the number of items.
+//!
+//! The channel must be one the plan gave to its caller.  This function may be
+//! called from interrupt handlers, as long as each channel is only set up
+//! from one of them.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+DMAMgrTransferSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Mode,
+                  void *pvSrcAddr, void *pvDstAddr, uint32_t ui32TransferSize)
+{
+    ASSERT(g_pui8Owner[DMAMGR_CHANNEL(ui32ChannelStructIndex)]);
+
+    MAP_uDMAChannelTransferSet(ui32ChannelStructIndex, ui32Mode, pvSrcAddr,
+                               pvDstAddr, ui32TransferSize);
+    DMAMgrAccount(DMAMGR_CHANNEL(ui32ChannelStructIndex), ui32TransferSize);
+}
+
+//*****************************************************************************
+//
+//! Counts a transfer that was not set up through DMAMgrTransferSet().
+//!
+//! \param ui32Channel is the channel number.
+//! \param ui32Items is the number of items moved.
+//!
+//! For transfers the controller sets up itself, such as the tasks of a
+//! scatter-gather list; the owner counts them once it sees them done.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+DMAMgrAccount(uint32_t ui32Channel, uint32_t ui32Items)
+{
+    g_psDMAStats[ui32Channel].ui32Transfers++;
+    g_psDMAStats[ui32Channel].ui32Items += ui32Items;
+}
+
+//*****************************************************************************
+//
+//! Charges a bus error to the channel it stopped.
+//!
+//! The controller disables the channel whose access failed, leaving the
+//! structure in use with a mode other than stop; a channel that finished its
+//! transfer is disabled with its mode at stop.  Call from the uDMA error
+//! interrupt handler, which clears the error.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+DMAMgrErrorAccount(void)
+{
+    uint32_t ui32Channel;
+
+    for(ui32Channel = 0; ui32Channel < DMAMGR_CHANNELS; ui32Channel++)
+    {
+        if(!g_pui8Owner[ui32Channel] ||
+           !g_psDMAStats[ui32Channel].ui32Transfers ||
+           MAP_uDMAChannelIsEnabled(ui32Channel))
+        {
+            continue;
+        }
+
+        if(DMAMgrActiveMode(ui32Channel) != UDMA_MODE_STOP)
+        {
+            g_psDMAStats[ui32Channel].ui32Errors++;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Prints the plan with each channel's state and statistics.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+DMAMgrReport(void)
+{
+    uint32_t ui32Idx, ui32Channel;
+    tDMAChannelStats *psStats;
+
+    UARTprintf("DMA channels (control table at 0x%08x, %d conflicts):\n",
+               (uint32_t)g_psDMAControlTable, g_ui32Conflicts);
+    UARTprintf("  Ch Enc            Owner  Transfers      Items  Errors  "
+               "State\n");
+
+    for(ui32Idx = 0; ui32Idx < g_ui32PlanCount; ui32Idx++)
+    {
+        ui32Channel = DMAMGR_CHANNEL(g_psPlan[ui32Idx].ui32Mapping);
+        UARTprintf("  %2d %3d %16s  ", ui32Channel,
+                   DMAMGR_ENCODING(g_psPlan[ui32Idx].ui32Mapping),
+                   g_psPlan[ui32Idx].pcName);
+
+        if(g_pui8Owner[ui32Channel] != (ui32Idx + 1))
+        {
+            UARTprintf("conflicts with %s, not assigned\n",
+                       g_psPlan[g_pui8Owner[ui32Channel] - 1].pcName);
+            continue;
+        }
+
+        psStats = &g_psDMAStats[ui32Channel];
+        UARTprintf("%9d %10d %7d  %s, %s\n", psStats->ui32Transfers,
+                   psStats->ui32Items, psStats->ui32Errors,
+                   MAP_uDMAChannelIsEnabled(ui32Channel) ? "on" : "off",
+                   g_ppcModeNames[DMAMgrActiveMode(ui32Channel) & 7]);
+    }
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
@@ -0,0 +1,70 @@
+//*****************************************************************************
+//
+// dmamgr.h - uDMA control table, channel assignments and statistics.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_DMAMGR_H__
+#define __UTILS_DMAMGR_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The channel number and the peripheral encoding of a UDMA_CHn_xxx mapping,
+// as uDMAChannelAssign() takes them apart.
+//
+//*****************************************************************************
+#define DMAMGR_CHANNELS         32
+#define DMAMGR_CHANNEL(ui32Mapping)                                           \
+        ((ui32Mapping) & 0x1F)
+#define DMAMGR_ENCODING(ui32Mapping)                                          \
+        ((ui32Mapping) >> 16)
+
+//*****************************************************************************
+//
+// An entry of a firmware image's DMA plan: a channel with the peripheral
+// that drives its requests, and who uses it.  A channel number can only
+// serve one peripheral at a time, whatever the encodings say, so two
+// entries with the same number are a conflict.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Mapping;       // UDMA_CHn_xxx
+    const char *pcName;
+}
+tDMAChannelUse;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern bool DMAMgrInit(const tDMAChannelUse *psPlan, uint32_t ui32Count);
+extern void DMAMgrTransferSet(uint32_t ui32ChannelStructIndex,
+                              uint32_t ui32Mode, void *pvSrcAddr,
+                              void *pvDstAddr, uint32_t ui32TransferSize);
+extern void DMAMgrAccount(uint32_t ui32Channel, uint32_t ui32Items);
+extern void DMAMgrErrorAccount(void);
+extern void DMAMgrReport(void);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_DMAMGR_H__
@@ -0,0 +1,248 @@
+//*****************************************************************************
+//
+// dmaseq.c - uDMA scatter-gather task lists.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_types.h"
+#include "inc/hw_udma.h"
+#include "driverlib/debug.h"
+#include "driverlib/udma.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/dmaseq.h"
+
+//*****************************************************************************
+//
+//! \addtogroup dmaseq_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// The item size in bytes of a source or destination increment, 0 for none.
+//
+//*****************************************************************************
+#define DMASEQ_SRC_STEP(ui32Control)                                          \
+        ((((ui32Control) & UDMA_SRC_INC_NONE) == UDMA_SRC_INC_NONE) ? 0 :     \
+         (((ui32Control) & UDMA_SRC_INC_NONE) == UDMA_SRC_INC_32) ? 4 :       \
+         (((ui32Control) & UDMA_SRC_INC_NONE) == UDMA_SRC_INC_16) ? 2 : 1)
+#define DMASEQ_DST_STEP(ui32Control)                                          \
+        ((((ui32Control) & UDMA_DST_INC_NONE) == UDMA_DST_INC_NONE) ? 0 :     \
+         (((ui32Control) & UDMA_DST_INC_NONE) == UDMA_DST_INC_32) ? 4 :       \
+         (((ui32Control) & UDMA_DST_INC_NONE) == UDMA_DST_INC_16) ? 2 : 1)
+
+//*****************************************************************************
+//
+// Appends a task in the given mode; the end pointers are worked out as
+// uDMATaskStructEntry() does.
+//
+//*****************************************************************************
+static bool
+DMASeqAdd(tDMASeq *psSeq, const volatile void *pvSrc, volatile void *pvDst,
+          uint32_t ui32Items, uint32_t ui32Control, uint32_t ui32Mode)
+{
+    tDMAControlTable *psTask;
+
+    if((psSeq->ui32Count >= psSeq->ui32MaxTasks) ||
+       (psSeq->ui32Count >= DMASEQ_MAX_TASKS) ||
+       (ui32Items == 0) || (ui32Items > 1024))
+    {
+        return(false);
+    }
+
+    psTask = &psSeq->psTasks[psSeq->ui32Count++];
+    psTask->pvSrcEndAddr = (uint8_t *)pvSrc +
+                           ((ui32Items - 1) * DMASEQ_SRC_STEP(ui32Control));
+    psTask->pvDstEndAddr = (uint8_t *)pvDst +
+                           ((ui32Items - 1) * DMASEQ_DST_STEP(ui32Control));
+    psTask->ui32Control = ui32Control |
+                          ((ui32Items - 1) << UDMA_CHCTL_XFERSIZE_S) |
+                          ui32Mode | UDMA_MODE_ALT_SELECT;
+    psTask->ui32Spare = 0;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Empties a sequence, ready for its tasks to be added.
+//!
+//! \param psSeq is the sequence, with its application members set.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+DMASeqInit(tDMASeq *psSeq)
+{
+    psSeq->ui32Count = 0;
+    psSeq->ui32Restart = 0;
+}
+
+//*****************************************************************************
+//
+//! Adds a transfer paced by the channel's peripheral.
+//!
+//! \param psSeq is the sequence.
+//! \param pvSrc is the first source item, for example a FIFO register.
+//! \param pvDst is the first destination item.
+//! \param ui32Items is the number of items, 1 to 1024.
+//! \param ui32Control is the item size, the source and destination
+//! increments and the arbitration size, as for uDMAChannelControlSet().
+//!
+//! The task moves \e ui32Items items as the peripheral requests them, then
+//! hands over to the next task.  Only a peripheral sequence can have them.
+//!
+//! \return Returns \b false if the list is full or the count out of range.
+//
+//*****************************************************************************
+bool
+DMASeqTransfer(tDMASeq *psSeq, const volatile void *pvSrc,
+               volatile void *pvDst, uint32_t ui32Items, uint32_t ui32Control)
+{
+    ASSERT(psSeq->bPeripheral);
+
+    return(DMASeqAdd(psSeq, pvSrc, pvDst, ui32Items, ui32Control,
+                     UDMA_MODE_PER_SCATTER_GATHER));
+}
+
+//*****************************************************************************
+//
+//! Adds a copy that runs as soon as the task before it is done.
+//!
+//! \param psSeq is the sequence.
+//! \param pvSrc is the first source item.
+//! \param pvDst is the first destination item.
+//! \param ui32Items is the number of items, 1 to 1024.
+//! \param ui32Control is the item size, the source and destination
+//! increments and the arbitration size, as for uDMAChannelControlSet().
+//!
+//! A single 32-bit item with no increments writes a register from a
+//! constant, reads one into memory (a timer value as a time stamp) or
+//! updates a status word.  The source must still hold the value when the
+//! task runs, so it cannot be on the stack.
+//!
+//! \return Returns \b false if the list is full or the count out of range.
+//
+//*****************************************************************************
+bool
+DMASeqCopy(tDMASeq *psSeq, const volatile void *pvSrc, volatile void *pvDst,
+           uint32_t ui32Items, uint32_t ui32Control)
+{
+    return(DMASeqAdd(psSeq, pvSrc, pvDst, ui32Items, ui32Control,
+                     UDMA_MODE_MEM_SCATTER_GATHER));
+}
+
+//*****************************************************************************
+//
+//! Makes a sequence start over when it reaches the end.
+//!
+//! \param psSeq is the sequence, with its other tasks added.
+//!
+//! Adds a last task that copies the primary control word saved by
+//! DMASeqStart() back into the channel's primary structure, which then
+//! starts again from the first task.  The sequence runs until the channel
+//! is disabled and never raises its completion interrupt.
+//!
+//! \return Returns \b false if the list is full.
+//
+//*****************************************************************************
+bool
+DMASeqLoop(tDMASeq *psSeq)
+{
+    tDMAControlTable *psPrimary;
+
+    psPrimary = (tDMAControlTable *)MAP_uDMAControlBaseGet() +
+                (psSeq->ui32Channel & 0x1F);
+
+    return(DMASeqCopy(psSeq, &psSeq->ui32Restart, &psPrimary->ui32Control,
+                      1, UDMA_SIZE_32 | UDMA_SRC_INC_NONE |
+                      UDMA_DST_INC_NONE | UDMA_ARB_1));
+}
+
+//*****************************************************************************
+//
+//! Points a task at a new destination.
+//!
+//! \param psSeq is the sequence.
+//! \param ui32Task is the task, numbered from 0 in the order it was added.
+//! \param pvDst is the new first destination item.
+//!
+//! The item count, size and increments stay as they were.  The uDMA reads a
+//! task when it starts it, so the change takes effect the next time the
+//! task runs; a task already running finishes at its old destination.  A
+//! looping sequence can so swap a buffer out of the list while the uDMA is
+//! busy with other tasks.
+//!
+//! \return Returns \b false if there is no such task.
+//
+//*****************************************************************************
+bool
+DMASeqDestSet(tDMASeq *psSeq, uint32_t ui32Task, volatile void *pvDst)
+{
+    tDMAControlTable *psTask;
+    uint32_t ui32Items;
+
+    if(ui32Task >= psSeq->ui32Count)
+    {
+        return(false);
+    }
+
+    psTask = &psSeq->psTasks[ui32Task];
+    ui32Items = ((psTask->ui32Control & UDMA_CHCTL_XFERSIZE_M) >>
+                 UDMA_CHCTL_XFERSIZE_S) + 1;
+    psTask->pvDstEndAddr = (uint8_t *)pvDst +
+                           ((ui32Items - 1) *
+                            DMASEQ_DST_STEP(psTask->ui32Control));
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Starts a sequence.
+//!
+//! \param psSeq is the sequence, with its tasks added.
+//!
+//! The channel's attributes are left as the application set them, except
+//! that it must not be set to use the alternate structure.  A peripheral
+//! sequence starts with the peripheral's next request; a memory sequence is
+//! started here by a software request.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+DMASeqStart(tDMASeq *psSeq)
+{
+    tDMAControlTable *psPrimary;
+
+    ASSERT(psSeq->ui32Count != 0);
+
+    MAP_uDMAChannelScatterGatherSet(psSeq->ui32Channel, psSeq->ui32Count,
+                                    psSeq->psTasks, psSeq->bPeripheral);
+
+    //
+    // The primary structure counts down as it copies the tasks; the copy
+    // taken now is what DMASeqLoop()'s task restores.
+    //
+    psPrimary = (tDMAControlTable *)MAP_uDMAControlBaseGet() +
+                (psSeq->ui32Channel & 0x1F);
+    psSeq->ui32Restart = psPrimary->ui32Control;
+
+    MAP_uDMAChannelEnable(psSeq->ui32Channel);
+    if(!psSeq->bPeripheral)
+    {
+        MAP_uDMAChannelRequest(psSeq->ui32Channel);
+    }
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
@@ -0,0 +1,82 @@
+//*****************************************************************************
+//
+// dmaseq.h - uDMA scatter-gather task lists.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_DMASEQ_H__
+#define __UTILS_DMASEQ_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The most tasks a list can hold: the primary control structure copies four
+// words per task and counts at most 1024.
+//
+//*****************************************************************************
+#define DMASEQ_MAX_TASKS        256
+
+//*****************************************************************************
+//
+// A uDMA scatter-gather sequence: a list of tasks that the channel's primary
+// control structure copies, one at a time, into its alternate structure and
+// runs, with no CPU involvement between them.  Transfers paced by the
+// channel's peripheral, copies of buffers or single words (register writes,
+// register reads and status updates) can be chained in any order, and the
+// list can be made to loop forever.
+//
+// The task storage (psTasks, room for ui32MaxTasks), the channel number and
+// whether the peripheral paces the sequence are set by the application; the
+// rest is private to dmaseq.c.  The task storage must stay in place while
+// the sequence runs.
+//
+//*****************************************************************************
+typedef struct
+{
+    tDMAControlTable *psTasks;
+    uint32_t ui32MaxTasks;
+    uint32_t ui32Channel;
+    bool bPeripheral;
+
+    uint32_t ui32Count;         // tasks added so far
+    uint32_t ui32Restart;       // primary control word, copied back to loop
+}
+tDMASeq;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void DMASeqInit(tDMASeq *psSeq);
+extern bool DMASeqTransfer(tDMASeq *psSeq, const volatile void *pvSrc,
+                           volatile void *pvDst, uint32_t ui32Items,
+                           uint32_t ui32Control);
+extern bool DMASeqCopy(tDMASeq *psSeq, const volatile void *pvSrc,
+                       volatile void *pvDst, uint32_t ui32Items,
+                       uint32_t ui32Control);
+extern bool DMASeqLoop(tDMASeq *psSeq);
+extern bool DMASeqDestSet(tDMASeq *psSeq, uint32_t ui32Task,
+                          volatile void *pvDst);
+extern void DMASeqStart(tDMASeq *psSeq);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_DMASEQ_H__
@@ -0,0 +1,382 @@
+//*****************************************************************************
+//
+// faultrecord.c - Fault capture into no-init RAM and reporting on next boot.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_nvic.h"
+#include "inc/hw_types.h"
+#include "utils/faultrecord.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup faultrecord_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Linker variable that marks the top of the stack.
+//
+//*****************************************************************************
+extern uint32_t __STACK_TOP;
+
+//*****************************************************************************
+//
+// The on-chip SRAM of the TM4C123GH6PM.
+//
+//*****************************************************************************
+#define SRAM_START              0x20000000
+#define SRAM_END                0x20008000
+
+//*****************************************************************************
+//
+// Configurable fault status bits for stacking errors on exception entry.
+//
+//*****************************************************************************
+#define FAULT_CFSR_MSTKERR      0x00000010
+#define FAULT_CFSR_STKERR       0x00001000
+
+//*****************************************************************************
+//
+// The fault record.  NOINIT keeps the C run-time from clearing it at boot.
+//
+//*****************************************************************************
+#pragma NOINIT(g_sFaultRecord)
+static tFaultRecord g_sFaultRecord;
+
+//*****************************************************************************
+//
+// A private stack for FaultRecordCapture().  The fault may have been caused
+// by the main stack overflowing, in which case pushing anything more onto it
+// would only escalate to a lockup.  FaultHandler switches to this stack
+// before calling into C.
+//
+//*****************************************************************************
+#define FAULT_HANDLER_STACK_BYTES 256
+#define STRINGIZE(x)            #x
+#define XSTRINGIZE(x)           STRINGIZE(x)
+
+#pragma DATA_ALIGN(g_pui32FaultStack, 8)
+uint32_t g_pui32FaultStack[FAULT_HANDLER_STACK_BYTES / 4];
+
+//*****************************************************************************
+//
+// Names of the fault status bits, used when reporting.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Bit;
+    const char *pcName;
+}
+tFaultBitName;
+
+static const tFaultBitName g_psCFSRNames[] =
+{
+    { 0x00000001, "IACCVIOL" },
+    { 0x00000002, "DACCVIOL" },
+    { 0x00000008, "MUNSTKERR" },
+    { 0x00000010, "MSTKERR" },
+    { 0x00000020, "MLSPERR" },
+    { 0x00000100, "IBUSERR" },
+    { 0x00000200, "PRECISERR" },
+    { 0x00000400, "IMPRECISERR" },
+    { 0x00000800, "UNSTKERR" },
+    { 0x00001000, "STKERR" },
+    { 0x00002000, "LSPERR" },
+    { 0x00010000, "UNDEFINSTR" },
+    { 0x00020000, "INVSTATE" },
+    { 0x00040000, "INVPC" },
+    { 0x00080000, "NOCP" },
+    { 0x01000000, "UNALIGNED" },
+    { 0x02000000, "DIVBYZERO" },
+};
+
+static const char * const g_ppcExceptionNames[] =
+{
+    "?", "Reset", "NMI", "HardFault", "MemManage", "BusFault", "UsageFault"
+};
+
+static const char * const g_ppcFrameNames[8] =
+{
+    "R0  ", "R1  ", "R2  ", "R3  ", "R12 ", "LR  ", "PC  ", "xPSR"
+};
+
+//*****************************************************************************
+//
+// Entry point for fault exceptions and unexpected interrupts.
+//
+// Works out which stack the exception frame was pushed to from EXC_RETURN,
+// moves MSP to the private fault stack and tail-calls
+// FaultRecordCapture(frame, EXC_RETURN).
+//
+//*****************************************************************************
+__asm("    .sect   \".text:FaultHandler\"\n"
+      "    .thumb\n"
+      "    .thumbfunc FaultHandler\n"
+      "    .global FaultHandler\n"
+      "    .global FaultRecordCapture\n"
+      "    .global g_pui32FaultStack\n"
+      "FaultHandler: .asmfunc\n"
+      "    tst     lr, #4\n"
+      "    ite     eq\n"
+      "    mrseq   r0, msp\n"
+      "    mrsne   r0, psp\n"
+      "    mov     r1, lr\n"
+      "    ldr     r2, c_fault_stack_top\n"
+      "    msr     msp, r2\n"
+      "    b.w     FaultRecordCapture\n"
+      "    .endasmfunc\n"
+      "    .align  4\n"
+      "c_fault_stack_top: .word g_pui32FaultStack + "
+      XSTRINGIZE(FAULT_HANDLER_STACK_BYTES) "\n");
+
+//*****************************************************************************
+//
+// Computes the checksum stored in the last word of the record.
+//
+//*****************************************************************************
+static uint32_t
+FaultRecordChecksum(const tFaultRecord *psRecord)
+{
+    const uint32_t *pui32Word = (const uint32_t *)psRecord;
+    uint32_t ui32Idx, ui32Sum = 0;
+
+    for(ui32Idx = 0; ui32Idx < (sizeof(tFaultRecord) / 4) - 1; ui32Idx++)
+    {
+        ui32Sum = ((ui32Sum << 1) | (ui32Sum >> 31)) + pui32Word[ui32Idx];
+    }
+
+    return(~ui32Sum);
+}
+
+//*****************************************************************************
+//
+//! Enables the dedicated fault exceptions.
+//!
+//! Without this, MemManage, BusFault and UsageFault all escalate to HardFault
+//! and the record only shows \b FORCED in HFSR.  Integer division by zero is
+//! also made to trap instead of silently returning zero.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FaultRecordInit(void)
+{
+    HWREG(NVIC_CFG_CTRL) |= NVIC_CFG_CTRL_DIV0;
+    HWREG(NVIC_SYS_HND_CTRL) |= (NVIC_SYS_HND_CTRL_MEM |
+                                 NVIC_SYS_HND_CTRL_BUS |
+                                 NVIC_SYS_HND_CTRL_USAGE);
+}
+
+//*****************************************************************************
+//
+//! Saves the state of a fault and resets the device.
+//!
+//! \param pui32Frame points to the exception frame pushed by the processor.
+//! \param ui32ExcReturn is the EXC_RETURN value the exception was entered
+//! with.
+//!
+//! This function is called by FaultHandler on the private fault stack and
+//! never returns.  If a debugger is attached it halts on a breakpoint instead
+//! of resetting, so the live state can still be examined.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FaultRecordCapture(uint32_t *pui32Frame, uint32_t ui32ExcReturn)
+{
+    tFaultRecord *psRecord = &g_sFaultRecord;
+    uint32_t *pui32Top = &__STACK_TOP;
+    uint32_t ui32Idx, ui32FrameWords;
+
+    psRecord->ui32Exception = HWREG(NVIC_INT_CTRL) & NVIC_INT_CTRL_VEC_ACT_M;
+    psRecord->ui32ExcReturn = ui32ExcReturn;
+    psRecord->ui32CFSR = HWREG(NVIC_FAULT_STAT);
+    psRecord->ui32HFSR = HWREG(NVIC_HFAULT_STAT);
+    psRecord->ui32MMFAR = HWREG(NVIC_MM_ADDR);
+    psRecord->ui32BFAR = HWREG(NVIC_FAULT_ADDR);
+    psRecord->ui32StackWords = 0;
+
+    //
+    // The frame is only trusted if it lies in SRAM and was stacked without
+    // error; a stacking fault (for example into a stack guard) can leave the
+    // stack pointer anywhere.  An extended (FPU) frame is 26 words instead of
+    // 8, and bit 9 of the stacked xPSR flags an alignment word.
+    //
+    if(((uint32_t)pui32Frame >= SRAM_START) &&
+       ((uint32_t)pui32Frame <= SRAM_END - 32) &&
+       !(psRecord->ui32CFSR & (FAULT_CFSR_MSTKERR | FAULT_CFSR_STKERR)))
+    {
+        for(ui32Idx = 0; ui32Idx < 8; ui32Idx++)
+        {
+            psRecord->pui32Frame[ui32Idx] = pui32Frame[ui32Idx];
+        }
+
+        ui32FrameWords = (ui32ExcReturn & 0x10) ? 8 : 26;
+        if(pui32Frame[7] & 0x200)
+        {
+            ui32FrameWords++;
+        }
+        psRecord->ui32SP = (uint32_t)(pui32Frame + ui32FrameWords);
+
+        for(ui32Idx = 0; ui32Idx < FAULT_STACK_WORDS; ui32Idx++)
+        {
+            if(pui32Frame + ui32FrameWords + ui32Idx >= pui32Top)
+            {
+                break;
+            }
+            psRecord->pui32Stack[ui32Idx] =
+                pui32Frame[ui32FrameWords + ui32Idx];
+        }
+        psRecord->ui32StackWords = ui32Idx;
+    }
+    else
+    {
+        for(ui32Idx = 0; ui32Idx < 8; ui32Idx++)
+        {
+            psRecord->pui32Frame[ui32Idx] = 0;
+        }
+        psRecord->ui32SP = (uint32_t)pui32Frame;
+    }
+
+    psRecord->ui32Magic = FAULT_RECORD_MAGIC;
+    psRecord->ui32Check = FaultRecordChecksum(psRecord);
+
+    //
+    // Stop here if a debugger is connected.
+    //
+    if(HWREG(NVIC_DBG_CTRL) & NVIC_DBG_CTRL_C_DEBUGEN)
+    {
+        __asm("    bkpt    #0");
+    }
+
+    //
+    // Request a system reset and wait for it to take effect.
+    //
+    HWREG(NVIC_APINT) = NVIC_APINT_VECTKEY | NVIC_APINT_SYSRESETREQ;
+    while(1)
+    {
+    }
+}
+
+//*****************************************************************************
+//
+//! Retrieves the fault record saved before the last reset, if any.
+//!
+//! \param psRecord receives a copy of the record.
+//!
+//! The record is only returned if both its magic number and checksum match,
+//! which rules out the random contents no-init RAM holds after power-up.
+//!
+//! \return Returns \b true if a valid, unreported record was found.
+//
+//*****************************************************************************
+bool
+FaultRecordGet(tFaultRecord *psRecord)
+{
+    if((g_sFaultRecord.ui32Magic != FAULT_RECORD_MAGIC) ||
+       (g_sFaultRecord.ui32Check != FaultRecordChecksum(&g_sFaultRecord)))
+    {
+        return(false);
+    }
+
+    *psRecord = g_sFaultRecord;
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Prints the saved fault record to the UART console and discards it.
+//!
+//! This should be called once UARTStdioConfig() has been called.  Nothing is
+//! printed if no valid record exists.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FaultRecordReport(void)
+{
+    tFaultRecord sRecord;
+    uint32_t ui32Idx;
+
+    if(!FaultRecordGet(&sRecord))
+    {
+        return;
+    }
+
+    //
+    // Invalidate the record first so that a fault while reporting cannot
+    // cause a reset loop.
+    //
+    g_sFaultRecord.ui32Magic = 0;
+
+    if(sRecord.ui32Exception < 7)
+    {
+        UARTprintf("\n*** Reset after %s\n",
+                   g_ppcExceptionNames[sRecord.ui32Exception]);
+    }
+    else
+    {
+        UARTprintf("\n*** Reset after unexpected interrupt %d\n",
+                   sRecord.ui32Exception - 16);
+    }
+
+    UARTprintf("CFSR  %08x HFSR  %08x MMFAR %08x BFAR  %08x\n",
+               sRecord.ui32CFSR, sRecord.ui32HFSR, sRecord.ui32MMFAR,
+               sRecord.ui32BFAR);
+    UARTprintf("Flags");
+    for(ui32Idx = 0;
+        ui32Idx < sizeof(g_psCFSRNames) / sizeof(g_psCFSRNames[0]);
+        ui32Idx++)
+    {
+        if(sRecord.ui32CFSR & g_psCFSRNames[ui32Idx].ui32Bit)
+        {
+            UARTprintf(" %s", g_psCFSRNames[ui32Idx].pcName);
+        }
+    }
+    if(sRecord.ui32HFSR & 0x40000000)
+    {
+        UARTprintf(" FORCED");
+    }
+    if(sRecord.ui32HFSR & 0x00000002)
+    {
+        UARTprintf(" VECTTBL");
+    }
+    UARTprintf("\n");
+
+    for(ui32Idx = 0; ui32Idx < 8; ui32Idx++)
+    {
+        UARTprintf("%s  %08x%s", g_ppcFrameNames[ui32Idx],
+                   sRecord.pui32Frame[ui32Idx],
+                   ((ui32Idx & 3) == 3) ? "\n" : " ");
+    }
+    UARTprintf("SP    %08x EXC_RETURN %08x\n", sRecord.ui32SP,
+               sRecord.ui32ExcReturn);
+
+    for(ui32Idx = 0; ui32Idx < sRecord.ui32StackWords; ui32Idx++)
+    {
+        if((ui32Idx & 3) == 0)
+        {
+            UARTprintf("%08x:", sRecord.ui32SP + (ui32Idx * 4));
+        }
+        UARTprintf(" %08x%s", sRecord.pui32Stack[ui32Idx],
+                   ((ui32Idx & 3) == 3) ? "\n" : "");
+    }
+    UARTprintf("\n");
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
@@ -0,0 +1,101 @@
+//*****************************************************************************
+//
+// faultrecord.h - Fault capture into no-init RAM and reporting on next boot.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_FAULTRECORD_H__
+#define __UTILS_FAULTRECORD_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Number of stack words saved above the exception frame.
+//
+//*****************************************************************************
+#define FAULT_STACK_WORDS       32
+
+//*****************************************************************************
+//
+// The persisted fault record.  It lives in a no-init RAM section, so it
+// survives the software reset issued after a fault but not a power cycle.
+//
+//*****************************************************************************
+typedef struct
+{
+    //
+    // FAULT_RECORD_MAGIC while the record holds an unreported fault.
+    //
+    uint32_t ui32Magic;
+
+    //
+    // Active exception number (3 = HardFault, 4 = MemManage, 5 = BusFault,
+    // 6 = UsageFault, 16+ = unexpected peripheral interrupt).
+    //
+    uint32_t ui32Exception;
+
+    //
+    // The hardware-stacked frame: R0-R3, R12, LR, PC and xPSR.
+    //
+    uint32_t pui32Frame[8];
+
+    //
+    // EXC_RETURN value and the stack pointer before the exception.
+    //
+    uint32_t ui32ExcReturn;
+    uint32_t ui32SP;
+
+    //
+    // System control block fault status and address registers.
+    //
+    uint32_t ui32CFSR;
+    uint32_t ui32HFSR;
+    uint32_t ui32MMFAR;
+    uint32_t ui32BFAR;
+
+    //
+    // Words found on the stack above the exception frame; ui32StackWords of
+    // them are valid.
+    //
+    uint32_t ui32StackWords;
+    uint32_t pui32Stack[FAULT_STACK_WORDS];
+
+    //
+    // Checksum over all of the preceding words.
+    //
+    uint32_t ui32Check;
+}
+tFaultRecord;
+
+#define FAULT_RECORD_MAGIC      0xFA017EC0
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void FaultRecordInit(void);
+extern bool FaultRecordGet(tFaultRecord *psRecord);
+extern void FaultRecordReport(void);
+extern void FaultRecordCapture(uint32_t *pui32Frame, uint32_t ui32ExcReturn);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_FAULTRECORD_H__
@@ -0,0 +1,587 @@
+//*****************************************************************************
+//
+// flashlog.c - Circular log of sample blocks in internal flash.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "inc/hw_types.h"
+#include "driverlib/flash.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/mempool.h"
+#include "utils/pipeline.h"
+#include "utils/telemetry.h"
+#include "utils/flashlog.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup flashlog_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Markers of sector and record headers ("LOGS" and the record's top byte).
+//
+//*****************************************************************************
+#define SECTOR_MAGIC            0x53474F4C
+#define RECORD_MAGIC            0xA5
+
+//*****************************************************************************
+//
+// Sizes in bytes.
+//
+//*****************************************************************************
+#define SECTOR_HEADER           16
+#define RECORD_HEADER           16
+#define RECORD_SIZE(ui32Bytes)  (RECORD_HEADER + (((ui32Bytes) + 3) & ~3) + 4)
+
+//*****************************************************************************
+//
+// States of a record position, from FlashLogRecordCheck().
+//
+//*****************************************************************************
+#define REC_VALID               0
+#define REC_TORN                1   // started but never completed; skip it
+#define REC_FREE                2   // erased; the sector ends here
+#define REC_CORRUPT             3   // unreadable; give up on the sector
+
+#define SECTOR_ADDR(psLog, ui32Sector)                                        \
+        ((psLog)->ui32Base + ((ui32Sector) * FLASHLOG_SECTOR_SIZE))
+#define FLASH_WORDS(ui32Addr)   ((const uint32_t *)(ui32Addr))
+
+//*****************************************************************************
+//
+// Tells whether a sector has a complete header.
+//
+//*****************************************************************************
+static bool
+FlashLogSectorValid(tFlashLog *psLog, uint32_t ui32Sector)
+{
+    const uint32_t *pui32Hdr = FLASH_WORDS(SECTOR_ADDR(psLog, ui32Sector));
+
+    return((pui32Hdr[0] == SECTOR_MAGIC) && (pui32Hdr[3] == ~pui32Hdr[1]));
+}
+
+//*****************************************************************************
+//
+// Tells whether every word of a sector is erased.
+//
+//*****************************************************************************
+static bool
+FlashLogSectorBlank(tFlashLog *psLog, uint32_t ui32Sector)
+{
+    const uint32_t *pui32Word = FLASH_WORDS(SECTOR_ADDR(psLog, ui32Sector));
+    uint32_t ui32Count;
+
+    for(ui32Count = 0; ui32Count < (FLASHLOG_SECTOR_SIZE / 4); ui32Count++)
+    {
+        if(pui32Word[ui32Count] != 0xFFFFFFFF)
+        {
+            return(false);
+        }
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Examines the record at ui32Offset of a sector; for a valid or torn record
+// its size in flash is stored in *pui32Size.
+//
+//*****************************************************************************
+static uint32_t
+FlashLogRecordCheck(tFlashLog *psLog, uint32_t ui32Sector, uint32_t ui32Offset,
+                    uint32_t *pui32Size)
+{
+    const uint32_t *pui32Rec;
+    uint32_t ui32Bytes;
+    uint16_t ui16CRC;
+
+    if((ui32Offset + RECORD_HEADER) > FLASHLOG_SECTOR_SIZE)
+    {
+        return(REC_FREE);
+    }
+
+    pui32Rec = FLASH_WORDS(SECTOR_ADDR(psLog, ui32Sector) + ui32Offset);
+    if(pui32Rec[0] == 0xFFFFFFFF)
+    {
+        return(REC_FREE);
+    }
+
+    ui32Bytes = pui32Rec[0] & 0xFFFF;
+    if(((pui32Rec[0] >> 24) != RECORD_MAGIC) ||
+       ((ui32Offset + RECORD_SIZE(ui32Bytes)) > FLASHLOG_SECTOR_SIZE))
+    {
+        return(REC_CORRUPT);
+    }
+    *pui32Size = RECORD_SIZE(ui32Bytes);
+
+    if(pui32Rec[(*pui32Size / 4) - 1] != ~pui32Rec[1])
+    {
+        return(REC_TORN);
+    }
+
+    ui16CRC = TelemetryCRC16(0xFFFF, (const uint8_t *)pui32Rec, 12);
+    ui16CRC = TelemetryCRC16(ui16CRC, (const uint8_t *)(pui32Rec + 4),
+                             ui32Bytes);
+    if((pui32Rec[3] & 0xFFFF) != ui16CRC)
+    {
+        return(REC_TORN);
+    }
+
+    return(REC_VALID);
+}
+
+//*****************************************************************************
+//
+//! Opens the log, finding where writing stopped before the last reset.
+//!
+//! \param psLog is the log.
+//! \param ui32Base is the address of the flash it occupies, on a sector
+//! boundary and away from the program image.
+//! \param ui32Size is the size of that flash, a multiple of
+//! \b FLASHLOG_SECTOR_SIZE and at least three sectors.
+//!
+//! The sector headers give the newest sector; its records are walked to the
+//! first erased word, skipping any record a reset left incomplete.  Only
+//! sector headers and the records of one sector are read, so this takes well
+//! under a millisecond.  Nothing is erased here; see FlashLogService().
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FlashLogInit(tFlashLog *psLog, uint32_t ui32Base, uint32_t ui32Size)
+{
+    const uint32_t *pui32Hdr;
+    uint32_t ui32Sector, ui32RecSize, ui32Time;
+    bool bFound;
+
+    memset(psLog, 0, sizeof(*psLog));
+    psLog->ui32Base = ui32Base;
+    psLog->ui32Sectors = ui32Size / FLASHLOG_SECTOR_SIZE;
+
+    //
+    // The head is the valid sector with the highest sequence number.
+    //
+    bFound = false;
+    for(ui32Sector = 0; ui32Sector < psLog->ui32Sectors; ui32Sector++)
+    {
+        pui32Hdr = FLASH_WORDS(SECTOR_ADDR(psLog, ui32Sector));
+        if(FlashLogSectorValid(psLog, ui32Sector) &&
+           (!bFound || ((int32_t)(pui32Hdr[1] - psLog->ui32SectorSeq) > 0)))
+        {
+            psLog->ui32Head = ui32Sector;
+            psLog->ui32SectorSeq = pui32Hdr[1];
+            bFound = true;
+        }
+    }
+
+    if(!bFound)
+    {
+        //
+        // An empty log: treat the last sector as a full head so that the
+        // first record starts sector 0 once it is erased.
+        //
+        psLog->ui32Head = psLog->ui32Sectors - 1;
+        psLog->ui32Offset = FLASHLOG_SECTOR_SIZE;
+    }
+    else
+    {
+        pui32Hdr = FLASH_WORDS(SECTOR_ADDR(psLog, psLog->ui32Head));
+        ui32Time = pui32Hdr[2];
+        psLog->ui32Offset = SECTOR_HEADER;
+        while(1)
+        {
+            switch(FlashLogRecordCheck(psLog, psLog->ui32Head,
+                                       psLog->ui32Offset, &ui32RecSize))
+            {
+                case REC_VALID:
+                {
+                    ui32Time = FLASH_WORDS(SECTOR_ADDR(psLog, psLog->ui32Head) +
+                                           psLog->ui32Offset)[2];
+                    psLog->ui32Offset += ui32RecSize;
+                    continue;
+                }
+
+                case REC_TORN:
+                {
+                    psLog->ui32Torn++;
+                    psLog->ui32Offset += ui32RecSize;
+                    continue;
+                }
+
+                case REC_CORRUPT:
+                {
+                    psLog->ui32Offset = FLASHLOG_SECTOR_SIZE;
+                    break;
+                }
+
+                default:
+                {
+                    break;
+                }
+            }
+            break;
+        }
+        psLog->ui32TimeBase = ui32Time + 1;
+    }
+
+    //
+    // Count the sectors already erased ahead of the head.
+    //
+    while((psLog->ui32Erased < FLASHLOG_ERASE_AHEAD) &&
+          FlashLogSectorBlank(psLog, (psLog->ui32Head + 1 + psLog->ui32Erased) %
+                                     psLog->ui32Sectors))
+    {
+        psLog->ui32Erased++;
+    }
+}
+
+//*****************************************************************************
+//
+//! Keeps sectors erased ahead of the write position.
+//!
+//! \param psLog is the log.
+//!
+//! Call this from the main loop.  It erases at most one sector per call, the
+//! oldest in the ring, until \b FLASHLOG_ERASE_AHEAD sectors are ready, so an
+//! append never has to wait for an erase.  An erase stalls instruction
+//! fetches from flash, interrupt handlers included, for several
+//! milliseconds; DMA carries on meanwhile, so sampling loses nothing as long
+//! as that is shorter than one DMA half buffer.
+//!
+//! \return Returns \b true if a sector was erased.
+//
+//*****************************************************************************
+bool
+FlashLogService(tFlashLog *psLog)
+{
+    uint32_t ui32Sector;
+
+    if((psLog->ui32Erased >= FLASHLOG_ERASE_AHEAD) ||
+       (psLog->ui32Erased >= (psLog->ui32Sectors - 1)))
+    {
+        return(false);
+    }
+
+    ui32Sector = (psLog->ui32Head + 1 + psLog->ui32Erased) % psLog->ui32Sectors;
+    if(MAP_FlashErase(SECTOR_ADDR(psLog, ui32Sector)))
+    {
+        return(false);
+    }
+
+    psLog->ui32Erased++;
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Appends a record.
+//!
+//! \param psLog is the log.
+//! \param ui32Format is the \b PIPE_FORMAT_ of the data.
+//! \param ui32Seq is the block sequence number.
+//! \param ui32Uptime is the time of the block in milliseconds since start-up;
+//! the log time stored is this plus the time the log had reached at
+//! start-up.
+//! \param pvData is the data, word aligned.
+//! \param ui32Bytes is the length of the data, at most
+//! \b FLASHLOG_MAX_DATA.
+//!
+//! The record goes into the head sector, or starts the next, already erased
+//! sector if it does not fit.  Only programming is done here, never an
+//! erase.
+//!
+//! \return Returns \b false, counting the record as dropped, if it is too
+//! long, no erased sector is ready or programming fails.
+//
+//*****************************************************************************
+bool
+FlashLogAppend(tFlashLog *psLog, uint32_t ui32Format, uint32_t ui32Seq,
+               uint32_t ui32Uptime, const void *pvData, uint32_t ui32Bytes)
+{
+    uint32_t pui32Header[4];
+    uint32_t ui32Addr, ui32Whole, ui32Tail, ui32Time;
+
+    ui32Time = psLog->ui32TimeBase + ui32Uptime;
+
+    if((ui32Bytes > FLASHLOG_MAX_DATA) ||
+       (((psLog->ui32Offset + RECORD_SIZE(ui32Bytes)) > FLASHLOG_SECTOR_SIZE) &&
+        !psLog->ui32Erased))
+    {
+        psLog->ui32Dropped++;
+        return(false);
+    }
+
+    //
+    // Start the next sector if this record does not fit in the head.
+    //
+    if((psLog->ui32Offset + RECORD_SIZE(ui32Bytes)) > FLASHLOG_SECTOR_SIZE)
+    {
+        psLog->ui32Head = (psLog->ui32Head + 1) % psLog->ui32Sectors;
+        psLog->ui32Erased--;
+        psLog->ui32SectorSeq++;
+        pui32Header[0] = SECTOR_MAGIC;
+        pui32Header[1] = psLog->ui32SectorSeq;
+        pui32Header[2] = ui32Time;
+        pui32Header[3] = ~psLog->ui32SectorSeq;
+        psLog->ui32Offset = FLASHLOG_SECTOR_SIZE;
+        if(MAP_FlashProgram(pui32Header, SECTOR_ADDR(psLog, psLog->ui32Head),
+                            SECTOR_HEADER))
+        {
+            psLog->ui32Dropped++;
+            return(false);
+        }
+        psLog->ui32Offset = SECTOR_HEADER;
+    }
+
+    //
+    // Header, data and a padded last word, then the completion word.
+    //
+    ui32Addr = SECTOR_ADDR(psLog, psLog->ui32Head) + psLog->ui32Offset;
+    pui32Header[0] = (RECORD_MAGIC << 24) | (ui32Format << 16) | ui32Bytes;
+    pui32Header[1] = ui32Seq;
+    pui32Header[2] = ui32Time;
+    pui32Header[3] = 0xFFFF0000 |
+                     TelemetryCRC16(TelemetryCRC16(0xFFFF,
+                                                   (const uint8_t *)pui32Header,
+                                                   12),
+                                    pvData, ui32Bytes);
+    psLog->ui32Offset += RECORD_SIZE(ui32Bytes);
+
+    ui32Whole = ui32Bytes & ~3;
+    ui32Tail = 0xFFFFFFFF;
+    memcpy(&ui32Tail, (const uint8_t *)pvData + ui32Whole, ui32Bytes & 3);
+    if(MAP_FlashProgram(pui32Header, ui32Addr, RECORD_HEADER) ||
+       (ui32Whole && MAP_FlashProgram((uint32_t *)pvData,
+                                      ui32Addr + RECORD_HEADER, ui32Whole)) ||
+       ((ui32Bytes & 3) && MAP_FlashProgram(&ui32Tail,
+                                            ui32Addr + RECORD_HEADER +
+                                            ui32Whole, 4)))
+    {
+        psLog->ui32Dropped++;
+        return(false);
+    }
+
+    ui32Tail = ~ui32Seq;
+    if(MAP_FlashProgram(&ui32Tail,
+                        ui32Addr + RECORD_SIZE(ui32Bytes) - 4, 4))
+    {
+        psLog->ui32Dropped++;
+        return(false);
+    }
+
+    psLog->ui32Records++;
+    psLog->ui32Bytes += RECORD_SIZE(ui32Bytes);
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Positions a cursor at the records from a given time on.
+//!
+//! \param psLog is the log.
+//! \param ui32Time is the log time to start from; 0 starts at the oldest
+//! record.
+//! \param psCursor receives the position.
+//!
+//! Sector times increase through the ring, so the sector holding
+//! \e ui32Time is found by a binary search of the sector headers.  Records
+//! before \e ui32Time in that sector are still returned by FlashLogNext();
+//! the caller skips them by their time.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FlashLogFind(tFlashLog *psLog, uint32_t ui32Time, tFlashLogCursor *psCursor)
+{
+    uint32_t ui32Oldest, ui32Total, ui32Low, ui32High, ui32Mid, ui32Sector;
+
+    //
+    // Ring positions run from the oldest sector not erased to the head.
+    //
+    ui32Oldest = (psLog->ui32Head + 1 + psLog->ui32Erased) % psLog->ui32Sectors;
+    ui32Total = psLog->ui32Sectors - psLog->ui32Erased;
+
+    psCursor->ui32Sector = psLog->ui32Head;
+    psCursor->ui32Offset = FLASHLOG_SECTOR_SIZE;
+    psCursor->ui32Left = 0;
+    if(!FlashLogSectorValid(psLog, psLog->ui32Head))
+    {
+        return;
+    }
+
+    //
+    // Sectors never written (a new log) come first: find the first valid.
+    //
+    ui32Low = 0;
+    ui32High = ui32Total - 1;
+    while(ui32Low < ui32High)
+    {
+        ui32Mid = (ui32Low + ui32High) / 2;
+        if(FlashLogSectorValid(psLog, (ui32Oldest + ui32Mid) % psLog->ui32Sectors))
+        {
+            ui32High = ui32Mid;
+        }
+        else
+        {
+            ui32Low = ui32Mid + 1;
+        }
+    }
+
+    //
+    // Then the last sector starting at or before ui32Time.
+    //
+    ui32High = ui32Total - 1;
+    while(ui32Low < ui32High)
+    {
+        ui32Mid = (ui32Low + ui32High + 1) / 2;
+        ui32Sector = (ui32Oldest + ui32Mid) % psLog->ui32Sectors;
+        if(FLASH_WORDS(SECTOR_ADDR(psLog, ui32Sector))[2] <= ui32Time)
+        {
+            ui32Low = ui32Mid;
+        }
+        else
+        {
+            ui32High = ui32Mid - 1;
+        }
+    }
+
+    psCursor->ui32Sector = (ui32Oldest + ui32Low) % psLog->ui32Sectors;
+    psCursor->ui32Offset = SECTOR_HEADER;
+    psCursor->ui32Left = ui32Total - 1 - ui32Low;
+}
+
+//*****************************************************************************
+//
+//! Reads the next record.
+//!
+//! \param psLog is the log.
+//! \param psCursor is the position, advanced past the record.
+//! \param psRecord receives the record; its data is read in place from flash.
+//!
+//! Incomplete records are skipped.  The caller must not append while
+//! reading, as the ring may overwrite what the cursor points to.
+//!
+//! \return Returns \b false at the end of the log.
+//
+//*****************************************************************************
+bool
+FlashLogNext(tFlashLog *psLog, tFlashLogCursor *psCursor,
+             tFlashLogRecord *psRecord)
+{
+    const uint32_t *pui32Rec;
+    uint32_t ui32Size;
+
+    while(1)
+    {
+        switch(FlashLogRecordCheck(psLog, psCursor->ui32Sector,
+                                   psCursor->ui32Offset, &ui32Size))
+        {
+            case REC_VALID:
+            {
+                pui32Rec = FLASH_WORDS(SECTOR_ADDR(psLog, psCursor->ui32Sector) +
+                                       psCursor->ui32Offset);
+                psRecord->ui32Format = (pui32Rec[0] >> 16) & 0xFF;
+                psRecord->ui32Bytes = pui32Rec[0] & 0xFFFF;
+                psRecord->ui32Seq = pui32Rec[1];
+                psRecord->ui32Time = pui32Rec[2];
+                psRecord->pvData = pui32Rec + 4;
+                psCursor->ui32Offset += ui32Size;
+                return(true);
+            }
+
+            case REC_TORN:
+            {
+                psCursor->ui32Offset += ui32Size;
+                continue;
+            }
+
+            default:
+            {
+                break;
+            }
+        }
+
+        //
+        // The end of this sector; move on to the next valid one.
+        //
+        if(!psCursor->ui32Left)
+        {
+            psCursor->ui32Offset = FLASHLOG_SECTOR_SIZE;
+            return(false);
+        }
+        psCursor->ui32Sector = (psCursor->ui32Sector + 1) % psLog->ui32Sectors;
+        psCursor->ui32Left--;
+        psCursor->ui32Offset = FlashLogSectorValid(psLog, psCursor->ui32Sector) ?
+                               SECTOR_HEADER : FLASHLOG_SECTOR_SIZE;
+    }
+}
+
+//*****************************************************************************
+//
+//! Pipeline stage that appends each block to the log while recording.
+//!
+//! \param pvState points to a \b tFlashLogStage.
+//! \param psBlock is the block, normally already packed (sampack.h).
+//!
+//! A block that cannot be logged is counted in the log's dropped records and
+//! passed on all the same; logging never holds back the pipeline.
+//!
+//! \return Returns \b PIPE_CONTINUE.
+//
+//*****************************************************************************
+uint32_t
+FlashLogStageWrite(void *pvState, tPipeBlock *psBlock)
+{
+    tFlashLogStage *psStage = pvState;
+    uint32_t ui32Uptime;
+
+    ui32Uptime = psStage->pfnTime();
+    if(psStage->bRecording)
+    {
+        FlashLogAppend(psStage->psLog, psBlock->ui32Format, psBlock->ui32Seq,
+                       ui32Uptime, psBlock->pvData, PIPE_BLOCK_BYTES(psBlock));
+    }
+
+    return(PIPE_CONTINUE);
+}
+
+//*****************************************************************************
+//
+//! Prints the state of the log.
+//!
+//! \param psLog is the log.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+FlashLogReport(tFlashLog *psLog)
+{
+    UARTprintf("Log: %d KB at 0x%08x, sector %d offset %d, %d erased ahead, "
+               "time %u ms at start-up\n",
+               (psLog->ui32Sectors * FLASHLOG_SECTOR_SIZE) / 1024,
+               psLog->ui32Base, psLog->ui32Head, psLog->ui32Offset,
+               psLog->ui32Erased, psLog->ui32TimeBase);
+    UARTprintf("     %d records (%d bytes) written, %d dropped, %d incomplete "
+               "at start-up\n",
+               psLog->ui32Records, psLog->ui32Bytes, psLog->ui32Dropped,
+               psLog->ui32Torn);
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
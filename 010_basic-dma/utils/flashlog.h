@@ -0,0 +1,135 @@
+//*****************************************************************************
+//
+// flashlog.h - Circular log of sample blocks in internal flash.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_FLASHLOG_H__
+#define __UTILS_FLASHLOG_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Layout.  The log is a ring of 1 KB flash sectors.  A sector in use starts
+// with a header
+//
+//     magic (4) | sector sequence (4) | time of first record (4) | ~sequence (4)
+//
+// followed by records, which never cross into the next sector:
+//
+//     magic, format, length (4) | block sequence (4) | time (4) | CRC-16 (4)
+//     data, padded to a word | ~block sequence (4)
+//
+// The CRC-16 (telemetry.c) covers the first three header words and the
+// data.  The last word is programmed after everything else and marks the
+// record complete; a record cut short by a reset lacks it and is skipped.
+// The sector headers, read straight from flash, are the index used to find
+// a time in the log.  Times are in milliseconds and carry on across resets
+// from the newest record, so they increase through the whole ring.
+//
+//*****************************************************************************
+#define FLASHLOG_SECTOR_SIZE    1024
+#define FLASHLOG_ERASE_AHEAD    2
+#define FLASHLOG_MAX_DATA       (FLASHLOG_SECTOR_SIZE - 36)
+
+//*****************************************************************************
+//
+// A log.  The members are private to flashlog.c.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Base;          // address of the first sector
+    uint32_t ui32Sectors;
+    uint32_t ui32Head;          // sector being written
+    uint32_t ui32Offset;        // next free byte in the head sector
+    uint32_t ui32SectorSeq;     // sequence number of the head sector
+    uint32_t ui32Erased;        // erased sectors following the head
+    uint32_t ui32TimeBase;      // log time at start-up
+    uint32_t ui32Records;       // records written since start-up
+    uint32_t ui32Bytes;         // flash used by them
+    uint32_t ui32Dropped;       // records refused for lack of erased space
+    uint32_t ui32Torn;          // incomplete records found at start-up
+}
+tFlashLog;
+
+//*****************************************************************************
+//
+// A record read back by FlashLogNext(); pvData points into flash.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Format;        // PIPE_FORMAT_ value of the block
+    uint32_t ui32Seq;
+    uint32_t ui32Time;
+    const void *pvData;
+    uint32_t ui32Bytes;
+}
+tFlashLogRecord;
+
+//*****************************************************************************
+//
+// A read position, set by FlashLogFind().
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Sector;
+    uint32_t ui32Offset;
+    uint32_t ui32Left;          // sectors still to visit after this one
+}
+tFlashLogCursor;
+
+//*****************************************************************************
+//
+// State of FlashLogStageWrite().  pfnTime returns milliseconds since
+// start-up and is called for every block, recording or not.
+//
+//*****************************************************************************
+typedef struct
+{
+    tFlashLog *psLog;
+    uint32_t (*pfnTime)(void);
+    bool bRecording;
+}
+tFlashLogStage;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void FlashLogInit(tFlashLog *psLog, uint32_t ui32Base,
+                         uint32_t ui32Size);
+extern bool FlashLogAppend(tFlashLog *psLog, uint32_t ui32Format,
+                           uint32_t ui32Seq, uint32_t ui32Uptime,
+                           const void *pvData, uint32_t ui32Bytes);
+extern bool FlashLogService(tFlashLog *psLog);
+extern void FlashLogFind(tFlashLog *psLog, uint32_t ui32Time,
+                         tFlashLogCursor *psCursor);
+extern bool FlashLogNext(tFlashLog *psLog, tFlashLogCursor *psCursor,
+                         tFlashLogRecord *psRecord);
+extern uint32_t FlashLogStageWrite(void *pvState, tPipeBlock *psBlock);
+extern void FlashLogReport(tFlashLog *psLog);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_FLASHLOG_H__
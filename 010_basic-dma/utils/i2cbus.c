@@ -0,0 +1,599 @@
+//*****************************************************************************
+//
+// i2cbus.c - Queued, interrupt-driven I2C master and sensor polling.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "driverlib/gpio.h"
+#include "driverlib/i2c.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/i2cbus.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup i2cbus_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// What the interrupt that ends the current command means.
+//
+//*****************************************************************************
+#define PHASE_WRITE             0   // a byte was sent
+#define PHASE_READ              1   // a byte was received
+#define PHASE_STOP              2   // a stop after an error was sent
+#define PHASE_STUCK             3   // the slave held the clock; wait for
+                                    // I2CBusService() to recover the bus
+
+//*****************************************************************************
+//
+// Clock low timeout, in units of 16 SCL periods: 20 ms at 100 kHz.
+//
+//*****************************************************************************
+#define CLOCK_LOW_TIMEOUT       0x7D
+
+//*****************************************************************************
+//
+// Sets up the master and its interrupt.
+//
+//*****************************************************************************
+static void
+I2CBusConfigure(tI2CBus *psBus)
+{
+    MAP_I2CMasterInitExpClk(psBus->ui32Base, MAP_SysCtlClockGet(),
+                            psBus->bFast);
+    MAP_I2CMasterTimeoutSet(psBus->ui32Base, CLOCK_LOW_TIMEOUT);
+    MAP_I2CMasterIntClearEx(psBus->ui32Base, I2C_MASTER_INT_DATA |
+                                             I2C_MASTER_INT_TIMEOUT);
+    MAP_I2CMasterIntEnableEx(psBus->ui32Base, I2C_MASTER_INT_DATA);
+}
+
+//*****************************************************************************
+//
+// Frees a bus held by a slave that lost track of a transfer: up to nine
+// clocks on SCL by hand until the slave lets go of SDA, then a stop.
+//
+//*****************************************************************************
+static void
+I2CBusRecover(tI2CBus *psBus)
+{
+    uint32_t ui32Delay, ui32Count;
+
+    ui32Delay = MAP_SysCtlClockGet() / (3 * 200000);    // 5 us
+    MAP_I2CMasterDisable(psBus->ui32Base);
+
+    MAP_GPIOPinWrite(psBus->ui32SCLPort, psBus->ui8SCLPin, psBus->ui8SCLPin);
+    MAP_GPIOPinTypeGPIOOutputOD(psBus->ui32SCLPort, psBus->ui8SCLPin);
+    MAP_GPIOPinTypeGPIOInput(psBus->ui32SDAPort, psBus->ui8SDAPin);
+
+    for(ui32Count = 0; (ui32Count < 9) &&
+        !MAP_GPIOPinRead(psBus->ui32SDAPort, psBus->ui8SDAPin); ui32Count++)
+    {
+        MAP_GPIOPinWrite(psBus->ui32SCLPort, psBus->ui8SCLPin, 0);
+        MAP_SysCtlDelay(ui32Delay);
+        MAP_GPIOPinWrite(psBus->ui32SCLPort, psBus->ui8SCLPin,
+                         psBus->ui8SCLPin);
+        MAP_SysCtlDelay(ui32Delay);
+    }
+
+    //
+    // Start then stop, with the clock high, so every slave resets.
+    //
+    MAP_GPIOPinWrite(psBus->ui32SDAPort, psBus->ui8SDAPin, 0);
+    MAP_GPIOPinTypeGPIOOutputOD(psBus->ui32SDAPort, psBus->ui8SDAPin);
+    MAP_SysCtlDelay(ui32Delay);
+    MAP_GPIOPinWrite(psBus->ui32SDAPort, psBus->ui8SDAPin, psBus->ui8SDAPin);
+    MAP_SysCtlDelay(ui32Delay);
+
+    MAP_GPIOPinTypeI2CSCL(psBus->ui32SCLPort, psBus->ui8SCLPin);
+    MAP_GPIOPinTypeI2C(psBus->ui32SDAPort, psBus->ui8SDAPin);
+    I2CBusConfigure(psBus);
+}
+
+//*****************************************************************************
+//
+// Issues a master command, noting whether it ends the transfer with a stop.
+//
+//*****************************************************************************
+static void
+I2CBusCommand(tI2CBus *psBus, uint32_t ui32Cmd, bool bStop)
+{
+    psBus->bStopped = bStop;
+    MAP_I2CMasterControl(psBus->ui32Base, ui32Cmd);
+}
+
+//*****************************************************************************
+//
+// Addresses the device for reading and asks for the first byte; a repeated
+// start if the write phase came first.
+//
+//*****************************************************************************
+static void
+I2CBusStartRead(tI2CBus *psBus, tI2CTransfer *psTransfer)
+{
+    psBus->ui32Phase = PHASE_READ;
+    psBus->ui32Index = 0;
+    MAP_I2CMasterSlaveAddrSet(psBus->ui32Base, psTransfer->ui8Addr, true);
+    if(psTransfer->ui32RxLen == 1)
+    {
+        I2CBusCommand(psBus, I2C_MASTER_CMD_SINGLE_RECEIVE, true);
+    }
+    else
+    {
+        I2CBusCommand(psBus, I2C_MASTER_CMD_BURST_RECEIVE_START, false);
+    }
+}
+
+//*****************************************************************************
+//
+// Starts the transfer at the head of the queue, if any.  Runs in the
+// interrupt handler or with the interrupt masked.
+//
+//*****************************************************************************
+static void
+I2CBusStart(tI2CBus *psBus)
+{
+    tI2CTransfer *psTransfer;
+
+    if(psBus->ui32Read == psBus->ui32Write)
+    {
+        psBus->psCurrent = 0;
+        return;
+    }
+    psTransfer = psBus->ppsQueue[psBus->ui32Read % I2C_QUEUE_DEPTH];
+    psBus->psCurrent = psTransfer;
+
+    if(!psTransfer->ui32TxLen)
+    {
+        I2CBusStartRead(psBus, psTransfer);
+        return;
+    }
+
+    psBus->ui32Phase = PHASE_WRITE;
+    psBus->ui32Index = 1;
+    MAP_I2CMasterSlaveAddrSet(psBus->ui32Base, psTransfer->ui8Addr, false);
+    MAP_I2CMasterDataPut(psBus->ui32Base, psTransfer->pui8Tx[0]);
+    if((psTransfer->ui32TxLen == 1) && !psTransfer->ui32RxLen)
+    {
+        I2CBusCommand(psBus, I2C_MASTER_CMD_SINGLE_SEND, true);
+    }
+    else
+    {
+        I2CBusCommand(psBus, I2C_MASTER_CMD_BURST_SEND_START, false);
+    }
+}
+
+//*****************************************************************************
+//
+// Completes the current transfer and starts the next.
+//
+//*****************************************************************************
+static void
+I2CBusFinish(tI2CBus *psBus, uint32_t ui32Status)
+{
+    if(ui32Status == I2C_STATUS_DONE)
+    {
+        psBus->ui32Done++;
+    }
+    else if(ui32Status == I2C_STATUS_NAK)
+    {
+        psBus->ui32Naks++;
+    }
+    else if(ui32Status == I2C_STATUS_ARB_LOST)
+    {
+        psBus->ui32ArbLost++;
+    }
+    else
+    {
+        psBus->ui32Timeouts++;
+    }
+
+    psBus->psCurrent->ui32Status = ui32Status;
+    psBus->ui32Read++;
+    I2CBusStart(psBus);
+}
+
+//*****************************************************************************
+//
+//! Prepares a bus.
+//!
+//! \param psBus is the bus, its application members filled in.
+//!
+//! The I2C module and GPIO port must be enabled and the pins configured for
+//! I2C (with pull-ups on the board).  Enables the module's interrupt.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+I2CBusInit(tI2CBus *psBus)
+{
+    psBus->ui32Write = 0;
+    psBus->ui32Read = 0;
+    psBus->psCurrent = 0;
+
+    I2CBusConfigure(psBus);
+    if(MAP_I2CMasterBusBusy(psBus->ui32Base))
+    {
+        I2CBusRecover(psBus);
+    }
+    MAP_IntEnable(psBus->ui32Int);
+}
+
+//*****************************************************************************
+//
+//! Queues a transfer.
+//!
+//! \param psBus is the bus.
+//! \param psTransfer is the transfer, not already queued.
+//!
+//! Transfers run one after another in the order queued, each started from
+//! the interrupt handler as the previous one ends; this call never waits
+//! for the bus.
+//!
+//! \return Returns \b false if the queue is full.
+//
+//*****************************************************************************
+bool
+I2CBusSubmit(tI2CBus *psBus, tI2CTransfer *psTransfer)
+{
+    if((psBus->ui32Write - psBus->ui32Read) >= I2C_QUEUE_DEPTH)
+    {
+        psBus->ui32Rejected++;
+        return(false);
+    }
+
+    psTransfer->ui32Status = I2C_STATUS_PENDING;
+    psBus->ppsQueue[psBus->ui32Write % I2C_QUEUE_DEPTH] = psTransfer;
+    psBus->ui32Write++;
+
+    MAP_IntDisable(psBus->ui32Int);
+    if(!psBus->psCurrent)
+    {
+        I2CBusStart(psBus);
+    }
+    MAP_IntEnable(psBus->ui32Int);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Moves the current transfer on by one byte.
+//!
+//! \param psBus is the bus.
+//!
+//! Call from the module's interrupt handler.  The TM4C123 master moves one
+//! byte per command (it has no FIFO and no uDMA channel), so this runs once
+//! per byte: on a NAK it sends a stop, and after each byte it issues the
+//! command for the next, finishing with a stop.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+I2CBusIntHandler(tI2CBus *psBus)
+{
+    tI2CTransfer *psTransfer;
+    uint32_t ui32Err;
+
+    //
+    // Ignore a request left pending in the NVIC by I2CBusRecover().
+    //
+    if(!MAP_I2CMasterIntStatusEx(psBus->ui32Base, true))
+    {
+        return;
+    }
+    MAP_I2CMasterIntClearEx(psBus->ui32Base, I2C_MASTER_INT_DATA |
+                                             I2C_MASTER_INT_TIMEOUT);
+    psTransfer = psBus->psCurrent;
+    if(!psTransfer || (psBus->ui32Phase == PHASE_STUCK))
+    {
+        return;
+    }
+
+    //
+    // The stop that followed an error; ui32Index holds the status.
+    //
+    if(psBus->ui32Phase == PHASE_STOP)
+    {
+        I2CBusFinish(psBus, psBus->ui32Index);
+        return;
+    }
+
+    ui32Err = MAP_I2CMasterErr(psBus->ui32Base);
+    if(ui32Err & I2C_MASTER_ERR_CLK_TOUT)
+    {
+        psBus->ui32Phase = PHASE_STUCK;
+        return;
+    }
+    if(ui32Err & I2C_MASTER_ERR_ARB_LOST)
+    {
+        I2CBusFinish(psBus, I2C_STATUS_ARB_LOST);
+        return;
+    }
+    if(ui32Err != I2C_MASTER_ERR_NONE)
+    {
+        if(psBus->bStopped)
+        {
+            I2CBusFinish(psBus, I2C_STATUS_NAK);
+        }
+        else
+        {
+            I2CBusCommand(psBus, (psBus->ui32Phase == PHASE_READ) ?
+                          I2C_MASTER_CMD_BURST_RECEIVE_ERROR_STOP :
+                          I2C_MASTER_CMD_BURST_SEND_ERROR_STOP, true);
+            psBus->ui32Phase = PHASE_STOP;
+            psBus->ui32Index = I2C_STATUS_NAK;
+        }
+        return;
+    }
+
+    if(psBus->ui32Phase == PHASE_WRITE)
+    {
+        if(psBus->ui32Index < psTransfer->ui32TxLen)
+        {
+            MAP_I2CMasterDataPut(psBus->ui32Base,
+                                 psTransfer->pui8Tx[psBus->ui32Index++]);
+            if((psBus->ui32Index == psTransfer->ui32TxLen) &&
+               !psTransfer->ui32RxLen)
+            {
+                I2CBusCommand(psBus, I2C_MASTER_CMD_BURST_SEND_FINISH, true);
+            }
+            else
+            {
+                I2CBusCommand(psBus, I2C_MASTER_CMD_BURST_SEND_CONT, false);
+            }
+        }
+        else if(psTransfer->ui32RxLen)
+        {
+            I2CBusStartRead(psBus, psTransfer);
+        }
+        else
+        {
+            I2CBusFinish(psBus, I2C_STATUS_DONE);
+        }
+        return;
+    }
+
+    psTransfer->pui8Rx[psBus->ui32Index++] =
+        MAP_I2CMasterDataGet(psBus->ui32Base);
+    if(psBus->ui32Index == psTransfer->ui32RxLen)
+    {
+        I2CBusFinish(psBus, I2C_STATUS_DONE);
+    }
+    else if(psBus->ui32Index == (psTransfer->ui32RxLen - 1))
+    {
+        I2CBusCommand(psBus, I2C_MASTER_CMD_BURST_RECEIVE_FINISH, true);
+    }
+    else
+    {
+        I2CBusCommand(psBus, I2C_MASTER_CMD_BURST_RECEIVE_CONT, false);
+    }
+}
+
+//*****************************************************************************
+//
+//! Watches for a stuck transfer.
+//!
+//! \param psBus is the bus.
+//! \param ui32NowMs is the time in milliseconds.
+//!
+//! Call from the main loop.  If no transfer has ended for \b I2C_TIMEOUT_MS
+//! while one is in progress, the bus is recovered (clocked by hand until
+//! the slaves let go of it, then the master is set up again), the transfer
+//! fails with \b I2C_STATUS_TIMEOUT and the queue carries on.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+I2CBusService(tI2CBus *psBus, uint32_t ui32NowMs)
+{
+    uint32_t ui32Ended;
+
+    ui32Ended = psBus->ui32Done + psBus->ui32Naks + psBus->ui32ArbLost +
+                psBus->ui32Timeouts;
+    if(!psBus->psCurrent || (ui32Ended != psBus->ui32Seen))
+    {
+        psBus->ui32Seen = ui32Ended;
+        psBus->ui32SeenTime = ui32NowMs;
+        return;
+    }
+    if((ui32NowMs - psBus->ui32SeenTime) < I2C_TIMEOUT_MS)
+    {
+        return;
+    }
+
+    //
+    // Check again with the interrupt masked, in case the transfer has just
+    // ended after all.
+    //
+    MAP_IntDisable(psBus->ui32Int);
+    if(psBus->psCurrent &&
+       ((psBus->ui32Done + psBus->ui32Naks + psBus->ui32ArbLost +
+         psBus->ui32Timeouts) == ui32Ended))
+    {
+        I2CBusRecover(psBus);
+        I2CBusFinish(psBus, I2C_STATUS_TIMEOUT);
+    }
+    MAP_IntEnable(psBus->ui32Int);
+    psBus->ui32SeenTime = ui32NowMs;
+}
+
+//*****************************************************************************
+//
+//! Prints the bus statistics.
+//!
+//! \param psBus is the bus.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+I2CBusReport(tI2CBus *psBus)
+{
+    UARTprintf("I2C: %d transfers done, %d NAKs, %d arbitration lost, "
+               "%d timeouts, %d refused, %d queued\n", psBus->ui32Done,
+               psBus->ui32Naks, psBus->ui32ArbLost, psBus->ui32Timeouts,
+               psBus->ui32Rejected, psBus->ui32Write - psBus->ui32Read);
+}
+
+//*****************************************************************************
+//
+//! Prepares sensors for polling.
+//!
+//! \param psPoller is the poller.
+//! \param psBus is the bus the sensors are on.
+//! \param psSensors is the sensor table.
+//! \param ui32Count is the number of sensors.
+//! \param ui32PerTick is how many are read per I2CPollTick().
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+I2CPollInit(tI2CPoller *psPoller, tI2CBus *psBus, tI2CSensor *psSensors,
+            uint32_t ui32Count, uint32_t ui32PerTick)
+{
+    tI2CSensor *psSensor;
+    uint32_t ui32Idx;
+
+    psPoller->psBus = psBus;
+    psPoller->psSensors = psSensors;
+    psPoller->ui32Count = ui32Count;
+    psPoller->ui32PerTick = (ui32PerTick < ui32Count) ? ui32PerTick :
+                                                         ui32Count;
+    psPoller->ui32Next = 0;
+
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        psSensor = &psSensors[ui32Idx];
+        psSensor->bValid = false;
+        psSensor->bBusy = false;
+        psSensor->ui32Reads = 0;
+        psSensor->ui32Errors = 0;
+        psSensor->sTransfer.ui8Addr = psSensor->ui8Addr;
+        psSensor->sTransfer.pui8Tx = &psSensor->ui8Reg;
+        psSensor->sTransfer.ui32TxLen = 1;
+        psSensor->sTransfer.pui8Rx = psSensor->pui8Data;
+        psSensor->sTransfer.ui32RxLen = psSensor->ui8Len;
+        psSensor->sTransfer.ui32Status = I2C_STATUS_DONE;
+    }
+}
+
+//*****************************************************************************
+//
+//! Collects finished readings and queues the next sensors.
+//!
+//! \param psPoller is the poller.
+//!
+//! Call at the polling interval from the main loop.  Each call takes the
+//! results of reads that have ended and queues reads of the next
+//! ui32PerTick sensors in turn (skipping any whose last read has not
+//! ended), so a call costs a few microseconds whatever the bus speed.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+I2CPollTick(tI2CPoller *psPoller)
+{
+    tI2CSensor *psSensor;
+    uint32_t ui32Idx, ui32Byte, ui32Value;
+
+    for(ui32Idx = 0; ui32Idx < psPoller->ui32Count; ui32Idx++)
+    {
+        psSensor = &psPoller->psSensors[ui32Idx];
+        if(!psSensor->bBusy ||
+           (psSensor->sTransfer.ui32Status == I2C_STATUS_PENDING))
+        {
+            continue;
+        }
+
+        psSensor->bBusy = false;
+        if(psSensor->sTransfer.ui32Status != I2C_STATUS_DONE)
+        {
+            psSensor->ui32Errors++;
+            psSensor->bValid = false;
+            continue;
+        }
+
+        if(psSensor->pfnConvert)
+        {
+            psSensor->i32Value = psSensor->pfnConvert(psSensor->pui8Data);
+        }
+        else
+        {
+            ui32Value = 0;
+            for(ui32Byte = 0; ui32Byte < psSensor->ui8Len; ui32Byte++)
+            {
+                ui32Value = (ui32Value << 8) | psSensor->pui8Data[ui32Byte];
+            }
+            psSensor->i32Value = (int32_t)ui32Value;
+        }
+        psSensor->bValid = true;
+        psSensor->ui32Reads++;
+    }
+
+    for(ui32Idx = 0; ui32Idx < psPoller->ui32PerTick; ui32Idx++)
+    {
+        psSensor = &psPoller->psSensors[psPoller->ui32Next];
+        psPoller->ui32Next = (psPoller->ui32Next + 1) % psPoller->ui32Count;
+        if(!psSensor->bBusy)
+        {
+            psSensor->bBusy = I2CBusSubmit(psPoller->psBus,
+                                           &psSensor->sTransfer);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Prints the latest reading of each sensor.
+//!
+//! \param psPoller is the poller.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+I2CPollReport(tI2CPoller *psPoller)
+{
+    tI2CSensor *psSensor;
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < psPoller->ui32Count; ui32Idx++)
+    {
+        psSensor = &psPoller->psSensors[ui32Idx];
+        if(psSensor->bValid)
+        {
+            UARTprintf("     %s (0x%02x): %d", psSensor->pcName,
+                       psSensor->ui8Addr, psSensor->i32Value);
+        }
+        else
+        {
+            UARTprintf("     %s (0x%02x): no reading", psSensor->pcName,
+                       psSensor->ui8Addr);
+        }
+        UARTprintf(", %d reads, %d errors\n", psSensor->ui32Reads,
+                   psSensor->ui32Errors);
+    }
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
@@ -0,0 +1,168 @@
+//*****************************************************************************
+//
+// i2cbus.h - Queued, interrupt-driven I2C master and sensor polling.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_I2CBUS_H__
+#define __UTILS_I2CBUS_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Transfers waiting for the bus, the one in progress included.
+//
+//*****************************************************************************
+#define I2C_QUEUE_DEPTH         8
+
+//*****************************************************************************
+//
+// A transfer that makes no progress for this long is abandoned and the bus
+// recovered.
+//
+//*****************************************************************************
+#define I2C_TIMEOUT_MS          20
+
+//*****************************************************************************
+//
+// Values of tI2CTransfer ui32Status.
+//
+//*****************************************************************************
+#define I2C_STATUS_DONE         0
+#define I2C_STATUS_PENDING      1   // queued or on the bus
+#define I2C_STATUS_NAK          2   // address or data not acknowledged
+#define I2C_STATUS_ARB_LOST     3   // another master took the bus
+#define I2C_STATUS_TIMEOUT      4   // stuck; the bus was recovered
+
+//*****************************************************************************
+//
+// A transfer: ui32TxLen bytes written to the device, then, after a repeated
+// start, ui32RxLen bytes read from it (either may be zero, not both).  The
+// caller owns the memory, fills in the first five members and leaves the
+// structure alone until ui32Status is no longer I2C_STATUS_PENDING.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t ui8Addr;            // 7-bit device address
+    const uint8_t *pui8Tx;
+    uint32_t ui32TxLen;
+    uint8_t *pui8Rx;
+    uint32_t ui32RxLen;
+    volatile uint32_t ui32Status;
+}
+tI2CTransfer;
+
+//*****************************************************************************
+//
+// A bus: the I2C module, its interrupt, the pins (needed to free a stuck
+// bus by hand) and the speed, set by the application; the rest is private
+// to i2cbus.c.  The application configures the pins for I2C and routes the
+// module's interrupt to I2CBusIntHandler().
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Base;
+    uint32_t ui32Int;
+    uint32_t ui32SCLPort;
+    uint8_t ui8SCLPin;
+    uint32_t ui32SDAPort;
+    uint8_t ui8SDAPin;
+    bool bFast;                 // 400 kHz rather than 100 kHz
+
+    tI2CTransfer *ppsQueue[I2C_QUEUE_DEPTH];
+    volatile uint32_t ui32Write;
+    volatile uint32_t ui32Read;
+    tI2CTransfer * volatile psCurrent;
+    uint32_t ui32Phase;
+    uint32_t ui32Index;         // bytes of the current phase done
+    bool bStopped;              // the last command ends with a stop
+
+    volatile uint32_t ui32Done;
+    volatile uint32_t ui32Naks;
+    volatile uint32_t ui32ArbLost;
+    uint32_t ui32Timeouts;
+    uint32_t ui32Rejected;      // refused because the queue was full
+    uint32_t ui32Seen;          // ui32Done + errors at the last check
+    uint32_t ui32SeenTime;
+}
+tI2CBus;
+
+//*****************************************************************************
+//
+// A sensor register read at regular intervals by I2CPollTick().  The
+// application sets the first five members.  pfnConvert turns the raw bytes
+// (big-endian, as most sensors send them) into the value kept in i32Value;
+// if it is 0 the raw bytes are kept as an unsigned number.
+//
+//*****************************************************************************
+typedef struct
+{
+    const char *pcName;
+    uint8_t ui8Addr;
+    uint8_t ui8Reg;
+    uint8_t ui8Len;             // at most 4
+    int32_t (*pfnConvert)(const uint8_t *pui8Data);
+
+    int32_t i32Value;
+    bool bValid;                // i32Value holds a reading
+    bool bBusy;                 // sTransfer submitted, result not yet taken
+    uint32_t ui32Reads;
+    uint32_t ui32Errors;
+    tI2CTransfer sTransfer;
+    uint8_t pui8Data[4];
+}
+tI2CSensor;
+
+//*****************************************************************************
+//
+// A set of sensors polled round robin, ui32PerTick of them per tick.
+//
+//*****************************************************************************
+typedef struct
+{
+    tI2CBus *psBus;
+    tI2CSensor *psSensors;
+    uint32_t ui32Count;
+    uint32_t ui32PerTick;
+    uint32_t ui32Next;
+}
+tI2CPoller;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void I2CBusInit(tI2CBus *psBus);
+extern bool I2CBusSubmit(tI2CBus *psBus, tI2CTransfer *psTransfer);
+extern void I2CBusIntHandler(tI2CBus *psBus);
+extern void I2CBusService(tI2CBus *psBus, uint32_t ui32NowMs);
+extern void I2CBusReport(tI2CBus *psBus);
+extern void I2CPollInit(tI2CPoller *psPoller, tI2CBus *psBus,
+                        tI2CSensor *psSensors, uint32_t ui32Count,
+                        uint32_t ui32PerTick);
+extern void I2CPollTick(tI2CPoller *psPoller);
+extern void I2CPollReport(tI2CPoller *psPoller);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_I2CBUS_H__
@@ -0,0 +1,268 @@
+//*****************************************************************************
+//
+// intprio.c - Interrupt priority plan and BASEPRI critical sections.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_types.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/cyclecount.h"
+#include "utils/intprio.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup intprio_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Flags IntMaskRaise() adds to the BASEPRI value it returns.
+//
+//*****************************************************************************
+#define INT_SAVED_PRIMASK       0x80000000  // PRIMASK was set by this call
+#define INT_SAVED_RAISED        0x40000000  // the mask was raised by this call
+
+//*****************************************************************************
+//
+// The image's plan, and the critical-section timings per level: when the
+// outermost section at each level began, how many ended, and the longest.
+//
+//*****************************************************************************
+static const tIntPriority *g_psPlan;
+static uint32_t g_ui32PlanCount;
+static volatile bool g_bStats;
+static uint32_t g_pui32Start[INT_LEVELS];
+static uint32_t g_pui32Sections[INT_LEVELS];
+static uint32_t g_pui32MaxHeld[INT_LEVELS];
+
+//*****************************************************************************
+//
+// Raises the interrupt mask to hold off priorities ui32Level and below,
+// never lowering it.  Level 0 sets PRIMASK instead, since BASEPRI cannot
+// mask priority 0.  Returns the previous BASEPRI with INT_SAVED_* flags.
+//
+// BASEPRI is read, then written: a handler that preempts in between restores
+// whatever mask it raises before it returns, so the value read is still
+// current.
+//
+//*****************************************************************************
+__asm("    .sect   \".text:IntMaskRaise\"\n"
+      "    .thumb\n"
+      "    .thumbfunc IntMaskRaise\n"
+      "    .global IntMaskRaise\n"
+      "IntMaskRaise: .asmfunc\n"
+      "    mrs     r1, basepri\n"
+      "    mrs     r2, primask\n"
+      "    cbnz    r2, IntMaskKeep\n"
+      "    ands    r0, r0, #0xe0\n"
+      "    beq     IntMaskAll\n"
+      "    cbz     r1, IntMaskSet\n"
+      "    cmp     r0, r1\n"
+      "    bhs     IntMaskKeep\n"
+      "IntMaskSet:\n"
+      "    msr     basepri, r0\n"
+      "    orr     r0, r1, #0x40000000\n"
+      "    bx      lr\n"
+      "IntMaskAll:\n"
+      "    cpsid   i\n"
+      "    orr     r0, r1, #0xc0000000\n"
+      "    bx      lr\n"
+      "IntMaskKeep:\n"
+      "    mov     r0, r1\n"
+      "    bx      lr\n"
+      "    .endasmfunc\n");
+
+//*****************************************************************************
+//
+// Puts back the mask saved by IntMaskRaise().
+//
+//*****************************************************************************
+__asm("    .sect   \".text:IntMaskRestore\"\n"
+      "    .thumb\n"
+      "    .thumbfunc IntMaskRestore\n"
+      "    .global IntMaskRestore\n"
+      "IntMaskRestore: .asmfunc\n"
+      "    msr     basepri, r0\n"
+      "    lsls    r1, r0, #1\n"
+      "    bcc     IntMaskRestored\n"
+      "    cpsie   i\n"
+      "IntMaskRestored:\n"
+      "    bx      lr\n"
+      "    .endasmfunc\n");
+
+extern uint32_t IntMaskRaise(uint32_t ui32Level);
+extern void IntMaskRestore(uint32_t ui32Saved);
+
+//*****************************************************************************
+//
+//! Gives each interrupt of a firmware image its priority.
+//!
+//! \param psPlan is the plan, one entry per interrupt the image uses.
+//! \param ui32Count is the number of entries.
+//!
+//! Call once, before any of the interrupts is enabled.  The plan is kept
+//! for IntPlanReport(), so it must stay in memory.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+IntPlanApply(const tIntPriority *psPlan, uint32_t ui32Count)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        MAP_IntPrioritySet(psPlan[ui32Idx].ui32Interrupt,
+                           psPlan[ui32Idx].ui8Priority);
+    }
+
+    g_psPlan = psPlan;
+    g_ui32PlanCount = ui32Count;
+}
+
+//*****************************************************************************
+//
+//! Begins a critical section against the interrupts at a priority level.
+//!
+//! \param ui32Level is the priority of the most urgent interrupt that shares
+//! the data being updated; it and every less urgent interrupt are held off.
+//! \b INT_LEVEL_ALL holds off all of them.
+//!
+//! Interrupts more urgent than \e ui32Level keep running.  Sections nest,
+//! and the mask is only ever raised, so an inner section at a less urgent
+//! level costs nothing.
+//!
+//! \return Returns the value to give to IntCriticalExit().
+//
+//*****************************************************************************
+uint32_t
+IntCriticalEnter(uint32_t ui32Level)
+{
+    uint32_t ui32Saved;
+
+    ui32Saved = IntMaskRaise(ui32Level);
+    if(ui32Saved & INT_SAVED_RAISED)
+    {
+        g_pui32Start[(ui32Saved & INT_SAVED_PRIMASK) ? 0 :
+                     (ui32Level / INT_LEVEL_STEP)] = CycleCountGet();
+    }
+
+    return(ui32Saved);
+}
+
+//*****************************************************************************
+//
+//! Ends a critical section.
+//!
+//! \param ui32Saved is the value returned by IntCriticalEnter().
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+IntCriticalExit(uint32_t ui32Saved)
+{
+    uint32_t ui32Level, ui32Cycles;
+
+    if(g_bStats && (ui32Saved & INT_SAVED_RAISED))
+    {
+        ui32Level = (ui32Saved & INT_SAVED_PRIMASK) ? 0 :
+                    (MAP_IntPriorityMaskGet() / INT_LEVEL_STEP);
+        ui32Cycles = CycleCountGet() - g_pui32Start[ui32Level];
+        g_pui32Sections[ui32Level]++;
+        if(ui32Cycles > g_pui32MaxHeld[ui32Level])
+        {
+            g_pui32MaxHeld[ui32Level] = ui32Cycles;
+        }
+    }
+
+    IntMaskRestore(ui32Saved);
+}
+
+//*****************************************************************************
+//
+//! Starts or stops timing the critical sections.
+//!
+//! \param bEnable is \b true to clear the timings and start, \b false to
+//! stop and keep them for IntPlanReport().
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+IntCriticalStatsEnable(bool bEnable)
+{
+    uint32_t ui32Idx;
+
+    if(bEnable)
+    {
+        g_bStats = false;
+        for(ui32Idx = 0; ui32Idx < INT_LEVELS; ui32Idx++)
+        {
+            g_pui32Sections[ui32Idx] = 0;
+            g_pui32MaxHeld[ui32Idx] = 0;
+        }
+    }
+    g_bStats = bEnable;
+}
+
+//*****************************************************************************
+//
+//! Prints the priority plan with the critical-section timings per level.
+//!
+//! For each level this lists the sections that masked at that level and the
+//! longest of them, then the longest an interrupt at that priority could
+//! have been held off: the longest section at its level or any more urgent
+//! one.  Code that masks with IntMasterDisable() directly is not counted.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+IntPlanReport(void)
+{
+    uint32_t ui32Level, ui32Idx, ui32Worst;
+    bool bFirst;
+
+    UARTprintf("Interrupt priorities (critical sections %s):\n",
+               g_bStats ? "timed" : "not timed");
+    UARTprintf("  Level  sections  max held  worst wait  interrupts\n");
+
+    ui32Worst = 0;
+    for(ui32Level = 0; ui32Level < INT_LEVELS; ui32Level++)
+    {
+        if(g_pui32MaxHeld[ui32Level] > ui32Worst)
+        {
+            ui32Worst = g_pui32MaxHeld[ui32Level];
+        }
+
+        UARTprintf("   0x%02x %9d %9d %11d  ", ui32Level * INT_LEVEL_STEP,
+                   g_pui32Sections[ui32Level], g_pui32MaxHeld[ui32Level],
+                   ui32Worst);
+        bFirst = true;
+        for(ui32Idx = 0; ui32Idx < g_ui32PlanCount; ui32Idx++)
+        {
+            if((g_psPlan[ui32Idx].ui8Priority / INT_LEVEL_STEP) == ui32Level)
+            {
+                UARTprintf(bFirst ? "%s" : ", %s", g_psPlan[ui32Idx].pcName);
+                bFirst = false;
+            }
+        }
+        UARTprintf("\n");
+    }
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
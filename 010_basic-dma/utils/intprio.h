@@ -0,0 +1,73 @@
+//*****************************************************************************
+//
+// intprio.h - Interrupt priority plan and BASEPRI critical sections.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_INTPRIO_H__
+#define __UTILS_INTPRIO_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The TM4C123 implements the top three bits of each priority, so there are
+// eight levels, 0x00 (most urgent) to 0xE0.
+//
+//*****************************************************************************
+#define INT_LEVELS              8
+#define INT_LEVEL_STEP          0x20
+
+//*****************************************************************************
+//
+// A critical section at this level holds off every interrupt, as
+// IntMasterDisable() does.  An interrupt at priority 0x00 can only be held
+// off this way, so it is the place for handlers that share nothing with
+// less urgent code.
+//
+//*****************************************************************************
+#define INT_LEVEL_ALL           0x00
+
+//*****************************************************************************
+//
+// An entry of a firmware image's priority plan.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Interrupt;     // INT_* or FAULT_SYSTICK/FAULT_PENDSV
+    uint8_t ui8Priority;
+    const char *pcName;
+}
+tIntPriority;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void IntPlanApply(const tIntPriority *psPlan, uint32_t ui32Count);
+extern uint32_t IntCriticalEnter(uint32_t ui32Level);
+extern void IntCriticalExit(uint32_t ui32Saved);
+extern void IntCriticalStatsEnable(bool bEnable);
+extern void IntPlanReport(void);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_INTPRIO_H__
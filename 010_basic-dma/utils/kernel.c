@@ -0,0 +1,841 @@
+//*****************************************************************************
+//
+// kernel.c - Minimal preemptive kernel: threads, semaphores and mutexes.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_ints.h"
+#include "inc/hw_nvic.h"
+#include "inc/hw_types.h"
+#include "driverlib/fpu.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/cyclecount.h"
+#include "utils/stackmon.h"
+#include "utils/kernel.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup kernel_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// PendSV runs at the lowest priority, so a switch never delays an interrupt
+// handler and always waits for the last one to finish.
+//
+//*****************************************************************************
+#define KERNEL_PENDSV_PRIORITY  0xE0
+
+//*****************************************************************************
+//
+// Stack sizes of the kernel's own threads.  A switched-out thread holds an
+// extended exception frame (26 words) and the registers saved by the switch
+// (25 words) on top of whatever it was using.
+//
+//*****************************************************************************
+#define KERNEL_IDLE_STACK_BYTES 256
+#define KERNEL_BENCH_STACK_BYTES 256
+
+//*****************************************************************************
+//
+// The initial xPSR of a thread (Thumb state) and the EXC_RETURN value that
+// returns to thread mode on the process stack without an FPU frame.
+//
+//*****************************************************************************
+#define THREAD_INITIAL_XPSR     0x01000000
+#define THREAD_INITIAL_EXC_RETURN 0xFFFFFFFD
+
+//*****************************************************************************
+//
+// The running thread and the one PendSV is to switch to, the hook run from
+// PendSV first and the number of switches.  Not static: the context switch
+// uses them.
+//
+//*****************************************************************************
+tThread *g_psKernelCurrent;
+tThread * volatile g_psKernelNext;
+void (*g_pfnKernelPendSV)(void);
+uint32_t g_ui32KernelSwitches;
+
+//*****************************************************************************
+//
+// All threads, in creation order; whether KernelStart() has run; the ticks
+// so far; and the cost of the kernel's critical sections.
+//
+//*****************************************************************************
+static tThread *g_psThreads;
+static bool g_bRunning;
+static uint32_t g_ui32Ticks;
+static uint32_t g_ui32LockStart;
+static uint32_t g_ui32MaxLocked;
+static uint32_t g_ui32SwitchCycles;
+
+//*****************************************************************************
+//
+// The idle thread, which runs when no other can, and the two threads
+// KernelBenchmark() bounces between.
+//
+//*****************************************************************************
+#pragma DATA_ALIGN(g_pui32IdleStack, 8)
+static uint32_t g_pui32IdleStack[KERNEL_IDLE_STACK_BYTES / 4];
+static tThread g_sIdleThread;
+#pragma DATA_ALIGN(g_pui32PingStack, 8)
+static uint32_t g_pui32PingStack[KERNEL_BENCH_STACK_BYTES / 4];
+#pragma DATA_ALIGN(g_pui32PongStack, 8)
+static uint32_t g_pui32PongStack[KERNEL_BENCH_STACK_BYTES / 4];
+static tThread g_sPingThread, g_sPongThread;
+static tSemaphore g_sPing, g_sBenchDone;
+static volatile bool g_bBenchStop;
+static uint32_t g_ui32BenchRounds;
+static uint32_t g_ui32BenchCycles;
+
+//*****************************************************************************
+//
+// Names of the THREAD_ states, for KernelReport().
+//
+//*****************************************************************************
+static const char * const g_ppcStateNames[] =
+{
+    "ready", "sleeping", "pending", "locking", "done"
+};
+
+//*****************************************************************************
+//
+// The PendSV handler.
+//
+// Runs the hook, then, if g_psKernelNext is not the running thread, saves
+// R4-R11 and EXC_RETURN (and S16-S31 if the thread has used the FPU; the
+// hardware has already reserved room for S0-S15 and stacks them lazily) on
+// the outgoing thread's stack and restores the incoming one's.  Interrupts
+// are masked only while the two thread pointers are used.
+//
+//*****************************************************************************
+__asm("    .sect   \".text:KernelPendSVHandler\"\n"
+      "    .thumb\n"
+      "    .thumbfunc KernelPendSVHandler\n"
+      "    .global KernelPendSVHandler\n"
+      "    .global g_psKernelCurrent\n"
+      "    .global g_psKernelNext\n"
+      "    .global g_pfnKernelPendSV\n"
+      "    .global g_ui32KernelSwitches\n"
+      "KernelPendSVHandler: .asmfunc\n"
+      "    ldr     r1, c_kernel_hook\n"
+      "    ldr     r1, [r1]\n"
+      "    cbz     r1, KernelSwitch\n"
+      "    push    {r0, lr}\n"
+      "    blx     r1\n"
+      "    pop     {r0, lr}\n"
+      "KernelSwitch:\n"
+      "    cpsid   i\n"
+      "    ldr     r3, c_kernel_current\n"
+      "    ldr     r2, [r3]\n"
+      "    ldr     r1, c_kernel_next\n"
+      "    ldr     r1, [r1]\n"
+      "    cmp     r1, r2\n"
+      "    beq     KernelSwitchDone\n"
+      "    mrs     r0, psp\n"
+      "    cbz     r2, KernelRestore\n"
+      "    tst     lr, #0x10\n"
+      "    it      eq\n"
+      "    vstmdbeq r0!, {s16-s31}\n"
+      "    stmdb   r0!, {r4-r11, lr}\n"
+      "    str     r0, [r2]\n"
+      "KernelRestore:\n"
+      "    str     r1, [r3]\n"
+      "    ldr     r0, [r1]\n"
+      "    ldmia   r0!, {r4-r11, lr}\n"
+      "    tst     lr, #0x10\n"
+      "    it      eq\n"
+      "    vldmiaeq r0!, {s16-s31}\n"
+      "    msr     psp, r0\n"
+      "    ldr     r3, c_kernel_switches\n"
+      "    ldr     r2, [r3]\n"
+      "    adds    r2, r2, #1\n"
+      "    str     r2, [r3]\n"
+      "KernelSwitchDone:\n"
+      "    cpsie   i\n"
+      "    bx      lr\n"
+      "    .endasmfunc\n"
+      "    .align  4\n"
+      "c_kernel_hook: .word g_pfnKernelPendSV\n"
+      "c_kernel_current: .word g_psKernelCurrent\n"
+      "c_kernel_next: .word g_psKernelNext\n"
+      "c_kernel_switches: .word g_ui32KernelSwitches\n");
+
+//*****************************************************************************
+//
+// Masks interrupts for a change to the kernel's state, timing the outermost
+// critical section.  Returns whether interrupts were already masked.
+//
+//*****************************************************************************
+static bool
+KernelLock(void)
+{
+    bool bMasked;
+
+    bMasked = MAP_IntMasterDisable();
+    if(!bMasked)
+    {
+        g_ui32LockStart = CycleCountGet();
+    }
+    return(bMasked);
+}
+
+//*****************************************************************************
+//
+// Ends a critical section begun by KernelLock().  A switch requested inside
+// it happens here, when interrupts are unmasked and PendSV can run.
+//
+//*****************************************************************************
+static void
+KernelUnlock(bool bMasked)
+{
+    uint32_t ui32Cycles;
+
+    if(!bMasked)
+    {
+        ui32Cycles = CycleCountGet() - g_ui32LockStart;
+        if(ui32Cycles > g_ui32MaxLocked)
+        {
+            g_ui32MaxLocked = ui32Cycles;
+        }
+        MAP_IntMasterEnable();
+    }
+}
+
+//*****************************************************************************
+//
+// Picks the thread to run and requests a switch if it is not the running
+// one.  Called with interrupts masked.
+//
+//*****************************************************************************
+static void
+KernelSchedule(void)
+{
+    tThread *psThread, *psBest;
+
+    if(!g_bRunning)
+    {
+        return;
+    }
+
+    psBest = 0;
+    for(psThread = g_psThreads; psThread; psThread = psThread->psNext)
+    {
+        if((psThread->ui32State == THREAD_READY) &&
+           (!psBest || (psThread->ui32Priority < psBest->ui32Priority)))
+        {
+            psBest = psThread;
+        }
+    }
+
+    g_psKernelNext = psBest;
+    if(psBest != g_psKernelCurrent)
+    {
+        HWREG(NVIC_INT_CTRL) = NVIC_INT_CTRL_PEND_SV;
+    }
+}
+
+//*****************************************************************************
+//
+// Returns the most urgent thread in state ui32State waiting for pvWait, or 0.
+//
+//*****************************************************************************
+static tThread *
+KernelWaiter(void *pvWait, uint32_t ui32State)
+{
+    tThread *psThread, *psBest;
+
+    psBest = 0;
+    for(psThread = g_psThreads; psThread; psThread = psThread->psNext)
+    {
+        if((psThread->ui32State == ui32State) &&
+           (psThread->pvWait == pvWait) &&
+           (!psBest || (psThread->ui32Priority < psBest->ui32Priority)))
+        {
+            psBest = psThread;
+        }
+    }
+
+    return(psBest);
+}
+
+//*****************************************************************************
+//
+// Makes a sleeping or waiting thread ready.
+//
+//*****************************************************************************
+static void
+KernelWake(tThread *psThread, bool bTimedOut)
+{
+    psThread->ui32State = THREAD_READY;
+    psThread->pvWait = 0;
+    psThread->ui32Delay = 0;
+    psThread->bTimedOut = bTimedOut;
+}
+
+//*****************************************************************************
+//
+// Returns a thread's priority as raised by the threads waiting for the
+// mutexes it holds.
+//
+//*****************************************************************************
+static uint32_t
+KernelInherited(tThread *psOwner)
+{
+    tThread *psThread;
+    tMutex *psMutex;
+    uint32_t ui32Priority;
+
+    ui32Priority = psOwner->ui32BasePriority;
+    for(psMutex = psOwner->psHeld; psMutex; psMutex = psMutex->psNextHeld)
+    {
+        for(psThread = g_psThreads; psThread; psThread = psThread->psNext)
+        {
+            if((psThread->ui32State == THREAD_LOCKING) &&
+               (psThread->pvWait == psMutex) &&
+               (psThread->ui32Priority < ui32Priority))
+            {
+                ui32Priority = psThread->ui32Priority;
+            }
+        }
+    }
+
+    return(ui32Priority);
+}
+
+//*****************************************************************************
+//
+// Where a thread's entry function returns to.
+//
+//*****************************************************************************
+static void
+ThreadExit(void)
+{
+    KernelLock();
+    g_psKernelCurrent->ui32State = THREAD_DONE;
+    KernelSchedule();
+    KernelUnlock(false);
+
+    //
+    // PendSV has switched away for good by now.
+    //
+    while(1)
+    {
+    }
+}
+
+//*****************************************************************************
+//
+// The idle thread.
+//
+//*****************************************************************************
+static void
+ThreadIdle(void *pvArg)
+{
+    while(1)
+    {
+    }
+}
+
+//*****************************************************************************
+//
+//! Prepares the kernel.
+//!
+//! \param pfnPendSV is a function to run from PendSV before each switch, or
+//! 0.  An application that also defers interrupt work to PendSV (such as
+//! SchedPendSVHandler()) passes it here, since KernelPendSVHandler() takes
+//! over the exception.
+//!
+//! Creates the idle thread and sets PendSV to the lowest priority.  Lazy
+//! FPU stacking (the reset default) is made sure of: a thread that has used
+//! the FPU gets an extended exception frame, and the switch then saves
+//! S16-S31 as well; others pay nothing for it.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+KernelInit(void (*pfnPendSV)(void))
+{
+    g_psThreads = 0;
+    g_psKernelCurrent = 0;
+    g_psKernelNext = 0;
+    g_pfnKernelPendSV = pfnPendSV;
+    g_bRunning = false;
+
+    ThreadCreate(&g_sIdleThread, "idle", ThreadIdle, 0, g_pui32IdleStack,
+                 sizeof(g_pui32IdleStack), 0xFFFFFFFF);
+
+    MAP_FPULazyStackingEnable();
+    MAP_IntPrioritySet(FAULT_PENDSV, KERNEL_PENDSV_PRIORITY);
+}
+
+//*****************************************************************************
+//
+//! Creates a thread, or restarts one that has finished.
+//!
+//! \param psThread is the thread, which must stay allocated for ever.
+//! \param pcName names the thread in KernelReport().
+//! \param pfnEntry is the function the thread runs; the thread is done when
+//! it returns, and must not hold a mutex then.
+//! \param pvArg is passed to \e pfnEntry.
+//! \param pui32Stack is the thread's stack, 8-byte aligned.
+//! \param ui32StackBytes is the size of the stack.
+//! \param ui32Priority is the thread's priority, 0 the most urgent.
+//!
+//! The stack is painted, so KernelReport() can show how much of it has
+//! been used.  Once the kernel is running, a thread more urgent than the
+//! caller runs before this returns.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ThreadCreate(tThread *psThread, const char *pcName,
+             void (*pfnEntry)(void *pvArg), void *pvArg,
+             uint32_t *pui32Stack, uint32_t ui32StackBytes,
+             uint32_t ui32Priority)
+{
+    tThread *psScan;
+    uint32_t *pui32SP;
+    bool bMasked;
+
+    psThread->pcName = pcName;
+    psThread->ui32BasePriority = ui32Priority;
+    psThread->ui32Priority = ui32Priority;
+    psThread->ui32Delay = 0;
+    psThread->pvWait = 0;
+    psThread->psHeld = 0;
+    psThread->bTimedOut = false;
+    psThread->sStack.pui32Base = pui32Stack;
+    psThread->sStack.ui32Size = ui32StackBytes & ~7;
+    psThread->sStack.ui32GuardBytes = 0;
+    StackRegionPaint(&psThread->sStack);
+
+    //
+    // Build the frames the first switch to the thread unstacks: R4-R11 and
+    // EXC_RETURN, then the exception frame that "returns" to the entry
+    // function with pvArg in R0 and ThreadExit() as its return address.
+    //
+    pui32SP = pui32Stack + (psThread->sStack.ui32Size / 4);
+    *--pui32SP = THREAD_INITIAL_XPSR;
+    *--pui32SP = (uint32_t)pfnEntry & ~1;
+    *--pui32SP = (uint32_t)ThreadExit;
+    *--pui32SP = 0;                     // R12
+    *--pui32SP = 0;                     // R3
+    *--pui32SP = 0;                     // R2
+    *--pui32SP = 0;                     // R1
+    *--pui32SP = (uint32_t)pvArg;       // R0
+    *--pui32SP = THREAD_INITIAL_EXC_RETURN;
+    pui32SP -= 8;                       // R4-R11
+    psThread->pui32SP = pui32SP;
+
+    bMasked = KernelLock();
+    psThread->ui32State = THREAD_READY;
+    for(psScan = g_psThreads; psScan && (psScan != psThread);
+        psScan = psScan->psNext)
+    {
+        if(!psScan->psNext)
+        {
+            psScan->psNext = psThread;
+            psThread->psNext = 0;
+            break;
+        }
+    }
+    if(!g_psThreads)
+    {
+        g_psThreads = psThread;
+        psThread->psNext = 0;
+    }
+    KernelSchedule();
+    KernelUnlock(bMasked);
+}
+
+//*****************************************************************************
+//
+//! Starts running the threads.
+//!
+//! Interrupts are enabled.  The caller's stack is left to the exception
+//! handlers; from here on threads run on their own stacks.
+//!
+//! \return Does not return.
+//
+//*****************************************************************************
+void
+KernelStart(void)
+{
+    KernelLock();
+    g_bRunning = true;
+    KernelSchedule();
+    KernelUnlock(false);
+
+    //
+    // PendSV switches to the first thread as soon as interrupts are enabled.
+    //
+    while(1)
+    {
+    }
+}
+
+//*****************************************************************************
+//
+//! Advances the kernel's time base.
+//!
+//! Call from the SysTick (or other periodic) interrupt handler.  Threads
+//! sleeping or waiting with a timeout count down in these ticks.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+KernelTick(void)
+{
+    tThread *psThread;
+    bool bMasked;
+
+    bMasked = KernelLock();
+    g_ui32Ticks++;
+    for(psThread = g_psThreads; psThread; psThread = psThread->psNext)
+    {
+        if(((psThread->ui32State == THREAD_SLEEPING) ||
+            (psThread->ui32State == THREAD_PENDING)) &&
+           psThread->ui32Delay && (--psThread->ui32Delay == 0))
+        {
+            KernelWake(psThread, psThread->ui32State == THREAD_PENDING);
+        }
+    }
+    KernelSchedule();
+    KernelUnlock(bMasked);
+}
+
+//*****************************************************************************
+//
+//! Returns the running thread.
+//!
+//! \return Returns the thread, or 0 before KernelStart().
+//
+//*****************************************************************************
+tThread *
+ThreadSelf(void)
+{
+    return(g_psKernelCurrent);
+}
+
+//*****************************************************************************
+//
+//! Suspends the calling thread.
+//!
+//! \param ui32Ticks is the number of KernelTick() calls to sleep for; the
+//! first may come at any time, so the sleep is between \e ui32Ticks - 1 and
+//! \e ui32Ticks periods long.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ThreadSleep(uint32_t ui32Ticks)
+{
+    bool bMasked;
+
+    if(!ui32Ticks)
+    {
+        return;
+    }
+
+    bMasked = KernelLock();
+    g_psKernelCurrent->ui32State = THREAD_SLEEPING;
+    g_psKernelCurrent->ui32Delay = ui32Ticks;
+    KernelSchedule();
+    KernelUnlock(bMasked);
+}
+
+//*****************************************************************************
+//
+//! Takes a semaphore, waiting for it if need be.
+//!
+//! \param psSem is the semaphore.
+//! \param ui32Timeout is the most ticks to wait, or \b KERNEL_WAIT_FOREVER.
+//!
+//! Only a thread may wait, and not with interrupts masked; from an interrupt
+//! handler, or before KernelStart(), this only takes the semaphore if it is
+//! available.
+//!
+//! \return Returns \b false if the semaphore could not be taken in time.
+//
+//*****************************************************************************
+bool
+SemPend(tSemaphore *psSem, uint32_t ui32Timeout)
+{
+    tThread *psSelf;
+    bool bMasked;
+
+    bMasked = KernelLock();
+    if(psSem->ui32Count)
+    {
+        psSem->ui32Count--;
+        KernelUnlock(bMasked);
+        return(true);
+    }
+    if(bMasked || !g_bRunning ||
+       (HWREG(NVIC_INT_CTRL) & NVIC_INT_CTRL_VEC_ACT_M))
+    {
+        KernelUnlock(bMasked);
+        return(false);
+    }
+
+    psSelf = g_psKernelCurrent;
+    psSelf->ui32State = THREAD_PENDING;
+    psSelf->pvWait = psSem;
+    psSelf->ui32Delay = ui32Timeout;
+    KernelSchedule();
+    KernelUnlock(bMasked);
+
+    //
+    // Back here once SemPost() or KernelTick() has woken the thread.
+    //
+    return(!psSelf->bTimedOut);
+}
+
+//*****************************************************************************
+//
+//! Gives a semaphore.
+//!
+//! \param psSem is the semaphore.
+//!
+//! The most urgent waiting thread takes it at once, and runs now if it is
+//! more urgent than the caller.  May be called from interrupt handlers.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+SemPost(tSemaphore *psSem)
+{
+    tThread *psWaiter;
+    bool bMasked;
+
+    bMasked = KernelLock();
+    psWaiter = KernelWaiter(psSem, THREAD_PENDING);
+    if(psWaiter)
+    {
+        KernelWake(psWaiter, false);
+    }
+    else
+    {
+        psSem->ui32Count++;
+    }
+    KernelSchedule();
+    KernelUnlock(bMasked);
+}
+
+//*****************************************************************************
+//
+//! Locks a mutex, waiting for it if need be.
+//!
+//! \param psMutex is the mutex.
+//!
+//! While a thread waits, the owner (and whatever owner that one may be
+//! waiting for in turn) runs at the waiter's priority if it is more urgent,
+//! so a thread of middle priority cannot hold the waiter up indefinitely.
+//! Threads only, not with interrupts masked; mutexes are not recursive.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+MutexLock(tMutex *psMutex)
+{
+    tThread *psSelf, *psOwner;
+    bool bMasked;
+
+    bMasked = KernelLock();
+    psSelf = g_psKernelCurrent;
+    psMutex->ui32Locks++;
+    if(!psMutex->psOwner)
+    {
+        psMutex->psOwner = psSelf;
+        psMutex->psNextHeld = psSelf->psHeld;
+        psSelf->psHeld = psMutex;
+        KernelUnlock(bMasked);
+        return;
+    }
+
+    psMutex->ui32Contended++;
+    psSelf->ui32State = THREAD_LOCKING;
+    psSelf->pvWait = psMutex;
+    for(psOwner = psMutex->psOwner;
+        psOwner && (psSelf->ui32Priority < psOwner->ui32Priority);
+        psOwner = ((tMutex *)psOwner->pvWait)->psOwner)
+    {
+        psOwner->ui32Priority = psSelf->ui32Priority;
+        if(psOwner->ui32State != THREAD_LOCKING)
+        {
+            break;
+        }
+    }
+    KernelSchedule();
+    KernelUnlock(bMasked);
+
+    //
+    // Back here once MutexUnlock() has handed the mutex over.
+    //
+}
+
+//*****************************************************************************
+//
+//! Unlocks a mutex held by the calling thread.
+//!
+//! \param psMutex is the mutex.
+//!
+//! The mutex passes straight to the most urgent waiting thread.  The
+//! caller drops back to the priority its remaining mutexes call for.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+MutexUnlock(tMutex *psMutex)
+{
+    tThread *psSelf, *psWaiter;
+    tMutex **ppsHeld;
+    bool bMasked;
+
+    bMasked = KernelLock();
+    psSelf = g_psKernelCurrent;
+    for(ppsHeld = &psSelf->psHeld; *ppsHeld;
+        ppsHeld = &(*ppsHeld)->psNextHeld)
+    {
+        if(*ppsHeld == psMutex)
+        {
+            *ppsHeld = psMutex->psNextHeld;
+            break;
+        }
+    }
+    psSelf->ui32Priority = KernelInherited(psSelf);
+
+    psWaiter = KernelWaiter(psMutex, THREAD_LOCKING);
+    psMutex->psOwner = psWaiter;
+    if(psWaiter)
+    {
+        psMutex->psNextHeld = psWaiter->psHeld;
+        psWaiter->psHeld = psMutex;
+        KernelWake(psWaiter, false);
+    }
+    KernelSchedule();
+    KernelUnlock(bMasked);
+}
+
+//*****************************************************************************
+//
+// Benchmark threads: pong hands the semaphore to the more urgent ping and
+// gets the processor back when ping waits for it again.
+//
+//*****************************************************************************
+static void
+ThreadPing(void *pvArg)
+{
+    while(1)
+    {
+        SemPend(&g_sPing, KERNEL_WAIT_FOREVER);
+        if(g_bBenchStop)
+        {
+            return;
+        }
+    }
+}
+
+static void
+ThreadPong(void *pvArg)
+{
+    uint32_t ui32Round, ui32Start;
+
+    ui32Start = CycleCountGet();
+    for(ui32Round = 0; ui32Round < g_ui32BenchRounds; ui32Round++)
+    {
+        SemPost(&g_sPing);
+    }
+    g_ui32BenchCycles = CycleCountGet() - ui32Start;
+
+    g_bBenchStop = true;
+    SemPost(&g_sPing);
+    SemPost(&g_sBenchDone);
+}
+
+//*****************************************************************************
+//
+//! Measures the cost of a thread switch.
+//!
+//! \param ui32Rounds is the number of round trips to time.
+//!
+//! Two threads, more urgent than any other, bounce a semaphore back and
+//! forth: each round is a post, two switches and a pend.  Call from a
+//! thread; it waits until the measurement is done.
+//!
+//! \return Returns the cycles per switch, semaphore operation included.
+//
+//*****************************************************************************
+uint32_t
+KernelBenchmark(uint32_t ui32Rounds)
+{
+    g_sPing.ui32Count = 0;
+    g_sBenchDone.ui32Count = 0;
+    g_bBenchStop = false;
+    g_ui32BenchRounds = ui32Rounds;
+
+    ThreadCreate(&g_sPingThread, "bench ping", ThreadPing, 0,
+                 g_pui32PingStack, sizeof(g_pui32PingStack), 0);
+    ThreadCreate(&g_sPongThread, "bench pong", ThreadPong, 0,
+                 g_pui32PongStack, sizeof(g_pui32PongStack), 1);
+    SemPend(&g_sBenchDone, KERNEL_WAIT_FOREVER);
+
+    g_ui32SwitchCycles = g_ui32BenchCycles / (2 * ui32Rounds);
+    return(g_ui32SwitchCycles);
+}
+
+//*****************************************************************************
+//
+//! Prints the threads and the kernel's costs.
+//!
+//! The longest critical section is the most the kernel has added to any
+//! interrupt's latency (the switch itself masks interrupts for a few dozen
+//! cycles more, not counted).
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+KernelReport(void)
+{
+    tThread *psThread;
+
+    UARTprintf("Kernel: %d ticks, %d switches, %d cycles per switch, "
+               "interrupts masked at most %d cycles\n", g_ui32Ticks,
+               g_ui32KernelSwitches, g_ui32SwitchCycles, g_ui32MaxLocked);
+    UARTprintf("  Thread        prio  state     stack used\n");
+
+    for(psThread = g_psThreads; psThread; psThread = psThread->psNext)
+    {
+        UARTprintf("  %12s %5d  %8s %5d/%d%s\n", psThread->pcName,
+                   psThread->ui32Priority,
+                   g_ppcStateNames[psThread->ui32State],
+                   StackRegionHighWater(&psThread->sStack),
+                   psThread->sStack.ui32Size,
+                   (psThread->ui32Priority != psThread->ui32BasePriority) ?
+                   " (inherited)" : "");
+    }
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
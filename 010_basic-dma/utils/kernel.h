@@ -0,0 +1,121 @@
+//*****************************************************************************
+//
+// kernel.h - Minimal preemptive kernel: threads, semaphores and mutexes.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_KERNEL_H__
+#define __UTILS_KERNEL_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// A timeout of this many ticks waits for ever.
+//
+//*****************************************************************************
+#define KERNEL_WAIT_FOREVER     0
+
+//*****************************************************************************
+//
+// Values of tThread ui32State.
+//
+//*****************************************************************************
+#define THREAD_READY            0   // running or able to run
+#define THREAD_SLEEPING         1   // in ThreadSleep()
+#define THREAD_PENDING          2   // waiting for a semaphore
+#define THREAD_LOCKING          3   // waiting for a mutex
+#define THREAD_DONE             4   // returned from its entry function
+
+//*****************************************************************************
+//
+// A mutex.  Zero-initialised is unlocked; the members are private to
+// kernel.c.
+//
+//*****************************************************************************
+typedef struct tMutex
+{
+    struct tThread *psOwner;
+    struct tMutex *psNextHeld;  // the owner's other mutexes
+    uint32_t ui32Locks;
+    uint32_t ui32Contended;     // locks that had to wait
+}
+tMutex;
+
+//*****************************************************************************
+//
+// A counting semaphore.  The application may set ui32Count before use.
+//
+//*****************************************************************************
+typedef struct
+{
+    volatile uint32_t ui32Count;
+}
+tSemaphore;
+
+//*****************************************************************************
+//
+// A thread.  Lower priority numbers run first, as for NVIC priorities;
+// threads of equal priority run in creation order, without time slicing.
+// The members are private to kernel.c, and pui32SP must stay first: the
+// context switch finds it there.
+//
+//*****************************************************************************
+typedef struct tThread
+{
+    uint32_t *pui32SP;          // saved stack pointer while switched out
+    struct tThread *psNext;
+    const char *pcName;
+    uint32_t ui32BasePriority;
+    uint32_t ui32Priority;      // raised while it holds a mutex a more
+                                // urgent thread waits for
+    uint32_t ui32State;
+    uint32_t ui32Delay;         // ticks left to sleep or wait
+    void *pvWait;               // semaphore or mutex waited for
+    tMutex *psHeld;
+    bool bTimedOut;
+    tStackRegion sStack;
+}
+tThread;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void KernelInit(void (*pfnPendSV)(void));
+extern void ThreadCreate(tThread *psThread, const char *pcName,
+                         void (*pfnEntry)(void *pvArg), void *pvArg,
+                         uint32_t *pui32Stack, uint32_t ui32StackBytes,
+                         uint32_t ui32Priority);
+extern void KernelStart(void);
+extern void KernelTick(void);
+extern void KernelPendSVHandler(void);
+extern tThread *ThreadSelf(void);
+extern void ThreadSleep(uint32_t ui32Ticks);
+extern bool SemPend(tSemaphore *psSem, uint32_t ui32Timeout);
+extern void SemPost(tSemaphore *psSem);
+extern void MutexLock(tMutex *psMutex);
+extern void MutexUnlock(tMutex *psMutex);
+extern uint32_t KernelBenchmark(uint32_t ui32Rounds);
+extern void KernelReport(void);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_KERNEL_H__
@@ -0,0 +1,470 @@
+//*****************************************************************************
+//
+// lfqueue.c - Lock-free queues between interrupt handlers and tasks.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_types.h"
+#include "utils/cyclecount.h"
+#include "utils/lfqueue.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup lfqueue_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Queue size and batch used by LFQueueBenchmark().
+//
+//*****************************************************************************
+#define LFQUEUE_BENCH_SIZE      16
+#define LFQUEUE_BENCH_BATCH     8
+#define LFQUEUE_BENCH_ROUNDS    8
+
+//*****************************************************************************
+//
+// Compare-and-swap on a word with LDREX/STREX.
+//
+// An exception between the two clears the exclusive monitor, so STREX fails
+// and the load is retried; nothing is ever masked.  CLREX on a mismatch
+// leaves the monitor clear for whatever runs next.
+//
+//*****************************************************************************
+__asm("    .sect   \".text:LFCompareAndSwap\"\n"
+      "    .thumb\n"
+      "    .thumbfunc LFCompareAndSwap\n"
+      "    .global LFCompareAndSwap\n"
+      "LFCompareAndSwap: .asmfunc\n"
+      "LFCASRetry:\n"
+      "    ldrex   r3, [r0]\n"
+      "    cmp     r3, r1\n"
+      "    bne     LFCASFail\n"
+      "    strex   r3, r2, [r0]\n"
+      "    cmp     r3, #0\n"
+      "    bne     LFCASRetry\n"
+      "    movs    r0, #1\n"
+      "    bx      lr\n"
+      "LFCASFail:\n"
+      "    clrex\n"
+      "    movs    r0, #0\n"
+      "    bx      lr\n"
+      "    .endasmfunc\n");
+
+//*****************************************************************************
+//
+//! Adds to a word atomically.
+//!
+//! \param pui32Word is the word.
+//! \param ui32Add is the amount to add.
+//!
+//! \return Returns the value before the addition.
+//
+//*****************************************************************************
+uint32_t
+LFAtomicAdd(volatile uint32_t *pui32Word, uint32_t ui32Add)
+{
+    uint32_t ui32Old;
+
+    do
+    {
+        ui32Old = *pui32Word;
+    }
+    while(!LFCompareAndSwap(pui32Word, ui32Old, ui32Old + ui32Add));
+
+    return(ui32Old);
+}
+
+//*****************************************************************************
+//
+//! Sets bits of a word atomically.
+//!
+//! \param pui32Word is the word.
+//! \param ui32Bits are the bits to set.
+//!
+//! \return Returns the value before the bits were set.
+//
+//*****************************************************************************
+uint32_t
+LFAtomicOr(volatile uint32_t *pui32Word, uint32_t ui32Bits)
+{
+    uint32_t ui32Old;
+
+    do
+    {
+        ui32Old = *pui32Word;
+    }
+    while(!LFCompareAndSwap(pui32Word, ui32Old, ui32Old | ui32Bits));
+
+    return(ui32Old);
+}
+
+//*****************************************************************************
+//
+//! Clears bits of a word atomically.
+//!
+//! \param pui32Word is the word.
+//! \param ui32Bits are the bits to keep.
+//!
+//! \return Returns the value before the bits were cleared.
+//
+//*****************************************************************************
+uint32_t
+LFAtomicAnd(volatile uint32_t *pui32Word, uint32_t ui32Bits)
+{
+    uint32_t ui32Old;
+
+    do
+    {
+        ui32Old = *pui32Word;
+    }
+    while(!LFCompareAndSwap(pui32Word, ui32Old, ui32Old & ui32Bits));
+
+    return(ui32Old);
+}
+
+//*****************************************************************************
+//
+//! Prepares a single-producer, single-consumer queue.
+//!
+//! \param psQueue is the queue.
+//! \param pui32Slots is the storage, \e ui32Size words.
+//! \param ui32Size is the number of slots; the queue holds one word fewer.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+SPSCQueueInit(tSPSCQueue *psQueue, uint32_t *pui32Slots, uint32_t ui32Size)
+{
+    psQueue->pui32Slots = pui32Slots;
+    psQueue->ui32Size = ui32Size;
+    psQueue->ui32Write = 0;
+    psQueue->ui32Read = 0;
+}
+
+//*****************************************************************************
+//
+//! Adds a word to a single-producer queue.
+//!
+//! \param psQueue is the queue.
+//! \param ui32Value is the word.
+//!
+//! Only the producer may call this.  The word is stored before the write
+//! index moves on, so the consumer never sees a slot before it is filled.
+//!
+//! \return Returns \b false if the queue is full.
+//
+//*****************************************************************************
+bool
+SPSCQueuePut(tSPSCQueue *psQueue, uint32_t ui32Value)
+{
+    uint32_t ui32Write, ui32Next;
+
+    ui32Write = psQueue->ui32Write;
+    ui32Next = ui32Write + 1;
+    if(ui32Next == psQueue->ui32Size)
+    {
+        ui32Next = 0;
+    }
+    if(ui32Next == psQueue->ui32Read)
+    {
+        return(false);
+    }
+
+    psQueue->pui32Slots[ui32Write] = ui32Value;
+    psQueue->ui32Write = ui32Next;
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Takes the oldest word from a single-consumer queue.
+//!
+//! \param psQueue is the queue.
+//! \param pui32Value receives the word.
+//!
+//! Only the consumer may call this.
+//!
+//! \return Returns \b false if the queue is empty.
+//
+//*****************************************************************************
+bool
+SPSCQueueGet(tSPSCQueue *psQueue, uint32_t *pui32Value)
+{
+    uint32_t ui32Read;
+
+    ui32Read = psQueue->ui32Read;
+    if(ui32Read == psQueue->ui32Write)
+    {
+        return(false);
+    }
+
+    *pui32Value = psQueue->pui32Slots[ui32Read];
+    psQueue->ui32Read = ((ui32Read + 1) == psQueue->ui32Size) ? 0 :
+                        (ui32Read + 1);
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Prepares a multi-producer queue.
+//!
+//! \param psQueue is the queue.
+//! \param psSlots is the storage, \e ui32Size slots.
+//! \param ui32Size is the number of slots, a power of two; all are usable.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+MPMCQueueInit(tMPMCQueue *psQueue, tLFSlot *psSlots, uint32_t ui32Size)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < ui32Size; ui32Idx++)
+    {
+        psSlots[ui32Idx].ui32Seq = ui32Idx;
+    }
+    psQueue->psSlots = psSlots;
+    psQueue->ui32Mask = ui32Size - 1;
+    psQueue->ui32Write = 0;
+    psQueue->ui32Read = 0;
+}
+
+//*****************************************************************************
+//
+//! Adds a word to a multi-producer queue.
+//!
+//! \param psQueue is the queue.
+//! \param ui32Value is the word.
+//!
+//! A slot is free for position n when its sequence number is n.  The
+//! producer claims it by moving the write position on with a
+//! compare-and-swap, fills it, then sets its sequence number to n + 1 to
+//! hand it to the consumers.  May be called from any context.
+//!
+//! \return Returns \b false if the queue is full.
+//
+//*****************************************************************************
+bool
+MPMCQueuePut(tMPMCQueue *psQueue, uint32_t ui32Value)
+{
+    tLFSlot *psSlot;
+    uint32_t ui32Pos;
+    int32_t i32Diff;
+
+    ui32Pos = psQueue->ui32Write;
+    while(1)
+    {
+        psSlot = &psQueue->psSlots[ui32Pos & psQueue->ui32Mask];
+        i32Diff = (int32_t)(psSlot->ui32Seq - ui32Pos);
+        if(i32Diff == 0)
+        {
+            if(LFCompareAndSwap(&psQueue->ui32Write, ui32Pos, ui32Pos + 1))
+            {
+                break;
+            }
+        }
+        else if(i32Diff < 0)
+        {
+            //
+            // The slot still holds the word from a lap ago.
+            //
+            return(false);
+        }
+        ui32Pos = psQueue->ui32Write;
+    }
+
+    psSlot->ui32Value = ui32Value;
+    psSlot->ui32Seq = ui32Pos + 1;
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Takes the oldest word from a multi-consumer queue.
+//!
+//! \param psQueue is the queue.
+//! \param pui32Value receives the word.
+//!
+//! May be called from any context.  The slot is returned to the producers
+//! with sequence number n + size, its position on the next lap.
+//!
+//! \return Returns \b false if the queue is empty, or its oldest word is
+//! still being written by a preempted producer.
+//
+//*****************************************************************************
+bool
+MPMCQueueGet(tMPMCQueue *psQueue, uint32_t *pui32Value)
+{
+    tLFSlot *psSlot;
+    uint32_t ui32Pos;
+    int32_t i32Diff;
+
+    ui32Pos = psQueue->ui32Read;
+    while(1)
+    {
+        psSlot = &psQueue->psSlots[ui32Pos & psQueue->ui32Mask];
+        i32Diff = (int32_t)(psSlot->ui32Seq - (ui32Pos + 1));
+        if(i32Diff == 0)
+        {
+            if(LFCompareAndSwap(&psQueue->ui32Read, ui32Pos, ui32Pos + 1))
+            {
+                break;
+            }
+        }
+        else if(i32Diff < 0)
+        {
+            return(false);
+        }
+        ui32Pos = psQueue->ui32Read;
+    }
+
+    *pui32Value = psSlot->ui32Value;
+    psSlot->ui32Seq = ui32Pos + psQueue->ui32Mask + 1;
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Takes the oldest word from a multi-producer, single-consumer queue.
+//!
+//! \param psQueue is the queue.
+//! \param pui32Value receives the word.
+//!
+//! As MPMCQueueGet(), without the compare-and-swap; only one context may
+//! consume.
+//!
+//! \return Returns \b false if the queue is empty, or its oldest word is
+//! still being written by a preempted producer.
+//
+//*****************************************************************************
+bool
+MPSCQueueGet(tMPSCQueue *psQueue, uint32_t *pui32Value)
+{
+    tLFSlot *psSlot;
+    uint32_t ui32Pos;
+
+    ui32Pos = psQueue->ui32Read;
+    psSlot = &psQueue->psSlots[ui32Pos & psQueue->ui32Mask];
+    if(psSlot->ui32Seq != (ui32Pos + 1))
+    {
+        return(false);
+    }
+
+    *pui32Value = psSlot->ui32Value;
+    psSlot->ui32Seq = ui32Pos + psQueue->ui32Mask + 1;
+    psQueue->ui32Read = ui32Pos + 1;
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Returns the number of words in a multi-producer queue.
+//!
+//! \param psQueue is the queue.
+//!
+//! Slots claimed but not yet filled are counted.
+//!
+//! \return Returns the count, which may be stale by the time it is used.
+//
+//*****************************************************************************
+uint32_t
+MPMCQueueCount(tMPMCQueue *psQueue)
+{
+    return(psQueue->ui32Write - psQueue->ui32Read);
+}
+
+//*****************************************************************************
+//
+//! Prints the cycles taken by a put and a get on each kind of queue.
+//!
+//! Batches of puts then gets are timed with no contention, so these are
+//! the best case; a compare-and-swap that loses to a preempting producer
+//! or consumer costs another round.  The cycle counter must be running.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+LFQueueBenchmark(void)
+{
+    static uint32_t pui32SPSCSlots[LFQUEUE_BENCH_SIZE];
+    static tLFSlot psMPMCSlots[LFQUEUE_BENCH_SIZE];
+    tSPSCQueue sSPSC;
+    tMPMCQueue sMPMC;
+    uint32_t pui32Put[3], pui32Get[3];
+    uint32_t ui32Round, ui32Idx, ui32Value, ui32Start;
+
+    SPSCQueueInit(&sSPSC, pui32SPSCSlots, LFQUEUE_BENCH_SIZE);
+    MPMCQueueInit(&sMPMC, psMPMCSlots, LFQUEUE_BENCH_SIZE);
+    for(ui32Idx = 0; ui32Idx < 3; ui32Idx++)
+    {
+        pui32Put[ui32Idx] = 0;
+        pui32Get[ui32Idx] = 0;
+    }
+
+    for(ui32Round = 0; ui32Round < LFQUEUE_BENCH_ROUNDS; ui32Round++)
+    {
+        ui32Start = CycleCountGet();
+        for(ui32Idx = 0; ui32Idx < LFQUEUE_BENCH_BATCH; ui32Idx++)
+        {
+            SPSCQueuePut(&sSPSC, ui32Idx);
+        }
+        pui32Put[0] += CycleCountGet() - ui32Start;
+        ui32Start = CycleCountGet();
+        for(ui32Idx = 0; ui32Idx < LFQUEUE_BENCH_BATCH; ui32Idx++)
+        {
+            SPSCQueueGet(&sSPSC, &ui32Value);
+        }
+        pui32Get[0] += CycleCountGet() - ui32Start;
+
+        ui32Start = CycleCountGet();
+        for(ui32Idx = 0; ui32Idx < LFQUEUE_BENCH_BATCH; ui32Idx++)
+        {
+            MPSCQueuePut(&sMPMC, ui32Idx);
+        }
+        pui32Put[1] += CycleCountGet() - ui32Start;
+        ui32Start = CycleCountGet();
+        for(ui32Idx = 0; ui32Idx < LFQUEUE_BENCH_BATCH; ui32Idx++)
+        {
+            MPSCQueueGet(&sMPMC, &ui32Value);
+        }
+        pui32Get[1] += CycleCountGet() - ui32Start;
+
+        ui32Start = CycleCountGet();
+        for(ui32Idx = 0; ui32Idx < LFQUEUE_BENCH_BATCH; ui32Idx++)
+        {
+            MPMCQueuePut(&sMPMC, ui32Idx);
+        }
+        pui32Put[2] += CycleCountGet() - ui32Start;
+        ui32Start = CycleCountGet();
+        for(ui32Idx = 0; ui32Idx < LFQUEUE_BENCH_BATCH; ui32Idx++)
+        {
+            MPMCQueueGet(&sMPMC, &ui32Value);
+        }
+        pui32Get[2] += CycleCountGet() - ui32Start;
+    }
+
+    for(ui32Idx = 0; ui32Idx < 3; ui32Idx++)
+    {
+        pui32Put[ui32Idx] /= LFQUEUE_BENCH_ROUNDS * LFQUEUE_BENCH_BATCH;
+        pui32Get[ui32Idx] /= LFQUEUE_BENCH_ROUNDS * LFQUEUE_BENCH_BATCH;
+    }
+    UARTprintf("Queues (cycles per put/get, with loop): SPSC %d/%d, "
+               "MPSC %d/%d, MPMC %d/%d\n", pui32Put[0], pui32Get[0],
+               pui32Put[1], pui32Get[1], pui32Put[2], pui32Get[2]);
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
@@ -0,0 +1,112 @@
+//*****************************************************************************
+//
+// lfqueue.h - Lock-free queues between interrupt handlers and tasks.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_LFQUEUE_H__
+#define __UTILS_LFQUEUE_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// A single-producer, single-consumer queue of words.  The producer and the
+// consumer may each be a task or an interrupt handler, one of each.  Holds
+// ui32Size - 1 words.  The members are private to lfqueue.c.
+//
+//*****************************************************************************
+typedef struct
+{
+    volatile uint32_t *pui32Slots;
+    uint32_t ui32Size;
+    volatile uint32_t ui32Write;
+    volatile uint32_t ui32Read;
+}
+tSPSCQueue;
+
+//*****************************************************************************
+//
+// A slot of a multi-producer queue: the word and the sequence number that
+// tells producers and consumers whose turn the slot is.
+//
+//*****************************************************************************
+typedef struct
+{
+    volatile uint32_t ui32Seq;
+    volatile uint32_t ui32Value;
+}
+tLFSlot;
+
+//*****************************************************************************
+//
+// A multi-producer queue of words, with any number of consumers
+// (MPMCQueueGet()) or a single one (MPSCQueueGet(), cheaper).  Producers
+// may preempt each other at any point; a producer preempted between
+// claiming a slot and filling it holds back the words queued after it until
+// it resumes.  The size must be a power of two.  The members are private to
+// lfqueue.c.
+//
+//*****************************************************************************
+typedef struct
+{
+    tLFSlot *psSlots;
+    uint32_t ui32Mask;
+    volatile uint32_t ui32Write;
+    volatile uint32_t ui32Read;
+}
+tMPMCQueue;
+
+typedef tMPMCQueue tMPSCQueue;
+
+//*****************************************************************************
+//
+// Multi-producer, single-consumer queues share the multi-consumer producer
+// side.
+//
+//*****************************************************************************
+#define MPSCQueueInit           MPMCQueueInit
+#define MPSCQueuePut            MPMCQueuePut
+#define MPSCQueueCount          MPMCQueueCount
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern bool LFCompareAndSwap(volatile uint32_t *pui32Word, uint32_t ui32Old,
+                             uint32_t ui32New);
+extern uint32_t LFAtomicAdd(volatile uint32_t *pui32Word, uint32_t ui32Add);
+extern uint32_t LFAtomicOr(volatile uint32_t *pui32Word, uint32_t ui32Bits);
+extern uint32_t LFAtomicAnd(volatile uint32_t *pui32Word, uint32_t ui32Bits);
+extern void SPSCQueueInit(tSPSCQueue *psQueue, uint32_t *pui32Slots,
+                          uint32_t ui32Size);
+extern bool SPSCQueuePut(tSPSCQueue *psQueue, uint32_t ui32Value);
+extern bool SPSCQueueGet(tSPSCQueue *psQueue, uint32_t *pui32Value);
+extern void MPMCQueueInit(tMPMCQueue *psQueue, tLFSlot *psSlots,
+                          uint32_t ui32Size);
+extern bool MPMCQueuePut(tMPMCQueue *psQueue, uint32_t ui32Value);
+extern bool MPMCQueueGet(tMPMCQueue *psQueue, uint32_t *pui32Value);
+extern bool MPSCQueueGet(tMPSCQueue *psQueue, uint32_t *pui32Value);
+extern uint32_t MPMCQueueCount(tMPMCQueue *psQueue);
+extern void LFQueueBenchmark(void);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_LFQUEUE_H__
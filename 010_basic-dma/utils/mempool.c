@@ -0,0 +1,253 @@
+//*****************************************************************************
+//
+// mempool.c - Fixed-block memory pools with reference-counted blocks.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driverlib/debug.h"
+#include "utils/intprio.h"
+#include "utils/mempool.h"
+
+//*****************************************************************************
+//
+//! \addtogroup mempool_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Returns the index of a block from its address.
+//
+//*****************************************************************************
+static uint32_t
+MemPoolIndex(tMemPool *psPool, void *pvBlock)
+{
+    uint32_t ui32Offset;
+
+    ui32Offset = (uint8_t *)pvBlock - psPool->pui8Base;
+    ASSERT((ui32Offset % psPool->ui32BlockSize) == 0);
+    ASSERT(ui32Offset < (psPool->ui32BlockSize * psPool->ui32Count));
+
+    return(ui32Offset / psPool->ui32BlockSize);
+}
+
+//*****************************************************************************
+//
+//! Initializes a pool over caller-provided storage.
+//!
+//! \param psPool is the pool to initialize.
+//! \param pui32Storage is the backing memory, at least
+//! \b MEMPOOL_WORDS(ui32BlockSize, ui32Count) words long.
+//! \param ui32BlockSize is the size of each block in bytes; it is rounded up
+//! to a multiple of 4 so every block stays word aligned.
+//! \param ui32Count is the number of blocks.
+//! \param pui8Refs is an array of \e ui32Count reference counts.
+//!
+//! The storage is usually a static array, so its placement (and whether it
+//! is zeroed at boot) remains under the application's control.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+MemPoolInit(tMemPool *psPool, uint32_t *pui32Storage, uint32_t ui32BlockSize,
+            uint32_t ui32Count, uint8_t *pui8Refs)
+{
+    uint32_t ui32Idx;
+    uint8_t *pui8Block;
+
+    ui32BlockSize = (ui32BlockSize + 3) & ~3;
+
+    psPool->pui8Base = (uint8_t *)pui32Storage;
+    psPool->ui32BlockSize = ui32BlockSize;
+    psPool->ui32Count = ui32Count;
+    psPool->pui8Refs = pui8Refs;
+    psPool->ui32InUse = 0;
+    psPool->ui32Peak = 0;
+    psPool->ui32Failures = 0;
+    psPool->ui32Level = INT_LEVEL_ALL;
+
+    //
+    // Chain the blocks together, lowest address first.
+    //
+    psPool->pvFree = 0;
+    for(ui32Idx = ui32Count; ui32Idx > 0; ui32Idx--)
+    {
+        pui8Block = psPool->pui8Base + ((ui32Idx - 1) * ui32BlockSize);
+        *(void **)pui8Block = psPool->pvFree;
+        psPool->pvFree = pui8Block;
+        pui8Refs[ui32Idx - 1] = 0;
+    }
+}
+
+//*****************************************************************************
+//
+//! Sets which interrupts are held off while a pool is updated.
+//!
+//! \param psPool is the pool.
+//! \param ui32Level is the priority of the most urgent interrupt handler that
+//! allocates or releases blocks of the pool.
+//!
+//! Interrupts more urgent than \e ui32Level are never held off by the pool.
+//! Until this is called, every interrupt is.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+MemPoolLevelSet(tMemPool *psPool, uint32_t ui32Level)
+{
+    psPool->ui32Level = ui32Level;
+}
+
+//*****************************************************************************
+//
+//! Allocates a block from a pool.
+//!
+//! \param psPool is the pool to allocate from.
+//!
+//! The block is returned with a reference count of one.  This function may be
+//! called from interrupt handlers.
+//!
+//! \return Returns the block, or 0 if the pool is exhausted.
+//
+//*****************************************************************************
+void *
+MemPoolAlloc(tMemPool *psPool)
+{
+    void *pvBlock;
+    uint32_t ui32Saved;
+
+    ui32Saved = IntCriticalEnter(psPool->ui32Level);
+
+    pvBlock = psPool->pvFree;
+    if(pvBlock)
+    {
+        psPool->pvFree = *(void **)pvBlock;
+        psPool->pui8Refs[MemPoolIndex(psPool, pvBlock)] = 1;
+        if(++psPool->ui32InUse > psPool->ui32Peak)
+        {
+            psPool->ui32Peak = psPool->ui32InUse;
+        }
+    }
+    else
+    {
+        psPool->ui32Failures++;
+    }
+
+    IntCriticalExit(ui32Saved);
+
+    return(pvBlock);
+}
+
+//*****************************************************************************
+//
+//! Adds a reference to an allocated block.
+//!
+//! \param psPool is the pool the block came from.
+//! \param pvBlock is the block.
+//!
+//! Each holder of a block (for example a logging stage and a transmit stage
+//! sharing one ADC buffer) takes its own reference and releases it when done;
+//! the block returns to the pool when the last one is released.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+MemPoolRetain(tMemPool *psPool, void *pvBlock)
+{
+    uint32_t ui32Idx;
+    uint32_t ui32Saved;
+
+    ui32Idx = MemPoolIndex(psPool, pvBlock);
+
+    ui32Saved = IntCriticalEnter(psPool->ui32Level);
+    ASSERT((psPool->pui8Refs[ui32Idx] != 0) &&
+           (psPool->pui8Refs[ui32Idx] != 0xff));
+    psPool->pui8Refs[ui32Idx]++;
+    IntCriticalExit(ui32Saved);
+}
+
+//*****************************************************************************
+//
+//! Drops a reference to a block, freeing it when none remain.
+//!
+//! \param psPool is the pool the block came from.
+//! \param pvBlock is the block.
+//!
+//! This function may be called from interrupt handlers.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+MemPoolRelease(tMemPool *psPool, void *pvBlock)
+{
+    uint32_t ui32Idx;
+    uint32_t ui32Saved;
+
+    ui32Idx = MemPoolIndex(psPool, pvBlock);
+
+    ui32Saved = IntCriticalEnter(psPool->ui32Level);
+    ASSERT(psPool->pui8Refs[ui32Idx] != 0);
+    if(--psPool->pui8Refs[ui32Idx] == 0)
+    {
+        *(void **)pvBlock = psPool->pvFree;
+        psPool->pvFree = pvBlock;
+        psPool->ui32InUse--;
+    }
+    IntCriticalExit(ui32Saved);
+}
+
+//*****************************************************************************
+//
+//! Reads the number of references held on a block.
+//!
+//! \param psPool is the pool the block came from.
+//! \param pvBlock is the block.
+//!
+//! An owner that keeps a block for reuse (a buffer that uDMA refills in
+//! place) uses this to tell whether the other holders are done with it.
+//!
+//! \return Returns the reference count, 0 for a free block.
+//
+//*****************************************************************************
+uint32_t
+MemPoolRefsGet(tMemPool *psPool, void *pvBlock)
+{
+    return(psPool->pui8Refs[MemPoolIndex(psPool, pvBlock)]);
+}
+
+//*****************************************************************************
+//
+//! Reads the usage statistics of a pool.
+//!
+//! \param psPool is the pool.
+//! \param psStats receives the statistics.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+MemPoolStatsGet(tMemPool *psPool, tMemPoolStats *psStats)
+{
+    uint32_t ui32Saved;
+
+    ui32Saved = IntCriticalEnter(psPool->ui32Level);
+    psStats->ui32Count = psPool->ui32Count;
+    psStats->ui32InUse = psPool->ui32InUse;
+    psStats->ui32Peak = psPool->ui32Peak;
+    psStats->ui32Failures = psPool->ui32Failures;
+    IntCriticalExit(ui32Saved);
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
@@ -0,0 +1,95 @@
+//*****************************************************************************
+//
+// mempool.h - Fixed-block memory pools with reference-counted blocks.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_MEMPOOL_H__
+#define __UTILS_MEMPOOL_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The number of 32-bit words needed to back a pool of ui32Count blocks of
+// ui32Size bytes.  Use it to size the storage array passed to MemPoolInit(),
+// for example:
+//
+//     static uint32_t g_pui32Storage[MEMPOOL_WORDS(512, 4)];
+//     static uint8_t g_pui8Refs[4];
+//
+//*****************************************************************************
+#define MEMPOOL_WORDS(ui32Size, ui32Count)                                    \
+        ((((ui32Size) + 3) / 4) * (ui32Count))
+
+//*****************************************************************************
+//
+// A pool of equally sized blocks.  Free blocks are kept on a singly linked
+// list threaded through their first word, so allocation and release are O(1)
+// and need no memory beyond the blocks and one reference count byte each.
+// The members are private to mempool.c; use MemPoolStatsGet() to read the
+// usage figures.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t *pui8Base;
+    uint32_t ui32BlockSize;
+    uint32_t ui32Count;
+    uint8_t *pui8Refs;
+    void *pvFree;
+    uint32_t ui32InUse;
+    uint32_t ui32Peak;
+    uint32_t ui32Failures;
+    uint32_t ui32Level;         // critical-section level, see MemPoolLevelSet()
+}
+tMemPool;
+
+//*****************************************************************************
+//
+// Usage statistics of a pool.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Count;         // blocks in the pool
+    uint32_t ui32InUse;         // blocks allocated now
+    uint32_t ui32Peak;          // most blocks ever allocated at once
+    uint32_t ui32Failures;      // allocations refused because the pool was empty
+}
+tMemPoolStats;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void MemPoolInit(tMemPool *psPool, uint32_t *pui32Storage,
+                        uint32_t ui32BlockSize, uint32_t ui32Count,
+                        uint8_t *pui8Refs);
+extern void MemPoolLevelSet(tMemPool *psPool, uint32_t ui32Level);
+extern void *MemPoolAlloc(tMemPool *psPool);
+extern void MemPoolRetain(tMemPool *psPool, void *pvBlock);
+extern void MemPoolRelease(tMemPool *psPool, void *pvBlock);
+extern uint32_t MemPoolRefsGet(tMemPool *psPool, void *pvBlock);
+extern void MemPoolStatsGet(tMemPool *psPool, tMemPoolStats *psStats);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_MEMPOOL_H__
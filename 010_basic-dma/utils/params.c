@@ -0,0 +1,439 @@
+//*****************************************************************************
+//
+// params.c - Run-time tunable parameters persisted in the on-chip EEPROM.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "inc/hw_types.h"
+#include "driverlib/eeprom.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/params.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup params_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Marks a slot as holding a parameter image ("PRM1").
+//
+//*****************************************************************************
+#define PARAM_MAGIC             0x314D5250
+
+//*****************************************************************************
+//
+// Word offsets of the header fields within a slot.
+//
+//*****************************************************************************
+#define HDR_MAGIC               0
+#define HDR_SEQ                 1
+#define HDR_SCHEMA_COUNT        2   // schema in bits 15:0, count in 31:16
+#define HDR_CRC                 3
+#define HDR_WORDS               4
+
+#define SLOT_WORDS              (PARAM_SLOT_SIZE / 4)
+#define SLOT_ADDR(ui32Slot)                                                   \
+        (PARAM_EEPROM_BASE + ((ui32Slot) * PARAM_SLOT_SIZE))
+
+//*****************************************************************************
+//
+// The registered parameters, the schema version and the slot holding the
+// current image (PARAM_SLOTS if none has been written yet).
+//
+//*****************************************************************************
+static const tParam *g_psParams;
+static uint32_t g_ui32NumParams;
+static uint16_t g_ui16Schema;
+static uint32_t g_ui32Slot = PARAM_SLOTS;
+static uint32_t g_ui32Seq;
+static bool g_bDirty;
+
+//*****************************************************************************
+//
+// A slot image, used both for loading and for committing.
+//
+//*****************************************************************************
+static uint32_t g_pui32Image[SLOT_WORDS];
+
+//*****************************************************************************
+//
+// CRC-32 (reflected, polynomial 0x04C11DB7) over ui32Words words, low byte
+// first.  Bitwise; a slot is at most a few hundred bytes.
+//
+//*****************************************************************************
+static uint32_t
+ParamCRC32(const uint32_t *pui32Data, uint32_t ui32Words)
+{
+    uint32_t ui32CRC = 0xFFFFFFFF;
+    uint32_t ui32Byte, ui32Bit;
+
+    while(ui32Words--)
+    {
+        for(ui32Byte = 0; ui32Byte < 32; ui32Byte += 8)
+        {
+            ui32CRC ^= (*pui32Data >> ui32Byte) & 0xFF;
+            for(ui32Bit = 0; ui32Bit < 8; ui32Bit++)
+            {
+                ui32CRC = (ui32CRC >> 1) ^ (0xEDB88320 & -(ui32CRC & 1));
+            }
+        }
+        pui32Data++;
+    }
+
+    return(~ui32CRC);
+}
+
+//*****************************************************************************
+//
+// Stores a value in a parameter's variable without range checking.
+//
+//*****************************************************************************
+static void
+ParamStore(const tParam *psParam, int32_t i32Value)
+{
+    if(psParam->ui16Type == PARAM_TYPE_BOOL)
+    {
+        *(bool *)psParam->pvValue = (i32Value != 0);
+    }
+    else
+    {
+        *(int32_t *)psParam->pvValue = i32Value;
+    }
+}
+
+//*****************************************************************************
+//
+// Tells whether a value is within a parameter's range.
+//
+//*****************************************************************************
+static bool
+ParamInRange(const tParam *psParam, int32_t i32Value)
+{
+    if(psParam->ui16Type == PARAM_TYPE_I32)
+    {
+        return((i32Value >= psParam->i32Min) && (i32Value <= psParam->i32Max));
+    }
+
+    return(((uint32_t)i32Value >= (uint32_t)psParam->i32Min) &&
+           ((uint32_t)i32Value <= (uint32_t)psParam->i32Max));
+}
+
+//*****************************************************************************
+//
+// Reads a slot into g_pui32Image and returns the number of parameters in it,
+// or -1 if the slot does not hold a complete image.
+//
+//*****************************************************************************
+static int32_t
+ParamSlotRead(uint32_t ui32Slot)
+{
+    uint32_t ui32Count, ui32CRC;
+
+    MAP_EEPROMRead(g_pui32Image, SLOT_ADDR(ui32Slot), HDR_WORDS * 4);
+    ui32Count = g_pui32Image[HDR_SCHEMA_COUNT] >> 16;
+    if((g_pui32Image[HDR_MAGIC] != PARAM_MAGIC) || (ui32Count > PARAM_MAX))
+    {
+        return(-1);
+    }
+
+    MAP_EEPROMRead(g_pui32Image + HDR_WORDS,
+                   SLOT_ADDR(ui32Slot) + (HDR_WORDS * 4), ui32Count * 8);
+    ui32CRC = g_pui32Image[HDR_CRC];
+    g_pui32Image[HDR_CRC] = 0;
+    if(ParamCRC32(g_pui32Image, HDR_WORDS + (ui32Count * 2)) != ui32CRC)
+    {
+        return(-1);
+    }
+
+    return(ui32Count);
+}
+
+//*****************************************************************************
+//
+//! Registers the parameters and loads their saved values.
+//!
+//! \param psParams is the table of parameters.
+//! \param ui32Count is the number of entries in \e psParams, at most
+//! \b PARAM_MAX.
+//! \param ui16Schema is the version of the table, to be raised whenever
+//! parameters are added, removed or change meaning.
+//!
+//! Every parameter is first set to its default.  The newest valid image in
+//! the EEPROM is then found by reading the slot headers, and each value it
+//! holds is copied to the parameter with the same id if it is in range.
+//! Values saved under a different schema are matched the same way; ids no
+//! longer in the table are ignored and new parameters keep their defaults.
+//! The EEPROM peripheral must be enabled and ready.
+//!
+//! \return Returns one of the \b PARAM_LOAD_ values.
+//
+//*****************************************************************************
+uint32_t
+ParamsInit(const tParam *psParams, uint32_t ui32Count, uint16_t ui16Schema)
+{
+    uint32_t ui32Slot, ui32Idx, ui32Param, ui32Id, ui32Value;
+    int32_t i32Stored;
+
+    g_psParams = psParams;
+    g_ui32NumParams = ui32Count;
+    g_ui16Schema = ui16Schema;
+    g_ui32Slot = PARAM_SLOTS;
+    g_bDirty = false;
+    for(ui32Param = 0; ui32Param < ui32Count; ui32Param++)
+    {
+        ParamStore(&psParams[ui32Param], psParams[ui32Param].i32Default);
+    }
+
+    if(MAP_EEPROMInit() != EEPROM_INIT_OK)
+    {
+        return(PARAM_LOAD_ERROR);
+    }
+
+    //
+    // Find the newest image.  Sequence numbers are compared by difference so
+    // that they may wrap.
+    //
+    for(ui32Slot = 0; ui32Slot < PARAM_SLOTS; ui32Slot++)
+    {
+        if((ParamSlotRead(ui32Slot) >= 0) &&
+           ((g_ui32Slot == PARAM_SLOTS) ||
+            ((int32_t)(g_pui32Image[HDR_SEQ] - g_ui32Seq) > 0)))
+        {
+            g_ui32Slot = ui32Slot;
+            g_ui32Seq = g_pui32Image[HDR_SEQ];
+        }
+    }
+
+    if(g_ui32Slot == PARAM_SLOTS)
+    {
+        g_ui32Seq = 0;
+        return(PARAM_LOAD_DEFAULTS);
+    }
+
+    i32Stored = ParamSlotRead(g_ui32Slot);
+    for(ui32Idx = 0; ui32Idx < (uint32_t)i32Stored; ui32Idx++)
+    {
+        ui32Id = g_pui32Image[HDR_WORDS + (ui32Idx * 2)] & 0xFFFF;
+        ui32Value = g_pui32Image[HDR_WORDS + (ui32Idx * 2) + 1];
+        for(ui32Param = 0; ui32Param < ui32Count; ui32Param++)
+        {
+            if(psParams[ui32Param].ui16Id == ui32Id)
+            {
+                if(ParamInRange(&psParams[ui32Param], ui32Value))
+                {
+                    ParamStore(&psParams[ui32Param], ui32Value);
+                }
+                break;
+            }
+        }
+    }
+
+    if((g_pui32Image[HDR_SCHEMA_COUNT] & 0xFFFF) != ui16Schema)
+    {
+        g_bDirty = true;
+        return(PARAM_LOAD_MIGRATED);
+    }
+
+    return(PARAM_LOAD_OK);
+}
+
+//*****************************************************************************
+//
+//! Looks up a parameter by name.
+//!
+//! \param pcName is the name of the parameter.
+//!
+//! \return Returns the parameter, or 0 if there is none of that name.
+//
+//*****************************************************************************
+const tParam *
+ParamFind(const char *pcName)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < g_ui32NumParams; ui32Idx++)
+    {
+        if(!strcmp(g_psParams[ui32Idx].pcName, pcName))
+        {
+            return(&g_psParams[ui32Idx]);
+        }
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+//! Reads the value of a parameter.
+//!
+//! \param psParam is the parameter.
+//!
+//! \return Returns the value; unsigned values are returned bit for bit.
+//
+//*****************************************************************************
+int32_t
+ParamGet(const tParam *psParam)
+{
+    if(psParam->ui16Type == PARAM_TYPE_BOOL)
+    {
+        return(*(bool *)psParam->pvValue);
+    }
+
+    return(*(int32_t *)psParam->pvValue);
+}
+
+//*****************************************************************************
+//
+//! Changes the value of a parameter.
+//!
+//! \param psParam is the parameter.
+//! \param i32Value is the new value.
+//!
+//! The change takes effect at once but is only saved by ParamsCommit().
+//!
+//! \return Returns \b false, leaving the value alone, if \e i32Value is out
+//! of range.
+//
+//*****************************************************************************
+bool
+ParamSet(const tParam *psParam, int32_t i32Value)
+{
+    if(!ParamInRange(psParam, i32Value))
+    {
+        return(false);
+    }
+
+    if(ParamGet(psParam) != i32Value)
+    {
+        ParamStore(psParam, i32Value);
+        g_bDirty = true;
+        if(psParam->pfnChanged)
+        {
+            psParam->pfnChanged();
+        }
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Sets every parameter to its default value.
+//!
+//! Each change is made with ParamSet(), so change callbacks run; like any
+//! other change, the defaults are only saved by ParamsCommit().
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ParamsDefaults(void)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < g_ui32NumParams; ui32Idx++)
+    {
+        ParamSet(&g_psParams[ui32Idx], g_psParams[ui32Idx].i32Default);
+    }
+}
+
+//*****************************************************************************
+//
+//! Saves the current values to the EEPROM.
+//!
+//! The image is written to the slot after the current one, pairs first and
+//! header last; if power is lost part way, that slot fails its CRC and the
+//! previous image is loaded at the next start-up.  Nothing is written if an
+//! image exists and no value has changed since it was loaded or committed.
+//! This blocks for the EEPROM programming time, a few milliseconds for a full
+//! slot.
+//!
+//! \return Returns \b true if the values are saved.
+//
+//*****************************************************************************
+bool
+ParamsCommit(void)
+{
+    uint32_t ui32Slot, ui32Idx, ui32Words;
+
+    if(!g_bDirty && (g_ui32Slot != PARAM_SLOTS))
+    {
+        return(true);
+    }
+
+    for(ui32Idx = 0; ui32Idx < g_ui32NumParams; ui32Idx++)
+    {
+        g_pui32Image[HDR_WORDS + (ui32Idx * 2)] = g_psParams[ui32Idx].ui16Id;
+        g_pui32Image[HDR_WORDS + (ui32Idx * 2) + 1] =
+            ParamGet(&g_psParams[ui32Idx]);
+    }
+    g_pui32Image[HDR_MAGIC] = PARAM_MAGIC;
+    g_pui32Image[HDR_SEQ] = g_ui32Seq + 1;
+    g_pui32Image[HDR_SCHEMA_COUNT] = g_ui16Schema | (g_ui32NumParams << 16);
+    g_pui32Image[HDR_CRC] = 0;
+    ui32Words = HDR_WORDS + (g_ui32NumParams * 2);
+    g_pui32Image[HDR_CRC] = ParamCRC32(g_pui32Image, ui32Words);
+
+    ui32Slot = (g_ui32Slot + 1) % PARAM_SLOTS;
+    if(MAP_EEPROMProgram(g_pui32Image + HDR_WORDS,
+                         SLOT_ADDR(ui32Slot) + (HDR_WORDS * 4),
+                         (ui32Words - HDR_WORDS) * 4) ||
+       MAP_EEPROMProgram(g_pui32Image, SLOT_ADDR(ui32Slot), HDR_WORDS * 4))
+    {
+        return(false);
+    }
+
+    g_ui32Slot = ui32Slot;
+    g_ui32Seq++;
+    g_bDirty = false;
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Prints every parameter with its value and range.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ParamsReport(void)
+{
+    const tParam *psParam;
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < g_ui32NumParams; ui32Idx++)
+    {
+        psParam = &g_psParams[ui32Idx];
+        UARTprintf((psParam->ui16Type == PARAM_TYPE_I32) ?
+                   "  %s = %d (%d to %d)\n" : "  %s = %u (%u to %u)\n",
+                   psParam->pcName, ParamGet(psParam), psParam->i32Min,
+                   psParam->i32Max);
+    }
+
+    if(g_ui32Slot == PARAM_SLOTS)
+    {
+        UARTprintf("Schema %d, never saved%s\n", g_ui16Schema,
+                   g_bDirty ? ", changed" : "");
+    }
+    else
+    {
+        UARTprintf("Schema %d, saved in slot %d (commit %u)%s\n", g_ui16Schema,
+                   g_ui32Slot, g_ui32Seq, g_bDirty ? ", changed since" : "");
+    }
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
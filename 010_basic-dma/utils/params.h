@@ -0,0 +1,107 @@
+//*****************************************************************************
+//
+// params.h - Run-time tunable parameters persisted in the on-chip EEPROM.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_PARAMS_H__
+#define __UTILS_PARAMS_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// EEPROM layout.  The parameters occupy PARAM_SLOTS slots of PARAM_SLOT_SIZE
+// bytes from PARAM_EEPROM_BASE (1 KB, half of the TM4C123GH6PM's EEPROM).
+// Each commit writes the slot after the current one, so the previous image
+// stays intact until the new one is complete and writes are spread over all
+// slots.  A slot holds a header followed by (id, value) pairs:
+//
+//     magic (4) | sequence (4) | schema (2) | count (2) | CRC-32 (4)
+//     id (2) | reserved (2) | value (4)      repeated count times
+//
+// The CRC-32 covers the header, with the CRC field taken as zero, and the
+// pairs.  On start-up the valid slot with the highest sequence number wins.
+//
+//*****************************************************************************
+#define PARAM_EEPROM_BASE       0
+#define PARAM_SLOT_SIZE         128
+#define PARAM_SLOTS             8
+#define PARAM_MAX               ((PARAM_SLOT_SIZE - 16) / 8)
+
+//*****************************************************************************
+//
+// Parameter types; the variable a parameter points to is of the matching C
+// type.
+//
+//*****************************************************************************
+#define PARAM_TYPE_U32          0   // uint32_t
+#define PARAM_TYPE_I32          1   // int32_t
+#define PARAM_TYPE_BOOL         2   // bool
+
+//*****************************************************************************
+//
+// Values returned by ParamsInit().
+//
+//*****************************************************************************
+#define PARAM_LOAD_OK           0   // the saved values were loaded
+#define PARAM_LOAD_MIGRATED     1   // saved under another schema; matched by id
+#define PARAM_LOAD_DEFAULTS     2   // nothing saved yet, defaults in use
+#define PARAM_LOAD_ERROR        3   // the EEPROM could not be initialized
+
+//*****************************************************************************
+//
+// A parameter.  ui16Id is its key in the stored image, so it must never be
+// reused for something else; the name is only for the console.  Values are
+// kept within i32Min to i32Max (compared as signed numbers for I32, unsigned
+// otherwise).  pfnChanged, if not 0, is called after ParamSet() changes the
+// value so the application can apply it at once; it is not called when the
+// values are loaded by ParamsInit().
+//
+//*****************************************************************************
+typedef struct
+{
+    uint16_t ui16Id;
+    uint16_t ui16Type;
+    const char *pcName;
+    void *pvValue;
+    int32_t i32Min;
+    int32_t i32Max;
+    int32_t i32Default;
+    void (*pfnChanged)(void);
+}
+tParam;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern uint32_t ParamsInit(const tParam *psParams, uint32_t ui32Count,
+                           uint16_t ui16Schema);
+extern const tParam *ParamFind(const char *pcName);
+extern int32_t ParamGet(const tParam *psParam);
+extern bool ParamSet(const tParam *psParam, int32_t i32Value);
+extern void ParamsDefaults(void);
+extern bool ParamsCommit(void);
+extern void ParamsReport(void);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_PARAMS_H__
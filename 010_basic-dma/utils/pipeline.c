@@ -0,0 +1,297 @@
+//*****************************************************************************
+//
+// pipeline.c - Zero-copy block processing pipeline.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_types.h"
+#include "utils/cyclecount.h"
+#include "utils/mempool.h"
+#include "utils/pipeline.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup pipeline_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+//! Allocates a block and sets up its descriptor.
+//!
+//! \param psPool is a pool whose blocks are \b PIPE_BLOCK_SIZE() bytes.
+//! \param ui32Format is the format of the data the block will carry.
+//!
+//! The data area starts right after the descriptor and is empty
+//! (\e ui32Length is 0).  This function may be called from interrupt
+//! handlers, typically by a DMA source re-arming a transfer.
+//!
+//! \return Returns the block, or 0 if the pool is exhausted.
+//
+//*****************************************************************************
+tPipeBlock *
+PipeBlockAlloc(tMemPool *psPool, uint32_t ui32Format)
+{
+    tPipeBlock *psBlock;
+
+    psBlock = MemPoolAlloc(psPool);
+    if(psBlock)
+    {
+        psBlock->psPool = psPool;
+        psBlock->pvData = psBlock + 1;
+        psBlock->ui32Length = 0;
+        psBlock->ui32Format = ui32Format;
+        psBlock->ui32Seq = 0;
+        psBlock->ui32Time = 0;
+        psBlock->ui32Missed = 0;
+    }
+
+    return(psBlock);
+}
+
+//*****************************************************************************
+//
+//! Takes an additional reference to a block.
+//!
+//! \param psBlock is the block.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+PipeBlockRetain(tPipeBlock *psBlock)
+{
+    MemPoolRetain(psBlock->psPool, psBlock);
+}
+
+//*****************************************************************************
+//
+//! Releases a reference to a block, returning it to its pool when it was the
+//! last one.
+//!
+//! \param psBlock is the block.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+PipeBlockRelease(tPipeBlock *psBlock)
+{
+    MemPoolRelease(psBlock->psPool, psBlock);
+}
+
+//*****************************************************************************
+//
+//! Initializes a pipeline.
+//!
+//! \param psPipe is the pipeline.
+//! \param psStages is the array of stages, in processing order.
+//! \param ui32NumStages is the number of stages.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+PipelineInit(tPipeline *psPipe, tPipeStage *psStages, uint32_t ui32NumStages)
+{
+    uint32_t ui32Idx;
+
+    psPipe->psStages = psStages;
+    psPipe->ui32NumStages = ui32NumStages;
+    psPipe->ui32Write = 0;
+    psPipe->ui32Read = 0;
+    psPipe->psStalled = 0;
+    psPipe->ui32StallStage = 0;
+    psPipe->ui32Rejected = 0;
+    psPipe->ui32Completed = 0;
+    psPipe->ui32Dropped = 0;
+
+    for(ui32Idx = 0; ui32Idx < ui32NumStages; ui32Idx++)
+    {
+        psStages[ui32Idx].ui32Calls = 0;
+        psStages[ui32Idx].ui32Cycles = 0;
+        psStages[ui32Idx].ui32MaxCycles = 0;
+    }
+}
+
+//*****************************************************************************
+//
+//! Queues a block for processing.
+//!
+//! \param psPipe is the pipeline.
+//! \param psBlock is the block; the pipeline takes over the caller's
+//! reference.
+//!
+//! This is meant to be called by a single source, usually from its interrupt
+//! handler, while PipelineRun() is called from the main loop.  The queue has
+//! one writer and one reader, so no locking is needed.
+//!
+//! \return Returns \b false if the queue is full.  The caller still owns the
+//! block and should reuse it; this is how back-pressure reaches the source.
+//
+//*****************************************************************************
+bool
+PipelineSubmit(tPipeline *psPipe, tPipeBlock *psBlock)
+{
+    uint32_t ui32Write;
+
+    ui32Write = psPipe->ui32Write;
+    if((ui32Write - psPipe->ui32Read) >= PIPE_QUEUE_DEPTH)
+    {
+        psPipe->ui32Rejected++;
+        return(false);
+    }
+
+    psPipe->ppsQueue[ui32Write % PIPE_QUEUE_DEPTH] = psBlock;
+    psPipe->ui32Write = ui32Write + 1;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Passes queued blocks through the stages.
+//!
+//! \param psPipe is the pipeline.
+//!
+//! Every queued block is handed to each stage in turn.  A stage returning
+//! \b PIPE_DROP ends the block's trip early; either way the pipeline then
+//! releases its reference.  A stage returning \b PIPE_BUSY stalls the
+//! pipeline: the block is kept and offered to the same stage on the next
+//! call, and meanwhile the queue fills until the source is refused.  The
+//! cycles spent in each stage call are accumulated for PipelineReport().
+//!
+//! \return Returns the number of blocks that left the pipeline.
+//
+//*****************************************************************************
+uint32_t
+PipelineRun(tPipeline *psPipe)
+{
+    tPipeBlock *psBlock;
+    tPipeStage *psStage;
+    uint32_t ui32Stage, ui32Result, ui32Start, ui32Cycles, ui32Done;
+
+    ui32Done = 0;
+    while(1)
+    {
+        //
+        // Resume a stalled block first, otherwise take the next queued one.
+        //
+        if(psPipe->psStalled)
+        {
+            psBlock = psPipe->psStalled;
+            ui32Stage = psPipe->ui32StallStage;
+            psPipe->psStalled = 0;
+        }
+        else if(psPipe->ui32Read != psPipe->ui32Write)
+        {
+            psBlock = psPipe->ppsQueue[psPipe->ui32Read % PIPE_QUEUE_DEPTH];
+            psPipe->ui32Read++;
+            ui32Stage = 0;
+        }
+        else
+        {
+            return(ui32Done);
+        }
+
+        for(ui32Result = PIPE_CONTINUE; ui32Stage < psPipe->ui32NumStages;
+            ui32Stage++)
+        {
+            psStage = &psPipe->psStages[ui32Stage];
+
+            ui32Start = CycleCountGet();
+            ui32Result = psStage->pfnProcess(psStage->pvState, psBlock);
+            ui32Cycles = CycleCountGet() - ui32Start;
+
+            psStage->ui32Calls++;
+            psStage->ui32Cycles += ui32Cycles;
+            if(ui32Cycles > psStage->ui32MaxCycles)
+            {
+                psStage->ui32MaxCycles = ui32Cycles;
+            }
+
+            if(ui32Result != PIPE_CONTINUE)
+            {
+                break;
+            }
+        }
+
+        if(ui32Result == PIPE_BUSY)
+        {
+            psPipe->psStalled = psBlock;
+            psPipe->ui32StallStage = ui32Stage;
+            return(ui32Done);
+        }
+
+        if(ui32Result == PIPE_DROP)
+        {
+            psPipe->ui32Dropped++;
+        }
+        else
+        {
+            psPipe->ui32Completed++;
+        }
+        PipeBlockRelease(psBlock);
+        ui32Done++;
+    }
+}
+
+//*****************************************************************************
+//
+//! Tells whether a block is waiting for a busy stage.
+//!
+//! \param psPipe is the pipeline.
+//!
+//! A stalled pipeline has work to do even when no new block arrives; whoever
+//! schedules PipelineRun() uses this to call it again once the stage's
+//! resource has had a chance to free up.
+//!
+//! \return Returns \b true if PipelineRun() stopped at a busy stage.
+//
+//*****************************************************************************
+bool
+PipelineStalled(tPipeline *psPipe)
+{
+    return(psPipe->psStalled != 0);
+}
+
+//*****************************************************************************
+//
+//! Prints the block counts and the cycles spent in each stage.
+//!
+//! \param psPipe is the pipeline.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+PipelineReport(tPipeline *psPipe)
+{
+    tPipeStage *psStage;
+    uint32_t ui32Idx;
+
+    UARTprintf("Pipeline: %d blocks done, %d dropped by stages, "
+               "%d refused at the source\n", psPipe->ui32Completed,
+               psPipe->ui32Dropped, psPipe->ui32Rejected);
+    UARTprintf("  Stage         calls  avg cyc  max cyc\n");
+
+    for(ui32Idx = 0; ui32Idx < psPipe->ui32NumStages; ui32Idx++)
+    {
+        psStage = &psPipe->psStages[ui32Idx];
+        UARTprintf("  %s %6d %8d %8d\n", psStage->pcName, psStage->ui32Calls,
+                   psStage->ui32Calls ?
+                   (psStage->ui32Cycles / psStage->ui32Calls) : 0,
+                   psStage->ui32MaxCycles);
+    }
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
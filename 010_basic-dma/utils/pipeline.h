@@ -0,0 +1,151 @@
+//*****************************************************************************
+//
+// pipeline.h - Zero-copy block processing pipeline.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_PIPELINE_H__
+#define __UTILS_PIPELINE_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The number of blocks that can wait between the source and the first stage.
+// Must be a power of two.
+//
+//*****************************************************************************
+#define PIPE_QUEUE_DEPTH        4
+
+//*****************************************************************************
+//
+// Formats of the data in a block; ui32Length counts items of this type.
+//
+//*****************************************************************************
+#define PIPE_FORMAT_SAMPLES16   0   // uint16_t samples
+#define PIPE_FORMAT_BYTES       1   // opaque bytes
+#define PIPE_FORMAT_PACKED12    2   // 12-bit samples, 3 bytes per 2 (sampack.h)
+#define PIPE_FORMAT_RICE        3   // Rice coded sample differences (sampack.h)
+#define PIPE_FORMAT_VARINT      4   // varint coded sample differences (sampack.h)
+
+//*****************************************************************************
+//
+// Values returned by a stage.
+//
+//*****************************************************************************
+#define PIPE_CONTINUE           0   // pass the block on to the next stage
+#define PIPE_DROP               1   // stop here and release the block
+#define PIPE_BUSY               2   // cannot take the block yet, retry later
+
+//*****************************************************************************
+//
+// A block descriptor.  It sits at the start of a pool block, immediately
+// followed by the data, so a whole block is passed between the source and
+// the stages as one pointer and released with one reference count.
+//
+//*****************************************************************************
+typedef struct
+{
+    tMemPool *psPool;           // pool the block belongs to
+    void *pvData;               // the data, following this header
+    uint32_t ui32Length;        // valid items in pvData
+    uint32_t ui32Format;        // one of the PIPE_FORMAT_ values
+    uint32_t ui32Seq;           // sequence number set by the source
+    uint32_t ui32Time;          // cycle count of the last item, if the source sets it
+    uint32_t ui32Missed;        // items the source has lost so far, if it counts them
+}
+tPipeBlock;
+
+//*****************************************************************************
+//
+// The pool block size needed for blocks carrying ui32Bytes of data.
+//
+//*****************************************************************************
+#define PIPE_BLOCK_SIZE(ui32Bytes)  (sizeof(tPipeBlock) + (ui32Bytes))
+
+//*****************************************************************************
+//
+// The number of data bytes in a block, from its format and length.
+//
+//*****************************************************************************
+#define PIPE_BLOCK_BYTES(psBlock)                                             \
+        (((psBlock)->ui32Format == PIPE_FORMAT_SAMPLES16) ?                   \
+         ((psBlock)->ui32Length * sizeof(uint16_t)) : (psBlock)->ui32Length)
+
+//*****************************************************************************
+//
+// A processing stage.  pfnProcess works on the block in place and returns one
+// of the PIPE_ values; a stage that keeps the block beyond the call (to send
+// it later, for example) takes a reference with PipeBlockRetain().
+//
+//*****************************************************************************
+typedef struct
+{
+    const char *pcName;
+    uint32_t (*pfnProcess)(void *pvState, tPipeBlock *psBlock);
+    void *pvState;
+
+    //
+    // Accounting, maintained by PipelineRun().
+    //
+    uint32_t ui32Calls;
+    uint32_t ui32Cycles;
+    uint32_t ui32MaxCycles;
+}
+tPipeStage;
+
+//*****************************************************************************
+//
+// A pipeline: a queue of blocks from the source and the stages they pass
+// through in order.  The members are private to pipeline.c.
+//
+//*****************************************************************************
+typedef struct
+{
+    tPipeStage *psStages;
+    uint32_t ui32NumStages;
+    tPipeBlock *ppsQueue[PIPE_QUEUE_DEPTH];
+    volatile uint32_t ui32Write;
+    volatile uint32_t ui32Read;
+    tPipeBlock *psStalled;
+    uint32_t ui32StallStage;
+    uint32_t ui32Rejected;
+    uint32_t ui32Completed;
+    uint32_t ui32Dropped;
+}
+tPipeline;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern tPipeBlock *PipeBlockAlloc(tMemPool *psPool, uint32_t ui32Format);
+extern void PipeBlockRetain(tPipeBlock *psBlock);
+extern void PipeBlockRelease(tPipeBlock *psBlock);
+extern void PipelineInit(tPipeline *psPipe, tPipeStage *psStages,
+                         uint32_t ui32NumStages);
+extern bool PipelineSubmit(tPipeline *psPipe, tPipeBlock *psBlock);
+extern uint32_t PipelineRun(tPipeline *psPipe);
+extern bool PipelineStalled(tPipeline *psPipe);
+extern void PipelineReport(tPipeline *psPipe);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_PIPELINE_H__
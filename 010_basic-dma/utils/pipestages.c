@@ -0,0 +1,143 @@
+//*****************************************************************************
+//
+// pipestages.c - General purpose stages for the block pipeline.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "utils/mempool.h"
+#include "utils/pipeline.h"
+#include "utils/pipestages.h"
+
+//*****************************************************************************
+//
+//! \addtogroup pipestages_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+//! Low-pass filters a block of samples in place.
+//!
+//! \param pvState points to a \b tPipeFilter.
+//! \param psBlock is a block of \b PIPE_FORMAT_SAMPLES16 data.
+//!
+//! The filter state carries over from one block to the next, so consecutive
+//! blocks are filtered as one continuous signal.  A \e ui32Shift of 0 passes
+//! the block through untouched.
+//!
+//! \return Returns \b PIPE_CONTINUE.
+//
+//*****************************************************************************
+uint32_t
+PipeStageFilter(void *pvState, tPipeBlock *psBlock)
+{
+    tPipeFilter *psFilter = pvState;
+    uint16_t *pui16Data = psBlock->pvData;
+    uint32_t ui32Idx, ui32Shift = psFilter->ui32Shift;
+    int32_t i32Acc;
+
+    if(ui32Shift == 0)
+    {
+        return(PIPE_CONTINUE);
+    }
+
+    if(!psFilter->bPrimed && psBlock->ui32Length)
+    {
+        psFilter->i32Acc = (int32_t)pui16Data[0] << ui32Shift;
+        psFilter->bPrimed = true;
+    }
+
+    i32Acc = psFilter->i32Acc;
+    for(ui32Idx = 0; ui32Idx < psBlock->ui32Length; ui32Idx++)
+    {
+        i32Acc += (int32_t)pui16Data[ui32Idx] - (i32Acc >> ui32Shift);
+        pui16Data[ui32Idx] = (uint16_t)(i32Acc >> ui32Shift);
+    }
+    psFilter->i32Acc = i32Acc;
+
+    return(PIPE_CONTINUE);
+}
+
+//*****************************************************************************
+//
+//! Reduces the sample rate of a block in place.
+//!
+//! \param pvState points to a \b tPipeDecimate.
+//! \param psBlock is a block of \b PIPE_FORMAT_SAMPLES16 data.
+//!
+//! Each group of \e ui32Factor samples is replaced by its mean (a boxcar
+//! anti-alias filter); a partial group at the end of the block is dropped.
+//!
+//! \return Returns \b PIPE_CONTINUE.
+//
+//*****************************************************************************
+uint32_t
+PipeStageDecimate(void *pvState, tPipeBlock *psBlock)
+{
+    tPipeDecimate *psDecimate = pvState;
+    uint16_t *pui16Data = psBlock->pvData;
+    uint32_t ui32Out, ui32In, ui32Idx, ui32Sum, ui32Factor;
+
+    ui32Factor = psDecimate->ui32Factor;
+    if(ui32Factor < 2)
+    {
+        return(PIPE_CONTINUE);
+    }
+
+    for(ui32Out = 0, ui32In = 0; (ui32In + ui32Factor) <= psBlock->ui32Length;
+        ui32Out++)
+    {
+        for(ui32Sum = 0, ui32Idx = 0; ui32Idx < ui32Factor; ui32Idx++)
+        {
+            ui32Sum += pui16Data[ui32In++];
+        }
+        pui16Data[ui32Out] = (uint16_t)(ui32Sum / ui32Factor);
+    }
+    psBlock->ui32Length = ui32Out;
+
+    return(PIPE_CONTINUE);
+}
+
+//*****************************************************************************
+//
+//! Passes on only blocks containing an out-of-range sample.
+//!
+//! \param pvState points to a \b tPipeThreshold.
+//! \param psBlock is a block of \b PIPE_FORMAT_SAMPLES16 data.
+//!
+//! Useful ahead of logging or transmission stages so that only blocks with
+//! activity are stored or sent.
+//!
+//! \return Returns \b PIPE_CONTINUE if any sample is below \e ui16Low or above
+//! \e ui16High, otherwise \b PIPE_DROP.
+//
+//*****************************************************************************
+uint32_t
+PipeStageThreshold(void *pvState, tPipeBlock *psBlock)
+{
+    tPipeThreshold *psThreshold = pvState;
+    uint16_t *pui16Data = psBlock->pvData;
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < psBlock->ui32Length; ui32Idx++)
+    {
+        if((pui16Data[ui32Idx] < psThreshold->ui16Low) ||
+           (pui16Data[ui32Idx] > psThreshold->ui16High))
+        {
+            psThreshold->ui32Passed++;
+            return(PIPE_CONTINUE);
+        }
+    }
+
+    return(PIPE_DROP);
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
@@ -0,0 +1,79 @@
+//*****************************************************************************
+//
+// pipestages.h - General purpose stages for the block pipeline.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_PIPESTAGES_H__
+#define __UTILS_PIPESTAGES_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// State of PipeStageFilter(): a first-order low-pass filter,
+// y += (x - y) / 2^ui32Shift, carried across blocks.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Shift;
+    int32_t i32Acc;             // y scaled by 2^ui32Shift
+    bool bPrimed;
+}
+tPipeFilter;
+
+//*****************************************************************************
+//
+// State of PipeStageDecimate(): keep the mean of every ui32Factor samples.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Factor;
+}
+tPipeDecimate;
+
+//*****************************************************************************
+//
+// State of PipeStageThreshold(): pass only blocks with a sample outside
+// [ui16Low, ui16High].
+//
+//*****************************************************************************
+typedef struct
+{
+    uint16_t ui16Low;
+    uint16_t ui16High;
+    uint32_t ui32Passed;
+}
+tPipeThreshold;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.  Each is a tPipeStage pfnProcess function taking a
+// pointer to its state structure.
+//
+//*****************************************************************************
+extern uint32_t PipeStageFilter(void *pvState, tPipeBlock *psBlock);
+extern uint32_t PipeStageDecimate(void *pvState, tPipeBlock *psBlock);
+extern uint32_t PipeStageThreshold(void *pvState, tPipeBlock *psBlock);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_PIPESTAGES_H__
@@ -0,0 +1,149 @@
+//*****************************************************************************
+//
+// power.c - Real and reactive power and phase of sample pairs.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include "utils/power.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup power_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Tenths of a degree per radian.
+//
+//*****************************************************************************
+#define POWER_DECIDEG_PER_RAD   572.957795f
+
+//*****************************************************************************
+//
+//! Computes the power of a block of voltage and current samples.
+//!
+//! \param pui16V points to the voltage samples.
+//! \param pui16I points to the current samples, taken at the same instants.
+//! \param ui32Count is the number of samples of each; for an exact result
+//! the block should span whole cycles of the signal, or many of them.
+//! \param ui32Offset is subtracted from every sample before the products are
+//! taken (the ADC mid-scale, 2048), so they fit 32 bits.
+//! \param psResult receives the result.
+//!
+//! One pass sums the samples, their squares, their products and the
+//! cross products of each sample with the previous one of the other input;
+//! only the last few steps use the FPU.  The reactive power is the part of
+//! the apparent power that is not real (with harmonics, it includes the
+//! distortion power), signed by the cross products, whose mean is
+//! proportional to the sine of the phase whatever the signal frequency.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+PowerCompute(const uint16_t *pui16V, const uint16_t *pui16I,
+             uint32_t ui32Count, uint32_t ui32Offset, tPowerResult *psResult)
+{
+    int32_t i32V, i32I, i32PrevV, i32PrevI, i32SumV, i32SumI;
+    int64_t i64SumVV, i64SumII, i64SumVI, i64Cross;
+    uint32_t ui32Idx;
+    float fN, fMeanV, fMeanI, fReal, fVV, fII, fApparent, fReactive;
+
+    if(ui32Count == 0)
+    {
+        return;
+    }
+
+    i32SumV = i32SumI = 0;
+    i64SumVV = i64SumII = i64SumVI = i64Cross = 0;
+    i32PrevV = (int32_t)pui16V[0] - (int32_t)ui32Offset;
+    i32PrevI = (int32_t)pui16I[0] - (int32_t)ui32Offset;
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        i32V = (int32_t)pui16V[ui32Idx] - (int32_t)ui32Offset;
+        i32I = (int32_t)pui16I[ui32Idx] - (int32_t)ui32Offset;
+        i32SumV += i32V;
+        i32SumI += i32I;
+        i64SumVV += i32V * i32V;
+        i64SumII += i32I * i32I;
+        i64SumVI += i32V * i32I;
+        i64Cross += (i32PrevV * i32I) - (i32V * i32PrevI);
+        i32PrevV = i32V;
+        i32PrevI = i32I;
+    }
+
+    //
+    // Means of the products, less the products of the means: the DC part.
+    //
+    fN = (float)ui32Count;
+    fMeanV = (float)i32SumV / fN;
+    fMeanI = (float)i32SumI / fN;
+    fReal = ((float)i64SumVI / fN) - (fMeanV * fMeanI);
+    fVV = ((float)i64SumVV / fN) - (fMeanV * fMeanV);
+    fII = ((float)i64SumII / fN) - (fMeanI * fMeanI);
+    fVV = (fVV > 0.0f) ? fVV : 0.0f;
+    fII = (fII > 0.0f) ? fII : 0.0f;
+
+    fApparent = sqrtf(fVV * fII);
+    fReactive = (fApparent * fApparent) - (fReal * fReal);
+    fReactive = (fReactive > 0.0f) ? sqrtf(fReactive) : 0.0f;
+    if(i64Cross < 0)
+    {
+        fReactive = -fReactive;
+    }
+
+    psResult->i32Real = (int32_t)fReal;
+    psResult->i32Reactive = (int32_t)fReactive;
+    psResult->ui32Apparent = (uint32_t)fApparent;
+    psResult->ui32VRms = (uint32_t)sqrtf(fVV);
+    psResult->ui32IRms = (uint32_t)sqrtf(fII);
+    psResult->i32Phase = (int32_t)(atan2f(fReactive, fReal) *
+                                   POWER_DECIDEG_PER_RAD);
+}
+
+//*****************************************************************************
+//
+//! Prints a power result.
+//!
+//! \param psResult is the result.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+PowerReport(const tPowerResult *psResult)
+{
+    int32_t i32Phase, i32Factor;
+
+    i32Phase = psResult->i32Phase;
+    i32Factor = psResult->ui32Apparent ?
+                (int32_t)(((int64_t)psResult->i32Real * 1000) /
+                          (int32_t)psResult->ui32Apparent) : 0;
+
+    UARTprintf("  Vrms %d, Irms %d counts\n", psResult->ui32VRms,
+               psResult->ui32IRms);
+    UARTprintf("  Real %d, reactive %d, apparent %d counts^2\n",
+               psResult->i32Real, psResult->i32Reactive,
+               psResult->ui32Apparent);
+    UARTprintf("  Phase %s%d.%d deg (current %s), power factor %s%d.%03d\n",
+               (i32Phase < 0) ? "-" : "",
+               ((i32Phase < 0) ? -i32Phase : i32Phase) / 10,
+               ((i32Phase < 0) ? -i32Phase : i32Phase) % 10,
+               (i32Phase < 0) ? "leads" : "lags",
+               (i32Factor < 0) ? "-" : "",
+               ((i32Factor < 0) ? -i32Factor : i32Factor) / 1000,
+               ((i32Factor < 0) ? -i32Factor : i32Factor) % 1000);
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
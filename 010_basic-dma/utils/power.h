@@ -0,0 +1,60 @@
+//*****************************************************************************
+//
+// power.h - Real and reactive power and phase of sample pairs.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_POWER_H__
+#define __UTILS_POWER_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The power of one block of voltage and current samples, in ADC counts
+// (scale by the volts and amps per count of the front end).  The DC part of
+// each input is taken out first, so an offset in either does not show up as
+// power.  The phase is that of the current behind the voltage, in tenths of
+// a degree: positive when the current lags (an inductive load).
+//
+//*****************************************************************************
+typedef struct
+{
+    int32_t i32Real;            // mean of v * i, counts^2
+    int32_t i32Reactive;        // signed like the phase
+    uint32_t ui32Apparent;      // Vrms * Irms
+    uint32_t ui32VRms;
+    uint32_t ui32IRms;
+    int32_t i32Phase;           // tenths of a degree, -1800 to 1800
+}
+tPowerResult;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void PowerCompute(const uint16_t *pui16V, const uint16_t *pui16I,
+                         uint32_t ui32Count, uint32_t ui32Offset,
+                         tPowerResult *psResult);
+extern void PowerReport(const tPowerResult *psResult);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_POWER_H__
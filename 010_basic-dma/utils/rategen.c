@@ -0,0 +1,215 @@
+//*****************************************************************************
+//
+// rategen.c - Drift-free fractional rates from a periodic timer.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_types.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/timer.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/intprio.h"
+#include "utils/rategen.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup rategen_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// The time-out interrupt flag of the generator's timer.
+//
+//*****************************************************************************
+#define RATEGEN_TIMEOUT(psGen)                                                \
+        (((psGen)->ui32Timer == TIMER_B) ? TIMER_TIMB_TIMEOUT :               \
+         TIMER_TIMA_TIMEOUT)
+
+//*****************************************************************************
+//
+//! Prepares a rate generator.
+//!
+//! \param psGen is the generator, with its application members set.
+//! \param ui32Clock is the timer clock in Hz.
+//!
+//! The timer must already be configured for periodic mode.  It is set to
+//! take a new period at its next time-out, not straight away, so a period
+//! can be changed while the timer runs without cutting the current one
+//! short.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+RateGenInit(tRateGen *psGen, uint32_t ui32Clock)
+{
+    psGen->ui32Clock = ui32Clock;
+    psGen->ui32Rate = 0;
+    psGen->ui32Frac = 0;
+    psGen->ui32Reloads = 0;
+
+    MAP_TimerUpdateMode(psGen->ui32Base, psGen->ui32Timer,
+                        TIMER_UP_LOAD_TIMEOUT);
+    MAP_TimerIntDisable(psGen->ui32Base, RATEGEN_TIMEOUT(psGen));
+    MAP_TimerIntClear(psGen->ui32Base, RATEGEN_TIMEOUT(psGen));
+    MAP_IntEnable(psGen->ui32Int);
+}
+
+//*****************************************************************************
+//
+//! Sets the rate.
+//!
+//! \param psGen is the generator.
+//! \param ui32Rate and \e ui32Div give the rate, \e ui32Rate / \e ui32Div Hz
+//! (44100 and 1, or 29970 and 1000 for 29.97 Hz).
+//!
+//! The new rate starts at the timer's next time-out.  A rate that divides
+//! the clock needs no interrupts; any other alternates between two periods,
+//! one cycle apart, and takes an interrupt per period to load the next.
+//!
+//! \return Returns \b false, leaving the rate as it was, if the period would
+//! be under two cycles or beyond the timer's reach, or \e ui32Rate is over
+//! 2^31.
+//
+//*****************************************************************************
+bool
+RateGenSet(tRateGen *psGen, uint32_t ui32Rate, uint32_t ui32Div)
+{
+    uint64_t ui64Cycles, ui64Whole;
+    uint32_t ui32Frac, ui32Saved;
+
+    if((ui32Rate == 0) || (ui32Rate > 0x80000000) || (ui32Div == 0))
+    {
+        return(false);
+    }
+
+    ui64Cycles = (uint64_t)psGen->ui32Clock * ui32Div;
+    ui64Whole = ui64Cycles / ui32Rate;
+    ui32Frac = (uint32_t)(ui64Cycles % ui32Rate);
+    if((ui64Whole < 2) || (ui64Whole >= 0xFFFFFFFF) ||
+       (psGen->ui32MaxPeriod &&
+        ((ui64Whole + (ui32Frac ? 1 : 0)) > psGen->ui32MaxPeriod)))
+    {
+        return(false);
+    }
+
+    //
+    // The interrupt handler reads all of these.
+    //
+    ui32Saved = IntCriticalEnter(MAP_IntPriorityGet(psGen->ui32Int));
+    psGen->ui32Rate = ui32Rate;
+    psGen->ui32Div = ui32Div;
+    psGen->ui32Whole = (uint32_t)ui64Whole;
+    psGen->ui32Frac = ui32Frac;
+    psGen->ui32Acc = 0;
+    MAP_TimerLoadSet(psGen->ui32Base, psGen->ui32Timer, psGen->ui32Whole - 1);
+    if(ui32Frac)
+    {
+        MAP_TimerIntEnable(psGen->ui32Base, RATEGEN_TIMEOUT(psGen));
+    }
+    else
+    {
+        MAP_TimerIntDisable(psGen->ui32Base, RATEGEN_TIMEOUT(psGen));
+    }
+    IntCriticalExit(ui32Saved);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Handles the time-out interrupt of the generator's timer.
+//!
+//! \param psGen is the generator.
+//!
+//! The period that has just started was loaded by the previous call; this
+//! loads the one after it, a cycle longer whenever the fractions carried
+//! add up to a whole cycle.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+RateGenIntHandler(tRateGen *psGen)
+{
+    uint32_t ui32Period;
+
+    MAP_TimerIntClear(psGen->ui32Base, RATEGEN_TIMEOUT(psGen));
+
+    ui32Period = psGen->ui32Whole;
+    psGen->ui32Acc += psGen->ui32Frac;
+    if(psGen->ui32Acc >= psGen->ui32Rate)
+    {
+        psGen->ui32Acc -= psGen->ui32Rate;
+        ui32Period++;
+    }
+    MAP_TimerLoadSet(psGen->ui32Base, psGen->ui32Timer, ui32Period - 1);
+    psGen->ui32Reloads++;
+}
+
+//*****************************************************************************
+//
+//! Prints the rate achieved, its jitter and its cost.
+//!
+//! \param psGen is the generator.
+//!
+//! The achieved rate is the clock over the mean period, which is exact, so
+//! it only differs from the rate asked for below the last digit printed.
+//! The jitter is that of the time-outs against the ideal grid.  For
+//! comparison, the drift of a fixed period (the clock over the rate, rounded
+//! down) is printed too.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+RateGenReport(tRateGen *psGen)
+{
+    uint64_t ui64Num;
+    uint32_t ui32MilliHz, ui32PPB;
+
+    if(psGen->ui32Rate == 0)
+    {
+        UARTprintf("Rate generator: not set\n");
+        return;
+    }
+
+    //
+    // Mean period = (whole * rate + frac) / rate cycles, so the achieved
+    // rate is clock * rate / that numerator.
+    //
+    ui64Num = ((uint64_t)psGen->ui32Whole * psGen->ui32Rate) +
+              psGen->ui32Frac;
+    ui32MilliHz = (uint32_t)(((uint64_t)psGen->ui32Clock * 1000 *
+                              psGen->ui32Rate) / ui64Num);
+    ui32PPB = (uint32_t)(((uint64_t)psGen->ui32Frac * 1000000000) / ui64Num);
+
+    UARTprintf("Rate %d.%03d Hz: periods of %d", ui32MilliHz / 1000,
+               ui32MilliHz % 1000, psGen->ui32Whole);
+    if(psGen->ui32Frac)
+    {
+        UARTprintf(" and %d cycles, jitter under %d ns, %d reloads so far\n",
+                   psGen->ui32Whole + 1, 1000000000 / psGen->ui32Clock,
+                   psGen->ui32Reloads);
+        UARTprintf("  (a fixed period of %d cycles would run %d.%03d ppm "
+                   "fast)\n", psGen->ui32Whole, ui32PPB / 1000,
+                   ui32PPB % 1000);
+    }
+    else
+    {
+        UARTprintf(" cycles, no jitter, no interrupts\n");
+    }
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
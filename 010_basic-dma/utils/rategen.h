@@ -0,0 +1,73 @@
+//*****************************************************************************
+//
+// rategen.h - Drift-free fractional rates from a periodic timer.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_RATEGEN_H__
+#define __UTILS_RATEGEN_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// A rate generator: a timer in periodic mode whose period alternates between
+// two neighbouring cycle counts, chosen by a phase accumulator so that the
+// mean period is exact and the time-outs never drift from the ideal grid by
+// a clock cycle or more.  Whatever the time-out drives (an ADC trigger, a
+// PWM update, a uDMA request for pattern output) runs at the exact rate.
+//
+// The timer (ui32Base and ui32Timer, TIMER_A or TIMER_B), its time-out
+// interrupt and the longest period it can count (65536 for a 16-bit half,
+// 0 for no limit) are set by the application; the rest is private to
+// rategen.c.  The application routes the interrupt to RateGenIntHandler(),
+// at a priority that gets it handled within the shortest period; it is only
+// enabled when the rate does not divide the clock.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Base;
+    uint32_t ui32Timer;
+    uint32_t ui32Int;
+    uint32_t ui32MaxPeriod;
+
+    uint32_t ui32Clock;
+    uint32_t ui32Rate;          // requested rate, ui32Rate / ui32Div Hz
+    uint32_t ui32Div;
+    uint32_t ui32Whole;         // cycles per period, rounded down
+    uint32_t ui32Frac;          // and the remainder, in 1/ui32Rate cycles
+    uint32_t ui32Acc;
+    uint32_t ui32Reloads;       // interrupts taken
+}
+tRateGen;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void RateGenInit(tRateGen *psGen, uint32_t ui32Clock);
+extern bool RateGenSet(tRateGen *psGen, uint32_t ui32Rate, uint32_t ui32Div);
+extern void RateGenIntHandler(tRateGen *psGen);
+extern void RateGenReport(tRateGen *psGen);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_RATEGEN_H__
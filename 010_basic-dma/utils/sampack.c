@@ -0,0 +1,380 @@
+//*****************************************************************************
+//
+// sampack.c - 12-bit sample packing and delta coding for transmission.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "driverlib/debug.h"
+#include "utils/mempool.h"
+#include "utils/pipeline.h"
+#include "utils/sampack.h"
+
+//*****************************************************************************
+//
+//! \addtogroup sampack_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// A little-endian bit writer that gives up once the output limit is reached.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t *pui8Out;
+    uint32_t ui32Pos;
+    uint32_t ui32Max;
+    uint32_t ui32Acc;
+    uint32_t ui32Bits;
+}
+tBitWriter;
+
+//*****************************************************************************
+//
+// Appends the ui32Count low bits of ui32Value (at most 24).  Returns false if
+// the output is full.
+//
+//*****************************************************************************
+static bool
+BitsPut(tBitWriter *psWriter, uint32_t ui32Value, uint32_t ui32Count)
+{
+    psWriter->ui32Acc |= ui32Value << psWriter->ui32Bits;
+    psWriter->ui32Bits += ui32Count;
+
+    while(psWriter->ui32Bits >= 8)
+    {
+        if(psWriter->ui32Pos >= psWriter->ui32Max)
+        {
+            return(false);
+        }
+        psWriter->pui8Out[psWriter->ui32Pos++] = (uint8_t)psWriter->ui32Acc;
+        psWriter->ui32Acc >>= 8;
+        psWriter->ui32Bits -= 8;
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Writes any remaining bits, zero padded.  Returns the total byte count, or 0
+// if the output is full.
+//
+//*****************************************************************************
+static uint32_t
+BitsFlush(tBitWriter *psWriter)
+{
+    if(psWriter->ui32Bits && !BitsPut(psWriter, 0, 8 - psWriter->ui32Bits))
+    {
+        return(0);
+    }
+
+    return(psWriter->ui32Pos);
+}
+
+//*****************************************************************************
+//
+// Maps a signed difference onto an unsigned value, small magnitudes first:
+// 0, -1, 1, -2, 2... become 0, 1, 2, 3, 4...
+//
+//*****************************************************************************
+static uint32_t
+ZigZag(int32_t i32Delta)
+{
+    return(((uint32_t)i32Delta << 1) ^ (uint32_t)(i32Delta >> 31));
+}
+
+//*****************************************************************************
+//
+// Writes the count and first sample that start both delta codings.
+//
+//*****************************************************************************
+static void
+DeltaHeader(uint8_t *pui8Out, const uint16_t *pui16In, uint32_t ui32Samples)
+{
+    pui8Out[0] = (uint8_t)ui32Samples;
+    pui8Out[1] = (uint8_t)(ui32Samples >> 8);
+    pui8Out[2] = (uint8_t)pui16In[0];
+    pui8Out[3] = (uint8_t)(pui16In[0] >> 8);
+}
+
+//*****************************************************************************
+//
+//! Packs 12-bit samples three bytes to two samples.
+//!
+//! \param pui16In points to the samples; it must be word aligned.
+//! \param ui32Samples is the number of samples.
+//! \param pui8Out receives the packed bytes.  It may be the same buffer as
+//! \e pui16In, so a block can be packed in place.
+//!
+//! Eight samples are handled per step: four 32-bit loads of two samples each
+//! become three 32-bit stores, so the core does the work a word at a time
+//! rather than shifting individual bytes.  Only the upper four bits of each
+//! sample are dropped.
+//!
+//! \return Returns the number of bytes written, \b PACK_12BIT_SIZE().
+//
+//*****************************************************************************
+uint32_t
+SamplePack12(const uint16_t *pui16In, uint32_t ui32Samples, uint8_t *pui8Out)
+{
+    const uint32_t *pui32In = (const uint32_t *)pui16In;
+    uint32_t *pui32Out = (uint32_t *)pui8Out;
+    uint32_t ui32A, ui32B, ui32C, ui32D, ui32Idx, ui32Groups;
+    uint8_t *pui8Tail;
+
+    ASSERT(((uint32_t)pui16In & 3) == 0);
+    ASSERT(((uint32_t)pui8Out & 3) == 0);
+
+    for(ui32Groups = ui32Samples / 8; ui32Groups; ui32Groups--)
+    {
+        //
+        // Read all four words before writing, which makes packing in place
+        // safe: the three words written never reach beyond the four read.
+        //
+        ui32A = pui32In[0] & 0x0FFF0FFF;
+        ui32B = pui32In[1] & 0x0FFF0FFF;
+        ui32C = pui32In[2] & 0x0FFF0FFF;
+        ui32D = pui32In[3] & 0x0FFF0FFF;
+        pui32In += 4;
+
+        pui32Out[0] = (ui32A & 0xFFF) | ((ui32A >> 4) & 0xFFF000) |
+                      (ui32B << 24);
+        pui32Out[1] = ((ui32B >> 8) & 0xF) | (ui32B >> 12) |
+                      ((ui32C & 0xFFF) << 16) | ((ui32C >> 16) << 28);
+        pui32Out[2] = (ui32C >> 20) | ((ui32D & 0xFFF) << 8) |
+                      ((ui32D >> 16) << 20);
+        pui32Out += 3;
+    }
+
+    //
+    // Up to seven remaining samples, a pair at a time.
+    //
+    pui16In = (const uint16_t *)pui32In;
+    pui8Tail = (uint8_t *)pui32Out;
+    for(ui32Idx = ui32Samples & ~7; ui32Idx < ui32Samples; ui32Idx += 2)
+    {
+        ui32A = *pui16In++ & 0xFFF;
+        ui32B = ((ui32Idx + 1) < ui32Samples) ? (*pui16In++ & 0xFFF) : 0;
+
+        *pui8Tail++ = (uint8_t)ui32A;
+        *pui8Tail++ = (uint8_t)((ui32A >> 8) | (ui32B << 4));
+        if((ui32Idx + 1) < ui32Samples)
+        {
+            *pui8Tail++ = (uint8_t)(ui32B >> 4);
+        }
+    }
+
+    return(PACK_12BIT_SIZE(ui32Samples));
+}
+
+//*****************************************************************************
+//
+//! Delta codes 12-bit samples with a Rice code.
+//!
+//! \param pui16In points to the samples.
+//! \param ui32Samples is the number of samples (at least one).
+//! \param pui8Out receives the encoded bytes; it must not overlap the input.
+//! \param ui32MaxBytes is the most the caller is willing to accept.
+//!
+//! The Rice parameter is chosen per block from the mean size of the
+//! differences, so slowly varying signals cost a few bits per sample and
+//! noisy ones degrade gracefully.
+//!
+//! \return Returns the number of bytes written, or 0 if the result would
+//! exceed \e ui32MaxBytes.
+//
+//*****************************************************************************
+uint32_t
+SampleEncodeRice(const uint16_t *pui16In, uint32_t ui32Samples,
+                 uint8_t *pui8Out, uint32_t ui32MaxBytes)
+{
+    tBitWriter sWriter;
+    uint32_t ui32Idx, ui32Sum, ui32Mean, ui32K, ui32Z, ui32Q;
+
+    if((ui32Samples == 0) || (ui32MaxBytes < 5))
+    {
+        return(0);
+    }
+
+    //
+    // Pick k so that 2^k is close to the mean difference.
+    //
+    for(ui32Sum = 0, ui32Idx = 1; ui32Idx < ui32Samples; ui32Idx++)
+    {
+        ui32Sum += ZigZag((int32_t)pui16In[ui32Idx] -
+                          (int32_t)pui16In[ui32Idx - 1]);
+    }
+    ui32Mean = (ui32Samples > 1) ? (ui32Sum / (ui32Samples - 1)) : 0;
+    for(ui32K = 0; (ui32K < 12) && ((2u << ui32K) <= ui32Mean); ui32K++)
+    {
+    }
+
+    pui8Out[0] = (uint8_t)ui32K;
+    DeltaHeader(pui8Out + 1, pui16In, ui32Samples);
+
+    sWriter.pui8Out = pui8Out;
+    sWriter.ui32Pos = 5;
+    sWriter.ui32Max = ui32MaxBytes;
+    sWriter.ui32Acc = 0;
+    sWriter.ui32Bits = 0;
+
+    for(ui32Idx = 1; ui32Idx < ui32Samples; ui32Idx++)
+    {
+        ui32Z = ZigZag((int32_t)pui16In[ui32Idx] -
+                       (int32_t)pui16In[ui32Idx - 1]);
+        ui32Q = ui32Z >> ui32K;
+
+        if(ui32Q < PACK_RICE_ESCAPE)
+        {
+            if(!BitsPut(&sWriter, (1u << ui32Q) - 1, ui32Q + 1) ||
+               !BitsPut(&sWriter, ui32Z & ((1u << ui32K) - 1), ui32K))
+            {
+                return(0);
+            }
+        }
+        else
+        {
+            if(!BitsPut(&sWriter, (1u << PACK_RICE_ESCAPE) - 1,
+                        PACK_RICE_ESCAPE) ||
+               !BitsPut(&sWriter, ui32Z, PACK_RICE_RAW_BITS))
+            {
+                return(0);
+            }
+        }
+    }
+
+    return(BitsFlush(&sWriter));
+}
+
+//*****************************************************************************
+//
+//! Delta codes 12-bit samples as zigzag varints.
+//!
+//! \param pui16In points to the samples.
+//! \param ui32Samples is the number of samples (at least one).
+//! \param pui8Out receives the encoded bytes; it must not overlap the input.
+//! \param ui32MaxBytes is the most the caller is willing to accept.
+//!
+//! Differences within +/-63 take one byte.  Byte aligned, so cheaper to
+//! decode than the Rice code but less compact on noisy signals.
+//!
+//! \return Returns the number of bytes written, or 0 if the result would
+//! exceed \e ui32MaxBytes.
+//
+//*****************************************************************************
+uint32_t
+SampleEncodeVarint(const uint16_t *pui16In, uint32_t ui32Samples,
+                   uint8_t *pui8Out, uint32_t ui32MaxBytes)
+{
+    uint32_t ui32Idx, ui32Pos, ui32Z;
+
+    if((ui32Samples == 0) || (ui32MaxBytes < 4))
+    {
+        return(0);
+    }
+
+    DeltaHeader(pui8Out, pui16In, ui32Samples);
+
+    for(ui32Pos = 4, ui32Idx = 1; ui32Idx < ui32Samples; ui32Idx++)
+    {
+        ui32Z = ZigZag((int32_t)pui16In[ui32Idx] -
+                       (int32_t)pui16In[ui32Idx - 1]);
+
+        //
+        // A 12-bit difference needs at most two bytes.
+        //
+        if((ui32Pos + 2) > ui32MaxBytes)
+        {
+            return(0);
+        }
+
+        while(ui32Z >= 0x80)
+        {
+            pui8Out[ui32Pos++] = (uint8_t)(ui32Z | 0x80);
+            ui32Z >>= 7;
+        }
+        pui8Out[ui32Pos++] = (uint8_t)ui32Z;
+    }
+
+    return(ui32Pos);
+}
+
+//*****************************************************************************
+//
+//! Pipeline stage that packs or delta codes a block of samples.
+//!
+//! \param pvState points to a \b tPackStage.
+//! \param psBlock is a block of \b PIPE_FORMAT_SAMPLES16 data.
+//!
+//! The block's format and length are updated to describe the bytes that
+//! replace the samples.  Blocks in any other format are passed on untouched.
+//!
+//! \return Returns \b PIPE_CONTINUE.
+//
+//*****************************************************************************
+uint32_t
+PipeStagePack(void *pvState, tPipeBlock *psBlock)
+{
+    tPackStage *psPack = pvState;
+    uint32_t ui32Samples, ui32Packed, ui32Bytes;
+
+    if((psBlock->ui32Format != PIPE_FORMAT_SAMPLES16) ||
+       (psPack->ui32Mode == PACK_MODE_NONE) || (psBlock->ui32Length == 0))
+    {
+        return(PIPE_CONTINUE);
+    }
+
+    ui32Samples = psBlock->ui32Length;
+    ui32Packed = PACK_12BIT_SIZE(ui32Samples);
+    psPack->ui32BytesIn += ui32Samples * sizeof(uint16_t);
+
+    //
+    // Try the delta coding, accepting it only if it beats plain packing.
+    //
+    ui32Bytes = 0;
+    if(psPack->ui32ScratchSize >= ui32Packed)
+    {
+        if(psPack->ui32Mode == PACK_MODE_RICE)
+        {
+            ui32Bytes = SampleEncodeRice(psBlock->pvData, ui32Samples,
+                                         psPack->pui8Scratch, ui32Packed - 1);
+        }
+        else if(psPack->ui32Mode == PACK_MODE_VARINT)
+        {
+            ui32Bytes = SampleEncodeVarint(psBlock->pvData, ui32Samples,
+                                           psPack->pui8Scratch,
+                                           ui32Packed - 1);
+        }
+    }
+
+    if(ui32Bytes)
+    {
+        memcpy(psBlock->pvData, psPack->pui8Scratch, ui32Bytes);
+        psBlock->ui32Format = (psPack->ui32Mode == PACK_MODE_RICE) ?
+                              PIPE_FORMAT_RICE : PIPE_FORMAT_VARINT;
+    }
+    else
+    {
+        ui32Bytes = SamplePack12(psBlock->pvData, ui32Samples,
+                                 psBlock->pvData);
+        psBlock->ui32Format = PIPE_FORMAT_PACKED12;
+    }
+
+    psBlock->ui32Length = ui32Bytes;
+    psPack->ui32BytesOut += ui32Bytes;
+
+    return(PIPE_CONTINUE);
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
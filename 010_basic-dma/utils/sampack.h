@@ -0,0 +1,103 @@
+//*****************************************************************************
+//
+// sampack.h - 12-bit sample packing and delta coding for transmission.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_SAMPACK_H__
+#define __UTILS_SAMPACK_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Encodings produced by PipeStagePack().  All of them are for 12-bit samples
+// and decoded by tools/telemetry.py.
+//
+// PACK_MODE_12BIT: sample i occupies bits 12i to 12i+11 of the little-endian
+// byte stream, so two samples take three bytes.
+//
+// PACK_MODE_RICE: k (1 byte), sample count (2), first sample (2), then for
+// each following sample the zigzag-mapped difference z from the previous one
+// as a Rice code: q = z >> k in unary (q one bits and a zero bit) followed by
+// the k low bits of z.  A difference with q of 16 or more is sent as 16 one
+// bits and z in 13 bits instead.  Bits are filled from the LSB of each byte.
+//
+// PACK_MODE_VARINT: sample count (2), first sample (2), then each zigzag
+// difference as a little-endian base-128 varint (7 bits per byte, MSB set on
+// all but the last byte).
+//
+// The delta codings are only used for a block when they come out smaller
+// than 12-bit packing; otherwise the block is sent 12-bit packed.
+//
+//*****************************************************************************
+#define PACK_MODE_NONE          0
+#define PACK_MODE_12BIT         1
+#define PACK_MODE_RICE          2
+#define PACK_MODE_VARINT        3
+
+#define PACK_RICE_ESCAPE        16
+#define PACK_RICE_RAW_BITS      13
+
+//*****************************************************************************
+//
+// The number of bytes 12-bit packing turns ui32Samples samples into.
+//
+//*****************************************************************************
+#define PACK_12BIT_SIZE(ui32Samples)    (((ui32Samples) * 3 + 1) / 2)
+
+//*****************************************************************************
+//
+// State of PipeStagePack().  pui8Scratch must hold
+// PACK_12BIT_SIZE(samples per block) bytes; the delta codings are written
+// there first, as they can grow beyond the block's data while encoding.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Mode;          // one of the PACK_MODE_ values
+    uint8_t *pui8Scratch;
+    uint32_t ui32ScratchSize;
+
+    //
+    // Bytes in and out, for the compression ratio.
+    //
+    uint32_t ui32BytesIn;
+    uint32_t ui32BytesOut;
+}
+tPackStage;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern uint32_t SamplePack12(const uint16_t *pui16In, uint32_t ui32Samples,
+                             uint8_t *pui8Out);
+extern uint32_t SampleEncodeRice(const uint16_t *pui16In,
+                                 uint32_t ui32Samples, uint8_t *pui8Out,
+                                 uint32_t ui32MaxBytes);
+extern uint32_t SampleEncodeVarint(const uint16_t *pui16In,
+                                   uint32_t ui32Samples, uint8_t *pui8Out,
+                                   uint32_t ui32MaxBytes);
+extern uint32_t PipeStagePack(void *pvState, tPipeBlock *psBlock);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_SAMPACK_H__
@@ -0,0 +1,161 @@
+//*****************************************************************************
+//
+// samplering.c - A ring of sample blocks filled by a looping uDMA task list.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driverlib/udma.h"
+#include "utils/mempool.h"
+#include "utils/pipeline.h"
+#include "utils/dmaseq.h"
+#include "utils/samplering.h"
+
+//*****************************************************************************
+//
+//! \addtogroup samplering_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+//! Builds a ring's task list and gives every slot a block.
+//!
+//! \param psRing is the ring, with its application members set.
+//! \param pvFIFO is the peripheral FIFO the 16-bit samples are read from.
+//! \param ui32Samples is the number of samples per block, 1 to 1024.
+//! \param pvTimer is the free-running timer register whose count stamps
+//! each block as its last sample lands.
+//!
+//! The list is not started: the application sets the channel's attributes
+//! and calls DMASeqStart() on \e psRing->psSeq, before the peripheral's
+//! first request.  The pool needs more blocks than the ring has slots, as
+//! only the blocks beyond those can be lent at once.
+//!
+//! \return Returns \b false if the pool or the task list is too small.
+//
+//*****************************************************************************
+bool
+SampleRingInit(tSampleRing *psRing, const volatile void *pvFIFO,
+               uint32_t ui32Samples, const volatile void *pvTimer)
+{
+    uint32_t ui32Slot;
+    bool bOk;
+
+    psRing->ui32Done = psRing->ui32Slots - 1;
+    psRing->ui32Next = 0;
+    psRing->ui32Lent = 0;
+    psRing->ui32Kept = 0;
+
+    DMASeqInit(psRing->psSeq);
+    for(ui32Slot = 0; ui32Slot < psRing->ui32Slots; ui32Slot++)
+    {
+        psRing->ppsBlocks[ui32Slot] = PipeBlockAlloc(psRing->psPool,
+                                                     PIPE_FORMAT_SAMPLES16);
+        if(!psRing->ppsBlocks[ui32Slot])
+        {
+            return(false);
+        }
+        psRing->pui32Numbers[ui32Slot] = ui32Slot;
+
+        bOk = DMASeqTransfer(psRing->psSeq, pvFIFO,
+                             psRing->ppsBlocks[ui32Slot]->pvData, ui32Samples,
+                             UDMA_SIZE_16 | UDMA_SRC_INC_NONE |
+                             UDMA_DST_INC_16 | UDMA_ARB_1);
+        bOk = bOk && DMASeqCopy(psRing->psSeq, pvTimer,
+                                &psRing->pui32Times[ui32Slot], 1,
+                                UDMA_SIZE_32 | UDMA_SRC_INC_NONE |
+                                UDMA_DST_INC_NONE | UDMA_ARB_1);
+        bOk = bOk && DMASeqCopy(psRing->psSeq,
+                                &psRing->pui32Numbers[ui32Slot],
+                                &psRing->ui32Done, 1,
+                                UDMA_SIZE_32 | UDMA_SRC_INC_NONE |
+                                UDMA_DST_INC_NONE | UDMA_ARB_1);
+        if(!bOk)
+        {
+            return(false);
+        }
+    }
+
+    return(DMASeqLoop(psRing->psSeq));
+}
+
+//*****************************************************************************
+//
+//! Tells how many filled blocks are waiting to be lent.
+//!
+//! \param psRing is the ring.
+//! \param pui32Time receives the time stamp of the block filled last.
+//!
+//! \return Returns the number of slots filled since the last one lent, up
+//! to the ring's size less one; 0 both when there are none and when the
+//! uDMA has gone a whole lap unseen, which the time stamp tells apart.
+//
+//*****************************************************************************
+uint32_t
+SampleRingFilled(tSampleRing *psRing, uint32_t *pui32Time)
+{
+    uint32_t ui32Done;
+
+    ui32Done = psRing->ui32Done;
+    *pui32Time = psRing->pui32Times[ui32Done];  // written before the number
+    return((ui32Done + 1 + psRing->ui32Slots - psRing->ui32Next) %
+           psRing->ui32Slots);
+}
+
+//*****************************************************************************
+//
+//! Lends the block in the next slot.
+//!
+//! \param psRing is the ring.
+//! \param pui32Time receives the timer count of the block's last sample.
+//!
+//! A free block from the pool takes the slot, and the slot's transfer is
+//! pointed at it; the uDMA reaches it on its next lap.  The lent block is
+//! then the caller's, one reference, to release when done with.
+//!
+//! The block is kept in the ring, to be written over, if the pool has no
+//! free block or the slot is the one the uDMA is filling now (it has gone
+//! a whole lap since the block was filled).  The next call moves on to the
+//! following slot either way.
+//!
+//! \return Returns the block, or 0 if it was kept.
+//
+//*****************************************************************************
+tPipeBlock *
+SampleRingLend(tSampleRing *psRing, uint32_t *pui32Time)
+{
+    tPipeBlock *psBlock, *psFree;
+    uint32_t ui32Slot;
+
+    ui32Slot = psRing->ui32Next;
+    psRing->ui32Next = (ui32Slot + 1) % psRing->ui32Slots;
+    *pui32Time = psRing->pui32Times[ui32Slot];
+
+    psFree = 0;
+    if(ui32Slot != ((psRing->ui32Done + 1) % psRing->ui32Slots))
+    {
+        psFree = PipeBlockAlloc(psRing->psPool, PIPE_FORMAT_SAMPLES16);
+    }
+    if(!psFree)
+    {
+        psRing->ui32Kept++;
+        return(0);
+    }
+
+    psBlock = psRing->ppsBlocks[ui32Slot];
+    psRing->ppsBlocks[ui32Slot] = psFree;
+    DMASeqDestSet(psRing->psSeq, ui32Slot * SAMPLERING_TASKS_PER_SLOT,
+                  psFree->pvData);
+    psRing->ui32Lent++;
+    return(psBlock);
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
@@ -0,0 +1,79 @@
+//*****************************************************************************
+//
+// samplering.h - A ring of sample blocks filled by a looping uDMA task list.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_SAMPLERING_H__
+#define __UTILS_SAMPLERING_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Tasks per slot (the samples, the time stamp, the slot number) and the
+// length of the task list for a ring of n slots, the restart included.
+//
+//*****************************************************************************
+#define SAMPLERING_TASKS_PER_SLOT 3
+#define SAMPLERING_TASKS(n)     (((n) * SAMPLERING_TASKS_PER_SLOT) + 1)
+
+//*****************************************************************************
+//
+// A sample ring.  Each slot holds a pool block that the uDMA fills from a
+// peripheral FIFO; after the last sample it copies a timer count into the
+// slot's time stamp and the slot's number into ui32Done, and moves on to
+// the next slot, and after the last slot starts over, all without the CPU.
+// A filled block is lent by swapping a free pool block into its slot, so
+// the uDMA never writes a block once it has been lent.
+//
+// The task list (psSeq, SAMPLERING_TASKS(ui32Slots) long, its channel set),
+// the pool, the slots' blocks, time stamps and numbers (ui32Slots each)
+// are set by the application; the rest is private to samplering.c.
+//
+//*****************************************************************************
+typedef struct
+{
+    tDMASeq *psSeq;
+    tMemPool *psPool;
+    tPipeBlock **ppsBlocks;
+    volatile uint32_t *pui32Times;
+    uint32_t *pui32Numbers;
+    uint32_t ui32Slots;
+
+    volatile uint32_t ui32Done; // slot the uDMA filled last, written by it
+    uint32_t ui32Next;          // slot to lend next
+    uint32_t ui32Lent;          // blocks lent
+    uint32_t ui32Kept;          // filled blocks left in the ring instead
+}
+tSampleRing;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern bool SampleRingInit(tSampleRing *psRing, const volatile void *pvFIFO,
+                           uint32_t ui32Samples, const volatile void *pvTimer);
+extern uint32_t SampleRingFilled(tSampleRing *psRing, uint32_t *pui32Time);
+extern tPipeBlock *SampleRingLend(tSampleRing *psRing, uint32_t *pui32Time);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_SAMPLERING_H__
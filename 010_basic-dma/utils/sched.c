@@ -0,0 +1,293 @@
+//*****************************************************************************
+//
+// sched.c - Run-to-completion task scheduler with event queues.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_ints.h"
+#include "inc/hw_types.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/cyclecount.h"
+#include "utils/lfqueue.h"
+#include "utils/seqlock.h"
+#include "utils/sched.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup sched_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// PendSV runs at the lowest priority, below every interrupt.
+//
+//*****************************************************************************
+#define SCHED_PENDSV_PRIORITY   0xE0
+
+//*****************************************************************************
+//
+// The tasks, the ones dispatched from PendSV, and those with events waiting.
+//
+//*****************************************************************************
+static tSchedTask *g_psTasks;
+static uint32_t g_ui32NumTasks;
+static uint32_t g_ui32NumDeferred;
+static uint32_t g_ui32DeferredMask;
+static volatile uint32_t g_ui32Ready;
+
+//*****************************************************************************
+//
+// Runs one event of the highest priority ready task among ui32Mask.
+//
+// A ready task whose next event is still being posted (its producer was
+// preempted by this dispatcher) is passed over; the producer sets the ready
+// bit again once the event is in.  A task found empty has its ready bit
+// cleared, then set again if an event arrived meanwhile: posters queue the
+// event before they set the bit, so none is left unnoticed.
+//
+//*****************************************************************************
+static bool
+SchedDispatch(uint32_t ui32Mask)
+{
+    tSchedTask *psTask;
+    uint32_t ui32Ready, ui32Idx, ui32Event, ui32Start;
+
+    ui32Ready = g_ui32Ready & ui32Mask;
+    for(ui32Idx = 0; ui32Ready; ui32Idx++)
+    {
+        if(!(ui32Ready & (1 << ui32Idx)))
+        {
+            continue;
+        }
+        ui32Ready &= ~(1 << ui32Idx);
+        psTask = &g_psTasks[ui32Idx];
+
+        if(MPSCQueueGet(&psTask->sQueue, &ui32Event))
+        {
+            ui32Start = CycleCountGet();
+            psTask->pfnHandler(psTask->pvState, ui32Event);
+            ui32Start = CycleCountGet() - ui32Start;
+
+            SeqLockWriteBegin(&psTask->sStats);
+            psTask->ui32Runs++;
+            psTask->ui32Cycles += ui32Start;
+            if(ui32Start > psTask->ui32MaxCycles)
+            {
+                psTask->ui32MaxCycles = ui32Start;
+            }
+            SeqLockWriteEnd(&psTask->sStats);
+            return(true);
+        }
+
+        if(MPSCQueueCount(&psTask->sQueue) == 0)
+        {
+            LFAtomicAnd(&g_ui32Ready, ~(1 << ui32Idx));
+            if(MPSCQueueCount(&psTask->sQueue) != 0)
+            {
+                LFAtomicOr(&g_ui32Ready, 1 << ui32Idx);
+            }
+        }
+    }
+
+    return(false);
+}
+
+//*****************************************************************************
+//
+//! Prepares the scheduler.
+//!
+//! \param psTasks is the task table, highest priority first; each queue
+//! depth must be a power of two.
+//! \param ui32Count is the number of tasks, at most \b SCHED_MAX_TASKS.
+//! \param ui32Deferred is how many of the first tasks run from PendSV.
+//!
+//! Tasks run to completion, one event at a time, always the highest
+//! priority one with an event waiting.  The first \e ui32Deferred tasks are
+//! dispatched from the PendSV exception as soon as an event is posted to
+//! them, so they preempt the others (and the idle function) but never an
+//! interrupt handler or each other: they are the place for the work an
+//! interrupt handler defers.  The rest are dispatched by SchedRun() in
+//! thread mode.  Deferred tasks must not share unprotected state, the
+//! console included, with thread-mode code.
+//!
+//! The cycle counter must be running (CycleCountStart()).
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+SchedInit(tSchedTask *psTasks, uint32_t ui32Count, uint32_t ui32Deferred)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++)
+    {
+        MPSCQueueInit(&psTasks[ui32Idx].sQueue, psTasks[ui32Idx].psSlots,
+                      psTasks[ui32Idx].ui32Depth);
+        psTasks[ui32Idx].ui32Posted = 0;
+        psTasks[ui32Idx].ui32Lost = 0;
+        psTasks[ui32Idx].ui32MaxQueued = 0;
+        psTasks[ui32Idx].sStats.ui32Seq = 0;
+        psTasks[ui32Idx].ui32Runs = 0;
+        psTasks[ui32Idx].ui32Cycles = 0;
+        psTasks[ui32Idx].ui32MaxCycles = 0;
+    }
+
+    g_psTasks = psTasks;
+    g_ui32NumTasks = ui32Count;
+    g_ui32NumDeferred = ui32Deferred;
+    g_ui32DeferredMask = (1 << ui32Deferred) - 1;
+    g_ui32Ready = 0;
+
+    MAP_IntPrioritySet(FAULT_PENDSV, SCHED_PENDSV_PRIORITY);
+}
+
+//*****************************************************************************
+//
+//! Posts an event to a task.
+//!
+//! \param psTask is the task, an entry of the table given to SchedInit().
+//! \param ui32Event is the event, passed to the task's handler.
+//!
+//! May be called from interrupt handlers and tasks alike, which may preempt
+//! each other; nothing is masked.
+//!
+//! \return Returns \b false if the task's queue is full.
+//
+//*****************************************************************************
+bool
+SchedPost(tSchedTask *psTask, uint32_t ui32Event)
+{
+    uint32_t ui32Bit, ui32Queued, ui32Max;
+
+    if(!MPSCQueuePut(&psTask->sQueue, ui32Event))
+    {
+        LFAtomicAdd(&psTask->ui32Lost, 1);
+        return(false);
+    }
+
+    LFAtomicAdd(&psTask->ui32Posted, 1);
+    ui32Queued = MPSCQueueCount(&psTask->sQueue);
+    do
+    {
+        ui32Max = psTask->ui32MaxQueued;
+    }
+    while((ui32Queued > ui32Max) &&
+          !LFCompareAndSwap(&psTask->ui32MaxQueued, ui32Max, ui32Queued));
+
+    ui32Bit = 1 << (psTask - g_psTasks);
+    LFAtomicOr(&g_ui32Ready, ui32Bit);
+    if(ui32Bit & g_ui32DeferredMask)
+    {
+        MAP_IntPendSet(FAULT_PENDSV);
+    }
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Runs the highest priority thread-mode task with an event waiting.
+//!
+//! \return Returns \b false if no thread-mode task had an event.
+//
+//*****************************************************************************
+bool
+SchedRunOne(void)
+{
+    return(SchedDispatch(~g_ui32DeferredMask));
+}
+
+//*****************************************************************************
+//
+//! Runs the thread-mode tasks for ever.
+//!
+//! \param pfnIdle is called whenever no thread-mode task has an event, or
+//! is 0.  It should return quickly; it suits polled background work.
+//!
+//! \return Does not return.
+//
+//*****************************************************************************
+void
+SchedRun(void (*pfnIdle)(void))
+{
+    while(1)
+    {
+        if(!SchedRunOne() && pfnIdle)
+        {
+            pfnIdle();
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Runs the deferred tasks.
+//!
+//! Install as the PendSV handler.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+SchedPendSVHandler(void)
+{
+    while(SchedDispatch(g_ui32DeferredMask))
+    {
+    }
+}
+
+//*****************************************************************************
+//
+//! Prints the task statistics.
+//!
+//! Cycles are measured around each handler call and include any interrupts
+//! (and, for thread-mode tasks, deferred tasks) that preempted it.  Each
+//! task's run count and cycles are read as one snapshot, so the average is
+//! not skewed by a deferred task finishing in between; call from thread
+//! mode, which deferred tasks preempt.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+SchedReport(void)
+{
+    tSchedTask *psTask;
+    uint32_t ui32Idx, ui32Seq, ui32Runs, ui32Cycles, ui32MaxCycles;
+
+    UARTprintf("Scheduler: %d tasks, the first %d run from PendSV\n",
+               g_ui32NumTasks, g_ui32NumDeferred);
+    UARTprintf("  Task          events   lost  max q  avg cyc  max cyc\n");
+
+    for(ui32Idx = 0; ui32Idx < g_ui32NumTasks; ui32Idx++)
+    {
+        psTask = &g_psTasks[ui32Idx];
+        do
+        {
+            ui32Seq = SeqLockReadBegin(&psTask->sStats);
+            ui32Runs = psTask->ui32Runs;
+            ui32Cycles = psTask->ui32Cycles;
+            ui32MaxCycles = psTask->ui32MaxCycles;
+        }
+        while(SeqLockReadRetry(&psTask->sStats, ui32Seq));
+
+        UARTprintf("  %12s %7d %6d %6d %8d %8d\n", psTask->pcName,
+                   psTask->ui32Posted, psTask->ui32Lost, psTask->ui32MaxQueued,
+                   ui32Runs ? (ui32Cycles / ui32Runs) : 0, ui32MaxCycles);
+    }
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
@@ -0,0 +1,77 @@
+//*****************************************************************************
+//
+// sched.h - Run-to-completion task scheduler with event queues.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_SCHED_H__
+#define __UTILS_SCHED_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The most tasks a scheduler takes (one bit each in the ready set).
+//
+//*****************************************************************************
+#define SCHED_MAX_TASKS         32
+
+//*****************************************************************************
+//
+// A task: a handler that runs to completion once for each event posted to
+// it, from its own lock-free queue of ui32Depth events (a power of two).
+// Tasks are held in an array in priority order, highest first.  The
+// application sets the first five members; the rest are private to sched.c.
+//
+//*****************************************************************************
+typedef struct
+{
+    const char *pcName;
+    void (*pfnHandler)(void *pvState, uint32_t ui32Event);
+    void *pvState;
+    tLFSlot *psSlots;
+    uint32_t ui32Depth;
+
+    tMPSCQueue sQueue;
+    volatile uint32_t ui32Posted;
+    volatile uint32_t ui32Lost; // events refused because the queue was full
+    volatile uint32_t ui32MaxQueued;
+    tSeqLock sStats;            // guards the three run statistics below
+    volatile uint32_t ui32Runs;
+    volatile uint32_t ui32Cycles;
+    volatile uint32_t ui32MaxCycles;
+}
+tSchedTask;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void SchedInit(tSchedTask *psTasks, uint32_t ui32Count,
+                      uint32_t ui32Deferred);
+extern bool SchedPost(tSchedTask *psTask, uint32_t ui32Event);
+extern bool SchedRunOne(void);
+extern void SchedRun(void (*pfnIdle)(void));
+extern void SchedPendSVHandler(void);
+extern void SchedReport(void);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_SCHED_H__
@@ -0,0 +1,440 @@
+//*****************************************************************************
+//
+// sdspi.c - SD card block device in SPI mode.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "utils/ssidma.h"
+#include "utils/blockdev.h"
+#include "utils/sdspi.h"
+
+//*****************************************************************************
+//
+//! \addtogroup sdspi_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Commands used (SD Physical Layer Simplified Specification, SPI mode).
+//
+//*****************************************************************************
+#define SD_CMD_GO_IDLE          0
+#define SD_CMD_SEND_IF_COND     8
+#define SD_CMD_SEND_CSD         9
+#define SD_CMD_SET_BLOCKLEN     16
+#define SD_CMD_READ_BLOCK       17
+#define SD_CMD_WRITE_BLOCK      24
+#define SD_CMD_APP              55
+#define SD_CMD_READ_OCR         58
+#define SD_ACMD_SEND_OP_COND    41
+
+//*****************************************************************************
+//
+// Responses and tokens.
+//
+//*****************************************************************************
+#define SD_R1_IDLE              0x01
+#define SD_R1_ILLEGAL           0x04
+#define SD_TOKEN_DATA           0xFE
+#define SD_DATA_ACCEPTED        0x05
+#define SD_OCR_CCS              0x40    // in the first OCR byte
+
+//*****************************************************************************
+//
+// Limits, in bytes clocked while waiting (or ACMD41 attempts during
+// identification, about a second at SD_CLOCK_INIT).
+//
+//*****************************************************************************
+#define SD_READY_BYTES          50000
+#define SD_TOKEN_BYTES          50000
+#define SD_INIT_TRIES           2500
+#define SD_WRITE_POLLS          1000000
+
+//*****************************************************************************
+//
+// Progress of a write.
+//
+//*****************************************************************************
+#define SD_STATE_IDLE           0
+#define SD_STATE_DATA           1   // block going out by uDMA
+#define SD_STATE_BUSY           2   // card programming the block
+#define SD_STATE_ERROR          3   // failed; reported by the next poll
+
+//*****************************************************************************
+//
+// Releases the card: chip select high, then one byte so it lets go of MISO.
+//
+//*****************************************************************************
+static void
+SDDeselect(tSDCard *psCard)
+{
+    SSIDMASelect(psCard->psSSI, false);
+    SSIDMAByte(psCard->psSSI, 0xFF);
+}
+
+//*****************************************************************************
+//
+// Selects the card and sends a command, returning the R1 response (bit 7
+// set if there was none).  The card stays selected.
+//
+//*****************************************************************************
+static uint8_t
+SDCommand(tSDCard *psCard, uint8_t ui8Cmd, uint32_t ui32Arg)
+{
+    uint32_t ui32Count;
+    uint8_t ui8R1;
+
+    SSIDMASelect(psCard->psSSI, true);
+    for(ui32Count = 0; (ui32Count < SD_READY_BYTES) &&
+                       (SSIDMAByte(psCard->psSSI, 0xFF) != 0xFF); ui32Count++)
+    {
+    }
+
+    SSIDMAByte(psCard->psSSI, 0x40 | ui8Cmd);
+    SSIDMAByte(psCard->psSSI, ui32Arg >> 24);
+    SSIDMAByte(psCard->psSSI, ui32Arg >> 16);
+    SSIDMAByte(psCard->psSSI, ui32Arg >> 8);
+    SSIDMAByte(psCard->psSSI, ui32Arg);
+
+    //
+    // Only CMD0 and CMD8 are checked for a CRC in SPI mode.
+    //
+    SSIDMAByte(psCard->psSSI, (ui8Cmd == SD_CMD_GO_IDLE) ? 0x95 :
+                              (ui8Cmd == SD_CMD_SEND_IF_COND) ? 0x87 : 0x01);
+
+    for(ui32Count = 0; ui32Count < 10; ui32Count++)
+    {
+        ui8R1 = SSIDMAByte(psCard->psSSI, 0xFF);
+        if(!(ui8R1 & 0x80))
+        {
+            break;
+        }
+    }
+
+    return(ui8R1);
+}
+
+//*****************************************************************************
+//
+// Reads a data block following a command: waits for the start token, then
+// lets the uDMA take the data.
+//
+//*****************************************************************************
+static bool
+SDReadData(tSDCard *psCard, void *pvData, uint32_t ui32Len)
+{
+    uint32_t ui32Count;
+
+    for(ui32Count = 0; SSIDMAByte(psCard->psSSI, 0xFF) != SD_TOKEN_DATA;
+        ui32Count++)
+    {
+        if(ui32Count == SD_TOKEN_BYTES)
+        {
+            return(false);
+        }
+    }
+
+    SSIDMAStart(psCard->psSSI, 0, pvData, ui32Len);
+    while(SSIDMABusy(psCard->psSSI))
+    {
+    }
+
+    SSIDMAByte(psCard->psSSI, 0xFF);    // CRC, not checked
+    SSIDMAByte(psCard->psSSI, 0xFF);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Identifies an SD card and prepares it for block transfers.
+//!
+//! \param psCard is the card.
+//! \param psSSI is the bus it is on, its pins already configured.
+//! \param psDev receives the block device interface of the card.
+//!
+//! Follows the SPI-mode start-up: CMD0, CMD8 to tell version 2 cards, ACMD41
+//! until the card is ready, CMD58 for the addressing mode and CMD9 for the
+//! capacity, all at \b SD_CLOCK_INIT, then switches to \b SD_CLOCK_FAST.
+//! Without a card this gives up within a few milliseconds.
+//!
+//! \return Returns \b true if a card was found.
+//
+//*****************************************************************************
+bool
+SDCardInit(tSDCard *psCard, const tSSIDMA *psSSI, tBlockDevice *psDev)
+{
+    uint8_t pui8Buf[16];
+    uint32_t ui32Count, ui32Size;
+    uint8_t ui8R1;
+    bool bV2;
+
+    psCard->psSSI = psSSI;
+    psCard->bBlockAddressed = false;
+    psCard->ui32State = SD_STATE_IDLE;
+    SSIDMAInit(psSSI, SD_CLOCK_INIT);
+
+    //
+    // At least 74 clocks with the card deselected, then reset it into SPI
+    // mode.
+    //
+    for(ui32Count = 0; ui32Count < 10; ui32Count++)
+    {
+        SSIDMAByte(psSSI, 0xFF);
+    }
+    for(ui32Count = 0; ui32Count < 10; ui32Count++)
+    {
+        ui8R1 = SDCommand(psCard, SD_CMD_GO_IDLE, 0);
+        SDDeselect(psCard);
+        if(ui8R1 == SD_R1_IDLE)
+        {
+            break;
+        }
+    }
+    if(ui8R1 != SD_R1_IDLE)
+    {
+        return(false);
+    }
+
+    //
+    // Version 2 cards echo the check pattern; older ones reject CMD8.
+    //
+    ui8R1 = SDCommand(psCard, SD_CMD_SEND_IF_COND, 0x1AA);
+    bV2 = false;
+    if(ui8R1 == SD_R1_IDLE)
+    {
+        for(ui32Count = 0; ui32Count < 4; ui32Count++)
+        {
+            pui8Buf[ui32Count] = SSIDMAByte(psSSI, 0xFF);
+        }
+        if(((pui8Buf[2] & 0x0F) != 0x01) || (pui8Buf[3] != 0xAA))
+        {
+            SDDeselect(psCard);
+            return(false);
+        }
+        bV2 = true;
+    }
+    else if(!(ui8R1 & SD_R1_ILLEGAL))
+    {
+        SDDeselect(psCard);
+        return(false);
+    }
+    SDDeselect(psCard);
+
+    for(ui32Count = 0; ui32Count < SD_INIT_TRIES; ui32Count++)
+    {
+        SDCommand(psCard, SD_CMD_APP, 0);
+        SDDeselect(psCard);
+        ui8R1 = SDCommand(psCard, SD_ACMD_SEND_OP_COND, bV2 ? 0x40000000 : 0);
+        SDDeselect(psCard);
+        if(ui8R1 == 0)
+        {
+            break;
+        }
+    }
+    if(ui8R1 != 0)
+    {
+        return(false);
+    }
+
+    if(bV2)
+    {
+        if(SDCommand(psCard, SD_CMD_READ_OCR, 0) == 0)
+        {
+            for(ui32Count = 0; ui32Count < 4; ui32Count++)
+            {
+                pui8Buf[ui32Count] = SSIDMAByte(psSSI, 0xFF);
+            }
+            psCard->bBlockAddressed = (pui8Buf[0] & SD_OCR_CCS) != 0;
+        }
+        SDDeselect(psCard);
+    }
+
+    if(!psCard->bBlockAddressed)
+    {
+        SDCommand(psCard, SD_CMD_SET_BLOCKLEN, BLOCKDEV_BLOCK_SIZE);
+        SDDeselect(psCard);
+    }
+
+    //
+    // Capacity from the CSD register, version 2 (SDHC/SDXC) or version 1.
+    //
+    if((SDCommand(psCard, SD_CMD_SEND_CSD, 0) != 0) ||
+       !SDReadData(psCard, pui8Buf, 16))
+    {
+        SDDeselect(psCard);
+        return(false);
+    }
+    SDDeselect(psCard);
+
+    if((pui8Buf[0] >> 6) == 1)
+    {
+        ui32Size = ((pui8Buf[7] & 0x3F) << 16) | (pui8Buf[8] << 8) | pui8Buf[9];
+        psDev->ui32Blocks = (ui32Size + 1) * 1024;
+    }
+    else
+    {
+        ui32Size = ((pui8Buf[6] & 0x03) << 10) | (pui8Buf[7] << 2) |
+                   (pui8Buf[8] >> 6);
+        psDev->ui32Blocks = (ui32Size + 1) <<
+                            ((((pui8Buf[9] & 0x03) << 1) | (pui8Buf[10] >> 7)) +
+                             2 + (pui8Buf[5] & 0x0F) - 9);
+    }
+
+    SSIDMAClockSet(psSSI, SD_CLOCK_FAST);
+
+    psDev->pvInst = psCard;
+    psDev->pfnRead = SDCardRead;
+    psDev->pfnWriteStart = SDCardWriteStart;
+    psDev->pfnWritePoll = SDCardWritePoll;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Reads a block (tBlockDevice pfnRead).
+//!
+//! \param pvInst is the card.
+//! \param ui32Block is the block number.
+//! \param pvData receives the 512 bytes.
+//!
+//! Waits for the data, which the uDMA moves.  Fails while a write is in
+//! progress.
+//!
+//! \return Returns \b true if the block was read.
+//
+//*****************************************************************************
+bool
+SDCardRead(void *pvInst, uint32_t ui32Block, void *pvData)
+{
+    tSDCard *psCard = pvInst;
+    bool bOK;
+
+    if(psCard->ui32State != SD_STATE_IDLE)
+    {
+        return(false);
+    }
+
+    bOK = (SDCommand(psCard, SD_CMD_READ_BLOCK, psCard->bBlockAddressed ?
+                     ui32Block : (ui32Block * BLOCKDEV_BLOCK_SIZE)) == 0) &&
+          SDReadData(psCard, pvData, BLOCKDEV_BLOCK_SIZE);
+    SDDeselect(psCard);
+
+    return(bOK);
+}
+
+//*****************************************************************************
+//
+//! Starts writing a block (tBlockDevice pfnWriteStart).
+//!
+//! \param pvInst is the card.
+//! \param ui32Block is the block number.
+//! \param pvData is the 512 bytes to write.
+//!
+//! Sends the command and start token, then leaves the data to the uDMA.
+//!
+//! \return Returns \b false if a write is already in progress or the card
+//! rejects the command.
+//
+//*****************************************************************************
+bool
+SDCardWriteStart(void *pvInst, uint32_t ui32Block, const void *pvData)
+{
+    tSDCard *psCard = pvInst;
+
+    if((psCard->ui32State == SD_STATE_DATA) ||
+       (psCard->ui32State == SD_STATE_BUSY))
+    {
+        return(false);
+    }
+
+    if(SDCommand(psCard, SD_CMD_WRITE_BLOCK, psCard->bBlockAddressed ?
+                 ui32Block : (ui32Block * BLOCKDEV_BLOCK_SIZE)) != 0)
+    {
+        SDDeselect(psCard);
+        return(false);
+    }
+
+    SSIDMAByte(psCard->psSSI, 0xFF);
+    SSIDMAByte(psCard->psSSI, SD_TOKEN_DATA);
+    SSIDMAStart(psCard->psSSI, pvData, 0, BLOCKDEV_BLOCK_SIZE);
+    psCard->ui32State = SD_STATE_DATA;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Advances a write (tBlockDevice pfnWritePoll).
+//!
+//! \param pvInst is the card.
+//!
+//! Once the uDMA has sent the data, the CRC is clocked out and the card's
+//! data response read; after that each call clocks one byte to see whether
+//! the card has finished programming, so no call waits long.
+//!
+//! \return Returns one of the \b BLOCKDEV_ values.
+//
+//*****************************************************************************
+uint32_t
+SDCardWritePoll(void *pvInst)
+{
+    tSDCard *psCard = pvInst;
+
+    switch(psCard->ui32State)
+    {
+        case SD_STATE_DATA:
+        {
+            if(SSIDMABusy(psCard->psSSI))
+            {
+                return(BLOCKDEV_BUSY);
+            }
+
+            SSIDMAByte(psCard->psSSI, 0xFF);    // CRC, ignored in SPI mode
+            SSIDMAByte(psCard->psSSI, 0xFF);
+            if((SSIDMAByte(psCard->psSSI, 0xFF) & 0x1F) != SD_DATA_ACCEPTED)
+            {
+                SDDeselect(psCard);
+                psCard->ui32State = SD_STATE_IDLE;
+                return(BLOCKDEV_ERROR);
+            }
+            psCard->ui32State = SD_STATE_BUSY;
+            psCard->ui32Polls = 0;
+            return(BLOCKDEV_BUSY);
+        }
+
+        case SD_STATE_BUSY:
+        {
+            if(SSIDMAByte(psCard->psSSI, 0xFF) != 0xFF)
+            {
+                if(++psCard->ui32Polls < SD_WRITE_POLLS)
+                {
+                    return(BLOCKDEV_BUSY);
+                }
+                SDDeselect(psCard);
+                psCard->ui32State = SD_STATE_IDLE;
+                return(BLOCKDEV_ERROR);
+            }
+            SDDeselect(psCard);
+            psCard->ui32State = SD_STATE_IDLE;
+            return(BLOCKDEV_DONE);
+        }
+
+        default:
+        {
+            return(BLOCKDEV_DONE);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
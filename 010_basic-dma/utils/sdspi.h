@@ -0,0 +1,65 @@
+//*****************************************************************************
+//
+// sdspi.h - SD card block device in SPI mode.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_SDSPI_H__
+#define __UTILS_SDSPI_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// SPI clock while the card is identified, and afterwards (at most half the
+// system clock; SD cards take up to 25 MHz).
+//
+//*****************************************************************************
+#define SD_CLOCK_INIT           400000
+#define SD_CLOCK_FAST           20000000
+
+//*****************************************************************************
+//
+// A card.  The members are private to sdspi.c.
+//
+//*****************************************************************************
+typedef struct
+{
+    const tSSIDMA *psSSI;
+    bool bBlockAddressed;       // SDHC/SDXC: commands take block numbers
+    uint32_t ui32State;         // progress of the current write
+    uint32_t ui32Polls;         // busy polls of the current write
+}
+tSDCard;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern bool SDCardInit(tSDCard *psCard, const tSSIDMA *psSSI,
+                       tBlockDevice *psDev);
+extern bool SDCardRead(void *pvInst, uint32_t ui32Block, void *pvData);
+extern bool SDCardWriteStart(void *pvInst, uint32_t ui32Block,
+                             const void *pvData);
+extern uint32_t SDCardWritePoll(void *pvInst);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_SDSPI_H__
@@ -0,0 +1,227 @@
+//*****************************************************************************
+//
+// seqlock.c - Sequence locks for publishing multi-word values from handlers.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_types.h"
+#include "utils/cyclecount.h"
+#include "utils/seqlock.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup seqlock_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// How many times SeqLockRead() copies the value before giving up.  Each
+// retry means a write landed during the copy; only a reader that preempted
+// the writer mid-update sees every copy fail.
+//
+//*****************************************************************************
+#define SEQLOCK_READ_TRIES      8
+
+//*****************************************************************************
+//
+// Value size and rounds used by SeqLockBenchmark().
+//
+//*****************************************************************************
+#define SEQLOCK_BENCH_WORDS     4
+#define SEQLOCK_BENCH_ROUNDS    64
+
+//*****************************************************************************
+//
+//! Starts an update of the guarded value.
+//!
+//! \param psLock is the lock.
+//!
+//! A lock has a single writer: one interrupt handler, or one task, or
+//! several that never preempt each other.  Writers never wait, whatever the
+//! readers are doing.  The value's words must be volatile so that the
+//! compiler keeps their stores between this call and SeqLockWriteEnd(); the
+//! Cortex-M4 core itself makes its stores visible to the code it interrupts
+//! in program order, so no barrier is needed.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+SeqLockWriteBegin(tSeqLock *psLock)
+{
+    psLock->ui32Seq++;
+}
+
+//*****************************************************************************
+//
+//! Finishes an update of the guarded value.
+//!
+//! \param psLock is the lock.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+SeqLockWriteEnd(tSeqLock *psLock)
+{
+    psLock->ui32Seq++;
+}
+
+//*****************************************************************************
+//
+//! Starts a read of the guarded value.
+//!
+//! \param psLock is the lock.
+//!
+//! The reader copies the value's words, then calls SeqLockReadRetry() with
+//! the count returned here and copies them again if it says so.  Nothing is
+//! masked and the writer is never held up.  A reader that can preempt the
+//! writer must bound its retries, because the writer cannot finish until the
+//! reader returns; SeqLockRead() does.
+//!
+//! \return Returns the count to give to SeqLockReadRetry().
+//
+//*****************************************************************************
+uint32_t
+SeqLockReadBegin(tSeqLock *psLock)
+{
+    return(psLock->ui32Seq);
+}
+
+//*****************************************************************************
+//
+//! Tells whether a read of the guarded value must be repeated.
+//!
+//! \param psLock is the lock.
+//! \param ui32Seq is the count returned by SeqLockReadBegin().
+//!
+//! \return Returns \b true if an update was under way when the read began
+//! or happened during it, so the copy may mix old and new words.
+//
+//*****************************************************************************
+bool
+SeqLockReadRetry(tSeqLock *psLock, uint32_t ui32Seq)
+{
+    return((ui32Seq & 1) || (psLock->ui32Seq != ui32Seq));
+}
+
+//*****************************************************************************
+//
+//! Publishes a new value of several words.
+//!
+//! \param psLock is the lock guarding the value.
+//! \param pui32Value is the published value.
+//! \param pui32New is the new value.
+//! \param ui32Words is the number of words in the value.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+SeqLockPublish(tSeqLock *psLock, volatile uint32_t *pui32Value,
+               const uint32_t *pui32New, uint32_t ui32Words)
+{
+    uint32_t ui32Idx;
+
+    SeqLockWriteBegin(psLock);
+    for(ui32Idx = 0; ui32Idx < ui32Words; ui32Idx++)
+    {
+        pui32Value[ui32Idx] = pui32New[ui32Idx];
+    }
+    SeqLockWriteEnd(psLock);
+}
+
+//*****************************************************************************
+//
+//! Copies the latest value of several words.
+//!
+//! \param psLock is the lock guarding the value.
+//! \param pui32Value is the published value.
+//! \param pui32Copy receives the copy.
+//! \param ui32Words is the number of words in the value.
+//!
+//! The copy is all of one update, never part old and part new.
+//!
+//! \return Returns \b false if no consistent copy was made in
+//! \b SEQLOCK_READ_TRIES attempts; \e pui32Copy then holds the last, torn,
+//! attempt.
+//
+//*****************************************************************************
+bool
+SeqLockRead(tSeqLock *psLock, const volatile uint32_t *pui32Value,
+            uint32_t *pui32Copy, uint32_t ui32Words)
+{
+    uint32_t ui32Try, ui32Idx, ui32Seq;
+
+    for(ui32Try = 0; ui32Try < SEQLOCK_READ_TRIES; ui32Try++)
+    {
+        ui32Seq = SeqLockReadBegin(psLock);
+        for(ui32Idx = 0; ui32Idx < ui32Words; ui32Idx++)
+        {
+            pui32Copy[ui32Idx] = pui32Value[ui32Idx];
+        }
+        if(!SeqLockReadRetry(psLock, ui32Seq))
+        {
+            return(true);
+        }
+    }
+
+    return(false);
+}
+
+//*****************************************************************************
+//
+//! Prints the cycles taken to publish and to read a value.
+//!
+//! Timed with no writer running during the reads, so a read is the best
+//! case; each update that lands during a read costs another copy.  The
+//! cycle counter must be running.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+SeqLockBenchmark(void)
+{
+    static volatile uint32_t pui32Value[SEQLOCK_BENCH_WORDS];
+    tSeqLock sLock;
+    uint32_t pui32New[SEQLOCK_BENCH_WORDS], pui32Copy[SEQLOCK_BENCH_WORDS];
+    uint32_t ui32Round, ui32Start, ui32Publish, ui32Read;
+
+    sLock.ui32Seq = 0;
+    for(ui32Round = 0; ui32Round < SEQLOCK_BENCH_WORDS; ui32Round++)
+    {
+        pui32New[ui32Round] = ui32Round;
+    }
+
+    ui32Start = CycleCountGet();
+    for(ui32Round = 0; ui32Round < SEQLOCK_BENCH_ROUNDS; ui32Round++)
+    {
+        SeqLockPublish(&sLock, pui32Value, pui32New, SEQLOCK_BENCH_WORDS);
+    }
+    ui32Publish = CycleCountGet() - ui32Start;
+
+    ui32Start = CycleCountGet();
+    for(ui32Round = 0; ui32Round < SEQLOCK_BENCH_ROUNDS; ui32Round++)
+    {
+        SeqLockRead(&sLock, pui32Value, pui32Copy, SEQLOCK_BENCH_WORDS);
+    }
+    ui32Read = CycleCountGet() - ui32Start;
+
+    UARTprintf("Seqlock (cycles per %d-word value, with loop): publish %d, "
+               "read %d\n", SEQLOCK_BENCH_WORDS,
+               ui32Publish / SEQLOCK_BENCH_ROUNDS,
+               ui32Read / SEQLOCK_BENCH_ROUNDS);
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
@@ -0,0 +1,57 @@
+//*****************************************************************************
+//
+// seqlock.h - Sequence locks for publishing multi-word values from handlers.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_SEQLOCK_H__
+#define __UTILS_SEQLOCK_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// A sequence lock guarding a value of several words.  The count is odd while
+// the writer is updating the value.  Zero-initialised is ready for use.
+//
+//*****************************************************************************
+typedef struct
+{
+    volatile uint32_t ui32Seq;
+}
+tSeqLock;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void SeqLockWriteBegin(tSeqLock *psLock);
+extern void SeqLockWriteEnd(tSeqLock *psLock);
+extern uint32_t SeqLockReadBegin(tSeqLock *psLock);
+extern bool SeqLockReadRetry(tSeqLock *psLock, uint32_t ui32Seq);
+extern void SeqLockPublish(tSeqLock *psLock, volatile uint32_t *pui32Value,
+                           const uint32_t *pui32New, uint32_t ui32Words);
+extern bool SeqLockRead(tSeqLock *psLock, const volatile uint32_t *pui32Value,
+                        uint32_t *pui32Copy, uint32_t ui32Words);
+extern void SeqLockBenchmark(void);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_SEQLOCK_H__
@@ -0,0 +1,344 @@
+//*****************************************************************************
+//
+// shell.c - Non-blocking command shell on the buffered UART console.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "utils/shell.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup shell_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// The command table and prompt given to ShellInit().
+//
+//*****************************************************************************
+static const tShellCommand *g_psCommands;
+static const char *g_pcPrompt;
+
+//*****************************************************************************
+//
+// The line being edited.
+//
+//*****************************************************************************
+static char g_pcLine[SHELL_MAX_LINE];
+static uint32_t g_ui32LineLen;
+static bool g_bLastWasCR;
+
+//*****************************************************************************
+//
+// Prints the prompt followed by the line typed so far.
+//
+//*****************************************************************************
+static void
+ShellRedraw(void)
+{
+    UARTwrite(g_pcPrompt, strlen(g_pcPrompt));
+    UARTwrite(g_pcLine, g_ui32LineLen);
+}
+
+//*****************************************************************************
+//
+// Splits the line into arguments and runs the matching command.
+//
+//*****************************************************************************
+static void
+ShellExecute(void)
+{
+    const tShellCommand *psCmd;
+    char *ppcArgv[SHELL_MAX_ARGS + 1];
+    char *pcChar;
+    int iArgc, iResult;
+    bool bInArg;
+
+    g_pcLine[g_ui32LineLen] = 0;
+    iArgc = 0;
+    bInArg = false;
+    for(pcChar = g_pcLine; *pcChar; pcChar++)
+    {
+        if(*pcChar == ' ')
+        {
+            *pcChar = 0;
+            bInArg = false;
+        }
+        else if(!bInArg)
+        {
+            if(iArgc == SHELL_MAX_ARGS)
+            {
+                UARTprintf("Too many arguments\n");
+                return;
+            }
+            ppcArgv[iArgc++] = pcChar;
+            bInArg = true;
+        }
+    }
+    ppcArgv[iArgc] = 0;
+
+    if(iArgc == 0)
+    {
+        return;
+    }
+
+    for(psCmd = g_psCommands; psCmd->pcCmd; psCmd++)
+    {
+        if(!strcmp(ppcArgv[0], psCmd->pcCmd))
+        {
+            break;
+        }
+    }
+
+    if(!psCmd->pcCmd)
+    {
+        UARTprintf("Unknown command \"%s\", try help\n", ppcArgv[0]);
+        return;
+    }
+
+    iResult = psCmd->pfnCmd(iArgc, ppcArgv);
+    switch(iResult)
+    {
+        case SHELL_TOO_MANY_ARGS:
+        case SHELL_TOO_FEW_ARGS:
+        case SHELL_INVALID_ARG:
+        {
+            UARTprintf("Usage: %s%s\n", psCmd->pcCmd, psCmd->pcHelp);
+            break;
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Completes the command name being typed: a unique match is completed with a
+// trailing space, otherwise the line is extended to the longest common prefix
+// and, if that adds nothing, the candidates are listed.
+//
+//*****************************************************************************
+static void
+ShellComplete(void)
+{
+    const tShellCommand *psCmd, *psFirst;
+    uint32_t ui32Matches, ui32Common, ui32Idx;
+
+    //
+    // Only the command name (the first word) is completed.
+    //
+    for(ui32Idx = 0; ui32Idx < g_ui32LineLen; ui32Idx++)
+    {
+        if(g_pcLine[ui32Idx] == ' ')
+        {
+            return;
+        }
+    }
+
+    psFirst = 0;
+    ui32Matches = 0;
+    ui32Common = 0;
+    for(psCmd = g_psCommands; psCmd->pcCmd; psCmd++)
+    {
+        if(strncmp(psCmd->pcCmd, g_pcLine, g_ui32LineLen))
+        {
+            continue;
+        }
+
+        if(!psFirst)
+        {
+            psFirst = psCmd;
+            ui32Common = strlen(psCmd->pcCmd);
+        }
+        else
+        {
+            for(ui32Idx = g_ui32LineLen; (ui32Idx < ui32Common) &&
+                (psCmd->pcCmd[ui32Idx] == psFirst->pcCmd[ui32Idx]); ui32Idx++)
+            {
+            }
+            ui32Common = ui32Idx;
+        }
+        ui32Matches++;
+    }
+
+    if(ui32Matches == 0)
+    {
+        return;
+    }
+
+    if((ui32Common > g_ui32LineLen) && (ui32Common < (SHELL_MAX_LINE - 1)))
+    {
+        UARTwrite(psFirst->pcCmd + g_ui32LineLen, ui32Common - g_ui32LineLen);
+        memcpy(g_pcLine + g_ui32LineLen, psFirst->pcCmd + g_ui32LineLen,
+               ui32Common - g_ui32LineLen);
+        g_ui32LineLen = ui32Common;
+        if(ui32Matches == 1)
+        {
+            g_pcLine[g_ui32LineLen++] = ' ';
+            UARTwrite(" ", 1);
+        }
+    }
+    else if(ui32Matches > 1)
+    {
+        UARTprintf("\n");
+        for(psCmd = g_psCommands; psCmd->pcCmd; psCmd++)
+        {
+            if(!strncmp(psCmd->pcCmd, g_pcLine, g_ui32LineLen))
+            {
+                UARTprintf("%s  ", psCmd->pcCmd);
+            }
+        }
+        UARTprintf("\n");
+        ShellRedraw();
+    }
+}
+
+//*****************************************************************************
+//
+//! Starts the shell.
+//!
+//! \param psCommands is the command table, ending with a zero entry.
+//! \param pcPrompt is the prompt printed before each line.
+//!
+//! uartstdio's own echo and line editing are turned off; the shell echoes and
+//! edits the line itself so that it can offer completion.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ShellInit(const tShellCommand *psCommands, const char *pcPrompt)
+{
+    g_psCommands = psCommands;
+    g_pcPrompt = pcPrompt;
+    g_ui32LineLen = 0;
+    g_bLastWasCR = false;
+
+    UARTEchoSet(false);
+    UARTFlushRx();
+    ShellRedraw();
+}
+
+//*****************************************************************************
+//
+//! Processes any characters received since the last call.
+//!
+//! Call this from the main loop.  It never waits for input: it handles what
+//! is in the receive buffer and returns, running a command when a line is
+//! complete.  Backspace, Ctrl-C (discard the line) and Tab (complete the
+//! command name) are supported.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+ShellPoll(void)
+{
+    unsigned char ucChar;
+
+    while(UARTRxBytesAvail())
+    {
+        ucChar = UARTgetc();
+
+        if((ucChar == '\r') || (ucChar == '\n'))
+        {
+            //
+            // Treat CR LF as a single line end.
+            //
+            if((ucChar == '\n') && g_bLastWasCR)
+            {
+                g_bLastWasCR = false;
+                continue;
+            }
+            g_bLastWasCR = (ucChar == '\r');
+
+            UARTprintf("\n");
+            ShellExecute();
+            g_ui32LineLen = 0;
+            ShellRedraw();
+            continue;
+        }
+        g_bLastWasCR = false;
+
+        if((ucChar == '\b') || (ucChar == 0x7f))
+        {
+            if(g_ui32LineLen)
+            {
+                g_ui32LineLen--;
+                UARTwrite("\b \b", 3);
+            }
+        }
+        else if(ucChar == '\t')
+        {
+            ShellComplete();
+        }
+        else if(ucChar == 0x03)
+        {
+            UARTprintf("^C\n");
+            g_ui32LineLen = 0;
+            ShellRedraw();
+        }
+        else if((ucChar >= ' ') && (ucChar < 0x7f) &&
+                (g_ui32LineLen < (SHELL_MAX_LINE - 1)))
+        {
+            g_pcLine[g_ui32LineLen++] = ucChar;
+            UARTwrite((char *)&ucChar, 1);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Tells whether a command line is being typed.
+//!
+//! The application can hold back periodic console output meanwhile so it does
+//! not break up the line being edited.
+//!
+//! \return Returns \b true if the current line is not empty.
+//
+//*****************************************************************************
+bool
+ShellLineActive(void)
+{
+    return(g_ui32LineLen != 0);
+}
+
+//*****************************************************************************
+//
+//! Lists the commands in the table; use it as the table's help command.
+//!
+//! \param argc is the number of arguments.
+//! \param argv holds the arguments.
+//!
+//! \return Returns 0.
+//
+//*****************************************************************************
+int
+ShellCmdHelp(int argc, char *argv[])
+{
+    const tShellCommand *psCmd;
+
+    UARTprintf("Commands:\n");
+    for(psCmd = g_psCommands; psCmd->pcCmd; psCmd++)
+    {
+        UARTprintf("  %s%s\n", psCmd->pcCmd, psCmd->pcHelp);
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
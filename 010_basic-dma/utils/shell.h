@@ -0,0 +1,74 @@
+//*****************************************************************************
+//
+// shell.h - Non-blocking command shell on the buffered UART console.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_SHELL_H__
+#define __UTILS_SHELL_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Limits of the command line.
+//
+//*****************************************************************************
+#define SHELL_MAX_LINE          64
+#define SHELL_MAX_ARGS          8
+
+//*****************************************************************************
+//
+// Values a command returns, in the same spirit as TivaWare's cmdline module.
+// Anything else (usually 0) means success.
+//
+//*****************************************************************************
+#define SHELL_BAD_CMD           (-1)
+#define SHELL_TOO_MANY_ARGS     (-2)
+#define SHELL_TOO_FEW_ARGS      (-3)
+#define SHELL_INVALID_ARG       (-4)
+
+//*****************************************************************************
+//
+// A command: its name, the function run with the parsed arguments (argv[0]
+// is the name) and a help string such as " <Hz>: set the sample rate".  A
+// command table ends with an entry whose pcCmd is 0.
+//
+//*****************************************************************************
+typedef struct
+{
+    const char *pcCmd;
+    int (*pfnCmd)(int argc, char *argv[]);
+    const char *pcHelp;
+}
+tShellCommand;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void ShellInit(const tShellCommand *psCommands, const char *pcPrompt);
+extern void ShellPoll(void);
+extern bool ShellLineActive(void);
+extern int ShellCmdHelp(int argc, char *argv[]);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_SHELL_H__
@@ -0,0 +1,212 @@
+//*****************************************************************************
+//
+// ssidma.c - SPI master transfers on an SSI module through the uDMA.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_ssi.h"
+#include "inc/hw_types.h"
+#include "driverlib/gpio.h"
+#include "driverlib/ssi.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/udma.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/dmamgr.h"
+#include "utils/ssidma.h"
+
+//*****************************************************************************
+//
+//! \addtogroup ssidma_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// What is sent when there is nothing to send (SD and most SPI memories
+// expect ones), and where unwanted receive data goes.
+//
+//*****************************************************************************
+static const uint8_t g_ui8Idle = 0xFF;
+static uint8_t g_ui8Discard;
+
+//*****************************************************************************
+//
+//! Configures an SSI module as an 8-bit, mode 0 SPI master.
+//!
+//! \param psSSI is the bus.
+//! \param ui32BitRate is the initial clock rate, for example 400 kHz while
+//! an SD card is identified.
+//!
+//! The chip select is driven high (deselected).  The uDMA controller must
+//! already be enabled with its control table set.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+SSIDMAInit(const tSSIDMA *psSSI, uint32_t ui32BitRate)
+{
+    MAP_GPIOPinTypeGPIOOutput(psSSI->ui32CSPort, psSSI->ui8CSPin);
+    SSIDMASelect(psSSI, false);
+
+    SSIDMAClockSet(psSSI, ui32BitRate);
+
+    MAP_uDMAChannelAttributeDisable(psSSI->ui32RxChannel,
+                                    UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST |
+                                    UDMA_ATTR_HIGH_PRIORITY |
+                                    UDMA_ATTR_REQMASK);
+    MAP_uDMAChannelAttributeDisable(psSSI->ui32TxChannel,
+                                    UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST |
+                                    UDMA_ATTR_HIGH_PRIORITY |
+                                    UDMA_ATTR_REQMASK);
+}
+
+//*****************************************************************************
+//
+//! Changes the clock rate.
+//!
+//! \param psSSI is the bus.
+//! \param ui32BitRate is the new rate, at most half the system clock.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+SSIDMAClockSet(const tSSIDMA *psSSI, uint32_t ui32BitRate)
+{
+    uint32_t ui32Data;
+
+    MAP_SSIDisable(psSSI->ui32Base);
+    MAP_SSIConfigSetExpClk(psSSI->ui32Base, MAP_SysCtlClockGet(),
+                           SSI_FRF_MOTO_MODE_0, SSI_MODE_MASTER, ui32BitRate,
+                           8);
+    MAP_SSIEnable(psSSI->ui32Base);
+
+    while(MAP_SSIDataGetNonBlocking(psSSI->ui32Base, &ui32Data))
+    {
+    }
+}
+
+//*****************************************************************************
+//
+//! Drives the chip select.
+//!
+//! \param psSSI is the bus.
+//! \param bSelect is \b true to select the device (chip select low).
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+SSIDMASelect(const tSSIDMA *psSSI, bool bSelect)
+{
+    MAP_GPIOPinWrite(psSSI->ui32CSPort, psSSI->ui8CSPin,
+                     bSelect ? 0 : psSSI->ui8CSPin);
+}
+
+//*****************************************************************************
+//
+//! Exchanges one byte, waiting for it.
+//!
+//! \param psSSI is the bus.
+//! \param ui8Out is the byte to send.
+//!
+//! For command bytes and polling; must not be called during SSIDMAStart().
+//!
+//! \return Returns the byte received.
+//
+//*****************************************************************************
+uint8_t
+SSIDMAByte(const tSSIDMA *psSSI, uint8_t ui8Out)
+{
+    uint32_t ui32In;
+
+    MAP_SSIDataPut(psSSI->ui32Base, ui8Out);
+    MAP_SSIDataGet(psSSI->ui32Base, &ui32In);
+
+    return(ui32In & 0xFF);
+}
+
+//*****************************************************************************
+//
+//! Starts a full-duplex transfer by uDMA.
+//!
+//! \param psSSI is the bus.
+//! \param pvTx is the data to send, or 0 to send 0xFF bytes.
+//! \param pvRx receives the data, or is 0 to discard it.
+//! \param ui32Count is the number of bytes, at most \b SSIDMA_MAX_TRANSFER.
+//!
+//! Both directions run as uDMA transfers in bursts of four, the SSI FIFO
+//! half level; the CPU is free until SSIDMABusy() returns \b false.  The
+//! chip select is left alone.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+SSIDMAStart(const tSSIDMA *psSSI, const void *pvTx, void *pvRx,
+            uint32_t ui32Count)
+{
+    MAP_uDMAChannelControlSet(psSSI->ui32RxChannel | UDMA_PRI_SELECT,
+                              UDMA_SIZE_8 | UDMA_SRC_INC_NONE |
+                              (pvRx ? UDMA_DST_INC_8 : UDMA_DST_INC_NONE) |
+                              UDMA_ARB_4);
+    DMAMgrTransferSet(psSSI->ui32RxChannel | UDMA_PRI_SELECT,
+                      UDMA_MODE_BASIC,
+                      (void *)(psSSI->ui32Base + SSI_O_DR),
+                      pvRx ? pvRx : &g_ui8Discard, ui32Count);
+
+    MAP_uDMAChannelControlSet(psSSI->ui32TxChannel | UDMA_PRI_SELECT,
+                              UDMA_SIZE_8 |
+                              (pvTx ? UDMA_SRC_INC_8 : UDMA_SRC_INC_NONE) |
+                              UDMA_DST_INC_NONE | UDMA_ARB_4);
+    DMAMgrTransferSet(psSSI->ui32TxChannel | UDMA_PRI_SELECT,
+                      UDMA_MODE_BASIC,
+                      pvTx ? (void *)pvTx : (void *)&g_ui8Idle,
+                      (void *)(psSSI->ui32Base + SSI_O_DR),
+                      ui32Count);
+
+    //
+    // Receive first, so no byte can arrive before its channel is ready.
+    //
+    MAP_uDMAChannelEnable(psSSI->ui32RxChannel);
+    MAP_uDMAChannelEnable(psSSI->ui32TxChannel);
+    MAP_SSIDMAEnable(psSSI->ui32Base, SSI_DMA_RX | SSI_DMA_TX);
+}
+
+//*****************************************************************************
+//
+//! Tells whether a transfer started by SSIDMAStart() is still running.
+//!
+//! \param psSSI is the bus.
+//!
+//! The transfer is over when the receive channel has taken the last byte;
+//! the SSI's DMA requests are then turned off again so SSIDMAByte() can be
+//! used.
+//!
+//! \return Returns \b true while the transfer runs.
+//
+//*****************************************************************************
+bool
+SSIDMABusy(const tSSIDMA *psSSI)
+{
+    if(MAP_uDMAChannelIsEnabled(psSSI->ui32RxChannel))
+    {
+        return(true);
+    }
+
+    MAP_SSIDMADisable(psSSI->ui32Base, SSI_DMA_RX | SSI_DMA_TX);
+    return(false);
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
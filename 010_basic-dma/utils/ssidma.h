@@ -0,0 +1,69 @@
+//*****************************************************************************
+//
+// ssidma.h - SPI master transfers on an SSI module through the uDMA.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_SSIDMA_H__
+#define __UTILS_SSIDMA_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The longest transfer SSIDMAStart() takes, the uDMA's limit.
+//
+//*****************************************************************************
+#define SSIDMA_MAX_TRANSFER     1024
+
+//*****************************************************************************
+//
+// An SPI bus: the SSI module, its receive and transmit uDMA channels (for
+// example UDMA_CHANNEL_SSI0RX and UDMA_CHANNEL_SSI0TX, or 12 and 13 for SSI2
+// after uDMAChannelAssign()) and the GPIO driving the device's chip select,
+// which is held low across whole commands rather than toggled per frame.
+// The application enables the peripherals and configures the pins.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Base;
+    uint32_t ui32RxChannel;
+    uint32_t ui32TxChannel;
+    uint32_t ui32CSPort;
+    uint8_t ui8CSPin;
+}
+tSSIDMA;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void SSIDMAInit(const tSSIDMA *psSSI, uint32_t ui32BitRate);
+extern void SSIDMAClockSet(const tSSIDMA *psSSI, uint32_t ui32BitRate);
+extern void SSIDMASelect(const tSSIDMA *psSSI, bool bSelect);
+extern uint8_t SSIDMAByte(const tSSIDMA *psSSI, uint8_t ui8Out);
+extern void SSIDMAStart(const tSSIDMA *psSSI, const void *pvTx, void *pvRx,
+                        uint32_t ui32Count);
+extern bool SSIDMABusy(const tSSIDMA *psSSI);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_SSIDMA_H__
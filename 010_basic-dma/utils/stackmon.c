@@ -0,0 +1,247 @@
+//*****************************************************************************
+//
+// stackmon.c - Stack painting, high-water marks and MPU stack guards.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driverlib/mpu.h"
+#include "utils/stackmon.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup stackmon_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// Linker variables that mark the bottom and the top of the system stack.
+//
+//*****************************************************************************
+extern uint32_t __stack;
+extern uint32_t __STACK_TOP;
+
+//*****************************************************************************
+//
+// The system (main) stack, shared by main() and every interrupt handler.
+//
+//*****************************************************************************
+static tStackRegion g_sMainStack;
+
+//*****************************************************************************
+//
+// The deepest main stack use seen by StackMonitorSample() for each context.
+//
+//*****************************************************************************
+static uint32_t g_pui32ContextDepth[STACK_MAX_CONTEXTS];
+
+//*****************************************************************************
+//
+//! Paints the unused part of the system stack.
+//!
+//! Every word between the bottom of the stack and a little below the caller's
+//! frame is set to \b STACK_PAINT so that StackRegionHighWater() can later
+//! tell how deep the stack has ever been.  Call this as early in main() as
+//! possible.
+//!
+//! \return Returns the system stack region, for use with the other APIs.
+//
+//*****************************************************************************
+tStackRegion *
+StackMonitorInit(void)
+{
+    volatile uint32_t ui32Here;
+    uint32_t *pui32Word, *pui32Limit;
+
+    g_sMainStack.pui32Base = &__stack;
+    g_sMainStack.ui32Size = (uint32_t)&__STACK_TOP - (uint32_t)&__stack;
+    g_sMainStack.ui32GuardBytes = 0;
+
+    //
+    // Leave the live frames, plus a margin for this function's own, alone.
+    //
+    pui32Limit = (uint32_t *)&ui32Here - 16;
+    for(pui32Word = g_sMainStack.pui32Base; pui32Word < pui32Limit;
+        pui32Word++)
+    {
+        *pui32Word = STACK_PAINT;
+    }
+
+    return(&g_sMainStack);
+}
+
+//*****************************************************************************
+//
+//! Paints an entire stack that is not in use yet.
+//!
+//! \param psStack is the stack to paint (for example a thread stack).
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+StackRegionPaint(tStackRegion *psStack)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = psStack->ui32GuardBytes / 4; ui32Idx < psStack->ui32Size / 4;
+        ui32Idx++)
+    {
+        psStack->pui32Base[ui32Idx] = STACK_PAINT;
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns the deepest use of a painted stack so far.
+//!
+//! \param psStack is the stack to examine.
+//!
+//! The stack is scanned from its bottom (above any guard) for the first word
+//! that no longer holds the paint value.  The result can be one word short
+//! if that word happened to be written with \b STACK_PAINT itself.
+//!
+//! \return Returns the high-water mark in bytes.
+//
+//*****************************************************************************
+uint32_t
+StackRegionHighWater(const tStackRegion *psStack)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = psStack->ui32GuardBytes / 4; ui32Idx < psStack->ui32Size / 4;
+        ui32Idx++)
+    {
+        if(psStack->pui32Base[ui32Idx] != STACK_PAINT)
+        {
+            break;
+        }
+    }
+
+    return(psStack->ui32Size - (ui32Idx * 4));
+}
+
+//*****************************************************************************
+//
+//! Places a no-access MPU region at the bottom of a stack.
+//!
+//! \param psStack is the stack to protect.
+//! \param ui32MPURegion is the MPU region number to use.
+//!
+//! Any access to the lowest \b STACK_GUARD_BYTES (after rounding the base up
+//! to the MPU's 32-byte alignment) raises a MemManage fault, which is
+//! recorded by the fault handler, instead of the stack silently overwriting
+//! whatever lies below it.  The guarded bytes are no longer usable stack.
+//! The MPU is enabled with the default memory map as background, so nothing
+//! else is affected.
+//!
+//! \return Returns \b false if there is no MPU or the stack is too small.
+//
+//*****************************************************************************
+bool
+StackGuardEnable(tStackRegion *psStack, uint32_t ui32MPURegion)
+{
+    uint32_t ui32Base, ui32Guard;
+
+    ui32Base = ((uint32_t)psStack->pui32Base + STACK_GUARD_BYTES - 1) &
+               ~(STACK_GUARD_BYTES - 1);
+    ui32Guard = ui32Base + STACK_GUARD_BYTES - (uint32_t)psStack->pui32Base;
+
+    if((MPURegionCountGet() <= ui32MPURegion) ||
+       (ui32Guard >= psStack->ui32Size / 2))
+    {
+        return(false);
+    }
+
+    psStack->ui32GuardBytes = ui32Guard;
+    MPURegionSet(ui32MPURegion, ui32Base,
+                 (MPU_RGN_SIZE_32B | MPU_RGN_PERM_NOEXEC |
+                  MPU_RGN_PERM_PRV_NO_USR_NO | MPU_RGN_ENABLE));
+    MPUEnable(MPU_CONFIG_PRIV_DEFAULT);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Records how deep the system stack is at this point.
+//!
+//! \param ui32Context identifies the caller (for example one number per
+//! interrupt handler), up to \b STACK_MAX_CONTEXTS.
+//!
+//! Placed at the deepest point of a handler or loop, this attributes system
+//! stack use to the context responsible for it, which the overall high-water
+//! mark cannot do.  A sample taken on another stack (a thread's, once a
+//! kernel runs) is ignored.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+StackMonitorSample(uint32_t ui32Context)
+{
+    volatile uint32_t ui32Here;
+    uint32_t ui32Depth;
+
+    ui32Depth = (uint32_t)&__STACK_TOP - (uint32_t)&ui32Here;
+    if((ui32Context < STACK_MAX_CONTEXTS) &&
+       (ui32Depth <= g_sMainStack.ui32Size) &&
+       (ui32Depth > g_pui32ContextDepth[ui32Context]))
+    {
+        g_pui32ContextDepth[ui32Context] = ui32Depth;
+    }
+}
+
+//*****************************************************************************
+//
+//! Returns the deepest system stack use sampled for a context.
+//!
+//! \param ui32Context is the context number.
+//!
+//! \return Returns the depth in bytes, or 0 if never sampled.
+//
+//*****************************************************************************
+uint32_t
+StackMonitorDepth(uint32_t ui32Context)
+{
+    return((ui32Context < STACK_MAX_CONTEXTS) ?
+           g_pui32ContextDepth[ui32Context] : 0);
+}
+
+//*****************************************************************************
+//
+//! Prints the system stack high-water mark and per-context depths.
+//!
+//! \param ppcContextNames names the contexts, indexed by context number.
+//! \param ui32Contexts is the number of names.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+StackMonitorReport(const char * const *ppcContextNames, uint32_t ui32Contexts)
+{
+    uint32_t ui32Idx;
+
+    UARTprintf("Stack: %d of %d bytes used, %d byte guard\n",
+               StackRegionHighWater(&g_sMainStack), g_sMainStack.ui32Size,
+               g_sMainStack.ui32GuardBytes);
+
+    for(ui32Idx = 0; (ui32Idx < ui32Contexts) &&
+                     (ui32Idx < STACK_MAX_CONTEXTS); ui32Idx++)
+    {
+        UARTprintf("  %s: %d bytes deep\n", ppcContextNames[ui32Idx],
+                   g_pui32ContextDepth[ui32Idx]);
+    }
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
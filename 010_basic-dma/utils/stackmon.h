@@ -0,0 +1,88 @@
+//*****************************************************************************
+//
+// stackmon.h - Stack painting, high-water marks and MPU stack guards.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_STACKMON_H__
+#define __UTILS_STACKMON_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The value unused stack words are filled with.
+//
+//*****************************************************************************
+#define STACK_PAINT             0xA5A5A5A5
+
+//*****************************************************************************
+//
+// The size of an MPU stack guard.  32 bytes is the smallest MPU region.
+//
+//*****************************************************************************
+#define STACK_GUARD_BYTES       32
+
+//*****************************************************************************
+//
+// The MPU region used for the main stack guard.  The highest numbered region
+// takes precedence where regions overlap.
+//
+//*****************************************************************************
+#define STACK_GUARD_MPU_REGION  7
+
+//*****************************************************************************
+//
+// The number of contexts StackMonitorSample() can keep track of.
+//
+//*****************************************************************************
+#define STACK_MAX_CONTEXTS      8
+
+//*****************************************************************************
+//
+// A stack: the lowest address, its size and the number of bytes at the
+// bottom reserved as a guard (never painted or scanned once the guard is
+// active).
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t *pui32Base;
+    uint32_t ui32Size;
+    uint32_t ui32GuardBytes;
+}
+tStackRegion;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern tStackRegion *StackMonitorInit(void);
+extern void StackRegionPaint(tStackRegion *psStack);
+extern uint32_t StackRegionHighWater(const tStackRegion *psStack);
+extern bool StackGuardEnable(tStackRegion *psStack, uint32_t ui32MPURegion);
+extern void StackMonitorSample(uint32_t ui32Context);
+extern uint32_t StackMonitorDepth(uint32_t ui32Context);
+extern void StackMonitorReport(const char * const *ppcContextNames,
+                               uint32_t ui32Contexts);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_STACKMON_H__
@@ -0,0 +1,374 @@
+//*****************************************************************************
+//
+// telemetry.c - COBS framed binary telemetry over the console UART.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driverlib/debug.h"
+#include "utils/mempool.h"
+#include "utils/pipeline.h"
+#include "utils/telemetry.h"
+#include "utils/uartstdio.h"
+
+//*****************************************************************************
+//
+//! \addtogroup telemetry_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// CRC-16/CCITT-FALSE lookup table (polynomial 0x1021), one byte per step.
+//
+//*****************************************************************************
+static const uint16_t g_pui16CRCTable[256] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+//*****************************************************************************
+//
+// The frame being encoded.  TelemetrySend() builds each frame here, COBS
+// encoding on the fly, then queues it with a single UARTwriteBinary() call.
+//
+//*****************************************************************************
+static uint8_t g_pui8Frame[TELEM_ENCODED_SIZE(TELEM_MAX_PAYLOAD)];
+static uint32_t g_ui32FramePos;         // next free byte in g_pui8Frame
+static uint32_t g_ui32CodePos;          // where the current COBS code goes
+static uint8_t g_ui8Code;               // current COBS code (run length + 1)
+
+static tTelemetryStats g_sTelemetryStats;
+
+//*****************************************************************************
+//
+//! Updates a CRC-16/CCITT-FALSE.
+//!
+//! \param ui16CRC is the CRC so far (0xFFFF to start).
+//! \param pui8Data points to the data.
+//! \param ui32Len is the number of bytes.
+//!
+//! \return Returns the updated CRC.
+//
+//*****************************************************************************
+uint16_t
+TelemetryCRC16(uint16_t ui16CRC, const uint8_t *pui8Data, uint32_t ui32Len)
+{
+    while(ui32Len--)
+    {
+        ui16CRC = (ui16CRC << 8) ^
+                  g_pui16CRCTable[(ui16CRC >> 8) ^ *pui8Data++];
+    }
+
+    return(ui16CRC);
+}
+
+//*****************************************************************************
+//
+// Appends bytes to the frame, COBS encoding them: each run of up to 254
+// non-zero bytes is preceded by a code byte giving its length plus one, and
+// the zero bytes themselves are dropped.
+//
+//*****************************************************************************
+static void
+FrameAppend(const uint8_t *pui8Data, uint32_t ui32Len)
+{
+    uint32_t ui32Pos = g_ui32FramePos;
+    uint8_t ui8Code = g_ui8Code;
+
+    while(ui32Len--)
+    {
+        if(*pui8Data)
+        {
+            g_pui8Frame[ui32Pos++] = *pui8Data;
+            ui8Code++;
+        }
+
+        if((*pui8Data++ == 0) || (ui8Code == 0xFF))
+        {
+            g_pui8Frame[g_ui32CodePos] = ui8Code;
+            g_ui32CodePos = ui32Pos++;
+            ui8Code = 1;
+        }
+    }
+
+    g_ui32FramePos = ui32Pos;
+    g_ui8Code = ui8Code;
+}
+
+//*****************************************************************************
+//
+//! Sends one frame.
+//!
+//! \param ui8Type is the frame type, one of the \b TELEM_TYPE_ values.
+//! \param ui8Channel identifies the stream the frame belongs to.
+//! \param ui16Seq is the sequence number of the frame within its channel.
+//! \param pvPayload points to the payload.
+//! \param ui32Len is the payload length in bytes, up to
+//! \b TELEM_MAX_PAYLOAD.
+//!
+//! The frame is queued in the UART transmit buffer as a whole or not at all,
+//! so frames are never interleaved or truncated.
+//!
+//! \return Returns \b false if the transmit buffer does not have room for the
+//! frame yet.
+//
+//*****************************************************************************
+bool
+TelemetrySend(uint8_t ui8Type, uint8_t ui8Channel, uint16_t ui16Seq,
+              const void *pvPayload, uint32_t ui32Len)
+{
+    uint8_t pui8Header[4], pui8CRC[2];
+    uint16_t ui16CRC;
+
+    ASSERT(ui32Len <= TELEM_MAX_PAYLOAD);
+
+#ifdef UART_BUFFERED
+    //
+    // Don't spend time encoding a frame that cannot be queued.
+    //
+    if(UARTTxBytesFree() <= TELEM_ENCODED_SIZE(ui32Len))
+    {
+        g_sTelemetryStats.ui32Busy++;
+        return(false);
+    }
+#endif
+
+    pui8Header[0] = ui8Type;
+    pui8Header[1] = ui8Channel;
+    pui8Header[2] = (uint8_t)ui16Seq;
+    pui8Header[3] = (uint8_t)(ui16Seq >> 8);
+    ui16CRC = TelemetryCRC16(0xFFFF, pui8Header, 4);
+    ui16CRC = TelemetryCRC16(ui16CRC, pvPayload, ui32Len);
+    pui8CRC[0] = (uint8_t)ui16CRC;
+    pui8CRC[1] = (uint8_t)(ui16CRC >> 8);
+
+    //
+    // Leading delimiter, then the first COBS code byte, filled in later.
+    //
+    g_pui8Frame[0] = 0;
+    g_ui32CodePos = 1;
+    g_ui32FramePos = 2;
+    g_ui8Code = 1;
+
+    FrameAppend(pui8Header, 4);
+    FrameAppend(pvPayload, ui32Len);
+    FrameAppend(pui8CRC, 2);
+
+    //
+    // Close the last run and add the trailing delimiter.
+    //
+    g_pui8Frame[g_ui32CodePos] = g_ui8Code;
+    g_pui8Frame[g_ui32FramePos++] = 0;
+
+    if(!UARTwriteBinary(g_pui8Frame, g_ui32FramePos))
+    {
+        g_sTelemetryStats.ui32Busy++;
+        return(false);
+    }
+
+    g_sTelemetryStats.ui32Frames++;
+    g_sTelemetryStats.ui32Bytes += g_ui32FramePos;
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+//! Gives the frame type for blocks of a pipeline format.
+//!
+//! \param ui32Format is one of the \b PIPE_FORMAT_ values.
+//!
+//! \return Returns the \b TELEM_TYPE_ value, or 0 if the format has no frame
+//! type.
+//
+//*****************************************************************************
+uint8_t
+TelemetryFormatType(uint32_t ui32Format)
+{
+    switch(ui32Format)
+    {
+        case PIPE_FORMAT_SAMPLES16:
+        {
+            return(TELEM_TYPE_SAMPLES16);
+        }
+
+        case PIPE_FORMAT_PACKED12:
+        {
+            return(TELEM_TYPE_PACKED12);
+        }
+
+        case PIPE_FORMAT_RICE:
+        {
+            return(TELEM_TYPE_RICE);
+        }
+
+        case PIPE_FORMAT_VARINT:
+        {
+            return(TELEM_TYPE_VARINT);
+        }
+
+        default:
+        {
+            return(0);
+        }
+    }
+}
+
+//*****************************************************************************
+//
+//! Pipeline stage that sends each block as a telemetry frame.
+//!
+//! \param pvState points to a \b tTelemetryStage.
+//! \param psBlock is the block to send.
+//!
+//! The frame type follows the block format and the sequence number counts
+//! the stage's own frames, so a block an earlier stage dropped on purpose
+//! (a gate, say) is not taken for a lost frame.  Blocks the source had to
+//! drop show in the block numbers of TelemetryStageTime()'s frames instead.
+//! When the UART cannot take the frame yet the stage reports \b PIPE_BUSY,
+//! holding back the pipeline rather than losing the block.
+//!
+//! \return Returns \b PIPE_CONTINUE once sent, \b PIPE_BUSY to be retried, or
+//! \b PIPE_DROP for a format that has no frame type.
+//
+//*****************************************************************************
+uint32_t
+TelemetryStageSend(void *pvState, tPipeBlock *psBlock)
+{
+    tTelemetryStage *psStage = pvState;
+    uint32_t ui32Bytes;
+    uint8_t ui8Type;
+
+    ui8Type = TelemetryFormatType(psBlock->ui32Format);
+    if(!ui8Type)
+    {
+        return(PIPE_DROP);
+    }
+    ui32Bytes = PIPE_BLOCK_BYTES(psBlock);
+
+    if(ui32Bytes > TELEM_MAX_PAYLOAD)
+    {
+        return(PIPE_DROP);
+    }
+
+    if(!TelemetrySend(ui8Type, psStage->ui8Channel,
+                      (uint16_t)psStage->ui32Frames, psBlock->pvData,
+                      ui32Bytes))
+    {
+        return(PIPE_BUSY);
+    }
+    psStage->ui32Frames++;
+
+    return(PIPE_CONTINUE);
+}
+
+//*****************************************************************************
+//
+// Stores a little-endian field of a frame payload.
+//
+//*****************************************************************************
+static void
+TelemetryPut32(uint8_t *pui8Dst, uint32_t ui32Value)
+{
+    pui8Dst[0] = (uint8_t)ui32Value;
+    pui8Dst[1] = (uint8_t)(ui32Value >> 8);
+    pui8Dst[2] = (uint8_t)(ui32Value >> 16);
+    pui8Dst[3] = (uint8_t)(ui32Value >> 24);
+}
+
+//*****************************************************************************
+//
+//! Pipeline stage that sends the time stamp of each block.
+//!
+//! \param pvState points to a \b tTelemetryTimeStage.
+//! \param psBlock is the block.
+//!
+//! Sends a \b TELEM_TYPE_BLOCKTIME frame with the block's sequence number,
+//! time stamp and lost sample count, from which the receiver can work out
+//! the rate the samples were really taken at, how steady it was and where
+//! samples or blocks went missing (tools/sample_clock.py).  The block itself
+//! is passed on untouched.  It belongs ahead of any stage that drops blocks
+//! or changes their length, so every block taken is reported as taken.
+//!
+//! \return Returns \b PIPE_CONTINUE once sent, or \b PIPE_BUSY to be
+//! retried.
+//
+//*****************************************************************************
+uint32_t
+TelemetryStageTime(void *pvState, tPipeBlock *psBlock)
+{
+    tTelemetryTimeStage *psStage = pvState;
+    uint8_t pui8Payload[TELEM_BLOCKTIME_SIZE];
+
+    TelemetryPut32(pui8Payload, psBlock->ui32Seq);
+    TelemetryPut32(pui8Payload + 4, psBlock->ui32Time);
+    TelemetryPut32(pui8Payload + 8, psBlock->ui32Missed);
+    TelemetryPut32(pui8Payload + 12, psStage->ui32Clock);
+    pui8Payload[16] = (uint8_t)psBlock->ui32Length;
+    pui8Payload[17] = (uint8_t)(psBlock->ui32Length >> 8);
+
+    if(!TelemetrySend(TELEM_TYPE_BLOCKTIME, psStage->ui8Channel,
+                      (uint16_t)psBlock->ui32Seq, pui8Payload,
+                      sizeof(pui8Payload)))
+    {
+        return(PIPE_BUSY);
+    }
+
+    return(PIPE_CONTINUE);
+}
+
+//*****************************************************************************
+//
+//! Reads the transmit statistics.
+//!
+//! \param psStats receives the statistics.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+TelemetryStatsGet(tTelemetryStats *psStats)
+{
+    *psStats = g_sTelemetryStats;
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
@@ -0,0 +1,132 @@
+//*****************************************************************************
+//
+// telemetry.h - COBS framed binary telemetry over the console UART.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_TELEMETRY_H__
+#define __UTILS_TELEMETRY_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// Frame format.  Before encoding a frame is
+//
+//     type (1) | channel (1) | sequence (2) | payload (0-512) | CRC-16 (2)
+//
+// with multi-byte fields little-endian and the CRC-16/CCITT-FALSE (polynomial
+// 0x1021, initial value 0xFFFF) taken over everything before it.  The frame
+// is then COBS encoded, so it contains no zero bytes, and sent with a zero
+// byte on either side.  A receiver can therefore resynchronize at any zero,
+// and console text sent between frames is simply discarded.  The sequence
+// number is chosen by the sender (for sample blocks, the block number) and
+// lets the receiver count lost frames per channel.  tools/telemetry.py is the
+// matching host receiver.
+//
+//*****************************************************************************
+#define TELEM_MAX_PAYLOAD       512
+#define TELEM_FRAME_OVERHEAD    6
+#define TELEM_ENCODED_SIZE(ui32Payload)                                       \
+        ((ui32Payload) + TELEM_FRAME_OVERHEAD +                               \
+         (((ui32Payload) + TELEM_FRAME_OVERHEAD + 253) / 254) + 2)
+
+//*****************************************************************************
+//
+// Frame types (the layout of the payload).
+//
+//*****************************************************************************
+#define TELEM_TYPE_SAMPLES16    0x01    // little-endian uint16_t samples
+#define TELEM_TYPE_PACKED12     0x02    // PACK_MODE_12BIT samples
+#define TELEM_TYPE_RICE         0x03    // PACK_MODE_RICE samples
+#define TELEM_TYPE_VARINT       0x04    // PACK_MODE_VARINT samples
+#define TELEM_TYPE_CAPTURE      0x05    // a triggered capture window (capture.h)
+#define TELEM_TYPE_BLOCKTIME    0x06    // when a block was taken (TelemetryStageTime())
+
+//*****************************************************************************
+//
+// Payload of a TELEM_TYPE_BLOCKTIME frame:
+//
+//     block (4) | time (4) | missed (4) | clock (4) | samples (2)
+//
+// the full block sequence number, the cycle count of its last sample, the
+// samples the source has lost so far, the cycle counter rate in Hz and the
+// samples in the block.
+//
+//*****************************************************************************
+#define TELEM_BLOCKTIME_SIZE    18
+
+//*****************************************************************************
+//
+// State of TelemetryStageSend(): the channel its blocks are sent on, set by
+// the application, and the count of frames sent, which numbers them.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t ui8Channel;
+
+    uint32_t ui32Frames;
+}
+tTelemetryStage;
+
+//*****************************************************************************
+//
+// State of TelemetryStageTime(): the channel its frames are sent on and the
+// rate of the cycle counter the blocks are stamped with.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint8_t ui8Channel;
+    uint32_t ui32Clock;
+}
+tTelemetryTimeStage;
+
+//*****************************************************************************
+//
+// Transmit statistics.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Frames;        // frames queued for transmission
+    uint32_t ui32Bytes;         // bytes on the wire, including framing
+    uint32_t ui32Busy;          // sends deferred for lack of buffer space
+}
+tTelemetryStats;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern uint16_t TelemetryCRC16(uint16_t ui16CRC, const uint8_t *pui8Data,
+                               uint32_t ui32Len);
+extern bool TelemetrySend(uint8_t ui8Type, uint8_t ui8Channel,
+                          uint16_t ui16Seq, const void *pvPayload,
+                          uint32_t ui32Len);
+extern uint8_t TelemetryFormatType(uint32_t ui32Format);
+extern uint32_t TelemetryStageSend(void *pvState, tPipeBlock *psBlock);
+extern uint32_t TelemetryStageTime(void *pvState, tPipeBlock *psBlock);
+extern void TelemetryStatsGet(tTelemetryStats *psStats);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_TELEMETRY_H__
@@ -35,6 +35,7 @@
 #include "driverlib/rom_map.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/uart.h"
+#include "utils/intprio.h"
 #include "utils/uartstdio.h"
 
 //*****************************************************************************
@@ -267,6 +268,20 @@ GetBufferCount(volatile uint32_t *pui32Read,
 }
 #endif
 
+//*****************************************************************************
+//
+// The critical-section level that holds off the UART interrupt: its own
+// priority, read back so that it follows the image's priority plan.
+//
+//*****************************************************************************
+#ifdef UART_BUFFERED
+static uint32_t
+UARTIntLevel(void)
+{
+    return(MAP_IntPriorityGet(g_ui32UARTInt[g_ui32PortNum]));
+}
+#endif
+
 //*****************************************************************************
 //
 // Take as many bytes from the transmit buffer as we have space for and move
@@ -277,16 +292,19 @@ GetBufferCount(volatile uint32_t *pui32Read,
 static void
 UARTPrimeTransmit(uint32_t ui32Base)
 {
+    uint32_t ui32Saved;
+
     //
     // Do we have any data to transmit?
     //
     if(!TX_BUFFER_EMPTY)
     {
         //
-        // Disable the UART interrupt.  If we don't do this there is a race
-        // condition which can cause the read index to be corrupted.
+        // Hold off the UART interrupt, and anything less urgent, while the
+        // FIFO is fed.  If we don't do this there is a race condition which
+        // can cause the read index to be corrupted.
         //
-        MAP_IntDisable(g_ui32UARTInt[g_ui32PortNum]);
+        ui32Saved = IntCriticalEnter(UARTIntLevel());
 
         //
         // Yes - take some characters out of the transmit buffer and feed
@@ -300,9 +318,9 @@ UARTPrimeTransmit(uint32_t ui32Base)
         }
 
         //
-        // Reenable the UART interrupt.
+        // Let the UART interrupt in again.
         //
-        MAP_IntEnable(g_ui32UARTInt[g_ui32PortNum]);
+        IntCriticalExit(ui32Saved);
     }
 }
 #endif
@@ -544,6 +562,70 @@ UARTwrite(const char *pcBuf, uint32_t ui32Len)
 #endif
 }
 
+//*****************************************************************************
+//
+//! Writes a block of binary data to the UART output.
+//!
+//! \param pui8Buf points to the data to transmit.
+//! \param ui32Len is the number of bytes to transmit.
+//!
+//! Unlike UARTwrite(), this function sends every byte as is: there is no LF
+//! to CRLF translation and a zero byte does not end the transfer.  It is
+//! meant for binary protocols that share the console UART.
+//!
+//! In buffered mode the block is queued only if it fits in the transmit
+//! buffer as a whole, so a frame is never cut short; otherwise nothing is
+//! written and the caller can try again once more space is free.  In
+//! non-buffered mode this function blocks until every byte is in the FIFO.
+//!
+//! \return Returns \e ui32Len if the data was written, or 0 if there was not
+//! enough room in the transmit buffer.
+//
+//*****************************************************************************
+int
+UARTwriteBinary(const uint8_t *pui8Buf, uint32_t ui32Len)
+{
+    uint32_t ui32Idx;
+
+    //
+    // Check for valid UART base address, and valid arguments.
+    //
+    ASSERT(g_ui32Base != 0);
+    ASSERT(pui8Buf != 0);
+
+#ifdef UART_BUFFERED
+    //
+    // The ring buffer holds one byte less than its size.
+    //
+    if(ui32Len >= TX_BUFFER_FREE)
+    {
+        return(0);
+    }
+
+    for(ui32Idx = 0; ui32Idx < ui32Len; ui32Idx++)
+    {
+        g_pcUARTTxBuffer[g_ui32UARTTxWriteIndex] = pui8Buf[ui32Idx];
+        ADVANCE_TX_BUFFER_INDEX(g_ui32UARTTxWriteIndex);
+    }
+
+    //
+    // Make sure that the UART is set up to transmit it.
+    //
+    if(!TX_BUFFER_EMPTY)
+    {
+        UARTPrimeTransmit(g_ui32Base);
+        MAP_UARTIntEnable(g_ui32Base, UART_INT_TX);
+    }
+#else
+    for(ui32Idx = 0; ui32Idx < ui32Len; ui32Idx++)
+    {
+        MAP_UARTCharPut(g_ui32Base, pui8Buf[ui32Idx]);
+    }
+#endif
+
+    return(ui32Len);
+}
+
 //*****************************************************************************
 //
 //! A simple UART based get string function, with some line processing.
@@ -1429,12 +1511,12 @@ UARTPeek(unsigned char ucChar)
 void
 UARTFlushRx(void)
 {
-    uint32_t ui32Int;
+    uint32_t ui32Saved;
 
     //
-    // Temporarily turn off interrupts.
+    // Temporarily hold off the UART interrupt.
     //
-    ui32Int = MAP_IntMasterDisable();
+    ui32Saved = IntCriticalEnter(UARTIntLevel());
 
     //
     // Flush the receive buffer.
@@ -1443,13 +1525,9 @@ UARTFlushRx(void)
     g_ui32UARTRxWriteIndex = 0;
 
     //
-    // If interrupts were enabled when we turned them off, turn them
-    // back on again.
+    // Let the UART interrupt in again.
     //
-    if(!ui32Int)
-    {
-        MAP_IntMasterEnable();
-    }
+    IntCriticalExit(ui32Saved);
 }
 #endif
 
@@ -1473,7 +1551,7 @@ UARTFlushRx(void)
 void
 UARTFlushTx(bool bDiscard)
 {
-    uint32_t ui32Int;
+    uint32_t ui32Saved;
 
     //
     // Should the remaining data be discarded or transmitted?
@@ -1481,10 +1559,10 @@ UARTFlushTx(bool bDiscard)
     if(bDiscard)
     {
         //
-        // The remaining data should be discarded, so temporarily turn off
-        // interrupts.
+        // The remaining data should be discarded, so temporarily hold off
+        // the UART interrupt.
         //
-        ui32Int = MAP_IntMasterDisable();
+        ui32Saved = IntCriticalEnter(UARTIntLevel());
 
         //
         // Flush the transmit buffer.
@@ -1493,13 +1571,9 @@ UARTFlushTx(bool bDiscard)
         g_ui32UARTTxWriteIndex = 0;
 
         //
-        // If interrupts were enabled when we turned them off, turn them
-        // back on again.
+        // Let the UART interrupt in again.
         //
-        if(!ui32Int)
-        {
-            MAP_IntMasterEnable();
-        }
+        IntCriticalExit(ui32Saved);
     }
     else
     {
@@ -0,0 +1,205 @@
+//*****************************************************************************
+//
+// vtable.c - Boot-time vector table placement and interrupt entry latency
+//            measurement.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "inc/hw_ints.h"
+#include "inc/hw_nvic.h"
+#include "inc/hw_types.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/rom.h"
+#include "driverlib/rom_map.h"
+#include "utils/cyclecount.h"
+#include "utils/vtable.h"
+
+//*****************************************************************************
+//
+//! \addtogroup vtable_api
+//! @{
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// The link-time populated vector table in tm4c123gh6pm_startup_ccs.c.
+//
+//*****************************************************************************
+extern void (* const g_pfnVectors[])(void);
+
+//*****************************************************************************
+//
+// The SRAM copy of the vector table.  The NVIC requires the table to be
+// aligned to the next power of two above its size (155 words -> 1024 bytes).
+// It is excluded from C run-time zero-initialization since VectorTableInit()
+// overwrites every entry anyway.
+//
+//*****************************************************************************
+#ifdef VECTOR_TABLE_IN_RAM
+#pragma DATA_ALIGN(g_pfnRAMVectors, 1024)
+#pragma NOINIT(g_pfnRAMVectors)
+static void (*g_pfnRAMVectors[NUM_INTERRUPTS])(void);
+#endif
+
+//*****************************************************************************
+//
+// Cycle count captured by the probe handler and the flag telling the
+// measurement loop that it has run.
+//
+//*****************************************************************************
+static volatile uint32_t g_ui32ProbeCycles;
+static volatile bool g_bProbeFired;
+
+//*****************************************************************************
+//
+//! Places the vector table according to the build configuration.
+//!
+//! With \b VECTOR_TABLE_IN_RAM defined, the flash table is copied once into
+//! the aligned SRAM table and the NVIC is pointed at it.  Otherwise this
+//! function does nothing; the flash table is used as linked.
+//!
+//! This function must be called before any interrupt is enabled.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+VectorTableInit(void)
+{
+#ifdef VECTOR_TABLE_IN_RAM
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < NUM_INTERRUPTS; ui32Idx++)
+    {
+        g_pfnRAMVectors[ui32Idx] = g_pfnVectors[ui32Idx];
+    }
+
+    HWREG(NVIC_VTABLE) = (uint32_t)g_pfnRAMVectors;
+#endif
+}
+
+//*****************************************************************************
+//
+//! Reports where the active vector table is located.
+//!
+//! \return Returns \b true if the NVIC fetches vectors from SRAM.
+//
+//*****************************************************************************
+bool
+VectorTableIsRAM(void)
+{
+    return(HWREG(NVIC_VTABLE) >= 0x20000000);
+}
+
+//*****************************************************************************
+//
+//! Installs an interrupt handler at run time.
+//!
+//! \param ui32Interrupt is the interrupt number (for example \b INT_ADC0SS0).
+//! \param pfnHandler is the handler to install.
+//!
+//! With the table in SRAM the entry is simply overwritten; unlike
+//! IntRegister() nothing is copied.  With the table in flash the handler must
+//! already be in g_pfnVectors, and the call only confirms that.
+//!
+//! \return Returns \b true if \e pfnHandler is now the active handler.
+//
+//*****************************************************************************
+bool
+VectorTableRegister(uint32_t ui32Interrupt, void (*pfnHandler)(void))
+{
+    if(ui32Interrupt >= NUM_INTERRUPTS)
+    {
+        return(false);
+    }
+
+#ifdef VECTOR_TABLE_IN_RAM
+    g_pfnRAMVectors[ui32Interrupt] = pfnHandler;
+    return(true);
+#else
+    return(g_pfnVectors[ui32Interrupt] == pfnHandler);
+#endif
+}
+
+//*****************************************************************************
+//
+//! Handler for the latency probe interrupt.
+//!
+//! This must be placed in the vector table at \b VTABLE_PROBE_INT.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+VectorTableProbeHandler(void)
+{
+    g_ui32ProbeCycles = CycleCountGet();
+    g_bProbeFired = true;
+}
+
+//*****************************************************************************
+//
+//! Measures interrupt entry latency through the active vector table.
+//!
+//! \param psLatency receives the minimum and maximum latency seen.
+//! \param ui32Samples is the number of times the probe interrupt is fired.
+//!
+//! The probe interrupt is pended through the NVIC software trigger register
+//! and the cycle counter is read again in its handler.  The result covers
+//! exception entry (stacking and vector fetch) plus the handler prologue, so
+//! it is best compared between the two \b VECTOR_TABLE_IN_RAM builds rather
+//! than read as an absolute figure.  Interrupts are enabled for the duration
+//! of the measurement and restored afterwards.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void
+VectorTableLatencyMeasure(tVectorLatency *psLatency, uint32_t ui32Samples)
+{
+    uint32_t ui32Start, ui32Delta;
+    bool bWasDisabled;
+
+    psLatency->ui32Min = 0xFFFFFFFF;
+    psLatency->ui32Max = 0;
+
+    MAP_IntPrioritySet(VTABLE_PROBE_INT, 0);
+    MAP_IntEnable(VTABLE_PROBE_INT);
+    bWasDisabled = MAP_IntMasterEnable();
+
+    while(ui32Samples--)
+    {
+        g_bProbeFired = false;
+        ui32Start = CycleCountGet();
+        HWREG(NVIC_SW_TRIG) = VTABLE_PROBE_INT - 16;
+        while(!g_bProbeFired)
+        {
+        }
+
+        ui32Delta = g_ui32ProbeCycles - ui32Start;
+        if(ui32Delta < psLatency->ui32Min)
+        {
+            psLatency->ui32Min = ui32Delta;
+        }
+        if(ui32Delta > psLatency->ui32Max)
+        {
+            psLatency->ui32Max = ui32Delta;
+        }
+    }
+
+    if(bWasDisabled)
+    {
+        MAP_IntMasterDisable();
+    }
+    MAP_IntDisable(VTABLE_PROBE_INT);
+}
+
+//*****************************************************************************
+//
+// Close the Doxygen group.
+//! @}
+//
+//*****************************************************************************
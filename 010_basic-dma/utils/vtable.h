@@ -0,0 +1,79 @@
+//*****************************************************************************
+//
+// vtable.h - Boot-time vector table placement and interrupt entry latency
+//            measurement.
+//
+//*****************************************************************************
+
+#ifndef __UTILS_VTABLE_H__
+#define __UTILS_VTABLE_H__
+
+//*****************************************************************************
+//
+// If building with a C++ compiler, make all of the definitions in this header
+// have a C binding.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+//*****************************************************************************
+//
+// The vector table lives in flash by default: every handler is placed in
+// g_pfnVectors (tm4c123gh6pm_startup_ccs.c) at link time, nothing is copied
+// and no SRAM is used.  Define VECTOR_TABLE_IN_RAM in the project's
+// predefined symbols to have VectorTableInit() copy that table once into an
+// aligned SRAM table so handlers can be swapped at run time with
+// VectorTableRegister().
+//
+// Do not mix either mode with the driverlib IntRegister() family; those
+// functions copy the whole table into their own SRAM block on first use.
+//
+//*****************************************************************************
+
+//*****************************************************************************
+//
+// The interrupt used to probe interrupt entry latency.  It is triggered by
+// software only, so any vector not used by the application will do.
+//
+//*****************************************************************************
+#define VTABLE_PROBE_INT        INT_TIMER5B
+
+//*****************************************************************************
+//
+// Interrupt entry latency, in core clock cycles, from the write to the NVIC
+// software trigger register to the first C statement of the handler.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Min;
+    uint32_t ui32Max;
+}
+tVectorLatency;
+
+//*****************************************************************************
+//
+// Prototypes for the APIs.
+//
+//*****************************************************************************
+extern void VectorTableInit(void);
+extern bool VectorTableIsRAM(void);
+extern bool VectorTableRegister(uint32_t ui32Interrupt,
+                                void (*pfnHandler)(void));
+extern void VectorTableLatencyMeasure(tVectorLatency *psLatency,
+                                      uint32_t ui32Samples);
+extern void VectorTableProbeHandler(void);
+
+//*****************************************************************************
+//
+// Mark the end of the C bindings section for C++ compilers.
+//
+//*****************************************************************************
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __UTILS_VTABLE_H__
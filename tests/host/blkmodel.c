@@ -0,0 +1,186 @@
+//*****************************************************************************
+//
+// blkmodel.c - A model of a block device (an SD card) for the host tests.
+//
+// A write is started, then polled: it stays busy for a set number of polls
+// and lands when it is done, as an SD card programs a block after taking
+// it.  A power cut can be scheduled after a number of writes: the write it
+// falls in lands only its first half, and from then on nothing is written,
+// which leaves the card as a reset would.  A write can also be made to
+// fail, as a card reporting a programming error.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "utils/blockdev.h"
+#include "blkmodel.h"
+
+tBlkModelStats g_sBlkModel;
+
+static uint8_t g_pui8Card[BLK_MODEL_MAX_BLOCKS][BLOCKDEV_BLOCK_SIZE];
+static uint32_t g_ui32Busy;         // polls a write stays busy for
+static int32_t g_i32Budget = -1;    // writes left before the power cut, or -1
+static int32_t g_i32FailAfter = -1; // writes left before one fails, or -1
+
+//*****************************************************************************
+//
+// The write in progress: the block, its data and the polls left.
+//
+//*****************************************************************************
+static bool g_bWriting;
+static uint32_t g_ui32Block;
+static const void *g_pvData;
+static uint32_t g_ui32Polls;
+static uint32_t g_ui32Result;
+
+static bool
+BlkModelRead(void *pvInst, uint32_t ui32Block, void *pvData)
+{
+    if(g_bWriting || (ui32Block >= g_sBlkModelDev.ui32Blocks))
+    {
+        g_sBlkModel.ui32Violations++;
+        return(false);
+    }
+    memcpy(pvData, g_pui8Card[ui32Block], BLOCKDEV_BLOCK_SIZE);
+    g_sBlkModel.ui32Reads++;
+    return(true);
+}
+
+static bool
+BlkModelWriteStart(void *pvInst, uint32_t ui32Block, const void *pvData)
+{
+    if(g_bWriting || (ui32Block >= g_sBlkModelDev.ui32Blocks))
+    {
+        g_sBlkModel.ui32Violations++;
+        return(false);
+    }
+    g_bWriting = true;
+    g_ui32Block = ui32Block;
+    g_pvData = pvData;
+    g_ui32Polls = g_ui32Busy;
+    return(true);
+}
+
+//*****************************************************************************
+//
+// The data is taken when the write finishes, so a caller that touches its
+// buffer before then is caught by the contents.
+//
+//*****************************************************************************
+static uint32_t
+BlkModelWritePoll(void *pvInst)
+{
+    if(!g_bWriting)
+    {
+        return(g_ui32Result);
+    }
+    if(g_ui32Polls)
+    {
+        g_ui32Polls--;
+        return(BLOCKDEV_BUSY);
+    }
+
+    g_bWriting = false;
+    g_ui32Result = BLOCKDEV_DONE;
+    if(g_i32FailAfter == 0)
+    {
+        g_i32FailAfter = -1;
+        g_ui32Result = BLOCKDEV_ERROR;
+        return(g_ui32Result);
+    }
+    if(g_i32FailAfter > 0)
+    {
+        g_i32FailAfter--;
+    }
+
+    if(g_i32Budget == 0)
+    {
+        return(g_ui32Result);
+    }
+    if(g_i32Budget == 1)
+    {
+        memcpy(g_pui8Card[g_ui32Block], g_pvData, BLOCKDEV_BLOCK_SIZE / 2);
+        g_i32Budget = 0;
+        return(g_ui32Result);
+    }
+    if(g_i32Budget > 0)
+    {
+        g_i32Budget--;
+    }
+    memcpy(g_pui8Card[g_ui32Block], g_pvData, BLOCKDEV_BLOCK_SIZE);
+    g_sBlkModel.ui32Writes++;
+    return(g_ui32Result);
+}
+
+tBlockDevice g_sBlkModelDev =
+{
+    0, 0, BlkModelRead, BlkModelWriteStart, BlkModelWritePoll
+};
+
+//*****************************************************************************
+//
+// Sets up a card of ui32Blocks blocks filled with a byte pattern (0xFF or
+// 0x00 for a new card, anything else for one with old contents), with
+// writes done at their first poll.
+//
+//*****************************************************************************
+void
+BlkModelInit(uint32_t ui32Blocks, uint8_t ui8Fill)
+{
+    memset(g_pui8Card, ui8Fill, sizeof(g_pui8Card));
+    memset(&g_sBlkModel, 0, sizeof(g_sBlkModel));
+    g_sBlkModelDev.ui32Blocks = ui32Blocks;
+    g_ui32Busy = 0;
+    g_i32Budget = -1;
+    g_i32FailAfter = -1;
+    g_bWriting = false;
+    g_ui32Result = BLOCKDEV_DONE;
+}
+
+//*****************************************************************************
+//
+// Makes each write busy for ui32Polls polls.
+//
+//*****************************************************************************
+void
+BlkModelBusy(uint32_t ui32Polls)
+{
+    g_ui32Busy = ui32Polls;
+}
+
+//*****************************************************************************
+//
+// Cuts the power during the write after i32Writes more, whole, writes; -1
+// restores it, with the card idle as after a reset.
+//
+//*****************************************************************************
+void
+BlkModelCut(int32_t i32Writes)
+{
+    g_i32Budget = (i32Writes < 0) ? -1 : (i32Writes + 1);
+    g_bWriting = false;
+}
+
+//*****************************************************************************
+//
+// Fails the write after i32Writes more; -1 for none.
+//
+//*****************************************************************************
+void
+BlkModelFail(int32_t i32Writes)
+{
+    g_i32FailAfter = i32Writes;
+}
+
+//*****************************************************************************
+//
+// Returns the contents of a block.
+//
+//*****************************************************************************
+uint8_t *
+BlkModelBlock(uint32_t ui32Block)
+{
+    return(g_pui8Card[ui32Block]);
+}
@@ -0,0 +1,49 @@
+//*****************************************************************************
+//
+// blkmodel.h - A model of a block device (an SD card) for the host tests.
+//
+//*****************************************************************************
+
+#ifndef __BLKMODEL_H__
+#define __BLKMODEL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "utils/blockdev.h"
+
+//*****************************************************************************
+//
+// The largest device the model holds.
+//
+//*****************************************************************************
+#define BLK_MODEL_MAX_BLOCKS    4096
+
+//*****************************************************************************
+//
+// What the model has seen.  A violation is an access while a write is in
+// progress, or to a block past the end, which the card does not allow.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Reads;
+    uint32_t ui32Writes;
+    uint32_t ui32Violations;
+}
+tBlkModelStats;
+
+extern tBlkModelStats g_sBlkModel;
+extern tBlockDevice g_sBlkModelDev;
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void BlkModelInit(uint32_t ui32Blocks, uint8_t ui8Fill);
+extern void BlkModelBusy(uint32_t ui32Polls);
+extern void BlkModelCut(int32_t i32Writes);
+extern void BlkModelFail(int32_t i32Writes);
+extern uint8_t *BlkModelBlock(uint32_t ui32Block);
+
+#endif // __BLKMODEL_H__
@@ -0,0 +1,133 @@
+//*****************************************************************************
+//
+// flashmodel.c - A model of the TM4C123 internal flash for the host tests.
+//
+// FlashErase() sets a 1 KB sector to ones; FlashProgram() can only clear
+// bits, a word at a time, as on the part.  A power cut can be scheduled
+// after a number of programmed words: from then on nothing is written,
+// which leaves a record cut short as a reset would.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "driverlib/flash.h"
+#include "flashmodel.h"
+
+tFlashModelStats g_sFlashModel;
+
+static uint32_t g_ui32Size;
+static int32_t g_i32Budget = -1;    // words left before the power cut, or -1
+
+//*****************************************************************************
+//
+// Maps the model's flash at FLASH_MODEL_BASE, filled with a byte pattern
+// (0xFF for erased flash, anything else for a part with old contents).
+//
+//*****************************************************************************
+void
+FlashModelInit(uint32_t ui32Size, uint8_t ui8Fill)
+{
+    void *pvFlash;
+
+    if(!g_ui32Size)
+    {
+        pvFlash = mmap((void *)(uintptr_t)FLASH_MODEL_BASE, ui32Size,
+                       PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+        if(pvFlash != (void *)(uintptr_t)FLASH_MODEL_BASE)
+        {
+            perror("flashmodel: mmap");
+            exit(2);
+        }
+        g_ui32Size = ui32Size;
+    }
+
+    memset((void *)(uintptr_t)FLASH_MODEL_BASE, ui8Fill, g_ui32Size);
+    memset(&g_sFlashModel, 0, sizeof(g_sFlashModel));
+    g_i32Budget = -1;
+}
+
+//*****************************************************************************
+//
+// Cuts the power after i32Words more words are programmed; -1 restores it.
+//
+//*****************************************************************************
+void
+FlashModelCut(int32_t i32Words)
+{
+    g_i32Budget = i32Words;
+}
+
+//*****************************************************************************
+//
+// Returns the address of a sector.
+//
+//*****************************************************************************
+uint32_t
+FlashModelSector(uint32_t ui32Sector)
+{
+    return(FLASH_MODEL_BASE + (ui32Sector * FLASH_MODEL_SECTOR));
+}
+
+//*****************************************************************************
+//
+// The driverlib functions.  Both return 0 on success, -1 for a bad address
+// or when the power is off.
+//
+//*****************************************************************************
+int32_t
+FlashErase(uint32_t ui32Address)
+{
+    if((ui32Address & (FLASH_MODEL_SECTOR - 1)) ||
+       (ui32Address < FLASH_MODEL_BASE) ||
+       (ui32Address >= (FLASH_MODEL_BASE + g_ui32Size)) ||
+       (g_i32Budget == 0))
+    {
+        return(-1);
+    }
+
+    memset((void *)(uintptr_t)ui32Address, 0xFF, FLASH_MODEL_SECTOR);
+    g_sFlashModel.ui32Erases++;
+    return(0);
+}
+
+int32_t
+FlashProgram(uint32_t *pui32Data, uint32_t ui32Address, uint32_t ui32Count)
+{
+    volatile uint32_t *pui32Flash;
+    uint32_t ui32Idx;
+
+    if((ui32Address & 3) || (ui32Count & 3) ||
+       (ui32Address < FLASH_MODEL_BASE) ||
+       ((ui32Address + ui32Count) > (FLASH_MODEL_BASE + g_ui32Size)))
+    {
+        return(-1);
+    }
+
+    pui32Flash = (volatile uint32_t *)(uintptr_t)ui32Address;
+    for(ui32Idx = 0; ui32Idx < (ui32Count / 4); ui32Idx++)
+    {
+        if(g_i32Budget == 0)
+        {
+            return(-1);
+        }
+        if(g_i32Budget > 0)
+        {
+            g_i32Budget--;
+        }
+
+        if((pui32Flash[ui32Idx] & pui32Data[ui32Idx]) != pui32Data[ui32Idx])
+        {
+            g_sFlashModel.ui32Violations++;
+        }
+        pui32Flash[ui32Idx] &= pui32Data[ui32Idx];
+        g_sFlashModel.ui32Words++;
+    }
+
+    return(0);
+}
@@ -0,0 +1,46 @@
+//*****************************************************************************
+//
+// flashmodel.h - A model of the TM4C123 internal flash for the host tests.
+//
+//*****************************************************************************
+
+#ifndef __FLASHMODEL_H__
+#define __FLASHMODEL_H__
+
+#include <stdint.h>
+
+//*****************************************************************************
+//
+// The model is mapped at a fixed address below 4 GB, since the target code
+// keeps flash addresses in uint32_t.  Sectors are 1 KB, as on the part.
+//
+//*****************************************************************************
+#define FLASH_MODEL_BASE        0x10000000
+#define FLASH_MODEL_SECTOR      1024
+
+//*****************************************************************************
+//
+// What the model has seen.  A violation is a word programmed over bits that
+// were already programmed, which the part does not allow.
+//
+//*****************************************************************************
+typedef struct
+{
+    uint32_t ui32Erases;
+    uint32_t ui32Words;
+    uint32_t ui32Violations;
+}
+tFlashModelStats;
+
+extern tFlashModelStats g_sFlashModel;
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void FlashModelInit(uint32_t ui32Size, uint8_t ui8Fill);
+extern void FlashModelCut(int32_t i32Words);
+extern uint32_t FlashModelSector(uint32_t ui32Sector);
+
+#endif // __FLASHMODEL_H__
@@ -0,0 +1,268 @@
+//*****************************************************************************
+//
+// host.c - Support for the host tests: checks, a register file standing in
+// for the memory-mapped registers, interrupt masking and delivery, and the
+// console and critical-section functions the tested modules call.
+//
+//*****************************************************************************
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "inc/hw_nvic.h"
+#include "host.h"
+
+//*****************************************************************************
+//
+// Checks run and failed.
+//
+//*****************************************************************************
+static uint32_t g_ui32Checks;
+static uint32_t g_ui32Failures;
+
+//*****************************************************************************
+//
+// The register file: each address used gets a word, zero at first.
+//
+//*****************************************************************************
+#define HOST_REGISTERS          32
+
+static struct
+{
+    uint32_t ui32Address;
+    volatile uint32_t ui32Value;
+}
+g_psRegisters[HOST_REGISTERS];
+static uint32_t g_ui32Registers;
+
+//*****************************************************************************
+//
+// Whether interrupts are masked, the exception being handled (0 in thread
+// mode) and the function standing in for the PendSV handler.
+//
+//*****************************************************************************
+static bool g_bMasked;
+static uint32_t g_ui32Vector;
+void (*g_pfnHostPendSV)(void);
+
+//*****************************************************************************
+//
+// The interrupts enabled in the NVIC.
+//
+//*****************************************************************************
+#define HOST_INTERRUPTS         160
+
+static bool g_pbEnabled[HOST_INTERRUPTS];
+
+//*****************************************************************************
+//
+// Counts a check, printing it if it failed.
+//
+//*****************************************************************************
+bool
+HostCheck(bool bPassed, const char *pcExpr, const char *pcFile, int iLine)
+{
+    g_ui32Checks++;
+    if(!bPassed)
+    {
+        g_ui32Failures++;
+        printf("%s:%d: check failed: %s\n", pcFile, iLine, pcExpr);
+    }
+    return(bPassed);
+}
+
+//*****************************************************************************
+//
+// Prints the outcome of a test program; returns its exit status.
+//
+//*****************************************************************************
+int
+HostResult(const char *pcTest)
+{
+    printf("%s: %u checks, %u failed\n", pcTest, g_ui32Checks,
+           g_ui32Failures);
+    return(g_ui32Failures ? 1 : 0);
+}
+
+//*****************************************************************************
+//
+// Returns the word standing in for a register (HWREG() in the stub
+// hw_types.h).
+//
+//*****************************************************************************
+volatile uint32_t *
+HostRegister(uint32_t ui32Address)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < g_ui32Registers; ui32Idx++)
+    {
+        if(g_psRegisters[ui32Idx].ui32Address == ui32Address)
+        {
+            //
+            // The interrupt control register shows the active exception.
+            //
+            if(ui32Address == NVIC_INT_CTRL)
+            {
+                g_psRegisters[ui32Idx].ui32Value =
+                    ((g_psRegisters[ui32Idx].ui32Value &
+                      ~NVIC_INT_CTRL_VEC_ACT_M) | g_ui32Vector);
+            }
+            return(&g_psRegisters[ui32Idx].ui32Value);
+        }
+    }
+
+    if(g_ui32Registers == HOST_REGISTERS)
+    {
+        printf("host: out of registers at 0x%08x\n", ui32Address);
+        return(&g_psRegisters[0].ui32Value);
+    }
+    g_psRegisters[g_ui32Registers].ui32Address = ui32Address;
+    return(&g_psRegisters[g_ui32Registers++].ui32Value);
+}
+
+//*****************************************************************************
+//
+// Runs the PendSV handler if PendSV is pending and could be taken: in
+// thread mode with interrupts enabled, it being the lowest priority.
+//
+//*****************************************************************************
+static void
+HostPendSVRun(void)
+{
+    volatile uint32_t *pui32IntCtrl;
+
+    pui32IntCtrl = HostRegister(NVIC_INT_CTRL);
+    if(!g_bMasked && !g_ui32Vector && (*pui32IntCtrl & NVIC_INT_CTRL_PEND_SV))
+    {
+        *pui32IntCtrl &= ~NVIC_INT_CTRL_PEND_SV;
+        if(g_pfnHostPendSV)
+        {
+            g_pfnHostPendSV();
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// Interrupt masking (driverlib/interrupt.c on the target).  Each returns
+// whether interrupts were masked before.
+//
+//*****************************************************************************
+bool
+IntMasterDisable(void)
+{
+    bool bMasked;
+
+    bMasked = g_bMasked;
+    g_bMasked = true;
+    return(bMasked);
+}
+
+bool
+IntMasterEnable(void)
+{
+    bool bMasked;
+
+    bMasked = g_bMasked;
+    g_bMasked = false;
+    HostPendSVRun();
+    return(bMasked);
+}
+
+void
+IntPrioritySet(uint32_t ui32Interrupt, uint8_t ui8Priority)
+{
+}
+
+void
+IntEnable(uint32_t ui32Interrupt)
+{
+    g_pbEnabled[ui32Interrupt % HOST_INTERRUPTS] = true;
+}
+
+void
+IntDisable(uint32_t ui32Interrupt)
+{
+    g_pbEnabled[ui32Interrupt % HOST_INTERRUPTS] = false;
+}
+
+//*****************************************************************************
+//
+// Returns whether interrupt ui32Interrupt could be taken now: enabled in
+// the NVIC and not masked.
+//
+//*****************************************************************************
+bool
+HostIntEnabled(uint32_t ui32Interrupt)
+{
+    return(!g_bMasked && g_pbEnabled[ui32Interrupt % HOST_INTERRUPTS]);
+}
+
+void
+FPULazyStackingEnable(void)
+{
+}
+
+//*****************************************************************************
+//
+// Takes exception ui32Vector now, running pfnHandler as its handler, then
+// PendSV if that became pending.  Call with interrupts enabled.
+//
+//*****************************************************************************
+void
+HostInterrupt(uint32_t ui32Vector, void (*pfnHandler)(void))
+{
+    uint32_t ui32Preempted;
+
+    ui32Preempted = g_ui32Vector;
+    g_ui32Vector = ui32Vector;
+    pfnHandler();
+    g_ui32Vector = ui32Preempted;
+    HostPendSVRun();
+}
+
+//*****************************************************************************
+//
+// Console output (utils/uartstdio.c on the target).
+//
+//*****************************************************************************
+void
+UARTprintf(const char *pcString, ...)
+{
+    va_list vaArgs;
+
+    va_start(vaArgs, pcString);
+    vprintf(pcString, vaArgs);
+    va_end(vaArgs);
+}
+
+int
+UARTwriteBinary(const uint8_t *pui8Buf, uint32_t ui32Len)
+{
+    return((int)ui32Len);
+}
+
+int
+UARTTxBytesFree(void)
+{
+    return(4096);
+}
+
+//*****************************************************************************
+//
+// Critical sections (utils/intprio.c on the target); the tests that use
+// them run on one thread.
+//
+//*****************************************************************************
+uint32_t
+IntCriticalEnter(uint32_t ui32Level)
+{
+    return(0);
+}
+
+void
+IntCriticalExit(uint32_t ui32Saved)
+{
+}
@@ -0,0 +1,35 @@
+//*****************************************************************************
+//
+// host.h - Support for the host tests: checks and the simulated hardware.
+//
+//*****************************************************************************
+
+#ifndef __HOST_H__
+#define __HOST_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+//*****************************************************************************
+//
+// Checks a condition, reporting where it failed; the test carries on.
+//
+//*****************************************************************************
+#define CHECK(expr)                                                           \
+        HostCheck((expr), #expr, __FILE__, __LINE__)
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern bool HostCheck(bool bPassed, const char *pcExpr, const char *pcFile,
+                      int iLine);
+extern int HostResult(const char *pcTest);
+extern volatile uint32_t *HostRegister(uint32_t ui32Address);
+extern bool HostIntEnabled(uint32_t ui32Interrupt);
+extern void HostInterrupt(uint32_t ui32Vector, void (*pfnHandler)(void));
+extern void (*g_pfnHostPendSV)(void);
+
+#endif // __HOST_H__
@@ -0,0 +1,571 @@
+//*****************************************************************************
+//
+// i2cmodel.c - A model of the TM4C123 I2C master, its pins and a register
+// file device on the bus, for the host tests.
+//
+// A command runs at once: the master moves its byte, sets its error bits
+// and raises its data interrupt, which the test then delivers.  The device
+// takes the first byte written after a start as its register pointer and
+// the rest as register values; reads run on from the pointer.
+//
+// The pins matter when the bus is freed by hand.  Both lines are open drain
+// with pull-ups.  A device that held the clock holds data low until it has
+// been clocked enough times; a start then stop with the clock high resets
+// it.
+//
+//*****************************************************************************
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "driverlib/gpio.h"
+#include "driverlib/i2c.h"
+#include "driverlib/sysctl.h"
+#include "i2cmodel.h"
+
+tI2CModelStats g_sI2CModel;
+
+//*****************************************************************************
+//
+// The master control register's bits, of which the commands are made.
+//
+//*****************************************************************************
+#define CMD_RUN                 0x00000001
+#define CMD_START               0x00000002
+#define CMD_STOP                0x00000004
+#define CMD_ACK                 0x00000008
+
+//*****************************************************************************
+//
+// A pin: in I2C mode, a GPIO input, or a GPIO open-drain output driving its
+// latched level.
+//
+//*****************************************************************************
+#define PIN_I2C                 0
+#define PIN_INPUT               1
+#define PIN_OUTPUT              2
+
+typedef struct
+{
+    uint32_t ui32Port;
+    uint8_t ui8Pin;
+    uint32_t ui32Mode;
+    bool bLatch;
+}
+tPin;
+
+static tPin g_sSCL;
+static tPin g_sSDA;
+
+//*****************************************************************************
+//
+// The master: on or off, whether it holds the bus, the address and
+// direction set for the next start and those of the current transfer, its
+// data register, error bits, raw interrupts and interrupt mask.
+//
+//*****************************************************************************
+static bool g_bEnabled;
+static bool g_bOwned;
+static uint8_t g_ui8Slave;
+static bool g_bReceiveNext;
+static bool g_bReceive;
+static uint8_t g_ui8Data;
+static uint32_t g_ui32Err;
+static uint32_t g_ui32Raw;
+static uint32_t g_ui32Mask;
+
+//*****************************************************************************
+//
+// The device: whether the next byte written sets its register pointer, the
+// pointer, and the clocks it needs before letting go of SDA (0 if it does
+// not hold it).
+//
+//*****************************************************************************
+static bool g_bFirst;
+static uint8_t g_ui8Ptr;
+static uint32_t g_ui32Held;
+
+//*****************************************************************************
+//
+// The line levels last seen and whether a start has been made by hand.
+//
+//*****************************************************************************
+static bool g_bSCLHigh;
+static bool g_bSDAHigh;
+static bool g_bStarted;
+
+//*****************************************************************************
+//
+// The faults to come: each counts down what must pass before it strikes,
+// and is off at -1.
+//
+//*****************************************************************************
+static int32_t g_i32Nak;
+static int32_t g_i32ArbLost;
+static int32_t g_i32Stick;
+static uint32_t g_ui32StickClocks;
+static bool g_bStickTimeout;
+
+//*****************************************************************************
+//
+// Sets up the model: device ui8Addr, its registers holding their own
+// addresses, and the master's pins.  No faults are set.
+//
+//*****************************************************************************
+void
+I2CModelInit(uint8_t ui8Addr, uint32_t ui32SCLPort, uint8_t ui8SCLPin,
+             uint32_t ui32SDAPort, uint8_t ui8SDAPin)
+{
+    uint32_t ui32Idx;
+
+    memset(&g_sI2CModel, 0, sizeof(g_sI2CModel));
+    g_sI2CModel.ui8Addr = ui8Addr;
+    for(ui32Idx = 0; ui32Idx < sizeof(g_sI2CModel.pui8Regs); ui32Idx++)
+    {
+        g_sI2CModel.pui8Regs[ui32Idx] = (uint8_t)ui32Idx;
+    }
+
+    g_sSCL.ui32Port = ui32SCLPort;
+    g_sSCL.ui8Pin = ui8SCLPin;
+    g_sSCL.ui32Mode = PIN_I2C;
+    g_sSCL.bLatch = true;
+    g_sSDA.ui32Port = ui32SDAPort;
+    g_sSDA.ui8Pin = ui8SDAPin;
+    g_sSDA.ui32Mode = PIN_I2C;
+    g_sSDA.bLatch = true;
+
+    g_bEnabled = false;
+    g_bOwned = false;
+    g_ui32Err = I2C_MASTER_ERR_NONE;
+    g_ui32Raw = 0;
+    g_ui32Mask = 0;
+    g_bFirst = true;
+    g_ui8Ptr = 0;
+    g_ui32Held = 0;
+    g_bSCLHigh = true;
+    g_bSDAHigh = true;
+    g_bStarted = false;
+    g_i32Nak = -1;
+    g_i32ArbLost = -1;
+    g_i32Stick = -1;
+}
+
+//*****************************************************************************
+//
+// The device acknowledges i32Bytes more bytes written to it, then refuses
+// the next one; -1 cancels.
+//
+//*****************************************************************************
+void
+I2CModelNak(int32_t i32Bytes)
+{
+    g_i32Nak = i32Bytes;
+}
+
+//*****************************************************************************
+//
+// Another master wins the bus during the command after i32Commands more;
+// -1 cancels.
+//
+//*****************************************************************************
+void
+I2CModelArbLost(int32_t i32Commands)
+{
+    g_i32ArbLost = i32Commands;
+}
+
+//*****************************************************************************
+//
+// The device holds the clock low during the command after i32Commands more,
+// then holds data low until clocked ui32Clocks times.  If bTimeout is true
+// the master's clock low timeout ends the command; if not, the command
+// never ends.  -1 cancels.
+//
+//*****************************************************************************
+void
+I2CModelStick(int32_t i32Commands, uint32_t ui32Clocks, bool bTimeout)
+{
+    g_i32Stick = i32Commands;
+    g_ui32StickClocks = ui32Clocks;
+    g_bStickTimeout = bTimeout;
+}
+
+//*****************************************************************************
+//
+// The device holds data low now, until clocked ui32Clocks times, as after
+// a reset of the master part way through a read.
+//
+//*****************************************************************************
+void
+I2CModelHold(uint32_t ui32Clocks)
+{
+    g_ui32Held = ui32Clocks;
+    g_bSDAHigh = !ui32Clocks;
+}
+
+//*****************************************************************************
+//
+// Returns whether the master's interrupt is asserted.
+//
+//*****************************************************************************
+bool
+I2CModelPending(void)
+{
+    return((g_ui32Raw & g_ui32Mask) != 0);
+}
+
+//*****************************************************************************
+//
+// Adds a token to the log.
+//
+//*****************************************************************************
+static void
+Log(const char *pcFormat, ...)
+{
+    va_list vaArgs;
+    size_t sLen;
+
+    sLen = strlen(g_sI2CModel.pcLog);
+    if(sLen && (sLen < (I2C_MODEL_LOG - 1)))
+    {
+        g_sI2CModel.pcLog[sLen++] = ' ';
+    }
+    va_start(vaArgs, pcFormat);
+    vsnprintf(g_sI2CModel.pcLog + sLen, I2C_MODEL_LOG - sLen, pcFormat,
+              vaArgs);
+    va_end(vaArgs);
+}
+
+//*****************************************************************************
+//
+// Counts down a fault, returning true when it strikes.
+//
+//*****************************************************************************
+static bool
+Due(int32_t *pi32Count)
+{
+    if(*pi32Count < 0)
+    {
+        return(false);
+    }
+    if(*pi32Count == 0)
+    {
+        *pi32Count = -1;
+        return(true);
+    }
+    (*pi32Count)--;
+    return(false);
+}
+
+//*****************************************************************************
+//
+// The level of a line: low if driven low by its pin, or, for SDA, by the
+// device.
+//
+//*****************************************************************************
+static bool
+Level(tPin *psPin)
+{
+    return((psPin->ui32Mode != PIN_OUTPUT) || psPin->bLatch);
+}
+
+static bool
+SDALevel(void)
+{
+    return(Level(&g_sSDA) && !g_ui32Held);
+}
+
+//*****************************************************************************
+//
+// Follows the lines after a pin changes: counts clocks, which free a device
+// holding data, and spots a start then stop, which resets it.
+//
+//*****************************************************************************
+static void
+Lines(void)
+{
+    bool bSCL, bSDA;
+
+    bSCL = Level(&g_sSCL);
+    if(bSCL && !g_bSCLHigh)
+    {
+        g_sI2CModel.ui32Clocks++;
+        if(g_ui32Held)
+        {
+            g_ui32Held--;
+        }
+    }
+
+    bSDA = SDALevel();
+    if(bSCL && g_bSCLHigh && (bSDA != g_bSDAHigh))
+    {
+        if(!bSDA)
+        {
+            g_bStarted = true;
+        }
+        else if(g_bStarted)
+        {
+            Log("X");
+            g_bStarted = false;
+            g_bFirst = true;
+        }
+    }
+
+    g_bSCLHigh = bSCL;
+    g_bSDAHigh = bSDA;
+}
+
+//*****************************************************************************
+//
+// The master (driverlib/i2c.c on the target).
+//
+//*****************************************************************************
+void
+I2CMasterInitExpClk(uint32_t ui32Base, uint32_t ui32I2CClk, bool bFast)
+{
+    g_bEnabled = true;
+    g_bOwned = false;
+    g_ui32Err = I2C_MASTER_ERR_NONE;
+    g_sI2CModel.ui32Inits++;
+}
+
+void
+I2CMasterTimeoutSet(uint32_t ui32Base, uint32_t ui32Value)
+{
+}
+
+void
+I2CMasterDisable(uint32_t ui32Base)
+{
+    g_bEnabled = false;
+    g_bOwned = false;
+}
+
+bool
+I2CMasterBusBusy(uint32_t ui32Base)
+{
+    return(g_ui32Held != 0);
+}
+
+void
+I2CMasterSlaveAddrSet(uint32_t ui32Base, uint8_t ui8SlaveAddr, bool bReceive)
+{
+    g_ui8Slave = ui8SlaveAddr;
+    g_bReceiveNext = bReceive;
+}
+
+void
+I2CMasterDataPut(uint32_t ui32Base, uint8_t ui8Data)
+{
+    g_ui8Data = ui8Data;
+}
+
+uint32_t
+I2CMasterDataGet(uint32_t ui32Base)
+{
+    return(g_ui8Data);
+}
+
+uint32_t
+I2CMasterErr(uint32_t ui32Base)
+{
+    return(g_ui32Err);
+}
+
+void
+I2CMasterIntEnableEx(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    g_ui32Mask |= ui32IntFlags;
+}
+
+void
+I2CMasterIntClearEx(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    g_ui32Raw &= ~ui32IntFlags;
+}
+
+uint32_t
+I2CMasterIntStatusEx(uint32_t ui32Base, bool bMasked)
+{
+    return(bMasked ? (g_ui32Raw & g_ui32Mask) : g_ui32Raw);
+}
+
+void
+I2CMasterControl(uint32_t ui32Base, uint32_t ui32Cmd)
+{
+    if(!g_bEnabled || (g_sSCL.ui32Mode != PIN_I2C) ||
+       (g_sSDA.ui32Mode != PIN_I2C) || g_ui32Held ||
+       (!(ui32Cmd & CMD_START) && !g_bOwned))
+    {
+        g_sI2CModel.ui32Violations++;
+        return;
+    }
+    g_ui32Err = I2C_MASTER_ERR_NONE;
+
+    if(Due(&g_i32ArbLost))
+    {
+        Log("A");
+        g_bOwned = false;
+        g_ui32Err = I2C_MASTER_ERR_ARB_LOST;
+        g_ui32Raw |= I2C_MASTER_INT_DATA;
+        return;
+    }
+    if(Due(&g_i32Stick))
+    {
+        Log("T");
+        g_bOwned = false;
+        I2CModelHold(g_ui32StickClocks);
+        if(g_bStickTimeout)
+        {
+            g_ui32Err = I2C_MASTER_ERR_CLK_TOUT;
+            g_ui32Raw |= I2C_MASTER_INT_DATA | I2C_MASTER_INT_TIMEOUT;
+        }
+        return;
+    }
+
+    if(ui32Cmd & CMD_START)
+    {
+        Log(g_bOwned ? "Sr" : "S");
+        g_bOwned = true;
+        g_bReceive = g_bReceiveNext;
+        if(g_ui8Slave == g_sI2CModel.ui8Addr)
+        {
+            Log("%02x%c", g_ui8Slave, g_bReceive ? 'r' : 'w');
+            g_bFirst = !g_bReceive;
+        }
+        else
+        {
+            Log("%02x%c!", g_ui8Slave, g_bReceive ? 'r' : 'w');
+            g_ui32Err = I2C_MASTER_ERR_ADDR_ACK;
+        }
+    }
+
+    if((ui32Cmd & CMD_RUN) && (g_ui32Err == I2C_MASTER_ERR_NONE))
+    {
+        if(g_bReceive)
+        {
+            g_ui8Data = g_sI2CModel.pui8Regs[g_ui8Ptr++];
+            Log("<%02x%s", g_ui8Data, (ui32Cmd & CMD_ACK) ? "" : ".");
+        }
+        else if(Due(&g_i32Nak))
+        {
+            Log("=%02x!", g_ui8Data);
+            g_ui32Err = I2C_MASTER_ERR_DATA_ACK;
+        }
+        else
+        {
+            Log("=%02x", g_ui8Data);
+            if(g_bFirst)
+            {
+                g_ui8Ptr = g_ui8Data;
+                g_bFirst = false;
+            }
+            else
+            {
+                g_sI2CModel.pui8Regs[g_ui8Ptr++] = g_ui8Data;
+            }
+        }
+    }
+
+    if(ui32Cmd & CMD_STOP)
+    {
+        Log("P");
+        g_bOwned = false;
+    }
+    g_ui32Raw |= I2C_MASTER_INT_DATA;
+}
+
+//*****************************************************************************
+//
+// The pins (driverlib/gpio.c on the target).  Only the master's two are
+// modelled.
+//
+//*****************************************************************************
+static void
+PinsSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32Mode)
+{
+    if((ui32Port == g_sSCL.ui32Port) && (ui8Pins & g_sSCL.ui8Pin))
+    {
+        g_sSCL.ui32Mode = ui32Mode;
+    }
+    if((ui32Port == g_sSDA.ui32Port) && (ui8Pins & g_sSDA.ui8Pin))
+    {
+        g_sSDA.ui32Mode = ui32Mode;
+    }
+    Lines();
+}
+
+void
+GPIOPinWrite(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Val)
+{
+    if((ui32Port == g_sSCL.ui32Port) && (ui8Pins & g_sSCL.ui8Pin))
+    {
+        g_sSCL.bLatch = (ui8Val & g_sSCL.ui8Pin) != 0;
+    }
+    if((ui32Port == g_sSDA.ui32Port) && (ui8Pins & g_sSDA.ui8Pin))
+    {
+        g_sSDA.bLatch = (ui8Val & g_sSDA.ui8Pin) != 0;
+    }
+    Lines();
+}
+
+int32_t
+GPIOPinRead(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    int32_t i32Val;
+
+    i32Val = 0;
+    if((ui32Port == g_sSCL.ui32Port) && (ui8Pins & g_sSCL.ui8Pin) &&
+       Level(&g_sSCL))
+    {
+        i32Val |= g_sSCL.ui8Pin;
+    }
+    if((ui32Port == g_sSDA.ui32Port) && (ui8Pins & g_sSDA.ui8Pin) &&
+       SDALevel())
+    {
+        i32Val |= g_sSDA.ui8Pin;
+    }
+    return(i32Val);
+}
+
+void
+GPIOPinTypeGPIOInput(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    PinsSet(ui32Port, ui8Pins, PIN_INPUT);
+}
+
+void
+GPIOPinTypeGPIOOutputOD(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    PinsSet(ui32Port, ui8Pins, PIN_OUTPUT);
+}
+
+void
+GPIOPinTypeI2C(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    PinsSet(ui32Port, ui8Pins, PIN_I2C);
+}
+
+void
+GPIOPinTypeI2CSCL(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    PinsSet(ui32Port, ui8Pins, PIN_I2C);
+}
+
+//*****************************************************************************
+//
+// The clock (driverlib/sysctl.c on the target).
+//
+//*****************************************************************************
+uint32_t
+SysCtlClockGet(void)
+{
+    return(80000000);
+}
+
+void
+SysCtlDelay(uint32_t ui32Count)
+{
+}
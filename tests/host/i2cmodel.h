@@ -0,0 +1,62 @@
+//*****************************************************************************
+//
+// i2cmodel.h - A model of the TM4C123 I2C master, its pins and a register
+// file device on the bus, for the host tests.
+//
+//*****************************************************************************
+
+#ifndef __I2CMODEL_H__
+#define __I2CMODEL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//*****************************************************************************
+//
+// What the model has seen.  The log is the bus traffic, a token per event:
+//
+//     S, Sr       start, repeated start
+//     48w, 48r    address and direction (hex), ! appended if not acknowledged
+//     =10         byte written, ! appended if not acknowledged
+//     <10, <10.   byte read, acknowledged by the master or not
+//     P           stop
+//     A           arbitration lost; the master has let go of the bus
+//     T           the device held the clock; it then holds data low
+//     X           a start and stop made by hand, which reset the device
+//
+// A violation is a command the master cannot take: one while it is off or
+// its pins are not in I2C mode, or one that carries on a transfer it does
+// not have.
+//
+//*****************************************************************************
+#define I2C_MODEL_LOG           256
+
+typedef struct
+{
+    uint8_t ui8Addr;
+    uint8_t pui8Regs[256];
+    char pcLog[I2C_MODEL_LOG];
+    uint32_t ui32Inits;
+    uint32_t ui32Clocks;
+    uint32_t ui32Violations;
+}
+tI2CModelStats;
+
+extern tI2CModelStats g_sI2CModel;
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void I2CModelInit(uint8_t ui8Addr, uint32_t ui32SCLPort,
+                         uint8_t ui8SCLPin, uint32_t ui32SDAPort,
+                         uint8_t ui8SDAPin);
+extern void I2CModelNak(int32_t i32Bytes);
+extern void I2CModelArbLost(int32_t i32Commands);
+extern void I2CModelStick(int32_t i32Commands, uint32_t ui32Clocks,
+                          bool bTimeout);
+extern void I2CModelHold(uint32_t ui32Clocks);
+extern bool I2CModelPending(void);
+
+#endif // __I2CMODEL_H__
@@ -0,0 +1,16 @@
+//*****************************************************************************
+//
+// flash.h - Host stand-in: implemented by the flash model, flashmodel.c.
+//
+//*****************************************************************************
+
+#ifndef __DRIVERLIB_FLASH_H__
+#define __DRIVERLIB_FLASH_H__
+
+#include <stdint.h>
+
+extern int32_t FlashErase(uint32_t ui32Address);
+extern int32_t FlashProgram(uint32_t *pui32Data, uint32_t ui32Address,
+                            uint32_t ui32Count);
+
+#endif // __DRIVERLIB_FLASH_H__
@@ -0,0 +1,12 @@
+//*****************************************************************************
+//
+// fpu.h - Host stand-in: implemented by host.c.
+//
+//*****************************************************************************
+
+#ifndef __DRIVERLIB_FPU_H__
+#define __DRIVERLIB_FPU_H__
+
+extern void FPULazyStackingEnable(void);
+
+#endif // __DRIVERLIB_FPU_H__
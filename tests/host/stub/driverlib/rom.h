@@ -0,0 +1,5 @@
+//*****************************************************************************
+//
+// rom.h - Host stand-in: there is no ROM; see rom_map.h.
+//
+//*****************************************************************************
@@ -0,0 +1,43 @@
+//*****************************************************************************
+//
+// rom_map.h - Host stand-in: every MAP_ call goes to the host function.
+//
+//*****************************************************************************
+
+#ifndef __DRIVERLIB_ROM_MAP_H__
+#define __DRIVERLIB_ROM_MAP_H__
+
+#define MAP_FlashErase          FlashErase
+#define MAP_FlashProgram        FlashProgram
+#define MAP_FPULazyStackingEnable FPULazyStackingEnable
+#define MAP_GPIOPinRead         GPIOPinRead
+#define MAP_GPIOPinTypeGPIOInput GPIOPinTypeGPIOInput
+#define MAP_GPIOPinTypeGPIOOutputOD GPIOPinTypeGPIOOutputOD
+#define MAP_GPIOPinTypeI2C      GPIOPinTypeI2C
+#define MAP_GPIOPinTypeI2CSCL   GPIOPinTypeI2CSCL
+#define MAP_GPIOPinWrite        GPIOPinWrite
+#define MAP_I2CMasterBusBusy    I2CMasterBusBusy
+#define MAP_I2CMasterControl    I2CMasterControl
+#define MAP_I2CMasterDataGet    I2CMasterDataGet
+#define MAP_I2CMasterDataPut    I2CMasterDataPut
+#define MAP_I2CMasterDisable    I2CMasterDisable
+#define MAP_I2CMasterErr        I2CMasterErr
+#define MAP_I2CMasterInitExpClk I2CMasterInitExpClk
+#define MAP_I2CMasterIntClearEx I2CMasterIntClearEx
+#define MAP_I2CMasterIntEnableEx I2CMasterIntEnableEx
+#define MAP_I2CMasterIntStatusEx I2CMasterIntStatusEx
+#define MAP_I2CMasterSlaveAddrSet I2CMasterSlaveAddrSet
+#define MAP_I2CMasterTimeoutSet I2CMasterTimeoutSet
+#define MAP_IntDisable          IntDisable
+#define MAP_IntEnable           IntEnable
+#define MAP_IntMasterDisable    IntMasterDisable
+#define MAP_IntMasterEnable     IntMasterEnable
+#define MAP_IntPrioritySet      IntPrioritySet
+#define MAP_SysCtlClockGet      SysCtlClockGet
+#define MAP_SysCtlDelay         SysCtlDelay
+#define MAP_uDMAChannelEnable   uDMAChannelEnable
+#define MAP_uDMAChannelRequest  uDMAChannelRequest
+#define MAP_uDMAChannelScatterGatherSet uDMAChannelScatterGatherSet
+#define MAP_uDMAControlBaseGet  uDMAControlBaseGet
+
+#endif // __DRIVERLIB_ROM_MAP_H__
@@ -0,0 +1,16 @@
+//*****************************************************************************
+//
+// sysctl.h - Host stand-in: implemented by the I2C model, i2cmodel.c, which
+// is the only model that needs the clock.
+//
+//*****************************************************************************
+
+#ifndef __DRIVERLIB_SYSCTL_H__
+#define __DRIVERLIB_SYSCTL_H__
+
+#include <stdint.h>
+
+extern uint32_t SysCtlClockGet(void);
+extern void SysCtlDelay(uint32_t ui32Count);
+
+#endif // __DRIVERLIB_SYSCTL_H__
@@ -0,0 +1,14 @@
+//*****************************************************************************
+//
+// hw_ints.h - Host stand-in: the exception numbers the tested code uses.
+//
+//*****************************************************************************
+
+#ifndef __HW_INTS_H__
+#define __HW_INTS_H__
+
+#define FAULT_PENDSV            14
+#define FAULT_SYSTICK           15
+#define INT_I2C0                24
+
+#endif // __HW_INTS_H__
@@ -0,0 +1,14 @@
+//*****************************************************************************
+//
+// hw_memmap.h - Host stand-in: the base addresses the tests use.  The
+// models do not map them; they only tell peripherals apart.
+//
+//*****************************************************************************
+
+#ifndef __HW_MEMMAP_H__
+#define __HW_MEMMAP_H__
+
+#define GPIO_PORTB_BASE         0x40005000
+#define I2C0_BASE               0x40020000
+
+#endif // __HW_MEMMAP_H__
@@ -0,0 +1,15 @@
+//*****************************************************************************
+//
+// hw_nvic.h - Host stand-in: the interrupt control register, as on the
+// Cortex-M4.  host.c keeps its active vector bits up to date.
+//
+//*****************************************************************************
+
+#ifndef __HW_NVIC_H__
+#define __HW_NVIC_H__
+
+#define NVIC_INT_CTRL           0xE000ED04
+#define NVIC_INT_CTRL_PEND_SV   0x10000000
+#define NVIC_INT_CTRL_VEC_ACT_M 0x000000FF
+
+#endif // __HW_NVIC_H__
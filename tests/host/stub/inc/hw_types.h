@@ -0,0 +1,16 @@
+//*****************************************************************************
+//
+// hw_types.h - Host stand-in: register accesses go to host.c's register file.
+//
+//*****************************************************************************
+
+#ifndef __HW_TYPES_H__
+#define __HW_TYPES_H__
+
+#include <stdint.h>
+
+extern volatile uint32_t *HostRegister(uint32_t ui32Address);
+
+#define HWREG(x)                (*HostRegister((uint32_t)(x)))
+
+#endif // __HW_TYPES_H__
@@ -0,0 +1,22 @@
+//*****************************************************************************
+//
+// hw_udma.h - Host stand-in: the control word fields the modules use.
+//
+//*****************************************************************************
+
+#ifndef __HW_UDMA_H__
+#define __HW_UDMA_H__
+
+#define UDMA_CHCTL_XFERMODE_M   0x00000007
+#define UDMA_CHCTL_XFERSIZE_M   0x00003FF0
+#define UDMA_CHCTL_XFERSIZE_S   4
+#define UDMA_CHCTL_ARBSIZE_M    0x0003C000
+#define UDMA_CHCTL_ARBSIZE_S    14
+#define UDMA_CHCTL_SRCSIZE_M    0x03000000
+#define UDMA_CHCTL_SRCSIZE_S    24
+#define UDMA_CHCTL_SRCINC_M     0x0C000000
+#define UDMA_CHCTL_SRCINC_S     26
+#define UDMA_CHCTL_DSTINC_M     0xC0000000
+#define UDMA_CHCTL_DSTINC_S     30
+
+#endif // __HW_UDMA_H__
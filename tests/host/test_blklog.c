@@ -0,0 +1,678 @@
+//*****************************************************************************
+//
+// test_blklog.c - Host tests of utils/blklog.c on the block device model:
+// formatting, finding the end of the log, a reset part way through a
+// record, a full card, a device that is slow or fails, and the pipeline
+// stage.
+//
+// The log is read back here as tools/blklog_read.py reads a card image,
+// from the layout in blklog.h alone.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "utils/mempool.h"
+#include "utils/pipeline.h"
+#include "utils/telemetry.h"
+#include "utils/blockdev.h"
+#include "utils/blklog.h"
+#include "blkmodel.h"
+#include "host.h"
+
+#define CARD_BLOCKS             1024
+#define MAX_RECORDS             2048
+
+//*****************************************************************************
+//
+// Record n: its length, format and data all follow from n.
+//
+//*****************************************************************************
+#define RECORD_BYTES(n)         (1 + (((n) * 131) % BLKLOG_MAX_DATA))
+#define RECORD_FORMAT(n)        ((n) % 4)
+#define RECORD_TIME(n)          ((n) * 16)
+#define STAGE_SEQ               2001    // its format counts bytes, not samples
+
+//*****************************************************************************
+//
+// The layout, as blklog.h describes it.
+//
+//*****************************************************************************
+#define SUPER_MAGIC             0x534B4C42
+#define BLOCK_MAGIC             0x444B4C42
+#define RECORD_MAGIC            0xA5
+#define RECORD_HEADER           12
+#define FIRST_NONE              0xFFFF
+#define NOT_RECORD              0xFFFFFFFF
+
+typedef struct
+{
+    uint32_t ui32Format;
+    uint32_t ui32Seq;
+    uint32_t ui32Time;
+    uint32_t ui32Bytes;
+}
+tRecord;
+
+static tBlkLog g_sLog;
+static uint8_t g_pui8Data[BLKLOG_MAX_DATA];
+
+//*****************************************************************************
+//
+// What ReadLog() found: the records, in order, records cut short, and
+// records whose contents did not follow from their sequence number.
+//
+//*****************************************************************************
+static tRecord g_psRead[MAX_RECORDS];
+static uint32_t g_ui32Read;
+static uint32_t g_ui32Torn;
+static uint32_t g_ui32Bad;
+static uint8_t g_pui8Pending[RECORD_HEADER + BLKLOG_MAX_DATA + 4];
+
+static void
+Fill(uint32_t ui32Seq)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < RECORD_BYTES(ui32Seq); ui32Idx++)
+    {
+        g_pui8Data[ui32Idx] = (uint8_t)((ui32Seq * 7) + ui32Idx);
+    }
+}
+
+static uint32_t
+Append(uint32_t ui32Seq)
+{
+    Fill(ui32Seq);
+    return(BlkLogAppend(&g_sLog, RECORD_FORMAT(ui32Seq), ui32Seq,
+                        RECORD_TIME(ui32Seq), g_pui8Data,
+                        RECORD_BYTES(ui32Seq)));
+}
+
+static void
+Service(void)
+{
+    while(BlkLogService(&g_sLog))
+    {
+    }
+}
+
+//*****************************************************************************
+//
+// Appends a record, servicing the log while it is busy, as the pipeline
+// stage is retried.
+//
+//*****************************************************************************
+static uint32_t
+AppendWait(uint32_t ui32Seq)
+{
+    uint32_t ui32Result;
+
+    while((ui32Result = Append(ui32Seq)) == BLKLOG_BUSY)
+    {
+        BlkLogService(&g_sLog);
+    }
+    return(ui32Result);
+}
+
+//*****************************************************************************
+//
+// Appends records and writes them all out.
+//
+//*****************************************************************************
+static void
+AppendRun(uint32_t ui32First, uint32_t ui32Count)
+{
+    while(ui32Count--)
+    {
+        CHECK(AppendWait(ui32First++) == BLKLOG_OK);
+    }
+    BlkLogFlush(&g_sLog);
+    Service();
+}
+
+//*****************************************************************************
+//
+// Writes ui32Blocks blocks of one record each, skipping records too big for
+// a block.  Returns the sequence number of the next record.
+//
+//*****************************************************************************
+static uint32_t
+AppendBlocks(uint32_t ui32Seq, uint32_t ui32Blocks)
+{
+    while(ui32Blocks--)
+    {
+        while((RECORD_HEADER + RECORD_BYTES(ui32Seq)) > BLKLOG_PAYLOAD)
+        {
+            ui32Seq++;
+        }
+        CHECK(AppendWait(ui32Seq++) == BLKLOG_OK);
+        BlkLogFlush(&g_sLog);
+    }
+    Service();
+    return(ui32Seq);
+}
+
+static bool
+Mount(void)
+{
+    return(BlkLogMount(&g_sLog, &g_sBlkModelDev));
+}
+
+//*****************************************************************************
+//
+// Size of the record at pui8Rec, padded, 0 if fewer than a header's bytes
+// are there to tell, or NOT_RECORD.
+//
+//*****************************************************************************
+static uint32_t
+RecordSize(const uint8_t *pui8Rec, uint32_t ui32Avail)
+{
+    if(ui32Avail < RECORD_HEADER)
+    {
+        return(0);
+    }
+    if(pui8Rec[3] != RECORD_MAGIC)
+    {
+        return(NOT_RECORD);
+    }
+    return(RECORD_HEADER + (((pui8Rec[0] | (pui8Rec[1] << 8)) + 3) & ~3));
+}
+
+static void
+Parse(const uint8_t *pui8Rec)
+{
+    tRecord *psRecord;
+
+    if(g_ui32Read == MAX_RECORDS)
+    {
+        g_ui32Bad++;
+        return;
+    }
+    psRecord = &g_psRead[g_ui32Read++];
+    memcpy(&psRecord->ui32Seq, pui8Rec + 4, 4);
+    memcpy(&psRecord->ui32Time, pui8Rec + 8, 4);
+    psRecord->ui32Format = pui8Rec[2];
+    psRecord->ui32Bytes = pui8Rec[0] | (pui8Rec[1] << 8);
+
+    Fill(psRecord->ui32Seq);
+    if((psRecord->ui32Bytes != RECORD_BYTES(psRecord->ui32Seq)) ||
+       (psRecord->ui32Format != RECORD_FORMAT(psRecord->ui32Seq)) ||
+       (psRecord->ui32Time != RECORD_TIME(psRecord->ui32Seq)) ||
+       memcmp(pui8Rec + RECORD_HEADER, g_pui8Data, psRecord->ui32Bytes))
+    {
+        g_ui32Bad++;
+    }
+}
+
+//*****************************************************************************
+//
+// Tells whether data block ui32Index is valid for ui32Generation.
+//
+//*****************************************************************************
+static bool
+BlockValid(uint32_t ui32Index, uint32_t ui32Generation)
+{
+    const uint32_t *pui32Block;
+    uint32_t ui32Used;
+
+    if((ui32Index + 1) >= g_sBlkModelDev.ui32Blocks)
+    {
+        return(false);
+    }
+    pui32Block = (const uint32_t *)BlkModelBlock(ui32Index + 1);
+    ui32Used = pui32Block[3] & 0xFFFF;
+    return((pui32Block[0] == BLOCK_MAGIC) &&
+           (pui32Block[1] == ui32Generation) &&
+           (pui32Block[2] == ui32Index) && (ui32Used <= BLKLOG_PAYLOAD) &&
+           (pui32Block[4] ==
+            TelemetryCRC16(TelemetryCRC16(0xFFFF, (const uint8_t *)pui32Block,
+                                          16),
+                           (const uint8_t *)pui32Block + BLKLOG_HEADER,
+                           ui32Used)));
+}
+
+//*****************************************************************************
+//
+// Reads the whole log on the card into g_psRead.  Returns the number of
+// records read.
+//
+//*****************************************************************************
+static uint32_t
+ReadLog(void)
+{
+    const uint32_t *pui32Super;
+    const uint8_t *pui8Payload;
+    uint32_t ui32Generation, ui32Index, ui32Used, ui32First, ui32Pending;
+    uint32_t ui32Size, ui32Off;
+
+    g_ui32Read = 0;
+    g_ui32Torn = 0;
+    g_ui32Bad = 0;
+    pui32Super = (const uint32_t *)BlkModelBlock(0);
+    if((pui32Super[0] != SUPER_MAGIC) || (pui32Super[2] != ~pui32Super[1]))
+    {
+        return(0);
+    }
+    ui32Generation = pui32Super[1];
+
+    ui32Pending = 0;
+    for(ui32Index = 0; BlockValid(ui32Index, ui32Generation); ui32Index++)
+    {
+        pui8Payload = BlkModelBlock(ui32Index + 1) + BLKLOG_HEADER;
+        ui32Used = ((const uint32_t *)BlkModelBlock(ui32Index + 1))[3] &
+                   0xFFFF;
+        ui32First = ((const uint32_t *)BlkModelBlock(ui32Index + 1))[3] >> 16;
+        if(ui32First == FIRST_NONE)
+        {
+            ui32First = ui32Used;
+        }
+
+        //
+        // The end of a record begun in an earlier block.
+        //
+        if(ui32Pending)
+        {
+            if((ui32Pending + ui32First) > sizeof(g_pui8Pending))
+            {
+                ui32First = ui32Used;
+                ui32Size = NOT_RECORD;
+            }
+            else
+            {
+                memcpy(g_pui8Pending + ui32Pending, pui8Payload, ui32First);
+                ui32Pending += ui32First;
+                ui32Size = RecordSize(g_pui8Pending, ui32Pending);
+            }
+            if(ui32Size && (ui32Size != NOT_RECORD) &&
+               (ui32Pending == ui32Size))
+            {
+                Parse(g_pui8Pending);
+                ui32Pending = 0;
+            }
+            else if((ui32Size == NOT_RECORD) ||
+                    (ui32Size && (ui32Pending > ui32Size)) ||
+                    (ui32First < ui32Used))
+            {
+                g_ui32Torn++;
+                ui32Pending = 0;
+            }
+        }
+        else if(ui32First)
+        {
+            g_ui32Torn++;
+        }
+        if(ui32First == ui32Used)
+        {
+            continue;
+        }
+
+        for(ui32Off = ui32First; ui32Off < ui32Used; ui32Off += ui32Size)
+        {
+            ui32Size = RecordSize(pui8Payload + ui32Off, ui32Used - ui32Off);
+            if(!ui32Size || (ui32Size == NOT_RECORD) ||
+               ((ui32Used - ui32Off) < ui32Size))
+            {
+                break;
+            }
+            Parse(pui8Payload + ui32Off);
+        }
+        ui32Pending = ui32Used - ui32Off;
+        memcpy(g_pui8Pending, pui8Payload + ui32Off, ui32Pending);
+    }
+    if(ui32Pending)
+    {
+        g_ui32Torn++;
+    }
+
+    return(g_ui32Read);
+}
+
+//*****************************************************************************
+//
+// Checks that g_psRead[ui32From] on holds records ui32First to ui32Last.
+//
+//*****************************************************************************
+static void
+CheckRun(uint32_t ui32From, uint32_t ui32First, uint32_t ui32Last)
+{
+    uint32_t ui32Idx;
+
+    CHECK(g_ui32Read >= (ui32From + ui32Last - ui32First + 1));
+    for(ui32Idx = 0; (ui32Idx <= (ui32Last - ui32First)) &&
+                     ((ui32From + ui32Idx) < g_ui32Read); ui32Idx++)
+    {
+        if(g_psRead[ui32From + ui32Idx].ui32Seq != (ui32First + ui32Idx))
+        {
+            CHECK(g_psRead[ui32From + ui32Idx].ui32Seq ==
+                  (ui32First + ui32Idx));
+            return;
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// A card that was never formatted is not mounted and takes no records;
+// formatting makes an empty log, records read back, a remount finds where
+// it ended, and formatting again empties it without touching the blocks.
+//
+//*****************************************************************************
+static void
+TestFormat(void)
+{
+    uint32_t ui32Assigned;
+
+    BlkModelInit(CARD_BLOCKS, 0x00);
+    CHECK(!Mount());
+    CHECK(Append(0) == BLKLOG_DROPPED);
+    CHECK(g_sLog.ui32Dropped == 1);
+
+    CHECK(BlkLogFormat(&g_sLog));
+    CHECK(g_sLog.ui32Generation == 1);
+    CHECK(ReadLog() == 0);
+    CHECK(Mount());
+    CHECK(g_sLog.ui32Assigned == 0);
+
+    AppendRun(0, 100);
+    CHECK(ReadLog() == 100);
+    CheckRun(0, 0, 99);
+    CHECK((g_ui32Torn == 0) && (g_ui32Bad == 0));
+    ui32Assigned = g_sLog.ui32Assigned;
+    CHECK(g_sLog.ui32Written == ui32Assigned);
+
+    CHECK(Mount());
+    CHECK(g_sLog.ui32Generation == 1);
+    CHECK(g_sLog.ui32Mounted == ui32Assigned);
+    AppendRun(100, 10);
+    CHECK(ReadLog() == 110);
+    CheckRun(0, 0, 109);
+    CHECK((g_ui32Torn == 0) && (g_ui32Bad == 0));
+
+    CHECK(BlkLogFormat(&g_sLog));
+    CHECK(g_sLog.ui32Generation == 2);
+    CHECK(ReadLog() == 0);
+    CHECK(((uint32_t *)BlkModelBlock(1))[0] == BLOCK_MAGIC);
+    CHECK(Mount());
+    CHECK(g_sLog.ui32Assigned == 0);
+    CHECK(g_sBlkModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// BlkLogMount() finds the end of logs of every length, past blocks left by
+// an older generation, in about log2(blocks) reads.
+//
+//*****************************************************************************
+static void
+TestBisection(void)
+{
+    static const uint32_t pui32Lengths[] =
+    {
+        0, 1, 2, 3, 511, 512, 513, 1000, CARD_BLOCKS - 2, CARD_BLOCKS - 1
+    };
+    uint32_t ui32Idx, ui32Length, ui32Reads, ui32Seq;
+
+    for(ui32Idx = 0; ui32Idx < (sizeof(pui32Lengths) / sizeof(uint32_t));
+        ui32Idx++)
+    {
+        ui32Length = pui32Lengths[ui32Idx];
+
+        //
+        // A full log of small records, a block each, then a new generation
+        // of ui32Length blocks over it.
+        //
+        BlkModelInit(CARD_BLOCKS, 0xFF);
+        CHECK(!Mount());
+        CHECK(BlkLogFormat(&g_sLog));
+        AppendBlocks(0, CARD_BLOCKS - 1);
+        CHECK(g_sLog.ui32Written == (CARD_BLOCKS - 1));
+        CHECK(BlkLogFormat(&g_sLog));
+        ui32Seq = AppendBlocks(0, ui32Length);
+
+        ui32Reads = g_sBlkModel.ui32Reads;
+        CHECK(Mount());
+        CHECK(g_sLog.ui32Assigned == ui32Length);
+        CHECK((g_sBlkModel.ui32Reads - ui32Reads) <= 11);
+
+        if(ui32Length == (CARD_BLOCKS - 1))
+        {
+            CHECK(Append(ui32Seq) == BLKLOG_DROPPED);
+        }
+        else
+        {
+            AppendRun(ui32Seq, 1);
+            CHECK(ReadLog() == (ui32Length + 1));
+            CHECK(g_psRead[ui32Length].ui32Seq == ui32Seq);
+        }
+        CHECK((g_ui32Torn == 0) && (g_ui32Bad == 0));
+        CHECK(g_sBlkModel.ui32Violations == 0);
+    }
+}
+
+//*****************************************************************************
+//
+// A reset after every number of block writes up to a dozen, each time part
+// way through a record and with the next block half written: the records
+// before read back whole, at most the one cut short is lost, and the log
+// carries on after the last whole block.
+//
+//*****************************************************************************
+static void
+TestReset(void)
+{
+    uint32_t ui32Cut, ui32Base, ui32Blocks, ui32Last, ui32Used;
+
+    for(ui32Cut = 0; ui32Cut < 12; ui32Cut++)
+    {
+        BlkModelInit(CARD_BLOCKS, 0xFF);
+        Mount();
+        CHECK(BlkLogFormat(&g_sLog));
+        AppendRun(0, 10);
+        ui32Base = ReadLog();
+        ui32Blocks = g_sLog.ui32Assigned;
+
+        BlkModelCut(ui32Cut);
+        for(ui32Last = 10; g_sLog.ui32Written < (ui32Blocks + ui32Cut + 2);
+            ui32Last++)
+        {
+            CHECK(AppendWait(ui32Last) == BLKLOG_OK);
+        }
+        BlkModelCut(-1);
+
+        //
+        // The half written block is whole if its payload was that short.
+        //
+        ui32Used = ((uint32_t *)BlkModelBlock(ui32Blocks + ui32Cut + 1))[3] &
+                   0xFFFF;
+        ui32Blocks += ui32Cut +
+                      (ui32Used <= ((BLOCKDEV_BLOCK_SIZE / 2) - BLKLOG_HEADER));
+        CHECK(Mount());
+        CHECK(g_sLog.ui32Assigned == ui32Blocks);
+        CHECK(ReadLog() >= ui32Base);
+        CHECK(g_ui32Read < ui32Last);
+        CheckRun(0, 0, g_ui32Read - 1);
+        CHECK(g_ui32Torn <= 1);
+        CHECK(g_ui32Bad == 0);
+
+        AppendRun(1000, 3);
+        ui32Base = g_ui32Read;
+        CHECK(ReadLog() == (ui32Base + 3));
+        CheckRun(0, 0, ui32Base - 1);
+        CheckRun(ui32Base, 1000, 1002);
+        CHECK(g_ui32Torn <= 1);
+        CHECK(g_ui32Bad == 0);
+        CHECK(g_sBlkModel.ui32Violations == 0);
+    }
+}
+
+//*****************************************************************************
+//
+// A full card: records that do not fit are dropped, not written past the
+// end, and every one taken reads back; a remount finds it full.
+//
+//*****************************************************************************
+static void
+TestFull(void)
+{
+    uint32_t ui32Seq;
+
+    BlkModelInit(9, 0xFF);
+    Mount();
+    CHECK(BlkLogFormat(&g_sLog));
+    for(ui32Seq = 0; AppendWait(ui32Seq) == BLKLOG_OK; ui32Seq++)
+    {
+    }
+    CHECK(ui32Seq > 0);
+    CHECK(g_sLog.ui32Dropped == 1);
+    CHECK(Append(0) == BLKLOG_DROPPED);
+    CHECK(g_sLog.ui32Dropped == 2);
+    BlkLogFlush(&g_sLog);
+    Service();
+
+    CHECK(ReadLog() == ui32Seq);
+    CheckRun(0, 0, ui32Seq - 1);
+    CHECK((g_ui32Torn == 0) && (g_ui32Bad == 0));
+    CHECK(g_sBlkModel.ui32Writes <= 9);
+
+    CHECK(Mount());
+    CHECK(g_sLog.ui32Assigned == 8);
+    CHECK(Append(0) == BLKLOG_DROPPED);
+    CHECK(g_sBlkModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// A slow card: BLKLOG_BUSY once both buffers wait, with nothing copied; a
+// record too big for what is free seals the part-filled buffer so room
+// comes; the stage holds the pipeline back meanwhile.  Buffers are not
+// touched while the card takes them (the model reads them at the end).
+//
+//*****************************************************************************
+static uint32_t
+StageTime(void)
+{
+    return(RECORD_TIME(STAGE_SEQ));
+}
+
+static void
+TestBusy(void)
+{
+    static uint32_t pui32Block[(sizeof(tPipeBlock) + RECORD_BYTES(STAGE_SEQ) + 3) /
+                               4];
+    tBlkLogStage sStage = { &g_sLog, StageTime, false };
+    tPipeBlock *psBlock = (tPipeBlock *)pui32Block;
+    uint32_t ui32Seq, ui32Records, ui32Calls;
+
+    BlkModelInit(64, 0xFF);
+    Mount();
+    BlkModelBusy(20);
+    CHECK(BlkLogFormat(&g_sLog));
+
+    for(ui32Seq = 0; Append(ui32Seq) == BLKLOG_OK; ui32Seq++)
+    {
+    }
+    ui32Records = g_sLog.ui32Records;
+    CHECK(ui32Records == ui32Seq);
+    CHECK(g_sLog.ui32Sealed > 0);
+    CHECK(Append(ui32Seq) == BLKLOG_BUSY);
+    CHECK(g_sLog.ui32Records == ui32Records);
+    CHECK(AppendWait(ui32Seq++) == BLKLOG_OK);
+    BlkLogFlush(&g_sLog);
+    Service();
+
+    //
+    // Too big for the buffer being filled, with nothing being written.
+    //
+    CHECK(AppendWait(ui32Seq++) == BLKLOG_OK);
+    while(RECORD_BYTES(ui32Seq) < BLKLOG_PAYLOAD)
+    {
+        ui32Seq++;
+    }
+    CHECK(Append(ui32Seq) == BLKLOG_BUSY);
+    CHECK(g_sLog.ui32Sealed == 1);
+    CHECK(AppendWait(ui32Seq) == BLKLOG_OK);
+    BlkLogFlush(&g_sLog);
+    Service();
+
+    //
+    // The stage: nothing while not recording, then held back until a
+    // buffer is free.
+    //
+    Fill(STAGE_SEQ);
+    psBlock->pvData = psBlock + 1;
+    psBlock->ui32Format = RECORD_FORMAT(STAGE_SEQ);
+    psBlock->ui32Length = RECORD_BYTES(STAGE_SEQ);
+    psBlock->ui32Seq = STAGE_SEQ;
+    memcpy(psBlock->pvData, g_pui8Data, RECORD_BYTES(STAGE_SEQ));
+    ui32Records = g_sLog.ui32Records;
+    CHECK(BlkLogStageWrite(&sStage, psBlock) == PIPE_CONTINUE);
+    CHECK(g_sLog.ui32Records == ui32Records);
+
+    sStage.bRecording = true;
+    while(BlkLogStageWrite(&sStage, psBlock) == PIPE_CONTINUE)
+    {
+    }
+    ui32Records = g_sLog.ui32Records;
+    for(ui32Calls = 1; BlkLogStageWrite(&sStage, psBlock) == PIPE_BUSY;
+        ui32Calls++)
+    {
+        BlkLogService(&g_sLog);
+    }
+    CHECK(ui32Calls > 1);
+    CHECK(g_sLog.ui32Records == (ui32Records + 1));
+    BlkLogFlush(&g_sLog);
+    Service();
+
+    CHECK(ReadLog() == g_sLog.ui32Records);
+    CHECK((g_ui32Torn == 0) && (g_ui32Bad == 0));
+    CHECK(g_psRead[g_ui32Read - 1].ui32Seq == STAGE_SEQ);
+    CHECK(g_sBlkModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// A write the card fails stops the log, dropping records, until a remount
+// carries on after the last block written.
+//
+//*****************************************************************************
+static void
+TestFailed(void)
+{
+    uint32_t ui32Seq;
+
+    BlkModelInit(CARD_BLOCKS, 0xFF);
+    Mount();
+    CHECK(BlkLogFormat(&g_sLog));
+    BlkModelFail(3);
+    for(ui32Seq = 0; AppendWait(ui32Seq) == BLKLOG_OK; ui32Seq++)
+    {
+        BlkLogService(&g_sLog);
+    }
+    CHECK(g_sLog.ui32Errors == 1);
+    CHECK(g_sLog.ui32Written == 3);
+    CHECK(!BlkLogService(&g_sLog));
+
+    CHECK(Mount());
+    CHECK(g_sLog.ui32Assigned == 3);
+    AppendRun(1000, 3);
+    ReadLog();
+    CHECK(g_ui32Read >= 3);
+    CheckRun(g_ui32Read - 3, 1000, 1002);
+    CHECK(g_ui32Torn <= 1);
+    CHECK(g_ui32Bad == 0);
+    CHECK(g_sBlkModel.ui32Violations == 0);
+}
+
+int
+main(void)
+{
+    TestFormat();
+    TestBisection();
+    TestReset();
+    TestFull();
+    TestBusy();
+    TestFailed();
+    return(HostResult("blklog"));
+}
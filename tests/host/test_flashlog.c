@@ -0,0 +1,327 @@
+//*****************************************************************************
+//
+// test_flashlog.c - Host tests of utils/flashlog.c on the flash model:
+// reading back, wrapping the ring, remounting, and power cut at every word
+// of a record.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "utils/mempool.h"
+#include "utils/pipeline.h"
+#include "utils/flashlog.h"
+#include "flashmodel.h"
+#include "host.h"
+
+#define LOG_SECTORS             8
+#define LOG_SIZE                (LOG_SECTORS * FLASHLOG_SECTOR_SIZE)
+#define MAX_RECORDS             1024
+
+//*****************************************************************************
+//
+// Record n: its length, format and data all follow from n.
+//
+//*****************************************************************************
+#define RECORD_BYTES(n)         (1 + (((n) * 37) % 300))
+#define RECORD_FORMAT(n)        ((n) % 4)
+#define RECORD_TIME(n)          ((n) * 16)
+
+static tFlashLog g_sLog;
+static uint32_t g_pui32Data[(FLASHLOG_MAX_DATA + 3) / 4];
+static tFlashLogRecord g_psRead[MAX_RECORDS];
+
+static void
+Fill(uint32_t ui32Seq)
+{
+    uint8_t *pui8Data = (uint8_t *)g_pui32Data;
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < RECORD_BYTES(ui32Seq); ui32Idx++)
+    {
+        pui8Data[ui32Idx] = (uint8_t)((ui32Seq * 7) + ui32Idx);
+    }
+}
+
+static bool
+Append(uint32_t ui32Seq, uint32_t ui32Uptime)
+{
+    Fill(ui32Seq);
+    return(FlashLogAppend(&g_sLog, RECORD_FORMAT(ui32Seq), ui32Seq, ui32Uptime,
+                          g_pui32Data, RECORD_BYTES(ui32Seq)));
+}
+
+static void
+Service(void)
+{
+    while(FlashLogService(&g_sLog))
+    {
+    }
+}
+
+static void
+Mount(void)
+{
+    FlashLogInit(&g_sLog, FLASH_MODEL_BASE, LOG_SIZE);
+}
+
+//*****************************************************************************
+//
+// Reads the log from a time on into g_psRead, checking every record's
+// contents against its sequence number.  Returns the number read.
+//
+//*****************************************************************************
+static uint32_t
+ReadFrom(uint32_t ui32Time)
+{
+    tFlashLogCursor sCursor;
+    tFlashLogRecord *psRecord;
+    uint32_t ui32Count;
+
+    FlashLogFind(&g_sLog, ui32Time, &sCursor);
+    for(ui32Count = 0; ui32Count < MAX_RECORDS; ui32Count++)
+    {
+        psRecord = &g_psRead[ui32Count];
+        if(!FlashLogNext(&g_sLog, &sCursor, psRecord))
+        {
+            break;
+        }
+        Fill(psRecord->ui32Seq);
+        CHECK(psRecord->ui32Bytes == RECORD_BYTES(psRecord->ui32Seq));
+        CHECK(psRecord->ui32Format == RECORD_FORMAT(psRecord->ui32Seq));
+        CHECK(!memcmp(psRecord->pvData, g_pui32Data, psRecord->ui32Bytes));
+    }
+
+    return(ui32Count);
+}
+
+//*****************************************************************************
+//
+// Checks that g_psRead holds consecutive records, times increasing.
+//
+//*****************************************************************************
+static void
+CheckRun(uint32_t ui32Count, uint32_t ui32First, uint32_t ui32Last)
+{
+    uint32_t ui32Idx;
+
+    CHECK(ui32Count == (ui32Last - ui32First + 1));
+    if(!ui32Count)
+    {
+        return;
+    }
+    CHECK(g_psRead[0].ui32Seq == ui32First);
+    CHECK(g_psRead[ui32Count - 1].ui32Seq == ui32Last);
+    for(ui32Idx = 1; ui32Idx < ui32Count; ui32Idx++)
+    {
+        CHECK(g_psRead[ui32Idx].ui32Seq == (g_psRead[ui32Idx - 1].ui32Seq + 1));
+        CHECK(g_psRead[ui32Idx].ui32Time > g_psRead[ui32Idx - 1].ui32Time);
+    }
+}
+
+//*****************************************************************************
+//
+// A new part, erased or holding old data: the log is empty until sectors
+// are erased, then takes records.
+//
+//*****************************************************************************
+static void
+TestEmpty(void)
+{
+    FlashModelInit(LOG_SIZE, 0xFF);
+    Mount();
+    CHECK(ReadFrom(0) == 0);
+    CHECK(g_sLog.ui32Erased == FLASHLOG_ERASE_AHEAD);
+
+    FlashModelInit(LOG_SIZE, 0x00);
+    Mount();
+    CHECK(ReadFrom(0) == 0);
+    CHECK(g_sLog.ui32Erased == 0);
+    CHECK(!Append(0, 0));
+    CHECK(g_sLog.ui32Dropped == 1);
+
+    Service();
+    CHECK(g_sLog.ui32Erased == FLASHLOG_ERASE_AHEAD);
+    CHECK(Append(1, 10));
+    CheckRun(ReadFrom(0), 1, 1);
+    CHECK(g_sFlashModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// Many laps of the ring: the oldest records go, the rest read back in
+// order, and FlashLogFind() starts at or just before a given time.
+//
+//*****************************************************************************
+static void
+TestWrap(void)
+{
+    uint32_t ui32Seq, ui32Count, ui32Idx;
+
+    FlashModelInit(LOG_SIZE, 0xFF);
+    Mount();
+    for(ui32Seq = 0; ui32Seq < 400; ui32Seq++)
+    {
+        Service();
+        CHECK(Append(ui32Seq, RECORD_TIME(ui32Seq)));
+    }
+    CHECK(g_sLog.ui32Dropped == 0);
+    CHECK(g_sFlashModel.ui32Erases > (3 * LOG_SECTORS));
+    CHECK(g_sFlashModel.ui32Violations == 0);
+
+    ui32Count = ReadFrom(0);
+    CHECK(ui32Count > 0);
+    CHECK(g_psRead[0].ui32Seq > 0);
+    CheckRun(ui32Count, g_psRead[0].ui32Seq, 399);
+
+    //
+    // Only the records in sectors still erased ahead are gone: at most the
+    // erase-ahead sectors' worth plus the part of a sector a lap leaves.
+    //
+    CHECK(ui32Count >= (((LOG_SECTORS - FLASHLOG_ERASE_AHEAD - 1) *
+                         FLASHLOG_SECTOR_SIZE) / (FLASHLOG_MAX_DATA + 36)));
+
+    //
+    // From a time part way through: the sector holding it, so the record
+    // at that time is among the first sector's worth.
+    //
+    ui32Idx = g_psRead[ui32Count / 2].ui32Time;
+    ui32Count = ReadFrom(ui32Idx);
+    CHECK(ui32Count > 0);
+    CHECK(g_psRead[0].ui32Time <= ui32Idx);
+    CHECK(g_psRead[ui32Count - 1].ui32Seq == 399);
+    for(ui32Seq = 0; ui32Seq < ui32Count; ui32Seq++)
+    {
+        if(g_psRead[ui32Seq].ui32Time == ui32Idx)
+        {
+            break;
+        }
+    }
+    CHECK(ui32Seq < ui32Count);
+    CHECK(ui32Seq < (FLASHLOG_SECTOR_SIZE / 36));
+}
+
+//*****************************************************************************
+//
+// A reset: the same records read back, and log time carries on from the
+// newest record.
+//
+//*****************************************************************************
+static void
+TestRemount(void)
+{
+    uint32_t ui32Count, ui32First, ui32LastTime;
+
+    FlashModelInit(LOG_SIZE, 0xFF);
+    Mount();
+    for(ui32First = 0; ui32First < 150; ui32First++)
+    {
+        Service();
+        Append(ui32First, RECORD_TIME(ui32First));
+    }
+
+    ui32Count = ReadFrom(0);
+    ui32First = g_psRead[0].ui32Seq;
+    ui32LastTime = g_psRead[ui32Count - 1].ui32Time;
+
+    Mount();
+    CHECK(g_sLog.ui32Torn == 0);
+    CHECK(g_sLog.ui32TimeBase > ui32LastTime);
+    CheckRun(ReadFrom(0), ui32First, 149);
+
+    Service();
+    CHECK(Append(150, 0));
+    ui32Count = ReadFrom(0);
+    CheckRun(ui32Count, g_psRead[0].ui32Seq, 150);
+    CHECK(g_psRead[ui32Count - 1].ui32Time > ui32LastTime);
+    CHECK(g_sFlashModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// Power cut after every possible number of words of a record, both one
+// that fits the head sector and one that starts the next: after the reset
+// the earlier records are all there, the cut one is either complete or
+// skipped, and logging carries on without programming a word twice.
+//
+//*****************************************************************************
+static void
+TestTorn(uint32_t ui32Before, bool bNewSector)
+{
+    uint32_t ui32Cut, ui32Words, ui32Count, ui32First;
+    bool bDone;
+
+    ui32Words = (RECORD_BYTES(ui32Before) + 3) / 4 + 5 + 4;
+    for(ui32Cut = 0; ui32Cut <= ui32Words; ui32Cut++)
+    {
+        FlashModelInit(LOG_SIZE, 0xFF);
+        Mount();
+        for(ui32Count = 0; ui32Count < ui32Before; ui32Count++)
+        {
+            Service();
+            Append(ui32Count, RECORD_TIME(ui32Count));
+        }
+        ui32First = ReadFrom(0) ? g_psRead[0].ui32Seq : 0;
+        Service();
+        CHECK(((g_sLog.ui32Offset + 20 + ((RECORD_BYTES(ui32Before) + 3) & ~3)) >
+               FLASHLOG_SECTOR_SIZE) == bNewSector);
+
+        FlashModelCut(ui32Cut);
+        bDone = Append(ui32Before, RECORD_TIME(ui32Before));
+        FlashModelCut(-1);
+
+        Mount();
+        ui32Count = ReadFrom(0);
+        if(bDone)
+        {
+            CheckRun(ui32Count, ui32First, ui32Before);
+        }
+        else
+        {
+            CheckRun(ui32Count, ui32First, ui32Before - 1);
+        }
+
+        Service();
+        CHECK(Append(ui32Before + 1, 0));
+        ui32Count = ReadFrom(0);
+        CHECK(ui32Count > 0);
+        CHECK(g_psRead[ui32Count - 1].ui32Seq == (ui32Before + 1));
+        CHECK(g_psRead[ui32Count - 1].ui32Time > RECORD_TIME(ui32Before - 1));
+        CHECK(g_sFlashModel.ui32Violations == 0);
+    }
+}
+
+//*****************************************************************************
+//
+// No erased sector ready: records are dropped, nothing is overwritten.
+//
+//*****************************************************************************
+static void
+TestFull(void)
+{
+    uint32_t ui32Seq;
+
+    FlashModelInit(LOG_SIZE, 0xFF);
+    Mount();
+    for(ui32Seq = 0; ui32Seq < 100; ui32Seq++)
+    {
+        Append(ui32Seq, RECORD_TIME(ui32Seq));
+    }
+    CHECK(g_sLog.ui32Dropped > 0);
+    CHECK(g_sFlashModel.ui32Erases == 0);
+    CHECK(g_sFlashModel.ui32Violations == 0);
+    CHECK(ReadFrom(0) == (100 - g_sLog.ui32Dropped));
+}
+
+int
+main(void)
+{
+    TestEmpty();
+    TestWrap();
+    TestRemount();
+    TestTorn(5, false);
+    TestTorn(7, true);
+    TestFull();
+    return(HostResult("flashlog"));
+}
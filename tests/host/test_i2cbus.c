@@ -0,0 +1,467 @@
+//*****************************************************************************
+//
+// test_i2cbus.c - Host tests of utils/i2cbus.c on the I2C model: the bus
+// traffic of each kind of transfer, the queue carrying on after a NAK, lost
+// arbitration or a stuck bus, and the sensor poller.
+//
+// The model runs each command at once and raises the master's interrupt;
+// Run() then takes the interrupt for as long as it is raised and enabled,
+// as the NVIC would, so a whole queue of transfers runs in one call.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/gpio.h"
+#include "driverlib/i2c.h"
+#include "utils/i2cbus.h"
+#include "i2cmodel.h"
+#include "host.h"
+
+//*****************************************************************************
+//
+// The device's address, and one no device answers to.
+//
+//*****************************************************************************
+#define ADDR                    0x48
+#define ABSENT                  0x49
+
+static tI2CBus g_sBus = { I2C0_BASE, INT_I2C0, GPIO_PORTB_BASE, GPIO_PIN_2,
+                          GPIO_PORTB_BASE, GPIO_PIN_3, false };
+
+static void
+I2C0IntHandler(void)
+{
+    I2CBusIntHandler(&g_sBus);
+}
+
+//*****************************************************************************
+//
+// Sets up the model and the bus.  The bus structure is cleared first, as it
+// is when static on the target.
+//
+//*****************************************************************************
+static void
+Init(void)
+{
+    I2CModelInit(ADDR, GPIO_PORTB_BASE, GPIO_PIN_2, GPIO_PORTB_BASE,
+                 GPIO_PIN_3);
+    memset(&g_sBus.ppsQueue, 0,
+           sizeof(g_sBus) - offsetof(tI2CBus, ppsQueue));
+    I2CBusInit(&g_sBus);
+}
+
+//*****************************************************************************
+//
+// Takes the I2C interrupt while it is raised.
+//
+//*****************************************************************************
+static void
+Run(void)
+{
+    uint32_t ui32Count;
+
+    for(ui32Count = 0; I2CModelPending() && HostIntEnabled(INT_I2C0);
+        ui32Count++)
+    {
+        if(ui32Count == 1000)
+        {
+            CHECK(!"interrupt never cleared");
+            return;
+        }
+        HostInterrupt(INT_I2C0, I2C0IntHandler);
+    }
+}
+
+//*****************************************************************************
+//
+// Returns whether the bus traffic since the last call was pcExpected,
+// printing it if not.
+//
+//*****************************************************************************
+static bool
+Traffic(const char *pcExpected)
+{
+    bool bMatch;
+
+    bMatch = !strcmp(g_sI2CModel.pcLog, pcExpected);
+    if(!bMatch)
+    {
+        printf("bus: \"%s\", expected \"%s\"\n", g_sI2CModel.pcLog,
+               pcExpected);
+    }
+    g_sI2CModel.pcLog[0] = 0;
+    return(bMatch);
+}
+
+static void
+Transfer(tI2CTransfer *psTransfer, uint8_t ui8Addr, const uint8_t *pui8Tx,
+         uint32_t ui32TxLen, uint8_t *pui8Rx, uint32_t ui32RxLen)
+{
+    psTransfer->ui8Addr = ui8Addr;
+    psTransfer->pui8Tx = pui8Tx;
+    psTransfer->ui32TxLen = ui32TxLen;
+    psTransfer->pui8Rx = pui8Rx;
+    psTransfer->ui32RxLen = ui32RxLen;
+}
+
+//*****************************************************************************
+//
+// Writes: a register and its values in a burst, and a single byte, which
+// only sets the register pointer.
+//
+//*****************************************************************************
+static void
+TestWrite(void)
+{
+    static const uint8_t pui8Burst[] = { 0x10, 0xab, 0xcd };
+    static const uint8_t pui8Single[] = { 0x20 };
+    tI2CTransfer sBurst, sSingle;
+
+    Init();
+    Transfer(&sBurst, ADDR, pui8Burst, sizeof(pui8Burst), 0, 0);
+    Transfer(&sSingle, ADDR, pui8Single, sizeof(pui8Single), 0, 0);
+    CHECK(I2CBusSubmit(&g_sBus, &sBurst));
+    CHECK(I2CBusSubmit(&g_sBus, &sSingle));
+    CHECK(sSingle.ui32Status == I2C_STATUS_PENDING);
+    Run();
+
+    CHECK(Traffic("S 48w =10 =ab =cd P S 48w =20 P"));
+    CHECK(sBurst.ui32Status == I2C_STATUS_DONE);
+    CHECK(sSingle.ui32Status == I2C_STATUS_DONE);
+    CHECK(g_sI2CModel.pui8Regs[0x10] == 0xab);
+    CHECK(g_sI2CModel.pui8Regs[0x11] == 0xcd);
+    CHECK(g_sI2CModel.pui8Regs[0x20] == 0x20);
+    CHECK(g_sBus.ui32Done == 2);
+    CHECK(!g_sBus.psCurrent);
+    CHECK(g_sI2CModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// Reads with no register written first: a burst, acknowledged up to its
+// last byte, and a single byte, both running on from the pointer.
+//
+//*****************************************************************************
+static void
+TestRead(void)
+{
+    static const uint8_t pui8Reg[] = { 0x30 };
+    tI2CTransfer sSet, sBurst, sSingle;
+    uint8_t pui8Burst[3], ui8Single;
+
+    Init();
+    Transfer(&sSet, ADDR, pui8Reg, sizeof(pui8Reg), 0, 0);
+    Transfer(&sBurst, ADDR, 0, 0, pui8Burst, sizeof(pui8Burst));
+    Transfer(&sSingle, ADDR, 0, 0, &ui8Single, 1);
+    CHECK(I2CBusSubmit(&g_sBus, &sSet));
+    CHECK(I2CBusSubmit(&g_sBus, &sBurst));
+    CHECK(I2CBusSubmit(&g_sBus, &sSingle));
+    Run();
+
+    CHECK(Traffic("S 48w =30 P S 48r <30 <31 <32. P S 48r <33. P"));
+    CHECK(sBurst.ui32Status == I2C_STATUS_DONE);
+    CHECK(sSingle.ui32Status == I2C_STATUS_DONE);
+    CHECK((pui8Burst[0] == 0x30) && (pui8Burst[1] == 0x31) &&
+          (pui8Burst[2] == 0x32));
+    CHECK(ui8Single == 0x33);
+    CHECK(g_sI2CModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// Register reads: the register is written, then read back after a repeated
+// start with no stop between.
+//
+//*****************************************************************************
+static void
+TestRepeatedStart(void)
+{
+    static const uint8_t pui8Reg[] = { 0x40 };
+    static const uint8_t pui8Write[] = { 0x50, 0x12, 0x34 };
+    tI2CTransfer sWrite, sBurst, sSingle;
+    uint8_t pui8Burst[2], ui8Single;
+
+    Init();
+    Transfer(&sWrite, ADDR, pui8Write, sizeof(pui8Write), 0, 0);
+    Transfer(&sBurst, ADDR, pui8Write, 1, pui8Burst, sizeof(pui8Burst));
+    Transfer(&sSingle, ADDR, pui8Reg, sizeof(pui8Reg), &ui8Single, 1);
+    CHECK(I2CBusSubmit(&g_sBus, &sWrite));
+    CHECK(I2CBusSubmit(&g_sBus, &sBurst));
+    CHECK(I2CBusSubmit(&g_sBus, &sSingle));
+    Run();
+
+    CHECK(Traffic("S 48w =50 =12 =34 P "
+                  "S 48w =50 Sr 48r <12 <34. P "
+                  "S 48w =40 Sr 48r <40. P"));
+    CHECK(sBurst.ui32Status == I2C_STATUS_DONE);
+    CHECK(sSingle.ui32Status == I2C_STATUS_DONE);
+    CHECK((pui8Burst[0] == 0x12) && (pui8Burst[1] == 0x34));
+    CHECK(ui8Single == 0x40);
+    CHECK(g_sI2CModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// NAKs: mid-burst the master holds the bus and then sends a stop; on the
+// last byte, and on an address with a stop to follow, the stop has already
+// gone.  An absent device NAKs its address.  Each transfer fails alone and
+// the queue carries on.
+//
+//*****************************************************************************
+static void
+TestNak(void)
+{
+    static const uint8_t pui8Write[] = { 0x60, 0x01, 0x02, 0x03 };
+    tI2CTransfer sMid, sLast, sAbsent, sAbsentRead, sAfter;
+    uint8_t pui8Read[2], ui8Read;
+
+    Init();
+    Transfer(&sMid, ADDR, pui8Write, sizeof(pui8Write), 0, 0);
+    Transfer(&sAfter, ADDR, pui8Write, 1, pui8Read, sizeof(pui8Read));
+    I2CModelNak(1);
+    CHECK(I2CBusSubmit(&g_sBus, &sMid));
+    CHECK(I2CBusSubmit(&g_sBus, &sAfter));
+    Run();
+    CHECK(Traffic("S 48w =60 =01! P S 48w =60 Sr 48r <60 <61. P"));
+    CHECK(sMid.ui32Status == I2C_STATUS_NAK);
+    CHECK(sAfter.ui32Status == I2C_STATUS_DONE);
+    CHECK(g_sI2CModel.pui8Regs[0x60] == 0x60);
+
+    Transfer(&sLast, ADDR, pui8Write, sizeof(pui8Write), 0, 0);
+    I2CModelNak(3);
+    CHECK(I2CBusSubmit(&g_sBus, &sLast));
+    Run();
+    CHECK(Traffic("S 48w =60 =01 =02 =03! P"));
+    CHECK(sLast.ui32Status == I2C_STATUS_NAK);
+
+    Transfer(&sAbsent, ABSENT, pui8Write, sizeof(pui8Write), 0, 0);
+    Transfer(&sAbsentRead, ABSENT, 0, 0, &ui8Read, 1);
+    CHECK(I2CBusSubmit(&g_sBus, &sAbsent));
+    CHECK(I2CBusSubmit(&g_sBus, &sAbsentRead));
+    CHECK(I2CBusSubmit(&g_sBus, &sAfter));
+    Run();
+    CHECK(Traffic("S 49w! P S 49r! P S 48w =60 Sr 48r <01 <02. P"));
+    CHECK(sAbsent.ui32Status == I2C_STATUS_NAK);
+    CHECK(sAbsentRead.ui32Status == I2C_STATUS_NAK);
+    CHECK(sAfter.ui32Status == I2C_STATUS_DONE);
+
+    CHECK(g_sBus.ui32Naks == 4);
+    CHECK(g_sBus.ui32Done == 2);
+    CHECK(g_sI2CModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// Lost arbitration, at the start and part way through: the master has let
+// go of the bus, so the transfer ends with no stop of its own.
+//
+//*****************************************************************************
+static void
+TestArbLost(void)
+{
+    static const uint8_t pui8Write[] = { 0x70, 0x01, 0x02 };
+    tI2CTransfer sStart, sMid, sAfter;
+
+    Init();
+    Transfer(&sStart, ADDR, pui8Write, sizeof(pui8Write), 0, 0);
+    Transfer(&sMid, ADDR, pui8Write, sizeof(pui8Write), 0, 0);
+    Transfer(&sAfter, ADDR, pui8Write, sizeof(pui8Write), 0, 0);
+    I2CModelArbLost(0);
+    CHECK(I2CBusSubmit(&g_sBus, &sStart));
+    Run();
+    I2CModelArbLost(1);
+    CHECK(I2CBusSubmit(&g_sBus, &sMid));
+    CHECK(I2CBusSubmit(&g_sBus, &sAfter));
+    Run();
+
+    CHECK(Traffic("A S 48w =70 A S 48w =70 =01 =02 P"));
+    CHECK(sStart.ui32Status == I2C_STATUS_ARB_LOST);
+    CHECK(sMid.ui32Status == I2C_STATUS_ARB_LOST);
+    CHECK(sAfter.ui32Status == I2C_STATUS_DONE);
+    CHECK(g_sBus.ui32ArbLost == 2);
+    CHECK(g_sI2CModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// A device that holds the clock: the clock low timeout leaves the transfer
+// stuck, and I2CBusService() recovers the bus once I2C_TIMEOUT_MS have
+// passed with no transfer ending.  It clocks the device until it lets go
+// of data, resets it with a start and stop, sets the master up again and
+// fails the transfer, and the queue carries on.  The same without the
+// timeout, when no interrupt comes at all.
+//
+//*****************************************************************************
+static void
+TestStuck(void)
+{
+    static const uint8_t pui8Write[] = { 0x80, 0x01, 0x02 };
+    tI2CTransfer sStuck, sAfter;
+    uint8_t pui8Read[2];
+    uint32_t ui32Inits;
+
+    Init();
+    I2CBusService(&g_sBus, 1000);
+    ui32Inits = g_sI2CModel.ui32Inits;
+    Transfer(&sStuck, ADDR, pui8Write, sizeof(pui8Write), 0, 0);
+    Transfer(&sAfter, ADDR, pui8Write, 1, pui8Read, sizeof(pui8Read));
+    I2CModelStick(1, 5, true);
+    CHECK(I2CBusSubmit(&g_sBus, &sStuck));
+    CHECK(I2CBusSubmit(&g_sBus, &sAfter));
+    Run();
+    CHECK(Traffic("S 48w =80 T"));
+    CHECK(sStuck.ui32Status == I2C_STATUS_PENDING);
+    CHECK(I2CMasterBusBusy(I2C0_BASE));
+
+    I2CBusService(&g_sBus, 1000 + I2C_TIMEOUT_MS - 1);
+    Run();
+    CHECK(sStuck.ui32Status == I2C_STATUS_PENDING);
+    CHECK(g_sI2CModel.ui32Clocks == 0);
+
+    I2CBusService(&g_sBus, 1000 + I2C_TIMEOUT_MS);
+    CHECK(sStuck.ui32Status == I2C_STATUS_TIMEOUT);
+    CHECK(g_sI2CModel.ui32Clocks == 5);
+    CHECK(g_sI2CModel.ui32Inits == (ui32Inits + 1));
+    CHECK(!I2CMasterBusBusy(I2C0_BASE));
+    CHECK(HostIntEnabled(INT_I2C0));
+    Run();
+    CHECK(Traffic("X S 48w =80 Sr 48r <80 <81. P"));
+    CHECK(sAfter.ui32Status == I2C_STATUS_DONE);
+    CHECK((pui8Read[0] == 0x80) && (pui8Read[1] == 0x81));
+
+    Init();
+    I2CBusService(&g_sBus, 0);
+    I2CModelStick(0, 2, false);
+    CHECK(I2CBusSubmit(&g_sBus, &sStuck));
+    Run();
+    CHECK(Traffic("T"));
+    I2CBusService(&g_sBus, I2C_TIMEOUT_MS - 1);
+    CHECK(sStuck.ui32Status == I2C_STATUS_PENDING);
+    I2CBusService(&g_sBus, I2C_TIMEOUT_MS);
+    CHECK(sStuck.ui32Status == I2C_STATUS_TIMEOUT);
+    CHECK(g_sI2CModel.ui32Clocks == 2);
+    CHECK(Traffic("X"));
+
+    CHECK(g_sBus.ui32Timeouts == 1);
+    CHECK(g_sI2CModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// A device holding data at power up, as after a reset part way through a
+// read: I2CBusInit() frees the bus before the first transfer.
+//
+//*****************************************************************************
+static void
+TestInitBusy(void)
+{
+    static const uint8_t pui8Write[] = { 0x90, 0x01 };
+    tI2CTransfer sWrite;
+
+    I2CModelInit(ADDR, GPIO_PORTB_BASE, GPIO_PIN_2, GPIO_PORTB_BASE,
+                 GPIO_PIN_3);
+    I2CModelHold(3);
+    memset(&g_sBus.ppsQueue, 0,
+           sizeof(g_sBus) - offsetof(tI2CBus, ppsQueue));
+    I2CBusInit(&g_sBus);
+    CHECK(g_sI2CModel.ui32Clocks == 3);
+    CHECK(!I2CMasterBusBusy(I2C0_BASE));
+
+    Transfer(&sWrite, ADDR, pui8Write, sizeof(pui8Write), 0, 0);
+    CHECK(I2CBusSubmit(&g_sBus, &sWrite));
+    Run();
+    CHECK(Traffic("X S 48w =90 =01 P"));
+    CHECK(sWrite.ui32Status == I2C_STATUS_DONE);
+    CHECK(g_sI2CModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// A full queue refuses a transfer, and counts it.
+//
+//*****************************************************************************
+static void
+TestFull(void)
+{
+    static const uint8_t pui8Write[] = { 0xa0 };
+    tI2CTransfer psTransfers[I2C_QUEUE_DEPTH + 1];
+    uint32_t ui32Idx;
+
+    Init();
+    for(ui32Idx = 0; ui32Idx < I2C_QUEUE_DEPTH; ui32Idx++)
+    {
+        Transfer(&psTransfers[ui32Idx], ADDR, pui8Write, 1, 0, 0);
+        CHECK(I2CBusSubmit(&g_sBus, &psTransfers[ui32Idx]));
+    }
+    Transfer(&psTransfers[ui32Idx], ADDR, pui8Write, 1, 0, 0);
+    CHECK(!I2CBusSubmit(&g_sBus, &psTransfers[ui32Idx]));
+    CHECK(g_sBus.ui32Rejected == 1);
+
+    Run();
+    CHECK(g_sBus.ui32Done == I2C_QUEUE_DEPTH);
+    CHECK(I2CBusSubmit(&g_sBus, &psTransfers[ui32Idx]));
+    Run();
+    CHECK(psTransfers[ui32Idx].ui32Status == I2C_STATUS_DONE);
+    CHECK(g_sI2CModel.ui32Violations == 0);
+}
+
+//*****************************************************************************
+//
+// The poller: a sensor read as a big-endian number, one through its
+// conversion, and one that is not there.
+//
+//*****************************************************************************
+static int32_t
+Negate(const uint8_t *pui8Data)
+{
+    return(-(int32_t)pui8Data[0]);
+}
+
+static void
+TestPoll(void)
+{
+    static tI2CSensor psSensors[] =
+    {
+        { "raw", ADDR, 0xb0, 2, 0 },
+        { "negated", ADDR, 0xc0, 1, Negate },
+        { "absent", ABSENT, 0x00, 1, 0 },
+    };
+    tI2CPoller sPoller;
+    uint32_t ui32Tick;
+
+    Init();
+    I2CPollInit(&sPoller, &g_sBus, psSensors, 3, 2);
+    for(ui32Tick = 0; ui32Tick < 6; ui32Tick++)
+    {
+        I2CPollTick(&sPoller);
+        Run();
+    }
+    I2CPollTick(&sPoller);
+
+    CHECK(psSensors[0].bValid && (psSensors[0].i32Value == 0xb0b1));
+    CHECK(psSensors[1].bValid && (psSensors[1].i32Value == -0xc0));
+    CHECK(!psSensors[2].bValid);
+    CHECK(psSensors[0].ui32Reads == 4);
+    CHECK(psSensors[2].ui32Errors == 4);
+    CHECK(g_sI2CModel.ui32Violations == 0);
+}
+
+int
+main(void)
+{
+    TestWrite();
+    TestRead();
+    TestRepeatedStart();
+    TestNak();
+    TestArbLost();
+    TestStuck();
+    TestInitBusy();
+    TestFull();
+    TestPoll();
+    return(HostResult("i2cbus"));
+}
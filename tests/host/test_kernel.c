@@ -0,0 +1,529 @@
+//*****************************************************************************
+//
+// test_kernel.c - Host tests of utils/kernel.c: thread switches, preemption
+// by a more urgent thread and from an interrupt, sleeping and waking,
+// semaphore timeouts and priority inheritance.
+//
+// kernel.c is included, so its state can be checked.  Each thread runs on a
+// host context in place of its stack; the PendSV handler (assembly, left
+// out of this build) is replaced by HostPendSV(), which switches contexts
+// as it would switch stacks.  A thread starts at the entry function,
+// argument and return address found in the frame ThreadCreate() built.
+// The idle thread is where time passes: it delivers SysTick interrupts
+// until a thread can run.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include "utils/kernel.c"
+#include "host.h"
+
+//*****************************************************************************
+//
+// Host contexts, one per thread, and the one KernelStart() ran on.
+//
+//*****************************************************************************
+#define HOST_THREADS            10
+#define HOST_STACK_BYTES        65536
+
+typedef struct
+{
+    tThread *psThread;
+    bool bFresh;                // ThreadCreate() since the last switch in
+    ucontext_t sContext;
+    void *pvStack;
+}
+tHostThread;
+
+static tHostThread g_psHostThreads[HOST_THREADS];
+static ucontext_t g_sBootContext;
+
+//*****************************************************************************
+//
+// Ticks the idle thread delivers before it gives up on every thread being
+// blocked for ever.
+//
+//*****************************************************************************
+#define IDLE_TICK_LIMIT         1000
+
+//*****************************************************************************
+//
+// The threads under test, their (target) stacks, and what they record.
+//
+//*****************************************************************************
+#define TEST_INT                32
+#define TEST_STACK_WORDS        64
+
+static tThread g_sTest, g_sHigh, g_sMid, g_sLow;
+static uint32_t g_pui32TestStack[TEST_STACK_WORDS];
+static uint32_t g_pui32HighStack[TEST_STACK_WORDS];
+static uint32_t g_pui32MidStack[TEST_STACK_WORDS];
+static uint32_t g_pui32LowStack[TEST_STACK_WORDS];
+static tSemaphore g_sSem;
+static tMutex g_sMutex;
+static char g_pcTrace[64];
+static uint32_t g_ui32TraceLen;
+static uint32_t g_ui32WokeAt;
+static bool g_bTaken;
+
+//*****************************************************************************
+//
+// Returns the host context of a thread.
+//
+//*****************************************************************************
+static tHostThread *
+HostThread(tThread *psThread)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < HOST_THREADS; ui32Idx++)
+    {
+        if(g_psHostThreads[ui32Idx].psThread == psThread)
+        {
+            return(&g_psHostThreads[ui32Idx]);
+        }
+        if(!g_psHostThreads[ui32Idx].psThread)
+        {
+            g_psHostThreads[ui32Idx].psThread = psThread;
+            g_psHostThreads[ui32Idx].pvStack = malloc(HOST_STACK_BYTES);
+            return(&g_psHostThreads[ui32Idx]);
+        }
+    }
+
+    printf("kernel: out of host threads\n");
+    exit(1);
+}
+
+//*****************************************************************************
+//
+// Stack painting (utils/stackmon.c on the target).  ThreadCreate() paints
+// every thread it (re)creates, which is how the host learns that the
+// thread is to start afresh.
+//
+//*****************************************************************************
+void
+StackRegionPaint(tStackRegion *psStack)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < (psStack->ui32Size / 4); ui32Idx++)
+    {
+        psStack->pui32Base[ui32Idx] = STACK_PAINT;
+    }
+    HostThread((tThread *)((char *)psStack -
+                           offsetof(tThread, sStack)))->bFresh = true;
+}
+
+uint32_t
+StackRegionHighWater(const tStackRegion *psStack)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < (psStack->ui32Size / 4); ui32Idx++)
+    {
+        if(psStack->pui32Base[ui32Idx] != STACK_PAINT)
+        {
+            break;
+        }
+    }
+    return(psStack->ui32Size - (ui32Idx * 4));
+}
+
+//*****************************************************************************
+//
+// Delivers ticks from a running thread, as if that much time went by.
+//
+//*****************************************************************************
+static void
+Tick(uint32_t ui32Ticks)
+{
+    while(ui32Ticks--)
+    {
+        HostInterrupt(FAULT_SYSTICK, KernelTick);
+    }
+}
+
+//*****************************************************************************
+//
+// The idle thread: time passes until a thread wakes up.
+//
+//*****************************************************************************
+static void
+HostIdle(void)
+{
+    Tick(IDLE_TICK_LIMIT);
+    CHECK(!"every thread is blocked");
+    exit(HostResult("kernel"));
+}
+
+//*****************************************************************************
+//
+// Where a thread starts: "returns" through the frame ThreadCreate() built.
+//
+//*****************************************************************************
+static void
+HostThreadStart(void)
+{
+    uint32_t *pui32Frame;
+    void (*pfnEntry)(void *pvArg);
+    void (*pfnReturn)(void);
+
+    pui32Frame = g_psKernelCurrent->pui32SP;
+    CHECK(pui32Frame[8] == THREAD_INITIAL_EXC_RETURN);
+    CHECK(pui32Frame[16] == THREAD_INITIAL_XPSR);
+    pfnEntry = (void (*)(void *))pui32Frame[15];
+    pfnReturn = (void (*)(void))pui32Frame[14];
+
+    if(pfnEntry == ThreadIdle)
+    {
+        HostIdle();
+    }
+    pfnEntry((void *)pui32Frame[9]);
+    pfnReturn();
+}
+
+//*****************************************************************************
+//
+// Stands in for KernelPendSVHandler().
+//
+//*****************************************************************************
+static void
+HostPendSV(void)
+{
+    tThread *psFrom, *psTo;
+    tHostThread *psHostTo;
+
+    if(g_pfnKernelPendSV)
+    {
+        g_pfnKernelPendSV();
+    }
+
+    psFrom = g_psKernelCurrent;
+    psTo = g_psKernelNext;
+    if(psFrom == psTo)
+    {
+        return;
+    }
+    g_psKernelCurrent = psTo;
+    g_ui32KernelSwitches++;
+
+    psHostTo = HostThread(psTo);
+    if(psHostTo->bFresh)
+    {
+        psHostTo->bFresh = false;
+        getcontext(&psHostTo->sContext);
+        psHostTo->sContext.uc_stack.ss_sp = psHostTo->pvStack;
+        psHostTo->sContext.uc_stack.ss_size = HOST_STACK_BYTES;
+        psHostTo->sContext.uc_link = 0;
+        makecontext(&psHostTo->sContext, HostThreadStart, 0);
+    }
+    swapcontext(psFrom ? &HostThread(psFrom)->sContext : &g_sBootContext,
+                &psHostTo->sContext);
+}
+
+//*****************************************************************************
+//
+// The trace of what the threads did, one character per step.
+//
+//*****************************************************************************
+static void
+Mark(char cStep)
+{
+    if(g_ui32TraceLen < (sizeof(g_pcTrace) - 1))
+    {
+        g_pcTrace[g_ui32TraceLen++] = cStep;
+        g_pcTrace[g_ui32TraceLen] = 0;
+    }
+}
+
+static bool
+Traced(const char *pcSteps)
+{
+    bool bMatch;
+
+    bMatch = (strcmp(g_pcTrace, pcSteps) == 0);
+    if(!bMatch)
+    {
+        printf("kernel: trace \"%s\", expected \"%s\"\n", g_pcTrace, pcSteps);
+    }
+    g_ui32TraceLen = 0;
+    g_pcTrace[0] = 0;
+    return(bMatch);
+}
+
+static void
+Create(tThread *psThread, void (*pfnEntry)(void *pvArg), char cArg,
+       uint32_t *pui32Stack, uint32_t ui32Priority)
+{
+    ThreadCreate(psThread, "", pfnEntry, (void *)(uint32_t)cArg, pui32Stack,
+                 TEST_STACK_WORDS * 4, ui32Priority);
+}
+
+//*****************************************************************************
+//
+// Thread entry functions.
+//
+//*****************************************************************************
+static void
+MarkArg(void *pvArg)
+{
+    Mark((char)(uint32_t)pvArg);
+}
+
+static void
+PendTwice(void *pvArg)
+{
+    SemPend(&g_sSem, KERNEL_WAIT_FOREVER);
+    Mark('w');
+    SemPend(&g_sSem, KERNEL_WAIT_FOREVER);
+    Mark('x');
+}
+
+static void
+SleepThree(void *pvArg)
+{
+    ThreadSleep(3);
+    Mark('s');
+    g_ui32WokeAt = g_ui32Ticks;
+}
+
+static void
+Post(void *pvArg)
+{
+    Mark('p');
+    SemPost(&g_sSem);
+}
+
+static void
+LowLocker(void *pvArg)
+{
+    MutexLock(&g_sMutex);
+    Mark('l');
+    ThreadSleep(2);
+    Mark('L');
+    MutexUnlock(&g_sMutex);
+    Mark('u');
+}
+
+static void
+MidWorker(void *pvArg)
+{
+    uint32_t ui32Step;
+
+    ThreadSleep(1);
+    Mark('m');
+    CHECK(g_sLow.ui32Priority == g_sHigh.ui32Priority);
+    for(ui32Step = 0; ui32Step < 4; ui32Step++)
+    {
+        Mark('.');
+        Tick(1);
+    }
+}
+
+static void
+HighLocker(void *pvArg)
+{
+    ThreadSleep(1);
+    MutexLock(&g_sMutex);
+    Mark('H');
+    MutexUnlock(&g_sMutex);
+}
+
+//*****************************************************************************
+//
+// Interrupt handlers.
+//
+//*****************************************************************************
+static void
+PostHandler(void)
+{
+    SemPost(&g_sSem);
+    Mark('h');
+}
+
+static void
+TakeHandler(void)
+{
+    g_bTaken = SemPend(&g_sSem, KERNEL_WAIT_FOREVER);
+}
+
+//*****************************************************************************
+//
+// A more urgent thread runs before ThreadCreate() returns, a less urgent
+// one once the caller blocks, and a finished thread can be created again.
+//
+//*****************************************************************************
+static void
+TestSwitch(void)
+{
+    uint32_t ui32Switches;
+
+    CHECK(ThreadSelf() == &g_sTest);
+
+    ui32Switches = g_ui32KernelSwitches;
+    Create(&g_sHigh, MarkArg, 'a', g_pui32HighStack, 5);
+    Mark('t');
+    CHECK(Traced("at"));
+    CHECK(g_sHigh.ui32State == THREAD_DONE);
+    CHECK((g_ui32KernelSwitches - ui32Switches) == 2);
+
+    Create(&g_sLow, MarkArg, 'b', g_pui32LowStack, 20);
+    Mark('t');
+    ThreadSleep(1);
+    Mark('w');
+    CHECK(Traced("tbw"));
+    CHECK(g_sLow.ui32State == THREAD_DONE);
+
+    Create(&g_sHigh, MarkArg, 'A', g_pui32HighStack, 5);
+    CHECK(Traced("A"));
+}
+
+//*****************************************************************************
+//
+// SemPost() from a thread switches to a more urgent waiter at once; from
+// an interrupt handler, as the handler returns.  SemPend() in a handler
+// never waits.
+//
+//*****************************************************************************
+static void
+TestPreempt(void)
+{
+    Create(&g_sHigh, PendTwice, 0, g_pui32HighStack, 5);
+    CHECK(g_sHigh.ui32State == THREAD_PENDING);
+    Mark('t');
+    SemPost(&g_sSem);
+    Mark('p');
+    HostInterrupt(TEST_INT, PostHandler);
+    Mark('i');
+    CHECK(Traced("twphxi"));
+    CHECK(g_sHigh.ui32State == THREAD_DONE);
+    CHECK(g_sSem.ui32Count == 0);
+
+    g_bTaken = true;
+    HostInterrupt(TEST_INT, TakeHandler);
+    CHECK(!g_bTaken);
+    SemPost(&g_sSem);
+    HostInterrupt(TEST_INT, TakeHandler);
+    CHECK(g_bTaken);
+    CHECK(g_sSem.ui32Count == 0);
+}
+
+//*****************************************************************************
+//
+// A sleeping thread wakes on the tick its sleep ends, and runs at once if
+// it is the more urgent; while every thread sleeps, the idle thread runs.
+//
+//*****************************************************************************
+static void
+TestSleep(void)
+{
+    uint32_t ui32Start, ui32Switches;
+
+    ui32Start = g_ui32Ticks;
+    Create(&g_sHigh, SleepThree, 0, g_pui32HighStack, 5);
+    CHECK(g_sHigh.ui32State == THREAD_SLEEPING);
+    Tick(2);
+    CHECK(g_sHigh.ui32State == THREAD_SLEEPING);
+    CHECK(Traced(""));
+    Tick(1);
+    CHECK(Traced("s"));
+    CHECK(g_ui32WokeAt == (ui32Start + 3));
+
+    ui32Start = g_ui32Ticks;
+    ThreadSleep(5);
+    CHECK((g_ui32Ticks - ui32Start) == 5);
+
+    ui32Switches = g_ui32KernelSwitches;
+    ThreadSleep(0);
+    CHECK(g_ui32KernelSwitches == ui32Switches);
+}
+
+//*****************************************************************************
+//
+// SemPend() gives up after its timeout, or returns as soon as another
+// thread posts.
+//
+//*****************************************************************************
+static void
+TestTimeout(void)
+{
+    uint32_t ui32Start;
+
+    ui32Start = g_ui32Ticks;
+    CHECK(!SemPend(&g_sSem, 3));
+    CHECK((g_ui32Ticks - ui32Start) == 3);
+
+    ui32Start = g_ui32Ticks;
+    Create(&g_sLow, Post, 0, g_pui32LowStack, 20);
+    CHECK(SemPend(&g_sSem, 10));
+    CHECK(g_ui32Ticks == ui32Start);
+    CHECK(Traced("p"));
+}
+
+//*****************************************************************************
+//
+// A low-priority thread holding a mutex the high-priority one waits for
+// runs ahead of a busy middle-priority thread until it lets go, then drops
+// back behind it.
+//
+//*****************************************************************************
+static void
+TestInherit(void)
+{
+    Create(&g_sLow, LowLocker, 0, g_pui32LowStack, 6);
+    Create(&g_sMid, MidWorker, 0, g_pui32MidStack, 4);
+    Create(&g_sHigh, HighLocker, 0, g_pui32HighStack, 2);
+    ThreadSleep(20);
+
+    CHECK(Traced("lm.LH...u"));
+    CHECK(g_sLow.ui32Priority == 6);
+    CHECK(g_sMutex.psOwner == 0);
+    CHECK(g_sMutex.ui32Locks == 2);
+    CHECK(g_sMutex.ui32Contended == 1);
+    CHECK(g_sTest.psHeld == 0);
+}
+
+//*****************************************************************************
+//
+// The benchmark's two threads switch twice a round and finish.
+//
+//*****************************************************************************
+static void
+TestBenchmark(void)
+{
+    uint32_t ui32Switches;
+
+    ui32Switches = g_ui32KernelSwitches;
+    KernelBenchmark(100);
+    CHECK((g_ui32KernelSwitches - ui32Switches) >= 200);
+    CHECK(g_sPingThread.ui32State == THREAD_DONE);
+    CHECK(g_sPongThread.ui32State == THREAD_DONE);
+}
+
+static void
+TestThread(void *pvArg)
+{
+    TestSwitch();
+    TestPreempt();
+    TestSleep();
+    TestTimeout();
+    TestInherit();
+    TestBenchmark();
+    exit(HostResult("kernel"));
+}
+
+int
+main(void)
+{
+    g_pfnHostPendSV = HostPendSV;
+    KernelInit(0);
+    ThreadCreate(&g_sTest, "test", TestThread, 0, g_pui32TestStack,
+                 sizeof(g_pui32TestStack), 10);
+    KernelStart();
+    return(1);
+}
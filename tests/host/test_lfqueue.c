@@ -0,0 +1,332 @@
+//*****************************************************************************
+//
+// test_lfqueue.c - Host stress tests of utils/lfqueue.c: producers and
+// consumers on threads of their own hammer small queues, and every value
+// must come out once, in each producer's order.
+//
+// LFCompareAndSwap() is assembly on the target (left out of this build);
+// here it is the compiler's compare-and-swap, a full barrier like the
+// exclusive-access loop it replaces.  Every few swaps it gives up the
+// processor just after swapping, the worst moment to be preempted: a put
+// has claimed its slot but not filled it, a get has not yet freed it.
+//
+//*****************************************************************************
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "utils/lfqueue.h"
+#include "host.h"
+
+//*****************************************************************************
+//
+// Producers, consumers and values per producer.  A value carries its
+// producer in the top byte and its sequence number (from 1) below.
+//
+//*****************************************************************************
+#define PRODUCERS               4
+#define CONSUMERS               4
+#define VALUES                  50000
+#define MPMC_SLOTS              64
+#define SPSC_SLOTS              17      // not a power of two: wraps unevenly
+
+#define VALUE(p, n)             (((uint32_t)(p) << 24) | (n))
+#define VALUE_PRODUCER(v)       ((v) >> 24)
+#define VALUE_SEQ(v)            ((v) & 0x00FFFFFF)
+#define CAS_YIELD               5       // swaps between forced preemptions
+#define TIMEOUT_SECONDS         60      // a lost value leaves a consumer waiting
+#define SEQ_SUM                 (((uint64_t)VALUES * (VALUES + 1)) / 2)
+
+//*****************************************************************************
+//
+// The queues, and what each consumer took: how many, the sum of the
+// sequence numbers, the last one seen from each producer and the number
+// that came out of order.
+//
+//*****************************************************************************
+static tLFSlot g_psSlots[MPMC_SLOTS];
+static tMPMCQueue g_sQueue;
+static uint32_t g_pui32SPSCSlots[SPSC_SLOTS];
+static tSPSCQueue g_sSPSC;
+static volatile bool g_bProduced;
+
+typedef struct
+{
+    uint32_t ui32Count;
+    uint64_t ui64Sum;
+    uint32_t pui32Last[PRODUCERS];
+    uint32_t ui32Disorder;
+}
+tTaken;
+
+static tTaken g_psTaken[CONSUMERS];
+
+bool
+LFCompareAndSwap(volatile uint32_t *pui32Word, uint32_t ui32Old,
+                 uint32_t ui32New)
+{
+    static __thread uint32_t ui32Swaps;
+    bool bSwapped;
+
+    bSwapped = __sync_bool_compare_and_swap(pui32Word, ui32Old, ui32New);
+    if(bSwapped && ((++ui32Swaps % CAS_YIELD) == 0))
+    {
+        sched_yield();
+    }
+    return(bSwapped);
+}
+
+static void
+Take(tTaken *psTaken, uint32_t ui32Value)
+{
+    uint32_t ui32Producer, ui32Seq;
+
+    ui32Producer = VALUE_PRODUCER(ui32Value);
+    ui32Seq = VALUE_SEQ(ui32Value);
+    if((ui32Producer >= PRODUCERS) ||
+       (ui32Seq <= psTaken->pui32Last[ui32Producer]))
+    {
+        psTaken->ui32Disorder++;
+        return;
+    }
+    psTaken->pui32Last[ui32Producer] = ui32Seq;
+    psTaken->ui64Sum += ui32Seq;
+    psTaken->ui32Count++;
+}
+
+//*****************************************************************************
+//
+// Sums what the consumers took and checks that each producer's values all
+// arrived, once and in order.
+//
+//*****************************************************************************
+static void
+CheckTaken(uint32_t ui32Consumers)
+{
+    uint64_t ui64Sum;
+    uint32_t ui32Idx, ui32Count, ui32Disorder;
+
+    ui64Sum = 0;
+    ui32Count = 0;
+    ui32Disorder = 0;
+    for(ui32Idx = 0; ui32Idx < ui32Consumers; ui32Idx++)
+    {
+        ui64Sum += g_psTaken[ui32Idx].ui64Sum;
+        ui32Count += g_psTaken[ui32Idx].ui32Count;
+        ui32Disorder += g_psTaken[ui32Idx].ui32Disorder;
+    }
+    CHECK(ui32Count == (PRODUCERS * VALUES));
+    CHECK(ui64Sum == (PRODUCERS * SEQ_SUM));
+    CHECK(ui32Disorder == 0);
+}
+
+//*****************************************************************************
+//
+// Thread functions.
+//
+//*****************************************************************************
+static void *
+Producer(void *pvArg)
+{
+    uint32_t ui32Producer, ui32Seq;
+
+    ui32Producer = (uint32_t)(uintptr_t)pvArg;
+    for(ui32Seq = 1; ui32Seq <= VALUES; ui32Seq++)
+    {
+        while(!MPMCQueuePut(&g_sQueue, VALUE(ui32Producer, ui32Seq)))
+        {
+            sched_yield();
+        }
+    }
+    return(0);
+}
+
+static void *
+MPMCConsumer(void *pvArg)
+{
+    tTaken *psTaken;
+    uint32_t ui32Value;
+
+    psTaken = &g_psTaken[(uintptr_t)pvArg];
+    while(1)
+    {
+        if(MPMCQueueGet(&g_sQueue, &ui32Value))
+        {
+            Take(psTaken, ui32Value);
+        }
+        else if(g_bProduced && !MPMCQueueCount(&g_sQueue))
+        {
+            break;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+    return(0);
+}
+
+static void *
+MPSCConsumer(void *pvArg)
+{
+    uint32_t ui32Value;
+
+    while(g_psTaken[0].ui32Count < (PRODUCERS * VALUES))
+    {
+        if(MPSCQueueGet(&g_sQueue, &ui32Value))
+        {
+            Take(&g_psTaken[0], ui32Value);
+        }
+        else if(g_bProduced && !MPMCQueueCount(&g_sQueue))
+        {
+            break;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+    return(0);
+}
+
+static void *
+SPSCProducer(void *pvArg)
+{
+    uint32_t ui32Seq;
+
+    for(ui32Seq = 1; ui32Seq <= (PRODUCERS * VALUES); ui32Seq++)
+    {
+        while(!SPSCQueuePut(&g_sSPSC, ui32Seq))
+        {
+            sched_yield();
+        }
+    }
+    return(0);
+}
+
+static void *
+SPSCConsumer(void *pvArg)
+{
+    uint32_t ui32Value, ui32Expected;
+
+    for(ui32Expected = 1; ui32Expected <= (PRODUCERS * VALUES); )
+    {
+        if(SPSCQueueGet(&g_sSPSC, &ui32Value))
+        {
+            g_psTaken[0].ui32Disorder += (ui32Value != ui32Expected);
+            g_psTaken[0].ui32Count++;
+            ui32Expected++;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Runs the producers against ui32Consumers threads of pfnConsumer.
+//
+//*****************************************************************************
+static void
+Run(void *(*pfnConsumer)(void *pvArg), uint32_t ui32Consumers)
+{
+    pthread_t psProducers[PRODUCERS], psConsumers[CONSUMERS];
+    uintptr_t uIdx;
+
+    memset(g_psTaken, 0, sizeof(g_psTaken));
+    MPMCQueueInit(&g_sQueue, g_psSlots, MPMC_SLOTS);
+    g_bProduced = false;
+
+    for(uIdx = 0; uIdx < ui32Consumers; uIdx++)
+    {
+        pthread_create(&psConsumers[uIdx], 0, pfnConsumer, (void *)uIdx);
+    }
+    for(uIdx = 0; uIdx < PRODUCERS; uIdx++)
+    {
+        pthread_create(&psProducers[uIdx], 0, Producer, (void *)uIdx);
+    }
+    for(uIdx = 0; uIdx < PRODUCERS; uIdx++)
+    {
+        pthread_join(psProducers[uIdx], 0);
+    }
+    g_bProduced = true;
+    for(uIdx = 0; uIdx < ui32Consumers; uIdx++)
+    {
+        pthread_join(psConsumers[uIdx], 0);
+    }
+
+    CheckTaken(ui32Consumers);
+    CHECK(MPMCQueueCount(&g_sQueue) == 0);
+}
+
+//*****************************************************************************
+//
+// One producer and one consumer; every value in order.
+//
+//*****************************************************************************
+static void
+TestSPSC(void)
+{
+    pthread_t sProducer, sConsumer;
+    uint32_t ui32Value;
+
+    memset(g_psTaken, 0, sizeof(g_psTaken));
+    SPSCQueueInit(&g_sSPSC, g_pui32SPSCSlots, SPSC_SLOTS);
+    pthread_create(&sConsumer, 0, SPSCConsumer, 0);
+    pthread_create(&sProducer, 0, SPSCProducer, 0);
+    pthread_join(sProducer, 0);
+    pthread_join(sConsumer, 0);
+
+    CHECK(g_psTaken[0].ui32Count == (PRODUCERS * VALUES));
+    CHECK(g_psTaken[0].ui32Disorder == 0);
+    CHECK(!SPSCQueueGet(&g_sSPSC, &ui32Value));
+}
+
+//*****************************************************************************
+//
+// The queues' limits on one thread: a full queue refuses a put, an empty
+// one a get.
+//
+//*****************************************************************************
+static void
+TestLimits(void)
+{
+    uint32_t ui32Idx, ui32Value;
+
+    MPMCQueueInit(&g_sQueue, g_psSlots, MPMC_SLOTS);
+    for(ui32Idx = 0; ui32Idx < MPMC_SLOTS; ui32Idx++)
+    {
+        CHECK(MPMCQueuePut(&g_sQueue, ui32Idx));
+    }
+    CHECK(!MPMCQueuePut(&g_sQueue, MPMC_SLOTS));
+    CHECK(MPMCQueueCount(&g_sQueue) == MPMC_SLOTS);
+    for(ui32Idx = 0; ui32Idx < MPMC_SLOTS; ui32Idx++)
+    {
+        CHECK(MPMCQueueGet(&g_sQueue, &ui32Value) && (ui32Value == ui32Idx));
+    }
+    CHECK(!MPMCQueueGet(&g_sQueue, &ui32Value));
+
+    SPSCQueueInit(&g_sSPSC, g_pui32SPSCSlots, SPSC_SLOTS);
+    for(ui32Idx = 0; ui32Idx < (SPSC_SLOTS - 1); ui32Idx++)
+    {
+        CHECK(SPSCQueuePut(&g_sSPSC, ui32Idx));
+    }
+    CHECK(!SPSCQueuePut(&g_sSPSC, SPSC_SLOTS));
+}
+
+int
+main(void)
+{
+    alarm(TIMEOUT_SECONDS);
+    TestLimits();
+    Run(MPMCConsumer, CONSUMERS);
+    Run(MPSCConsumer, 1);
+    TestSPSC();
+    return(HostResult("lfqueue"));
+}
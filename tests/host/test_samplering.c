@@ -0,0 +1,305 @@
+//*****************************************************************************
+//
+// test_samplering.c - Host tests of utils/samplering.c on the uDMA model: a
+// block lent to the pipeline is never written again while it is held, even
+// for laps of the ring, and blocks that cannot be lent are counted.
+//
+// Sample n is n, and the timer reads the number of samples taken, so a
+// block's time stamp tells what its samples must be.  The ring is polled
+// every few samples, at no fixed point in a block, so slots are swapped
+// while the uDMA is busy with others.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "driverlib/udma.h"
+#include "utils/mempool.h"
+#include "utils/pipeline.h"
+#include "utils/dmaseq.h"
+#include "utils/samplering.h"
+#include "udmamodel.h"
+#include "host.h"
+
+//*****************************************************************************
+//
+// Slots in the ring, blocks in the pool, samples per block, samples between
+// polls, and blocks the holder keeps before releasing the oldest (which it
+// does before taking another, so a held block outlasts a lap of the ring).
+//
+//*****************************************************************************
+#define SLOTS                   3
+#define POOL_BLOCKS             6
+#define SAMPLES                 32
+#define POLL_SAMPLES            7
+#define HELD                    (POOL_BLOCKS - SLOTS)
+
+static uint32_t g_pui32Storage[MEMPOOL_WORDS(PIPE_BLOCK_SIZE(SAMPLES *
+                                                             sizeof(uint16_t)),
+                                             POOL_BLOCKS)];
+static uint8_t g_pui8Refs[POOL_BLOCKS];
+static tMemPool g_sPool;
+
+static tDMAControlTable g_psTasks[SAMPLERING_TASKS(SLOTS)];
+static tDMASeq g_sSeq = { g_psTasks, SAMPLERING_TASKS(SLOTS),
+                          UDMA_CHANNEL_ADC0, true };
+static tPipeBlock *g_ppsBlocks[SLOTS];
+static volatile uint32_t g_pui32Times[SLOTS];
+static uint32_t g_pui32Numbers[SLOTS];
+static tSampleRing g_sRing = { &g_sSeq, &g_sPool, g_ppsBlocks, g_pui32Times,
+                               g_pui32Numbers, SLOTS };
+
+//*****************************************************************************
+//
+// The peripheral: its FIFO register and the free-running timer.
+//
+//*****************************************************************************
+static volatile uint16_t g_ui16FIFO;
+static volatile uint32_t g_ui32Timer;
+
+//*****************************************************************************
+//
+// The holder's blocks, oldest first, and what the test has counted: the
+// time stamp the next slot lent or kept should have, blocks lent and kept,
+// and blocks whose samples did not match their time stamp.
+//
+//*****************************************************************************
+static tPipeBlock *g_ppsHeld[POOL_BLOCKS];
+static uint32_t g_ui32Held;
+static uint32_t g_ui32Expected;
+static uint32_t g_ui32Lent;
+static uint32_t g_ui32Kept;
+static uint32_t g_ui32Bad;
+
+static void
+Init(void)
+{
+    MemPoolInit(&g_sPool, g_pui32Storage,
+                PIPE_BLOCK_SIZE(SAMPLES * sizeof(uint16_t)), POOL_BLOCKS,
+                g_pui8Refs);
+    UDMAModelInit();
+    CHECK(SampleRingInit(&g_sRing, &g_ui16FIFO, SAMPLES, &g_ui32Timer));
+    DMASeqStart(&g_sSeq);
+
+    g_ui32Timer = 0;
+    g_ui32Held = 0;
+    g_ui32Expected = SAMPLES;
+    g_ui32Lent = 0;
+    g_ui32Kept = 0;
+    g_ui32Bad = 0;
+}
+
+//*****************************************************************************
+//
+// Takes ui32Count samples.
+//
+//*****************************************************************************
+static void
+Sample(uint32_t ui32Count)
+{
+    while(ui32Count--)
+    {
+        g_ui16FIFO = (uint16_t)g_ui32Timer;
+        g_ui32Timer++;
+        UDMAModelRequest(UDMA_CHANNEL_ADC0);
+    }
+}
+
+//*****************************************************************************
+//
+// Checks a block's samples against its time stamp, the count after its
+// last sample.
+//
+//*****************************************************************************
+static void
+Check(tPipeBlock *psBlock)
+{
+    uint16_t *pui16Data;
+    uint32_t ui32Idx;
+
+    pui16Data = psBlock->pvData;
+    for(ui32Idx = 0; ui32Idx < SAMPLES; ui32Idx++)
+    {
+        if(pui16Data[ui32Idx] !=
+           (uint16_t)(psBlock->ui32Time - SAMPLES + ui32Idx))
+        {
+            g_ui32Bad++;
+            return;
+        }
+    }
+}
+
+static void
+ReleaseOldest(void)
+{
+    uint32_t ui32Idx;
+
+    Check(g_ppsHeld[0]);
+    PipeBlockRelease(g_ppsHeld[0]);
+    g_ui32Held--;
+    for(ui32Idx = 0; ui32Idx < g_ui32Held; ui32Idx++)
+    {
+        g_ppsHeld[ui32Idx] = g_ppsHeld[ui32Idx + 1];
+    }
+}
+
+//*****************************************************************************
+//
+// Lends every filled slot, as SysTick does, to a holder that keeps up to
+// ui32Hold blocks.  Lent blocks are checked when lent and again when
+// released, by which time the uDMA has been round the ring.
+//
+//*****************************************************************************
+static void
+Poll(uint32_t ui32Hold)
+{
+    tPipeBlock *psBlock;
+    uint32_t ui32Slots, ui32Time;
+
+    ui32Slots = SampleRingFilled(&g_sRing, &ui32Time);
+    while(ui32Slots--)
+    {
+        if(g_ui32Held && (g_ui32Held >= ui32Hold))
+        {
+            ReleaseOldest();
+        }
+        psBlock = SampleRingLend(&g_sRing, &ui32Time);
+        CHECK(ui32Time == g_ui32Expected);
+        g_ui32Expected += SAMPLES;
+        if(!psBlock)
+        {
+            g_ui32Kept++;
+            continue;
+        }
+        g_ui32Lent++;
+        psBlock->ui32Time = ui32Time;
+        Check(psBlock);
+        g_ppsHeld[g_ui32Held++] = psBlock;
+    }
+}
+
+static void
+ReleaseAll(void)
+{
+    while(g_ui32Held)
+    {
+        ReleaseOldest();
+    }
+}
+
+//*****************************************************************************
+//
+// Steady running: every block is lent and held for a lap of the ring, and
+// none is written while held.
+//
+//*****************************************************************************
+static void
+TestSteady(void)
+{
+    uint32_t ui32Poll;
+
+    Init();
+    for(ui32Poll = 0; ui32Poll < 1000; ui32Poll++)
+    {
+        Sample(POLL_SAMPLES);
+        Poll(HELD);
+    }
+    ReleaseAll();
+
+    CHECK(g_ui32Lent == ((1000 * POLL_SAMPLES) / SAMPLES));
+    CHECK(g_ui32Kept == 0);
+    CHECK(g_ui32Bad == 0);
+    CHECK(g_sRing.ui32Lent == g_ui32Lent);
+    CHECK(g_sRing.ui32Kept == 0);
+    CHECK(uDMAChannelIsEnabled(UDMA_CHANNEL_ADC0));
+}
+
+//*****************************************************************************
+//
+// A holder that keeps more than the pool can spare: the slots it cannot
+// take are kept in the ring, counted, and refilled; once it lets go,
+// lending resumes.
+//
+//*****************************************************************************
+static void
+TestExhausted(void)
+{
+    uint32_t ui32Poll;
+
+    Init();
+    for(ui32Poll = 0; ui32Poll < 100; ui32Poll++)
+    {
+        Sample(POLL_SAMPLES);
+        Poll(POOL_BLOCKS);
+    }
+    CHECK(g_ui32Held == HELD);
+    CHECK(g_ui32Kept == (((100 * POLL_SAMPLES) / SAMPLES) - HELD));
+    CHECK(g_sRing.ui32Kept == g_ui32Kept);
+
+    ReleaseAll();
+    for(ui32Poll = 0; ui32Poll < 100; ui32Poll++)
+    {
+        Sample(POLL_SAMPLES);
+        Poll(HELD);
+    }
+    ReleaseAll();
+
+    CHECK(g_ui32Lent > HELD);
+    CHECK(g_ui32Bad == 0);
+    CHECK(MemPoolRefsGet(&g_sPool, g_ppsBlocks[0]) == 1);
+}
+
+//*****************************************************************************
+//
+// A poll a lap late: the count of filled slots wraps to none (the time
+// stamp shows the lap), and of a whole lap's slots the one the uDMA has
+// started on again is kept.
+//
+//*****************************************************************************
+static void
+TestLap(void)
+{
+    uint32_t ui32Slots, ui32Time, ui32Idx;
+    tPipeBlock *psBlock;
+
+    Init();
+    Sample((SLOTS * SAMPLES) + 1);
+    ui32Slots = SampleRingFilled(&g_sRing, &ui32Time);
+    CHECK(ui32Slots == 0);
+    CHECK(ui32Time == (SLOTS * SAMPLES));
+
+    psBlock = SampleRingLend(&g_sRing, &ui32Time);
+    CHECK(psBlock == 0);
+    CHECK(g_sRing.ui32Kept == 1);
+    for(ui32Idx = 1; ui32Idx < SLOTS; ui32Idx++)
+    {
+        psBlock = SampleRingLend(&g_sRing, &ui32Time);
+        CHECK(psBlock != 0);
+        CHECK(ui32Time == ((ui32Idx + 1) * SAMPLES));
+        if(psBlock)
+        {
+            psBlock->ui32Time = ui32Time;
+            g_ppsHeld[g_ui32Held++] = psBlock;
+        }
+    }
+
+    //
+    // The kept slot is lent as usual once refilled.
+    //
+    g_ui32Expected = (SLOTS + 1) * SAMPLES;
+    Sample(SAMPLES);
+    Poll(HELD);
+    ReleaseAll();
+
+    CHECK(g_ui32Lent == 1);
+    CHECK(g_ui32Bad == 0);
+}
+
+int
+main(void)
+{
+    TestSteady();
+    TestExhausted();
+    TestLap();
+    return(HostResult("samplering"));
+}
@@ -0,0 +1,227 @@
+//*****************************************************************************
+//
+// test_seqlock.c - Host torture test of utils/seqlock.c: a writer thread
+// publishes a multi-word value as fast as it can while a reader copies it,
+// and no copy the lock accepts may mix two updates.
+//
+// Each side gives up the processor in the middle of its copy every so
+// often, so the other lands inside it even on one core: the reader inside
+// an update, and updates inside a read.
+//
+//*****************************************************************************
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "utils/seqlock.h"
+#include "host.h"
+
+//*****************************************************************************
+//
+// Words in the value, reads made (the writer keeps publishing until they
+// are done), and how often each side yields halfway through a copy.
+// Update n is n * (k + 1) in word k.
+//
+//*****************************************************************************
+#define WORDS                   6
+#define READS                   200000
+#define WRITE_YIELD             97
+#define READ_YIELD              89
+
+static tSeqLock g_sLock;
+static volatile uint32_t g_pui32Value[WORDS];
+static volatile bool g_bRead;
+
+//*****************************************************************************
+//
+// What the reader saw: copies accepted, copies refused or retried because
+// an update overlapped them, accepted copies that mixed two updates, and
+// accepted copies older than one before.
+//
+//*****************************************************************************
+static uint32_t g_ui32Accepted;
+static uint32_t g_ui32Refused;
+static uint32_t g_ui32Retried;
+static uint32_t g_ui32Torn;
+static uint32_t g_ui32Backwards;
+
+static void
+Fill(uint32_t *pui32Value, uint32_t ui32Update)
+{
+    uint32_t ui32Idx;
+
+    for(ui32Idx = 0; ui32Idx < WORDS; ui32Idx++)
+    {
+        pui32Value[ui32Idx] = ui32Update * (ui32Idx + 1);
+    }
+}
+
+//*****************************************************************************
+//
+// Checks an accepted copy: all of one update, and none older than the last.
+//
+//*****************************************************************************
+static void
+Accept(const uint32_t *pui32Copy, uint32_t *pui32Last)
+{
+    uint32_t ui32Idx;
+
+    g_ui32Accepted++;
+    for(ui32Idx = 1; ui32Idx < WORDS; ui32Idx++)
+    {
+        if(pui32Copy[ui32Idx] != (pui32Copy[0] * (ui32Idx + 1)))
+        {
+            g_ui32Torn++;
+            return;
+        }
+    }
+    if(pui32Copy[0] < *pui32Last)
+    {
+        g_ui32Backwards++;
+    }
+    *pui32Last = pui32Copy[0];
+}
+
+//*****************************************************************************
+//
+// Writer and reader threads.  The writer mostly uses SeqLockPublish(), but
+// now and then makes an update of its own that yields halfway, and as
+// often yields between updates.  The reader mostly uses SeqLockRead(), but
+// now and then makes a read of its own that yields halfway; a retry yields
+// first instead, to let the writer reach a point between updates (on one
+// core the reader would otherwise only ever find it halfway through one).
+//
+//*****************************************************************************
+static void *
+Writer(void *pvArg)
+{
+    uint32_t pui32New[WORDS];
+    uint32_t ui32Update, ui32Idx;
+
+    for(ui32Update = 1; !g_bRead; ui32Update++)
+    {
+        Fill(pui32New, ui32Update);
+        if(ui32Update % WRITE_YIELD)
+        {
+            SeqLockPublish(&g_sLock, g_pui32Value, pui32New, WORDS);
+            if((ui32Update % WRITE_YIELD) == (WRITE_YIELD / 2))
+            {
+                sched_yield();
+            }
+            continue;
+        }
+
+        SeqLockWriteBegin(&g_sLock);
+        for(ui32Idx = 0; ui32Idx < WORDS; ui32Idx++)
+        {
+            g_pui32Value[ui32Idx] = pui32New[ui32Idx];
+            if(ui32Idx == (WORDS / 2))
+            {
+                sched_yield();
+            }
+        }
+        SeqLockWriteEnd(&g_sLock);
+    }
+    return(0);
+}
+
+static void *
+Reader(void *pvArg)
+{
+    uint32_t pui32Copy[WORDS];
+    uint32_t ui32Read, ui32Idx, ui32Seq, ui32Last;
+    bool bRetry;
+
+    ui32Last = 0;
+    for(ui32Read = 1; ui32Read <= READS; ui32Read++)
+    {
+        if(ui32Read % READ_YIELD)
+        {
+            if(SeqLockRead(&g_sLock, g_pui32Value, pui32Copy, WORDS))
+            {
+                Accept(pui32Copy, &ui32Last);
+            }
+            else
+            {
+                g_ui32Refused++;
+            }
+            continue;
+        }
+
+        bRetry = false;
+        while(1)
+        {
+            if(bRetry)
+            {
+                sched_yield();
+            }
+            ui32Seq = SeqLockReadBegin(&g_sLock);
+            for(ui32Idx = 0; ui32Idx < WORDS; ui32Idx++)
+            {
+                pui32Copy[ui32Idx] = g_pui32Value[ui32Idx];
+                if((ui32Idx == (WORDS / 2)) && !bRetry)
+                {
+                    sched_yield();
+                }
+            }
+            if(!SeqLockReadRetry(&g_sLock, ui32Seq))
+            {
+                break;
+            }
+            g_ui32Retried++;
+            bRetry = true;
+        }
+        Accept(pui32Copy, &ui32Last);
+    }
+    g_bRead = true;
+    return(0);
+}
+
+//*****************************************************************************
+//
+// A reader that has preempted the writer mid-update (as a handler would)
+// gets no copy, and does not wait for one.
+//
+//*****************************************************************************
+static void
+TestPreemptedWriter(void)
+{
+    uint32_t pui32Copy[WORDS], pui32New[WORDS];
+
+    Fill(pui32New, 7);
+    SeqLockPublish(&g_sLock, g_pui32Value, pui32New, WORDS);
+    SeqLockWriteBegin(&g_sLock);
+    g_pui32Value[0] = 0;
+    CHECK(!SeqLockRead(&g_sLock, g_pui32Value, pui32Copy, WORDS));
+    g_pui32Value[0] = 7;
+    SeqLockWriteEnd(&g_sLock);
+    CHECK(SeqLockRead(&g_sLock, g_pui32Value, pui32Copy, WORDS));
+    CHECK((pui32Copy[0] == 7) && (pui32Copy[WORDS - 1] == (7 * WORDS)));
+}
+
+static void
+TestTorture(void)
+{
+    pthread_t sWriter, sReader;
+
+    g_sLock.ui32Seq = 0;
+    pthread_create(&sReader, 0, Reader, 0);
+    pthread_create(&sWriter, 0, Writer, 0);
+    pthread_join(sWriter, 0);
+    pthread_join(sReader, 0);
+
+    CHECK(g_ui32Accepted > 0);
+    CHECK((g_ui32Refused + g_ui32Retried) > 0);
+    CHECK(g_ui32Torn == 0);
+    CHECK(g_ui32Backwards == 0);
+    CHECK((g_sLock.ui32Seq & 1) == 0);
+}
+
+int
+main(void)
+{
+    TestPreemptedWriter();
+    TestTorture();
+    return(HostResult("seqlock"));
+}
@@ -0,0 +1,240 @@
+//*****************************************************************************
+//
+// udmamodel.c - A model of the TM4C123 uDMA controller for the host tests.
+//
+// Only what scatter-gather needs: the primary structure copies the task
+// list into the alternate one, a task at a time, and the alternate runs
+// each task.  A peripheral task moves its arbitration size of items per
+// request; a memory task runs through as soon as it is copied, so the tasks
+// after a peripheral one run straight after its last item, as on the part.
+// The task list is read when a task is copied, so a task changed before
+// then runs changed.
+//
+// On the host a task's pointers are 64 bits, so the primary structure's
+// count is still in 32-bit words (four per task, as uDMAChannelScatterGather
+// Set() writes it) but it copies whole tDMAControlTable entries.
+//
+//*****************************************************************************
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "inc/hw_udma.h"
+#include "driverlib/udma.h"
+#include "udmamodel.h"
+
+#define CHANNELS                32
+
+//*****************************************************************************
+//
+// The control table (primary structures, then alternate ones) and, per
+// channel, whether it is enabled and whether the alternate structure is the
+// one running.
+//
+//*****************************************************************************
+static tDMAControlTable g_psTable[CHANNELS * 2] __attribute__((aligned(1024)));
+static bool g_pbEnabled[CHANNELS];
+static bool g_pbAlternate[CHANNELS];
+
+void
+UDMAModelInit(void)
+{
+    memset(g_psTable, 0, sizeof(g_psTable));
+    memset(g_pbEnabled, 0, sizeof(g_pbEnabled));
+    memset(g_pbAlternate, 0, sizeof(g_pbAlternate));
+}
+
+//*****************************************************************************
+//
+// The address step of an increment field: 1, 2 or 4 bytes, or none.
+//
+//*****************************************************************************
+static uint32_t
+Step(uint32_t ui32Inc)
+{
+    return((ui32Inc == 3) ? 0 : (1 << ui32Inc));
+}
+
+//*****************************************************************************
+//
+// Moves the next item of a structure's transfer.  Returns true if that was
+// the last one, leaving the structure stopped.
+//
+//*****************************************************************************
+static bool
+Move(tDMAControlTable *psCtl)
+{
+    uint32_t ui32Control, ui32Left;
+    uint8_t *pui8Src, *pui8Dst;
+
+    ui32Control = psCtl->ui32Control;
+    ui32Left = ((ui32Control & UDMA_CHCTL_XFERSIZE_M) >>
+                UDMA_CHCTL_XFERSIZE_S) + 1;
+    pui8Src = (uint8_t *)psCtl->pvSrcEndAddr -
+              ((ui32Left - 1) * Step((ui32Control & UDMA_CHCTL_SRCINC_M) >>
+                                     UDMA_CHCTL_SRCINC_S));
+    pui8Dst = (uint8_t *)psCtl->pvDstEndAddr -
+              ((ui32Left - 1) * Step((ui32Control & UDMA_CHCTL_DSTINC_M) >>
+                                     UDMA_CHCTL_DSTINC_S));
+    memcpy(pui8Dst, pui8Src,
+           1 << ((ui32Control & UDMA_CHCTL_SRCSIZE_M) >> UDMA_CHCTL_SRCSIZE_S));
+
+    if(ui32Left == 1)
+    {
+        psCtl->ui32Control = ui32Control & ~(UDMA_CHCTL_XFERSIZE_M |
+                                             UDMA_CHCTL_XFERMODE_M);
+        return(true);
+    }
+    psCtl->ui32Control = (ui32Control & ~UDMA_CHCTL_XFERSIZE_M) |
+                         ((ui32Left - 2) << UDMA_CHCTL_XFERSIZE_S);
+    return(false);
+}
+
+//*****************************************************************************
+//
+// Copies the next task into the alternate structure.  The task's spare word
+// is where the primary structure's end pointer points.
+//
+//*****************************************************************************
+static void
+Fetch(uint32_t ui32Channel)
+{
+    tDMAControlTable *psPrimary, *psTask;
+    uint32_t ui32Control, ui32Words;
+
+    psPrimary = &g_psTable[ui32Channel];
+    ui32Control = psPrimary->ui32Control;
+    ui32Words = ((ui32Control & UDMA_CHCTL_XFERSIZE_M) >>
+                 UDMA_CHCTL_XFERSIZE_S) + 1;
+    psTask = (tDMAControlTable *)((uint8_t *)psPrimary->pvSrcEndAddr -
+                                  offsetof(tDMAControlTable, ui32Spare)) -
+             ((ui32Words / 4) - 1);
+    g_psTable[ui32Channel + CHANNELS] = *psTask;
+
+    if(ui32Words == 4)
+    {
+        psPrimary->ui32Control = ui32Control & ~(UDMA_CHCTL_XFERSIZE_M |
+                                                 UDMA_CHCTL_XFERMODE_M);
+    }
+    else
+    {
+        psPrimary->ui32Control = (ui32Control & ~UDMA_CHCTL_XFERSIZE_M) |
+                                 ((ui32Words - 5) << UDMA_CHCTL_XFERSIZE_S);
+    }
+    g_pbAlternate[ui32Channel] = true;
+}
+
+//*****************************************************************************
+//
+// Runs a channel until it waits for a peripheral request, or stops.  With
+// bRequest set, one request is there to be served.
+//
+//*****************************************************************************
+static void
+Run(uint32_t ui32Channel, bool bRequest)
+{
+    tDMAControlTable *psAlt;
+    uint32_t ui32Mode, ui32Items;
+
+    psAlt = &g_psTable[ui32Channel + CHANNELS];
+    while(g_pbEnabled[ui32Channel])
+    {
+        if(!g_pbAlternate[ui32Channel])
+        {
+            if(!(g_psTable[ui32Channel].ui32Control & UDMA_CHCTL_XFERMODE_M))
+            {
+                g_pbEnabled[ui32Channel] = false;
+                return;
+            }
+            Fetch(ui32Channel);
+            continue;
+        }
+
+        ui32Mode = psAlt->ui32Control & UDMA_CHCTL_XFERMODE_M;
+        if(ui32Mode == UDMA_MODE_STOP)
+        {
+            g_pbAlternate[ui32Channel] = false;
+        }
+        else if((ui32Mode & ~UDMA_MODE_ALT_SELECT) ==
+                UDMA_MODE_PER_SCATTER_GATHER)
+        {
+            if(!bRequest)
+            {
+                return;
+            }
+            bRequest = false;
+            ui32Items = 1 << ((psAlt->ui32Control & UDMA_CHCTL_ARBSIZE_M) >>
+                              UDMA_CHCTL_ARBSIZE_S);
+            while(ui32Items-- && !Move(psAlt))
+            {
+            }
+        }
+        else
+        {
+            while(!Move(psAlt))
+            {
+            }
+        }
+    }
+}
+
+//*****************************************************************************
+//
+// A peripheral request on a channel.
+//
+//*****************************************************************************
+void
+UDMAModelRequest(uint32_t ui32Channel)
+{
+    Run(ui32Channel, true);
+}
+
+//*****************************************************************************
+//
+// The driverlib functions, as TivaWare's.
+//
+//*****************************************************************************
+void *
+uDMAControlBaseGet(void)
+{
+    return(g_psTable);
+}
+
+void
+uDMAChannelScatterGatherSet(uint32_t ui32ChannelNum, uint32_t ui32TaskCount,
+                            void *pvTaskList, uint32_t ui32IsPeriphSG)
+{
+    tDMAControlTable *psPrimary;
+
+    ui32ChannelNum &= 0x1F;
+    psPrimary = &g_psTable[ui32ChannelNum];
+    psPrimary->pvSrcEndAddr =
+        &((tDMAControlTable *)pvTaskList)[ui32TaskCount - 1].ui32Spare;
+    psPrimary->pvDstEndAddr = &g_psTable[ui32ChannelNum + CHANNELS].ui32Spare;
+    psPrimary->ui32Control = UDMA_DST_INC_32 | UDMA_SRC_INC_32 |
+                             UDMA_SIZE_32 | UDMA_ARB_4 |
+                             (((ui32TaskCount * 4) - 1) <<
+                              UDMA_CHCTL_XFERSIZE_S) |
+                             (ui32IsPeriphSG ? UDMA_MODE_PER_SCATTER_GATHER :
+                              UDMA_MODE_MEM_SCATTER_GATHER);
+    g_pbAlternate[ui32ChannelNum] = false;
+}
+
+void
+uDMAChannelEnable(uint32_t ui32ChannelNum)
+{
+    g_pbEnabled[ui32ChannelNum & 0x1F] = true;
+}
+
+bool
+uDMAChannelIsEnabled(uint32_t ui32ChannelNum)
+{
+    return(g_pbEnabled[ui32ChannelNum & 0x1F]);
+}
+
+void
+uDMAChannelRequest(uint32_t ui32ChannelNum)
+{
+    Run(ui32ChannelNum & 0x1F, false);
+}
@@ -0,0 +1,20 @@
+//*****************************************************************************
+//
+// udmamodel.h - A model of the TM4C123 uDMA controller for the host tests.
+//
+//*****************************************************************************
+
+#ifndef __UDMAMODEL_H__
+#define __UDMAMODEL_H__
+
+#include <stdint.h>
+
+//*****************************************************************************
+//
+// Prototypes.
+//
+//*****************************************************************************
+extern void UDMAModelInit(void);
+extern void UDMAModelRequest(uint32_t ui32Channel);
+
+#endif // __UDMAMODEL_H__
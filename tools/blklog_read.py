@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""
+Name: blklog_read.py
+
+Description:
+Reads the sample log that 010_basic-dma writes to an SD card
+(utils/blklog.c) from an image of the card, checks every block and writes
+the decoded samples to CSV.
+
+The card holds no file system: block 0 is the superblock and the blocks
+after it, up to the first one that is not valid for the superblock's
+generation, carry a stream of records (see utils/blklog.h). A record cut
+short by a reset is reported and skipped.
+
+Usage:
+    sudo dd if=/dev/sdX of=card.img bs=1M count=64
+    python tools/blklog_read.py card.img --csv samples.csv
+    python tools/blklog_read.py /dev/sdX --csv samples.csv --from-ms 60000
+"""
+
+import argparse
+import struct
+import sys
+
+import telemetry
+
+BLOCK = 512
+HEADER = 20
+SUPER_MAGIC = 0x534B4C42
+BLOCK_MAGIC = 0x444B4C42
+RECORD_MAGIC = 0xA5
+RECORD_HEADER = 12
+FIRST_NONE = 0xFFFF
+
+# PIPE_FORMAT_ values (utils/pipeline.h) to telemetry frame types.
+FORMAT_TYPES = {
+    0: telemetry.TYPE_SAMPLES16,
+    2: telemetry.TYPE_PACKED12,
+    3: telemetry.TYPE_RICE,
+    4: telemetry.TYPE_VARINT,
+}
+
+
+def blocks(image):
+    """Yields the payload and first-record offset of each valid data block."""
+    superblock = image.read(BLOCK)
+    if len(superblock) < BLOCK:
+        raise ValueError('image shorter than one block')
+    magic, generation, check = struct.unpack_from('<III', superblock)
+    if magic != SUPER_MAGIC or check != generation ^ 0xFFFFFFFF:
+        raise ValueError('no log on this card (run "sd format")')
+    index = 0
+    while True:
+        block = image.read(BLOCK)
+        if len(block) < BLOCK:
+            return
+        magic, gen, number, used, first, crc = struct.unpack_from(
+            '<IIIHHI', block)
+        if magic != BLOCK_MAGIC or gen != generation or number != index or \
+                used > BLOCK - HEADER or \
+                crc != telemetry.crc16(block[HEADER:HEADER + used],
+                                       telemetry.crc16(block[:16])):
+            return
+        yield block[HEADER:HEADER + used], first
+        index += 1
+
+
+def record_size(data):
+    """Size of the record starting data, padded; None if it is no record."""
+    word = struct.unpack_from('<I', data)[0]
+    if word >> 24 != RECORD_MAGIC:
+        return None
+    return RECORD_HEADER + (((word & 0xFFFF) + 3) & ~3)
+
+
+def parse(data):
+    word, seq, time_ms = struct.unpack_from('<III', data)
+    return (word >> 16) & 0xFF, seq, time_ms, \
+        data[RECORD_HEADER:RECORD_HEADER + (word & 0xFFFF)]
+
+
+def records(image, stats):
+    """Yields (format, seq, time_ms, data) for each complete record."""
+    pending = b''           # a record begun in an earlier block
+    for payload, first in blocks(image):
+        stats['blocks'] += 1
+        if first == FIRST_NONE:
+            first = len(payload)
+        if pending:
+            pending += payload[:first]
+            size = record_size(pending) if len(pending) >= RECORD_HEADER \
+                else 0
+            if size and len(pending) == size:
+                yield parse(pending)
+                pending = b''
+            elif size is None or len(pending) > size > 0 or \
+                    first < len(payload):
+                stats['torn'] += 1
+                pending = b''
+        elif first:
+            stats['torn'] += 1      # the start of this record is gone
+        if first == len(payload):
+            continue
+
+        stream = payload[first:]
+        while stream:
+            size = record_size(stream) if len(stream) >= RECORD_HEADER \
+                else None
+            if size is not None and len(stream) >= size:
+                yield parse(stream)
+                stream = stream[size:]
+            else:
+                break
+        pending = stream
+    if pending:
+        stats['torn'] += 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n\n')[1])
+    ap.add_argument('image', help='card image or block device')
+    ap.add_argument('--csv', help='write seq,time_ms,index,sample rows here')
+    ap.add_argument('--from-ms', type=int, default=0,
+                    help='skip records older than this log time')
+    args = ap.parse_args()
+
+    csv = open(args.csv, 'w') if args.csv else None
+    if csv:
+        csv.write('seq,time_ms,index,sample\n')
+    stats = {'blocks': 0, 'torn': 0}
+    count = samples_total = errors = 0
+    last_seq = None
+    lost = 0
+    with open(args.image, 'rb') as image:
+        try:
+            for fmt, seq, time_ms, data in records(image, stats):
+                count += 1
+                if last_seq is not None and seq != last_seq + 1:
+                    lost += (seq - last_seq - 1) & 0xFFFFFFFF
+                last_seq = seq
+                if time_ms < args.from_ms or fmt not in FORMAT_TYPES:
+                    continue
+                try:
+                    samples = telemetry.decode_samples(telemetry.Frame(
+                        FORMAT_TYPES[fmt], 0, seq & 0xFFFF, data))
+                except ValueError:
+                    errors += 1
+                    continue
+                samples_total += len(samples)
+                if csv:
+                    for i, value in enumerate(samples):
+                        csv.write('%d,%d,%d,%d\n' % (seq, time_ms, i, value))
+        except ValueError as e:
+            sys.exit('blklog_read: %s' % e)
+
+    if csv:
+        csv.close()
+    sys.stderr.write('%d blocks, %d records (%d samples), %d missing by '
+                     'sequence, %d cut short, %d undecodable\n' % (
+                         stats['blocks'], count, samples_total, lost,
+                         stats['torn'], errors))
+    return 1 if stats['torn'] or errors else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+"""
+Name: sample_clock.py
+
+Description:
+Measures the ADC sample clock of 010_basic-dma (built with TELEMETRY_STREAM)
+from the block time stamps it sends on telemetry channel 3: the rate the
+samples were really taken at, the jitter of the block completions against a
+steady clock, and the gaps, whether blocks that never arrived, samples the
+ADC lost to a FIFO overflow or time that went missing between blocks.
+
+Each time stamp is the CPU cycle count of a block's last sample, taken in
+the DMA interrupt and corrected for the samples already in the next block,
+so the jitter reported includes that interrupt's latency. The analysis
+assumes the rate does not change while it runs.
+
+Usage:
+    python tools/sample_clock.py /dev/ttyACM0 --seconds 30
+    python tools/sample_clock.py capture.bin --csv blocks.csv
+    cat /dev/ttyACM0 | python tools/sample_clock.py -
+
+Reading a serial port needs pyserial (pip install pyserial).
+"""
+
+import argparse
+import math
+import os
+import stat
+import sys
+import time
+
+import telemetry
+from telemetry_rx import open_source
+
+CHANNEL_TIME = 3
+
+
+def collect(read, is_port, seconds):
+    """Reads the stream and returns its block time stamps, in order."""
+    rx = telemetry.Receiver()
+    stamps = []
+    start = time.time()
+    try:
+        while True:
+            data = read(4096)
+            if not data and not is_port:
+                break
+            for frame in rx.feed(data):
+                if frame.type == telemetry.TYPE_BLOCKTIME and \
+                        frame.channel == CHANNEL_TIME:
+                    stamps.append(telemetry.blocktime(frame.payload))
+            if seconds and time.time() - start >= seconds:
+                break
+    except KeyboardInterrupt:
+        pass
+    return stamps, rx
+
+
+def median(values):
+    ordered = sorted(values)
+    mid = len(ordered) // 2
+    if len(ordered) % 2:
+        return ordered[mid]
+    return (ordered[mid - 1] + ordered[mid]) / 2.0
+
+
+def analyse(stamps, csv):
+    """Prints the rate, jitter and gaps of a run of time stamps."""
+    clock = float(stamps[-1].clock)
+    samples = stamps[-1].samples
+    us = 1e6 / clock
+
+    #
+    # The nominal sample period comes from the intervals between
+    # consecutive blocks, which a lost block or sample does not disturb.
+    #
+    periods = [((b.time - a.time) & 0xFFFFFFFF) / float(b.samples)
+               for a, b in zip(stamps, stamps[1:]) if b.block == a.block + 1]
+    if not periods:
+        sys.exit('sample_clock: no consecutive blocks received')
+    period = median(periods)
+
+    lost_blocks = gap_samples = early = 0
+    deviations = []
+    elapsed = 0
+    sample_count = 0
+    fit = []
+    if csv:
+        csv.write('block,time_us,interval_us,deviation_us\n')
+    for a, b in zip(stamps, stamps[1:]):
+        steps = (b.block - a.block) & 0xFFFFFFFF
+        if steps == 0 or steps > 0x80000000:
+            continue                    # repeated or out of order
+        lost_blocks += steps - 1
+        interval = (b.time - a.time) & 0xFFFFFFFF
+        deviation = interval - steps * b.samples * period
+        elapsed += interval
+        sample_count += steps * b.samples
+        if deviation > period / 2:
+            missing = int(round(deviation / period))
+            gap_samples += missing
+            print('gap before block %d: %.1f us, about %d samples' % (
+                b.block, deviation * us, missing))
+        elif deviation < -period / 2:
+            early += 1
+            print('block %d came %.1f us early' % (b.block, -deviation * us))
+        else:
+            deviations.append(deviation)
+        fit.append((sample_count + gap_samples, elapsed))
+        if csv:
+            csv.write('%d,%.3f,%.3f,%.3f\n' % (b.block, elapsed * us,
+                                               interval * us, deviation * us))
+
+    #
+    # Time interval error: each stamp against the straight line through all
+    # of them, with the gaps taken out by counting the missing samples.
+    #
+    n = float(len(fit))
+    mean_x = sum(x for x, _ in fit) / n
+    mean_y = sum(y for _, y in fit) / n
+    sxx = sum((x - mean_x) ** 2 for x, _ in fit)
+    slope = sum((x - mean_x) * (y - mean_y) for x, y in fit) / sxx \
+        if sxx else period
+    errors = [y - mean_y - slope * (x - mean_x) for x, y in fit]
+
+    rms = math.sqrt(sum(d * d for d in deviations) / len(deviations)) \
+        if deviations else 0.0
+    missed = (stamps[-1].missed - stamps[0].missed) & 0xFFFFFFFF
+
+    print('%d blocks of %d samples over %.3f s, clock %d Hz' % (
+        len(stamps), samples, elapsed / clock, clock))
+    print('Sample rate %.3f Hz nominal, %.3f Hz fitted, %.3f Hz effective '
+          '(samples taken over the time taken)' % (
+              clock / period, clock / slope,
+              sample_count * clock / max(elapsed, 1)))
+    print('Block interval jitter %.2f us rms, %.2f us peak; time error '
+          '%.2f us peak to peak' % (
+              rms * us, max([abs(d) for d in deviations] or [0]) * us,
+              (max(errors) - min(errors)) * us))
+    print('Gaps: %d blocks not received, %d samples of time missing, '
+          '%d early blocks, %d ADC overflows reported' % (
+              lost_blocks, gap_samples, early, missed))
+    return lost_blocks or gap_samples or early or missed
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n\n')[1])
+    ap.add_argument('source', help='serial port, capture file, or - for stdin')
+    ap.add_argument('--baud', type=int, default=921600,
+                    help='serial baud rate (default: 921600)')
+    ap.add_argument('--csv', help='write block,time_us,interval_us,'
+                                  'deviation_us rows here')
+    ap.add_argument('--seconds', type=float,
+                    help='stop after this many seconds')
+    args = ap.parse_args()
+
+    is_port = args.source != '-' and \
+        stat.S_ISCHR(os.stat(args.source).st_mode)
+    stamps, rx = collect(open_source(args.source, args.baud), is_port,
+                         args.seconds)
+    if len(stamps) < 2:
+        sys.exit('sample_clock: fewer than two block time stamps received '
+                 '(%d CRC errors)' % rx.crc_errors)
+
+    csv = open(args.csv, 'w') if args.csv else None
+    irregular = analyse(stamps, csv)
+    if csv:
+        csv.close()
+    return 1 if irregular else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
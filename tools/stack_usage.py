@@ -0,0 +1,409 @@
+#!/usr/bin/env python3
+"""
+Name: stack_usage.py
+
+Description:
+Static worst-case stack analysis for the Tiva C projects.
+
+Disassembles the linked image with arm-none-eabi-objdump (TI's ELF output is
+standard ARM ELF), works out each function's frame from its prologue (PUSH,
+VPUSH, STMDB SP!, SUB SP) and builds the call graph from BL/BLX and tail
+branches. The interrupt handlers are the entries of g_pfnVectors in the
+project's startup file, less ResetISR (whose depth is main's) and any
+handler another entry calls (a helper, not a separate exception). The
+worst-case depth of main() and of every handler is then reported, plus the
+total the system stack must hold when handlers interrupt main at its deepest
+point. Handlers of one priority cannot nest, so the deepest handler of every
+level is added, since one of each may be stacked on the next. The levels are
+read from the project's interrupt priority plan (g_psIntPlan in main.c, its
+PRIORITY_* values and INT_*/FAULT_* numbers from TivaWare's inc/hw_ints.h)
+and matched to handlers by their place in the vector table. Without a plan,
+all handlers are taken at one priority, as in most of these projects, and the
+total is main plus the deepest handler. --priority sets a handler's level by
+hand, over the plan.
+
+Usage (also run as a post-build step in 010_basic-dma):
+    python tools/stack_usage.py --stack-size 1024 \
+        --startup tm4c123gh6pm_startup_ccs.c \
+        --hw-ints C:/ti/TivaWare_C_Series-2.2.0.295/inc/hw_ints.h \
+        Debug/010_basic-dma.out
+
+Functions reached through a function pointer (BLX rN) and recursive cycles
+cannot be bounded statically; they are listed so they can be checked by hand
+(or with utils/stackmon.c on target).
+"""
+
+import argparse
+import glob
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+# Bytes pushed by the processor on exception entry: basic frame, and extended
+# frame when the interrupted code had an active FPU context (plus alignment).
+EXCEPTION_FRAME = 32
+EXCEPTION_FRAME_FPU = 108
+
+FUNC_RE = re.compile(r'^([0-9a-fA-F]+) <([^>]+)>:\s*$')
+INSN_RE = re.compile(r'^\s*([0-9a-fA-F]+):\s+(?:[0-9a-fA-F]{4,8}\s+){1,2}\s*'
+                     r'([a-z][a-z0-9.]*)\s*(.*)$')
+TARGET_RE = re.compile(r'[0-9a-fA-F]+ <([^>+]+)(\+0x[0-9a-fA-F]+)?>')
+IMM_RE = re.compile(r'#(\d+|0x[0-9a-fA-F]+)')
+HANDLER_RE = re.compile(r'(Handler|ISR|IntHandler)$')
+VECTORS_RE = re.compile(r'g_pfnVectors\s*\[\s*\]\s*\)\s*\(\s*void\s*\)\s*=\s*'
+                        r'\{(.*?)\};', re.S)
+NAME_RE = re.compile(r'[A-Za-z_]\w*$')
+DEFINE_RE = re.compile(r'^\s*#\s*define\s+(\w+)\s+(\w+)', re.M)
+PLAN_RE = re.compile(r'g_psIntPlan\s*\[\s*\]\s*=\s*\{(.*?)\};', re.S)
+PLAN_ENTRY_RE = re.compile(r'\{\s*(\w+)\s*,\s*(\w+)\s*,')
+RESET = 'ResetISR'
+
+# TivaWare's hw_ints.h numbers each interrupt per device class
+# (INT_UART0_TM4C123) and resolves the plain name with a macro.
+DEVICE_CLASS = 'TM4C123'
+
+
+def reg_count(reglist):
+    """Number of registers in '{r4, r5, lr}' or '{r4-r7, lr}'."""
+    count = 0
+    for item in reglist.strip('{} ').split(','):
+        item = item.strip()
+        if not item:
+            continue
+        m = re.match(r'([a-z]+)(\d+)-[a-z]+(\d+)$', item)
+        count += int(m.group(3)) - int(m.group(2)) + 1 if m else 1
+    return count
+
+
+def parse(lines):
+    """Returns {function: {'frame': bytes, 'calls': set, 'indirect': bool}}."""
+    funcs = {}
+    cur = cur_name = None
+    for line in lines:
+        m = FUNC_RE.match(line)
+        if m:
+            cur_name = m.group(2)
+            cur = funcs.setdefault(m.group(2), {'frame': 0, 'calls': set(),
+                                                'indirect': False})
+            continue
+        m = INSN_RE.match(line)
+        if not m or cur is None:
+            continue
+        op, args = m.group(2), m.group(3).split(';')[0].strip()
+        base = op.split('.')[0]
+
+        if base in ('push', 'stmdb', 'stmfd') and \
+                (base == 'push' or args.startswith('sp!')):
+            cur['frame'] += 4 * reg_count(args[args.find('{'):])
+        elif base == 'vpush':
+            regs = reg_count(args)
+            cur['frame'] += (8 if 'd' in args else 4) * regs
+        elif base in ('sub', 'subw') and re.match(r'sp,\s*(sp,\s*)?#', args):
+            imm = IMM_RE.search(args)
+            cur['frame'] += int(imm.group(1), 0)
+        elif base == 'str' and re.search(r'\[sp,\s*#-(\d+)\]!', args):
+            cur['frame'] += int(re.search(r'#-(\d+)', args).group(1))
+        elif base in ('bl', 'blx'):
+            t = TARGET_RE.search(args)
+            if t:
+                cur['calls'].add(t.group(1))
+            else:
+                cur['indirect'] = True
+        elif base == 'b':
+            # A branch to the start of another function is a tail call.
+            t = TARGET_RE.search(args)
+            if t and not t.group(2) and t.group(1) != cur_name:
+                cur['calls'].add(t.group(1))
+    return funcs
+
+
+def worst_case(funcs, name, stack=None, memo=None):
+    """Worst-case depth from name; returns (bytes, path, notes)."""
+    stack = stack or []
+    memo = {} if memo is None else memo
+    if name in memo:
+        return memo[name]
+    if name in stack:
+        return 0, [name + ' (recursion)'], {'recursion: ' + name}
+    f = funcs.get(name)
+    if f is None:
+        return 0, [name + ' (unknown)'], set()
+
+    best, best_path, notes = 0, [], set()
+    if f['indirect']:
+        notes.add('indirect call in ' + name)
+    for callee in sorted(f['calls']):
+        depth, path, sub = worst_case(funcs, callee, stack + [name], memo)
+        notes |= sub
+        if depth > best:
+            best, best_path = depth, path
+    result = (f['frame'] + best, [name] + best_path, notes)
+    memo[name] = result
+    return result
+
+
+def strip_comments(text):
+    return re.sub(r'//[^\n]*|/\*.*?\*/', '', text, flags=re.S)
+
+
+def vector_table(path):
+    """(exception number, entry) pairs of the g_pfnVectors initializer of a
+    startup file.
+
+    Both sides of any #ifdef are taken, each numbered from the same place; a
+    handler that is not linked in is not in the disassembly and drops out
+    there.
+    """
+    with open(path) as f:
+        m = VECTORS_RE.search(strip_comments(f.read()))
+    if not m:
+        return None
+    table, number, marks = [], 0, []
+    for line in m.group(1).splitlines():
+        line = line.strip()
+        if line.startswith('#'):
+            word = (line[1:].split() or [''])[0]
+            if word.startswith('if'):
+                marks.append(number)
+            elif word in ('else', 'elif') and marks:
+                number = marks[-1]
+            elif word == 'endif' and marks:
+                marks.pop()
+            continue
+        for item in line.split(','):
+            if item.strip():
+                table.append((number, item.strip()))
+                number += 1
+    return table
+
+
+def vector_entries(table):
+    """Handler names in a vector table."""
+    return set(name for _, name in table if NAME_RE.match(name))
+
+
+def interrupt_numbers(path):
+    """{name: exception number} from TivaWare's inc/hw_ints.h."""
+    with open(path) as f:
+        defines = dict(DEFINE_RE.findall(strip_comments(f.read())))
+
+    def resolve(name):
+        for value in (defines.get(name + '_' + DEVICE_CLASS),
+                      defines.get(name)):
+            for _ in range(4):
+                if value is None or not NAME_RE.match(value):
+                    break
+                value = defines.get(value)
+            if value is not None:
+                try:
+                    return int(value, 0)
+                except ValueError:
+                    pass
+        return None
+
+    return resolve
+
+
+def has_plan(path):
+    with open(path) as f:
+        return PLAN_RE.search(strip_comments(f.read())) is not None
+
+
+def priority_plan(path, number):
+    """{exception number: priority} from the g_psIntPlan table of a source
+    file, its levels given as numbers or #defines of that file."""
+    with open(path) as f:
+        text = strip_comments(f.read())
+    m = PLAN_RE.search(text)
+    defines = dict(DEFINE_RE.findall(text))
+    plan = {}
+    for name, level in PLAN_ENTRY_RE.findall(m.group(1)):
+        try:
+            level = int(defines.get(level, level), 0)
+        except ValueError:
+            print('stack_usage: priority %s of %s unknown, skipped'
+                  % (level, name))
+            continue
+        if number(name) is None:
+            print('stack_usage: %s not in hw_ints.h, skipped' % name)
+            continue
+        plan[number(name)] = level
+    return plan
+
+
+def find_startup(explicit, image):
+    if explicit:
+        return explicit
+    if image == '-':
+        return None
+    here = os.path.dirname(os.path.abspath(image))
+    for folder in (here, os.path.dirname(here)):
+        hits = sorted(glob.glob(os.path.join(folder, '*_startup_*.c')))
+        if hits:
+            return hits[0]
+    return None
+
+
+def find_plan(explicit, startup):
+    if explicit:
+        return explicit
+    if startup:
+        path = os.path.join(os.path.dirname(os.path.abspath(startup)),
+                            'main.c')
+        if os.path.exists(path):
+            return path
+    return None
+
+
+def find_hw_ints(explicit):
+    if explicit:
+        return explicit if os.path.exists(explicit) else None
+    for pattern in ('C:/ti/TivaWare_C_Series-*/inc/hw_ints.h',
+                    os.path.expanduser('~/ti/TivaWare_C_Series-*/inc/'
+                                       'hw_ints.h')):
+        hits = sorted(glob.glob(pattern))
+        if hits:
+            return hits[-1]
+    return None
+
+
+def reachable(funcs, name):
+    """Every function name calls, directly or not."""
+    seen, todo = set(), [name]
+    while todo:
+        for callee in funcs.get(todo.pop(), {'calls': ()})['calls']:
+            if callee not in seen:
+                seen.add(callee)
+                todo.append(callee)
+    return seen
+
+
+def entry_points(funcs, candidates):
+    """The candidates that are real exception entries: ResetISR, main and
+    anything another candidate (or main) calls are left out."""
+    candidates = set(c for c in candidates if c in funcs) - {RESET, 'main'}
+    reach = dict((c, reachable(funcs, c)) for c in candidates | {'main'})
+    return sorted(c for c in candidates
+                  if not any(c in reach[o] and o not in reach[c]
+                             for o in reach if o != c))
+
+
+def find_objdump(explicit):
+    if explicit:
+        return explicit
+    for name in ('arm-none-eabi-objdump', 'arm-none-eabi-objdump.exe'):
+        path = shutil.which(name)
+        if path:
+            return path
+    # The GCC toolchain bundled with Code Composer Studio.
+    for pattern in ('C:/ti/ccs*/ccs/tools/compiler/gcc-arm-none-eabi*/bin/'
+                    'arm-none-eabi-objdump*',
+                    os.path.expanduser('~/ti/ccs*/ccs/tools/compiler/'
+                                       'gcc-arm-none-eabi*/bin/'
+                                       'arm-none-eabi-objdump*')):
+        hits = sorted(glob.glob(pattern))
+        if hits:
+            return hits[-1]
+    return None
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n\n')[1])
+    ap.add_argument('image', help='linked .out/.elf file, or "-" to read '
+                    'objdump -d output from stdin')
+    ap.add_argument('--stack-size', type=int, default=512,
+                    help='system stack size set with --stack_size (bytes)')
+    ap.add_argument('--fpu', action='store_true',
+                    help='assume interrupts may stack an FPU context')
+    ap.add_argument('--objdump', help='path to arm-none-eabi-objdump')
+    ap.add_argument('--startup', help='startup file with g_pfnVectors '
+                    '(default: *_startup_*.c beside the image or one up)')
+    ap.add_argument('--plan', help='source file with the g_psIntPlan '
+                    'priority table (default: main.c beside the startup '
+                    'file)')
+    ap.add_argument('--hw-ints', help="TivaWare's inc/hw_ints.h, for the "
+                    'interrupt numbers the plan names (default: the newest '
+                    'TivaWare under C:/ti or ~/ti)')
+    ap.add_argument('--isr', action='append', default=[],
+                    help='extra interrupt entry points, such as handlers '
+                    'installed at run time')
+    ap.add_argument('--priority', action='append', default=[],
+                    metavar='HANDLER=LEVEL',
+                    help='priority of a handler, over the plan; handlers '
+                    'with none share one level of their own')
+    ap.add_argument('--fail', action='store_true',
+                    help='exit with status 1 if the stack may overflow')
+    args = ap.parse_args()
+
+    if args.image == '-':
+        lines = sys.stdin.read().splitlines()
+    else:
+        objdump = find_objdump(args.objdump)
+        if objdump is None:
+            print('stack_usage: arm-none-eabi-objdump not found, skipping')
+            return 0
+        lines = subprocess.run([objdump, '-d', args.image], check=True,
+                               capture_output=True,
+                               text=True).stdout.splitlines()
+
+    funcs = parse(lines)
+    if 'main' not in funcs:
+        print('stack_usage: no main() in disassembly')
+        return 1
+
+    frame = EXCEPTION_FRAME_FPU if args.fpu else EXCEPTION_FRAME
+    main_depth, main_path, notes = worst_case(funcs, 'main')
+    startup = find_startup(args.startup, args.image)
+    table = vector_table(startup) if startup else None
+    if table is None:
+        print('stack_usage: no g_pfnVectors found, taking functions ending '
+              'in Handler/ISR as the handlers')
+        vectors = set(n for n in funcs if HANDLER_RE.search(n))
+    else:
+        vectors = vector_entries(table)
+    isrs = entry_points(funcs, vectors | set(args.isr))
+
+    levels = {}
+    plan_file = find_plan(args.plan, startup)
+    if table is not None and plan_file and has_plan(plan_file):
+        hw_ints = find_hw_ints(args.hw_ints)
+        if hw_ints is None:
+            print('stack_usage: hw_ints.h not found, taking all handlers at '
+                  'one priority')
+        else:
+            plan = priority_plan(plan_file, interrupt_numbers(hw_ints))
+            for number, name in table:
+                if number in plan:
+                    levels[name] = plan[number]
+    for item in args.priority:
+        name, _, level = item.partition('=')
+        levels[name] = int(level, 0)
+
+    print('Worst-case stack use (bytes)')
+    print('  %-28s %6d  %s' % ('main', main_depth, ' > '.join(main_path)))
+    worst_isr = {}
+    for isr in isrs:
+        depth, path, sub = worst_case(funcs, isr)
+        notes |= sub
+        level = levels.get(isr)
+        worst_isr[level] = max(worst_isr.get(level, 0), depth + frame)
+        print('  %-28s %6d  %s' % (isr, depth + frame,
+                                   ' > '.join(path)))
+
+    total = main_depth + sum(worst_isr.values())
+    if levels:
+        what = 'main + deepest handler of each of %d levels' % len(worst_isr)
+    else:
+        what = 'main + deepest handler'
+    print('System stack: %d of %d bytes (%s), %d bytes headroom'
+          % (total, args.stack_size, what, args.stack_size - total))
+    for note in sorted(notes):
+        print('  unbounded: ' + note)
+
+    return 1 if args.fail and total > args.stack_size else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
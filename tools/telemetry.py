@@ -0,0 +1,282 @@
+#!/usr/bin/env python3
+"""
+Name: telemetry.py
+
+Description:
+Host side of the framed binary telemetry sent by 010_basic-dma
+(utils/telemetry.c).
+
+Each frame is COBS encoded between zero bytes and, once decoded, is
+    type (1) | channel (1) | sequence (2) | payload | CRC-16 (2)
+with little-endian fields and a CRC-16/CCITT-FALSE over everything before
+it. Receiver reassembles frames from an arbitrary byte stream (console text
+in between is skipped), checks them and keeps per-channel statistics,
+counting frames lost from the gaps in the sequence numbers.
+
+The module has no dependencies beyond the standard library; see
+telemetry_rx.py for the command line receiver.
+"""
+
+import struct
+from collections import namedtuple
+
+TYPE_SAMPLES16 = 0x01
+TYPE_PACKED12 = 0x02
+TYPE_RICE = 0x03
+TYPE_VARINT = 0x04
+TYPE_CAPTURE = 0x05
+TYPE_BLOCKTIME = 0x06
+
+# Rice escape: a quotient this large is sent as this many one bits followed
+# by the zigzag difference in RAW_BITS bits (utils/sampack.h).
+RICE_ESCAPE = 16
+RICE_RAW_BITS = 13
+
+Frame = namedtuple('Frame', 'type channel seq payload')
+Capture = namedtuple('Capture', 'number offset window trigger index samples')
+BlockTime = namedtuple('BlockTime', 'block time missed clock samples')
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, matching TelemetryCRC16() on the target."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+        crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    """Decodes one COBS block (without delimiters); raises ValueError."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise ValueError('bad COBS code')
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def cobs_encode(data):
+    """COBS encodes data (no delimiters), as the target does."""
+    out = bytearray([0])
+    code_pos, code = 0, 1
+    for byte in data:
+        if byte:
+            out.append(byte)
+            code += 1
+        if byte == 0 or code == 0xFF:
+            out[code_pos] = code
+            code_pos = len(out)
+            out.append(0)
+            code = 1
+    out[code_pos] = code
+    return bytes(out)
+
+
+def build_frame(ftype, channel, seq, payload):
+    """Encodes a frame exactly as TelemetrySend() does (useful for tests)."""
+    body = struct.pack('<BBH', ftype, channel, seq & 0xFFFF) + bytes(payload)
+    body += struct.pack('<H', crc16(body))
+    return b'\x00' + cobs_encode(body) + b'\x00'
+
+
+def samples16(payload):
+    """Payload of a TYPE_SAMPLES16 frame as a list of ints."""
+    return list(struct.unpack('<%dH' % (len(payload) // 2), payload))
+
+
+def unpack12(payload):
+    """Payload of a TYPE_PACKED12 frame: 12-bit samples, LSB first."""
+    count = len(payload) * 2 // 3
+    value = int.from_bytes(payload, 'little')
+    return [(value >> (12 * i)) & 0xFFF for i in range(count)]
+
+
+def _unzigzag(z):
+    return (z >> 1) ^ -(z & 1)
+
+
+def _delta_header(payload):
+    count, first = struct.unpack('<HH', payload[:4])
+    return count, first
+
+
+def rice_decode(payload):
+    """Payload of a TYPE_RICE frame (see SampleEncodeRice())."""
+    k = payload[0]
+    count, value = _delta_header(payload[1:5])
+    bits = int.from_bytes(payload[5:], 'little')
+    nbits = 8 * (len(payload) - 5)
+    pos = 0
+
+    def take(n):
+        nonlocal pos
+        if pos + n > nbits:
+            raise ValueError('Rice stream truncated')
+        field = (bits >> pos) & ((1 << n) - 1)
+        pos += n
+        return field
+
+    out = [value] if count else []
+    while len(out) < count:
+        q = 0
+        while q < RICE_ESCAPE and take(1):
+            q += 1
+        if q == RICE_ESCAPE:
+            z = take(RICE_RAW_BITS)
+        else:
+            z = (q << k) | take(k)
+        value += _unzigzag(z)
+        out.append(value)
+    return out
+
+
+def varint_decode(payload):
+    """Payload of a TYPE_VARINT frame (see SampleEncodeVarint())."""
+    count, value = _delta_header(payload)
+    out = [value] if count else []
+    pos = 4
+    while len(out) < count:
+        z, shift = 0, 0
+        while True:
+            if pos >= len(payload):
+                raise ValueError('varint stream truncated')
+            byte = payload[pos]
+            pos += 1
+            z |= (byte & 0x7F) << shift
+            shift += 7
+            if not byte & 0x80:
+                break
+        value += _unzigzag(z)
+        out.append(value)
+    return out
+
+
+def capture(payload):
+    """Payload of a TYPE_CAPTURE frame (see CaptureService()): the header
+    fields and the samples, which start at offset in the window."""
+    number, offset, window, trigger, index = struct.unpack('<HHHHI',
+                                                           payload[:12])
+    return Capture(number, offset, window, trigger, index,
+                   samples16(payload[12:]))
+
+
+def blocktime(payload):
+    """Payload of a TYPE_BLOCKTIME frame (see TelemetryStageTime()): the
+    block number, the cycle count of its last sample, the samples lost so
+    far, the cycle counter rate in Hz and the samples in the block."""
+    return BlockTime(*struct.unpack('<IIIIH', payload[:18]))
+
+
+class CaptureAssembler(object):
+    """Puts the frames of capture windows back together.
+
+    feed() takes TYPE_CAPTURE frames in order and returns a complete window
+    as (capture, samples) once its last frame arrives; samples[capture.trigger]
+    is the trigger sample. A window missing a frame is dropped and counted in
+    .broken.
+    """
+
+    def __init__(self):
+        self._first = None
+        self._samples = []
+        self.broken = 0
+
+    def feed(self, frame):
+        part = capture(frame.payload)
+        if part.offset == 0:
+            if self._first is not None:
+                self.broken += 1
+            self._first, self._samples = part, []
+        elif self._first is None or part.number != self._first.number or \
+                part.offset != len(self._samples):
+            if self._first is not None:
+                self.broken += 1
+            self._first = None
+            return None
+        self._samples += part.samples
+        if len(self._samples) < part.window:
+            return None
+        first, self._first = self._first, None
+        return first, self._samples
+
+
+DECODERS = {
+    TYPE_SAMPLES16: samples16,
+    TYPE_PACKED12: unpack12,
+    TYPE_RICE: rice_decode,
+    TYPE_VARINT: varint_decode,
+}
+
+
+def decode_samples(frame):
+    """Samples carried by a frame of any sample type, or None."""
+    decoder = DECODERS.get(frame.type)
+    return decoder(frame.payload) if decoder else None
+
+
+class ChannelStats(object):
+    def __init__(self):
+        self.frames = 0
+        self.lost = 0
+        self.bytes = 0
+        self.last_seq = None
+
+
+class Receiver(object):
+    """Reassembles and checks frames from a byte stream.
+
+    feed() accepts chunks of any size and returns the complete, valid frames
+    found so far. Statistics are in .channels (per channel), .crc_errors
+    (frames that decoded but failed the CRC) and .junk (zero-delimited runs
+    that are not frames at all, such as console text).
+    """
+
+    def __init__(self):
+        self._buf = bytearray()
+        self.channels = {}
+        self.crc_errors = 0
+        self.junk = 0
+
+    def feed(self, data):
+        frames = []
+        self._buf += data
+        while True:
+            end = self._buf.find(b'\x00')
+            if end < 0:
+                break
+            chunk = bytes(self._buf[:end])
+            del self._buf[:end + 1]
+            if chunk:
+                frame = self._frame(chunk)
+                if frame:
+                    frames.append(frame)
+        return frames
+
+    def _frame(self, chunk):
+        try:
+            body = cobs_decode(chunk)
+        except ValueError:
+            self.junk += 1
+            return None
+        if len(body) < 6:
+            self.junk += 1
+            return None
+        if crc16(body[:-2]) != struct.unpack('<H', body[-2:])[0]:
+            self.crc_errors += 1
+            return None
+
+        ftype, channel, seq = struct.unpack('<BBH', body[:4])
+        stats = self.channels.setdefault(channel, ChannelStats())
+        if stats.last_seq is not None:
+            stats.lost += (seq - stats.last_seq - 1) & 0xFFFF
+        stats.last_seq = seq
+        stats.frames += 1
+        stats.bytes += len(body) - 6
+        return Frame(ftype, channel, seq, body[4:-2])
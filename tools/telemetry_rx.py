@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""
+Name: telemetry_rx.py
+
+Description:
+Receives the binary telemetry stream of 010_basic-dma (built with
+TELEMETRY_STREAM) from a serial port or a capture file, reports throughput
+and lost frames per channel, decodes raw, 12-bit packed and delta coded
+sample frames and optionally writes the samples to CSV. Triggered capture
+windows (the "capture" command) are reassembled and can be written to a CSV
+of their own, with sample positions counted from the trigger.
+
+Usage:
+    python tools/telemetry_rx.py /dev/ttyACM0 --csv samples.csv
+    python tools/telemetry_rx.py capture.bin        # a raw capture file
+    python tools/telemetry_rx.py /dev/ttyACM0 --capture windows.csv
+    cat /dev/ttyACM0 | python tools/telemetry_rx.py -
+
+Reading a serial port needs pyserial (pip install pyserial).
+"""
+
+import argparse
+import os
+import stat
+import sys
+import time
+
+import telemetry
+
+
+def open_source(path, baud):
+    """Returns a read(n) callable for a serial port, file or stdin."""
+    if path == '-':
+        stream = sys.stdin.buffer
+        return lambda n: stream.read1(n) if hasattr(stream, 'read1') \
+            else stream.read(n)
+    if stat.S_ISCHR(os.stat(path).st_mode):
+        try:
+            import serial
+        except ImportError:
+            sys.exit('telemetry_rx: reading a serial port needs pyserial')
+        port = serial.Serial(path, baud, timeout=0.2)
+        return lambda n: port.read(n)
+    stream = open(path, 'rb')
+    return stream.read
+
+
+def report(rx, elapsed, final=False):
+    parts = []
+    for channel in sorted(rx.channels):
+        stats = rx.channels[channel]
+        parts.append('ch%d: %d frames, %d lost, %.1f kB/s' % (
+            channel, stats.frames, stats.lost,
+            stats.bytes / 1000.0 / max(elapsed, 1e-6)))
+    line = '; '.join(parts) or 'no frames'
+    line += '; %d CRC errors, %d junk' % (rx.crc_errors, rx.junk)
+    sys.stderr.write(line + ('\n' if final else '\r'))
+    sys.stderr.flush()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n\n')[1])
+    ap.add_argument('source', help='serial port, capture file, or - for stdin')
+    ap.add_argument('--baud', type=int, default=921600,
+                    help='serial baud rate (default: 921600)')
+    ap.add_argument('--csv', help='write channel,seq,index,sample rows here')
+    ap.add_argument('--capture',
+                    help='write capture,index,position,sample rows of the '
+                         'triggered capture windows here')
+    ap.add_argument('--raw', help='also save the received bytes to this file')
+    ap.add_argument('--seconds', type=float,
+                    help='stop after this many seconds')
+    args = ap.parse_args()
+
+    is_port = args.source != '-' and \
+        stat.S_ISCHR(os.stat(args.source).st_mode)
+    read = open_source(args.source, args.baud)
+    csv = open(args.csv, 'w') if args.csv else None
+    raw = open(args.raw, 'wb') if args.raw else None
+    if csv:
+        csv.write('channel,seq,index,sample\n')
+    windows = open(args.capture, 'w') if args.capture else None
+    if windows:
+        windows.write('capture,index,position,sample\n')
+
+    rx = telemetry.Receiver()
+    assembler = telemetry.CaptureAssembler()
+    window_count = 0
+    sample_count = decode_errors = 0
+    start = last = time.time()
+    try:
+        while True:
+            data = read(4096)
+            now = time.time()
+            if not data and not is_port:
+                break
+            if raw:
+                raw.write(data)
+            for frame in rx.feed(data):
+                if frame.type == telemetry.TYPE_CAPTURE:
+                    window = assembler.feed(frame)
+                    if window:
+                        window_count += 1
+                        head, samples = window
+                        if windows:
+                            for i, value in enumerate(samples):
+                                windows.write('%d,%d,%d,%d\n' % (
+                                    head.number, head.index,
+                                    i - head.trigger, value))
+                    continue
+                try:
+                    samples = telemetry.decode_samples(frame)
+                except ValueError:
+                    decode_errors += 1
+                    continue
+                if samples is None:
+                    continue
+                sample_count += len(samples)
+                if csv:
+                    for i, value in enumerate(samples):
+                        csv.write('%d,%d,%d,%d\n' % (frame.channel, frame.seq,
+                                                     i, value))
+            if now - last >= 1.0:
+                report(rx, now - start)
+                last = now
+            if args.seconds and now - start >= args.seconds:
+                break
+    except KeyboardInterrupt:
+        pass
+
+    report(rx, time.time() - start, final=True)
+    payload = sum(s.bytes for s in rx.channels.values())
+    if sample_count:
+        sys.stderr.write('%d samples in %d payload bytes (%.2f bits/sample), '
+                         '%d undecodable\n' % (sample_count, payload,
+                                               8.0 * payload / sample_count,
+                                               decode_errors))
+    if window_count or assembler.broken:
+        sys.stderr.write('%d capture windows, %d incomplete\n' % (
+            window_count, assembler.broken))
+    if csv:
+        csv.close()
+    if windows:
+        windows.close()
+    if raw:
+        raw.close()
+    lost = sum(s.lost for s in rx.channels.values())
+    return 1 if lost or rx.crc_errors or decode_errors else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())